@@ -14,7 +14,7 @@ DECLARE_GLOBAL_DATA_PTR;
 /*
  * Generic timer implementation of get_tbclk()
  */
-unsigned long get_tbclk(void)
+unsigned long notrace get_tbclk(void)
 {
 	unsigned long cntfrq;
 	asm volatile("mrs %0, cntfrq_el0" : "=r" (cntfrq));
@@ -24,7 +24,7 @@ unsigned long get_tbclk(void)
 /*
  * Generic timer implementation of timer_read_counter()
  */
-unsigned long timer_read_counter(void)
+unsigned long notrace timer_read_counter(void)
 {
 	unsigned long cntpct;
 #ifdef CONFIG_SYS_FSL_ERRATUM_A008585
@@ -43,7 +43,7 @@ unsigned long timer_read_counter(void)
 	return cntpct;
 }
 
-uint64_t get_ticks(void)
+uint64_t notrace get_ticks(void)
 {
 	unsigned long ticks = timer_read_counter();
 
@@ -21,7 +21,12 @@ struct resource_file {
 	uint32_t	hash_size;
 	uint32_t	size;		/* in byte */
 	bool		in_ram;
+	void		*data;		/* lazy loaded file body */
+	uint32_t	lookups;
+	uint32_t	reads;
+	ulong		read_us;
 	struct list_head link;
+	struct hlist_node hnode;
 };
 
 extern struct list_head entry_head;
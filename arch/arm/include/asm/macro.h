@@ -78,6 +78,25 @@ lr	.req	x30
 	b.eq	\el1_label
 .endm
 
+/*
+ * Branch if the MMU is off or alignment checking is enabled at the
+ * current exception level. All data accesses are then to Device memory
+ * or must be aligned, so unaligned loads/stores and DC ZVA would fault.
+ */
+.macro	branch_if_strict_align, xreg, label
+	mrs	\xreg, CurrentEL
+	cmp	\xreg, 0x8
+	b.gt	1001f
+	b.eq	1002f
+	mrs	\xreg, sctlr_el1
+	b	1003f
+1001:	mrs	\xreg, sctlr_el3
+	b	1003f
+1002:	mrs	\xreg, sctlr_el2
+1003:	tbz	\xreg, #0, \label	/* SCTLR.M */
+	tbnz	\xreg, #1, \label	/* SCTLR.A */
+.endm
+
 /*
  * Branch if current processor is a Cortex-A35 core.
  */
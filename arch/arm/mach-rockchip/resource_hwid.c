@@ -18,9 +18,18 @@
 #define MAX_ADC_CH_NR		10
 #define MAX_GPIO_NR		10
 
+/*
+ * The hardware id doesn't change at runtime, so what we have read from
+ * ADC/GPIO is kept for all the later matchings. The valid masks tell
+ * whether the record was read, zero is a legal adc value or gpio level.
+ */
 static fdt_addr_t gpio_base_addr[MAX_GPIO_NR];
 static uint32_t gpio_record[MAX_GPIO_NR];
+static uint32_t gpio_valid;
 static int adc_record[MAX_ADC_CH_NR];
+static uint32_t adc_valid;
+static struct resource_file *hwid_dtb;
+static int hwid_dtb_files;
 
 #ifdef CONFIG_ROCKCHIP_GPIO_V2
 #define GPIO_SWPORT_DDR		0x08
@@ -91,13 +100,6 @@ static int gpio_parse_base_address(fdt_addr_t *gpio_base_addr)
 	return 0;
 }
 
-static void hwid_init_data(void)
-{
-	memset(adc_record, 0, sizeof(adc_record));
-	memset(gpio_record, 0, sizeof(gpio_record));
-	memset(gpio_base_addr, 0, sizeof(gpio_base_addr));
-}
-
 /*
  * How to use ?
  *
@@ -149,16 +151,17 @@ static int hwid_adc_find_dtb(const char *file_name)
 		 * Read raw adc value
 		 *
 		 * It doesn't need to read adc value every loop, reading once
-		 * is enough. We use adc_record[] to save what we have read, zero
-		 * means not read before.
+		 * is enough. We use adc_record[] to save what we have read, and
+		 * adc_valid tells whether it was read before.
 		 */
-		if (adc_record[channel] == 0) {
+		if (!(adc_valid & BIT(channel))) {
 			ret = adc_channel_single_shot(dev_name, channel, &raw_adc);
 			if (ret) {
 				debug("   - failed to read adc, ret=%d\n", ret);
 				return 0;
 			}
 			adc_record[channel] = raw_adc;
+			adc_valid |= BIT(channel);
 		}
 
 		/* Parse dtb adc value */
@@ -234,16 +237,17 @@ static int hwid_gpio_find_dtb(const char *file_name)
 
 		/*
 		 * It doesn't need to read gpio value every loop, reading once
-		 * is enough. We use gpio_record[] to save what we have read, zero
-		 * means not read before.
+		 * is enough. We use gpio_record[] to save what we have read, and
+		 * gpio_valid tells whether it was read before.
 		 */
-		if (gpio_record[port] == 0) {
+		if (!(gpio_valid & BIT(port))) {
 			if (!gpio_base_addr[port]) {
 				debug("   - can't find gpio%d base\n", port);
 				return 0;
 			}
 			gpio_record[port] =
 				gpio_read(gpio_base_addr[port], bank, pin);
+			gpio_valid |= BIT(port);
 		}
 
 		/* Verify result */
@@ -264,8 +268,17 @@ struct resource_file *resource_read_hwid_dtb(void)
 {
 	struct resource_file *file;
 	struct list_head *node;
+	int files = 0;
 
-	hwid_init_data();
+	/* match result is reused until the resource list gets new files */
+	list_for_each(node, &entry_head)
+		files++;
+
+	if (hwid_dtb_files == files)
+		return hwid_dtb;
+
+	hwid_dtb = NULL;
+	hwid_dtb_files = files;
 
 	list_for_each(node, &entry_head) {
 		file = list_entry(node, struct resource_file, link);
@@ -275,13 +288,15 @@ struct resource_file *resource_read_hwid_dtb(void)
 		if (strstr(file->name, KEY_WORDS_ADC_CTRL) &&
 		    strstr(file->name, KEY_WORDS_ADC_CH) &&
 		    hwid_adc_find_dtb(file->name)) {
-			return file;
+			hwid_dtb = file;
+			break;
 		} else if (strstr(file->name, KEY_WORDS_GPIO) &&
 			   hwid_gpio_find_dtb(file->name)) {
-			return file;
+			hwid_dtb = file;
+			break;
 		}
 	}
 
-	return NULL;
+	return hwid_dtb;
 }
 
@@ -24,6 +24,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define MAX_FILE_NAME_LEN		220
 #define MAX_HASH_LEN			32
 #define DEFAULT_DTB_FILE		"rk-kernel.dtb"
+#define RESOURCE_HASH_BITS		6
+#define RESOURCE_HASH_SIZE		(1 << RESOURCE_HASH_BITS)
+#define RESOURCE_PRELOAD_BLKS		64
 
 /*
  *         resource image structure
@@ -94,11 +97,45 @@ struct resource_entry {
 
 LIST_HEAD(entry_head);
 
+/* name index of entry_head, the list is still kept for ordered walk */
+static struct hlist_head entry_htable[RESOURCE_HASH_SIZE];
+
+static struct {
+	ulong scan_us;
+	ulong lookup_us;
+	u32 lookups;
+	u32 misses;
+} resc_stat;
+
 static int resource_check_header(struct resource_img_hdr *hdr)
 {
 	return memcmp(RESOURCE_MAGIC, hdr->magic, RESOURCE_MAGIC_SIZE);
 }
 
+static u32 resource_name_hash(const char *name)
+{
+	u32 hash = 5381;
+
+	while (*name)
+		hash = (hash << 5) + hash + (u8)*name++;
+
+	return (hash ^ (hash >> RESOURCE_HASH_BITS)) & (RESOURCE_HASH_SIZE - 1);
+}
+
+static struct resource_file *resource_find_file(const char *name)
+{
+	struct resource_file *f;
+	struct hlist_node *node;
+
+	hlist_for_each_entry(f, node,
+			     &entry_htable[resource_name_hash(name)], hnode) {
+		if (!strcmp(f->name, name))
+			return f;
+	}
+
+	return NULL;
+}
+
 static void resource_dump(struct resource_file *f)
 {
 	printf("%s\n", f->name);
@@ -106,6 +143,7 @@ static void resource_dump(struct resource_file *f)
 	printf("  blk_offset: 0x%08lx\n", (ulong)f->blk_offset);
 	printf("  size:       0x%08x\n", f->size);
 	printf("  in_ram:     %d\n", f->in_ram);
+	printf("  cached:     %d\n", f->data ? 1 : 0);
 	printf("  hash_size:  %d\n\n", f->hash_size);
 }
 
@@ -115,27 +153,24 @@ static int resource_add_file(const char *name, u32 size,
 			     bool in_ram)
 {
 	struct resource_file *f;
-	struct list_head *node;
-	bool _new = true;
 
 	/* old one ? */
-	list_for_each(node, &entry_head) {
-		f = list_entry(node, struct resource_file, link);
-		if (!strcmp(f->name, name)) {
-			_new = false;
-			break;
-		}
-	}
-
-	if (_new) {
+	f = resource_find_file(name);
+	if (!f) {
 		f = calloc(1, sizeof(*f));
 		if (!f)
 			return -ENOMEM;
 
+		strlcpy(f->name, name, MAX_FILE_NAME_LEN);
 		list_add_tail(&f->link, &entry_head);
+		hlist_add_head(&f->hnode,
+			       &entry_htable[resource_name_hash(f->name)]);
+	} else if (f->data) {
+		/* location changed, drop the stale body */
+		free(f->data);
+		f->data = NULL;
 	}
 
-	strcpy(f->name, name);
 	f->size       = size;
 	f->in_ram     = in_ram;
 	f->blk_start  = blk_start;
@@ -252,18 +287,26 @@ static int resource_setup_logo_bmp(struct blk_desc *desc)
 	return ret;
 }
 
+/*
+ * The header and entry table are read by one request of RESOURCE_PRELOAD_BLKS
+ * blocks (fewer near the end of the device), which covers the table of a
+ * normal resource image, only a huge table needs the second read for the rest.
+ */
 static int resource_setup_blk_list(struct blk_desc *desc, ulong blk_start)
 {
 	struct resource_img_hdr *hdr;
-	int blk_cnt;
+	int blk_cnt, tbl_cnt, pre_cnt;
 	int ret = 0;
-	void *buf;
 
-	hdr = memalign(ARCH_DMA_MINALIGN, desc->blksz);
+	if (blk_start >= desc->lba)
+		return -EIO;
+	pre_cnt = min_t(lbaint_t, RESOURCE_PRELOAD_BLKS, desc->lba - blk_start);
+
+	hdr = memalign(ARCH_DMA_MINALIGN, pre_cnt * desc->blksz);
 	if (!hdr)
 		return -ENOMEM;
 
-	if (blk_dread(desc, blk_start, 1, hdr) != 1) {
+	if (blk_dread(desc, blk_start, pre_cnt, hdr) != pre_cnt) {
 		ret = -EIO;
 		goto out;
 	}
@@ -283,17 +326,26 @@ static int resource_setup_blk_list(struct blk_desc *desc, ulong blk_start)
 		}
 	}
 
-	blk_cnt = hdr->e_blks * hdr->e_nums;
-	hdr = realloc(hdr, (1 + blk_cnt) * desc->blksz);
-	if (!hdr) {
-		ret = -ENOMEM;
-		goto out;
-	}
+	tbl_cnt = hdr->c_offset + hdr->e_blks * hdr->e_nums;
+	if (tbl_cnt > pre_cnt) {
+		struct resource_img_hdr *tbl;
 
-	buf = (void *)hdr + desc->blksz;
-	if (blk_dread(desc, blk_start + hdr->c_offset, blk_cnt, buf) != blk_cnt) {
-		ret = -EIO;
-		goto out;
+		tbl = memalign(ARCH_DMA_MINALIGN, tbl_cnt * desc->blksz);
+		if (!tbl) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		memcpy(tbl, hdr, pre_cnt * desc->blksz);
+		free(hdr);
+		hdr = tbl;
+
+		blk_cnt = tbl_cnt - pre_cnt;
+		if (blk_dread(desc, blk_start + pre_cnt, blk_cnt,
+			      (void *)hdr + pre_cnt * desc->blksz) != blk_cnt) {
+			ret = -EIO;
+			goto out;
+		}
 	}
 
 	resource_setup_list(desc, blk_start, hdr, false);
@@ -355,19 +407,10 @@ static int resource_default(struct blk_desc *desc,
 }
 #endif
 
-static int resource_scan(void)
+static int __resource_scan(struct blk_desc *desc)
 {
-	struct blk_desc *desc = rockchip_get_bootdev();
 	__maybe_unused int ret;
 
-	if (!desc) {
-		printf("RESC: No bootdev\n");
-		return -ENODEV;
-	}
-
-	if (!list_empty(&entry_head))
-		return 0;
-
 #ifdef CONFIG_ROCKCHIP_FIT_IMAGE
 	ret = fit_image_init_resource(desc);
 	if (!ret || ret != -EAGAIN)
@@ -407,29 +450,86 @@ static int resource_scan(void)
 	return -ENOENT;
 }
 
+static int resource_scan(void)
+{
+	struct blk_desc *desc = rockchip_get_bootdev();
+	ulong start;
+	int ret;
+
+	if (!desc) {
+		printf("RESC: No bootdev\n");
+		return -ENODEV;
+	}
+
+	if (!list_empty(&entry_head))
+		return 0;
+
+	start = timer_get_us();
+	ret = __resource_scan(desc);
+	resc_stat.scan_us += timer_get_us() - start;
+
+	return ret;
+}
+
 static struct resource_file *resource_get_file(const char *name)
 {
 	struct resource_file *f;
-	struct list_head *node;
+	ulong start;
 
 	if (resource_scan())
 		return NULL;
 
-	list_for_each(node, &entry_head) {
-		f = list_entry(node, struct resource_file, link);
-		if (!strcmp(f->name, name))
-			return f;
+	start = timer_get_us();
+	f = resource_find_file(name);
+	resc_stat.lookup_us += timer_get_us() - start;
+	resc_stat.lookups++;
+	if (f)
+		f->lookups++;
+	else
+		resc_stat.misses++;
+
+	return f;
+}
+
+/*
+ * Load the whole body of a small file on its first access, so that the caller
+ * pattern "read header, then read the whole file" only touches storage once.
+ */
+static void *resource_load_file(struct blk_desc *desc, struct resource_file *f)
+{
+	int blk_cnt;
+	void *data;
+
+	if (f->data)
+		return f->data;
+
+	if (!CONFIG_ROCKCHIP_RESOURCE_CACHE_SIZE ||
+	    f->size > CONFIG_ROCKCHIP_RESOURCE_CACHE_SIZE)
+		return NULL;
+
+	blk_cnt = DIV_ROUND_UP(f->size, desc->blksz);
+	data = memalign(ARCH_DMA_MINALIGN, blk_cnt * desc->blksz);
+	if (!data)
+		return NULL;
+
+	if (blk_dread(desc, f->blk_start + f->blk_offset,
+		      blk_cnt, data) != blk_cnt) {
+		free(data);
+		return NULL;
 	}
 
-	return NULL;
+	f->data = data;
+
+	return data;
 }
 
 int rockchip_read_resource_file(void *buf, const char *name, int blk_offset, int len)
 {
 	struct blk_desc *desc = rockchip_get_bootdev();
 	struct resource_file *f;
+	ulong start, pos;
 	int blk_cnt;
-	ulong pos;
+	void *data;
 
 	if (!desc)
 		return -ENODEV;
@@ -443,16 +543,25 @@ int rockchip_read_resource_file(void *buf, const char *name, int blk_offset, int
 	if (len <= 0 || len > f->size)
 		len = f->size;
 
+	start = timer_get_us();
 	if (f->in_ram) {
 		pos = f->blk_start + (f->blk_offset + blk_offset) * desc->blksz;
 		memcpy(buf, (char *)pos, len);
 	} else {
-		blk_cnt = DIV_ROUND_UP(len, desc->blksz);
-		if (blk_dread(desc,
-			      f->blk_start + f->blk_offset + blk_offset,
-			      blk_cnt, buf) != blk_cnt)
-			len = -EIO;
+		pos = (ulong)blk_offset * desc->blksz;
+		data = resource_load_file(desc, f);
+		if (data && pos + len <= ALIGN(f->size, desc->blksz)) {
+			memcpy(buf, data + pos, len);
+		} else {
+			blk_cnt = DIV_ROUND_UP(len, desc->blksz);
+			if (blk_dread(desc,
+				      f->blk_start + f->blk_offset + blk_offset,
+				      blk_cnt, buf) != blk_cnt)
+				len = -EIO;
+		}
 	}
+	f->read_us += timer_get_us() - start;
+	f->reads++;
 
 	return len;
 }
@@ -497,18 +606,39 @@ static int do_dump_resource(cmd_tbl_t *cmdtp, int flag,
 {
 	struct resource_file *f;
 	struct list_head *node;
+	bool timing = false;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "--timing"))
+			return CMD_RET_USAGE;
+		timing = true;
+	}
 
 	list_for_each(node, &entry_head) {
 		f = list_entry(node, struct resource_file, link);
-		resource_dump(f);
+		if (!timing) {
+			resource_dump(f);
+			continue;
+		}
+
+		printf("%-40s lookups: %3d, reads: %3d, read: %6lu us%s\n",
+		       f->name, f->lookups, f->reads, f->read_us,
+		       f->data ? " (cached)" : "");
+	}
+
+	if (timing) {
+		printf("\nscan: %lu us, lookups: %d (%d miss), lookup: %lu us\n",
+		       resc_stat.scan_us, resc_stat.lookups, resc_stat.misses,
+		       resc_stat.lookup_us);
 	}
 
 	return 0;
 }
 
 U_BOOT_CMD(
-	dump_resource, 1, 1, do_dump_resource,
+	dump_resource, 2, 1, do_dump_resource,
 	"dump resource files",
-	""
+	"[--timing]\n"
+	"    --timing: show lookup and read cost of each file"
 );
 
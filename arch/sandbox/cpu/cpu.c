@@ -17,6 +17,9 @@ DECLARE_GLOBAL_DATA_PTR;
 /* Enable access to PCI memory with map_sysmem() */
 static bool enable_pci_map;
 
+/* Enable memory access with readl() and writel() */
+static bool enable_memio;
+
 #ifdef CONFIG_PCI
 /* Last device that was mapped into memory, and length of mapping */
 static struct udevice *map_dev;
@@ -91,6 +94,51 @@ void sandbox_set_enable_pci_map(int enable)
 	enable_pci_map = enable;
 }
 
+void sandbox_set_enable_memio(bool enable)
+{
+	enable_memio = enable;
+}
+
+unsigned long sandbox_read(const void *addr, enum sandboxio_size_t size)
+{
+	if (!enable_memio)
+		return 0;
+
+	switch (size) {
+	case SB_SIZE_8:
+		return *(volatile u8 *)addr;
+	case SB_SIZE_16:
+		return *(volatile u16 *)addr;
+	case SB_SIZE_32:
+		return *(volatile u32 *)addr;
+	}
+
+	return 0;
+}
+
+void sandbox_write(void *addr, unsigned long val, enum sandboxio_size_t size)
+{
+	if (!enable_memio)
+		return;
+
+#if defined(CONFIG_PCI) && !defined(CONFIG_SPL_BUILD)
+	if (enable_pci_map && !pci_write_mmio(addr, val, size))
+		return;
+#endif
+
+	switch (size) {
+	case SB_SIZE_8:
+		*(volatile u8 *)addr = val;
+		break;
+	case SB_SIZE_16:
+		*(volatile u16 *)addr = val;
+		break;
+	case SB_SIZE_32:
+		*(volatile u32 *)addr = val;
+		break;
+	}
+}
+
 phys_addr_t map_to_sysmem(const void *ptr)
 {
 	return (u8 *)ptr - gd->arch.ram_buf;
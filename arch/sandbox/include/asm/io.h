@@ -39,13 +39,41 @@ static inline void unmap_sysmem(const void *vaddr)
 /* Map from a pointer to our RAM buffer */
 phys_addr_t map_to_sysmem(const void *ptr);
 
-/* Define nops for sandbox I/O access */
-#define readb(addr) ((void)addr, 0)
-#define readw(addr) ((void)addr, 0)
-#define readl(addr) ((void)addr, 0)
-#define writeb(v, addr) ((void)addr)
-#define writew(v, addr) ((void)addr)
-#define writel(v, addr) ((void)addr)
+enum sandboxio_size_t {
+	SB_SIZE_8,
+	SB_SIZE_16,
+	SB_SIZE_32,
+};
+
+unsigned long sandbox_read(const void *addr, enum sandboxio_size_t size);
+void sandbox_write(void *addr, unsigned long val, enum sandboxio_size_t size);
+
+/**
+ * pci_write_mmio() - offer a memory write to the PCI emulators
+ *
+ * @addr:	Address being written, as returned by map_physmem()
+ * @val:	Value to write
+ * @size:	Access size
+ * @return 0 if an emulator handled the write, -ENOENT if none did
+ */
+int pci_write_mmio(void *addr, unsigned long val, enum sandboxio_size_t size);
+
+/*
+ * Sandbox I/O access is a nop unless enabled with sandbox_set_enable_memio(),
+ * since most drivers built for sandbox use addresses which are not mapped
+ */
+#define readb(addr) ((u8)sandbox_read((const void *)(uintptr_t)(addr), \
+				      SB_SIZE_8))
+#define readw(addr) ((u16)sandbox_read((const void *)(uintptr_t)(addr), \
+				       SB_SIZE_16))
+#define readl(addr) ((u32)sandbox_read((const void *)(uintptr_t)(addr), \
+				       SB_SIZE_32))
+#define writeb(v, addr) sandbox_write((void *)(uintptr_t)(addr), \
+				      (unsigned long)(v), SB_SIZE_8)
+#define writew(v, addr) sandbox_write((void *)(uintptr_t)(addr), \
+				      (unsigned long)(v), SB_SIZE_16)
+#define writel(v, addr) sandbox_write((void *)(uintptr_t)(addr), \
+				      (unsigned long)(v), SB_SIZE_32)
 
 /* I/O access functions */
 int inl(unsigned int addr);
@@ -110,4 +110,39 @@ int sandbox_pwm_get_config(struct udevice *dev, uint channel, uint *period_nsp,
  */
 void sandbox_sf_set_block_protect(struct udevice *dev, int bp_mask);
 
+/* Data movement counters of the sandbox crypto device */
+struct sandbox_crypto_stats {
+	ulong dma_bytes;	/* bytes read by the emulated DMA engine */
+	ulong bounce_bytes;	/* bytes copied to the hash cache first */
+	ulong descs;		/* link list items submitted */
+};
+
+/**
+ * sandbox_crypto_get_stats() - get the data movement counters
+ *
+ * @dev: Crypto device to check
+ * @stats: Returns the counters
+ * @reset: true to clear the counters after reading them
+ */
+void sandbox_crypto_get_stats(struct udevice *dev,
+			      struct sandbox_crypto_stats *stats, bool reset);
+
+/* Queue counters of the sandbox NVMe emulator */
+struct sandbox_nvme_stats {
+	ulong doorbells;	/* I/O submission queue doorbell writes */
+	ulong cmds;		/* I/O commands completed */
+	ulong max_batch;	/* most I/O commands seen by one doorbell */
+	ulong reordered;	/* completions posted out of submission order */
+};
+
+/**
+ * sandbox_nvme_get_stats() - get the I/O queue counters
+ *
+ * @emul: NVMe emulator device to check
+ * @stats: Returns the counters
+ * @reset: true to clear the counters after reading them
+ */
+void sandbox_nvme_get_stats(struct udevice *emul,
+			    struct sandbox_nvme_stats *stats, bool reset);
+
 #endif
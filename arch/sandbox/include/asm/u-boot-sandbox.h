@@ -75,6 +75,18 @@ int pci_unmap_physmem(const void *addr, unsigned long len,
  */
 void sandbox_set_enable_pci_map(int enable);
 
+/**
+ * sandbox_set_enable_memio() - Enable readl/writel etc. to access memory
+ *
+ * These are nops by default, since drivers built for sandbox often use
+ * hardware addresses which are not mapped. Tests which emulate a device
+ * in memory can enable real accesses. Writes are offered to the PCI
+ * emulators first, using their write_mmio() method.
+ *
+ * @enable: true to access memory, false for nops
+ */
+void sandbox_set_enable_memio(bool enable);
+
 /**
  * sandbox_read_fdt_from_file() - Read a device tree from a file
  *
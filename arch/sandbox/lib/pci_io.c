@@ -92,6 +92,24 @@ static int pci_io_write(unsigned int addr, ulong value, pci_size_t size)
 	return -ENOSYS;
 }
 
+int pci_write_mmio(void *addr, unsigned long val, enum sandboxio_size_t size)
+{
+	struct udevice *dev;
+
+	for (uclass_first_device(UCLASS_PCI_EMUL, &dev);
+	     dev;
+	     uclass_next_device(&dev)) {
+		struct dm_pci_emul_ops *ops = pci_get_emul_ops(dev);
+
+		/* enum sandboxio_size_t matches enum pci_size_t */
+		if (ops && ops->write_mmio &&
+		    !(ops->write_mmio)(dev, addr, val, (enum pci_size_t)size))
+			return 0;
+	}
+
+	return -ENOENT;
+}
+
 int inl(unsigned int addr)
 {
 	unsigned long value;
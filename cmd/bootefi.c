@@ -183,6 +183,7 @@ static unsigned long do_bootefi_exec(void *efi, void *fdt,
 
 	/* Call our payload! */
 	debug("%s:%d Jumping to 0x%lx\n", __func__, __LINE__, (long)entry);
+	efi_disk_readahead_start();
 
 	if (setjmp(&loaded_image_info.exit_jmp)) {
 		ret = loaded_image_info.exit_status;
@@ -209,6 +210,9 @@ static unsigned long do_bootefi_exec(void *efi, void *fdt,
 	ret = efi_do_enter(&loaded_image_info, &systab, entry);
 
 exit:
+	efi_disk_readahead_stop();
+	efi_disk_show_stats();
+	efi_memory_show_stats();
 	/* image has returned, loaded-image obj goes *poof*: */
 	list_del(&loaded_image_info_obj.link);
 
@@ -8,11 +8,14 @@
 #include <crypto.h>
 #include <dm.h>
 #include <u-boot/md5.h>
+#include <u-boot/rsa.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
 #include <u-boot/sha512.h>
 #include <rockchip/crypto_fix_test_data.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 #define PERF_TOTAL_SIZE			(128 * 1024 * 1024)
 #define PERF_BUFF_SIZE			(4 * 1024 * 1024)
 
@@ -674,13 +677,115 @@ exit:
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(FIT_SIGNATURE)
+/*
+ * Compare the RSA verify latency of crypto uclass (hardware) and
+ * UCLASS_MOD_EXP device (software) with the first key of control FDT,
+ * which is what FIT signature verify uses.
+ */
+static int bench_rsa(int count)
+{
+	const void *blob = gd->fdt_blob;
+	ulong start, hw_us = 0, sw_us = 0;
+	u8 *sig, *hw_out, *sw_out;
+	const u8 *modulus;
+	int sig_node, node;
+	int len, i, ret;
+
+	sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
+	node = sig_node < 0 ? sig_node : fdt_first_subnode(blob, sig_node);
+	if (node < 0) {
+		printf("No RSA key in control FDT\n");
+		return -ENOENT;
+	}
+
+	modulus = fdt_getprop(blob, node, "rsa,modulus", &len);
+	if (!modulus) {
+		printf("No modulus of key %s\n", fdt_get_name(blob, node, NULL));
+		return -EINVAL;
+	}
+
+	sig = memalign(CONFIG_SYS_CACHELINE_SIZE, len);
+	hw_out = memalign(CONFIG_SYS_CACHELINE_SIZE, len);
+	sw_out = memalign(CONFIG_SYS_CACHELINE_SIZE, len);
+	if (!sig || !hw_out || !sw_out) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	/* any input smaller than modulus is fine for the latency */
+	memcpy(sig, modulus, len);
+	sig[0] >>= 1;
+
+	printf("RSA%d verify with key '%s', %d loops:\n", len * 8,
+	       fdt_get_name(blob, node, NULL), count);
+
+	for (i = 0; i < count; i++) {
+		start = timer_get_us();
+		ret = rsa_key_mod_exp(blob, node, sig, len, hw_out, true);
+		hw_us += timer_get_us() - start;
+		if (ret) {
+			printf("  hw: unsupported, ret=%d\n", ret);
+			hw_us = 0;
+			break;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		start = timer_get_us();
+		ret = rsa_key_mod_exp(blob, node, sig, len, sw_out, false);
+		sw_us += timer_get_us() - start;
+		if (ret) {
+			printf("  sw: unsupported, ret=%d\n", ret);
+			sw_us = 0;
+			break;
+		}
+	}
+
+	if (hw_us)
+		printf("  hw: %lu us/verify\n", hw_us / count);
+	if (sw_us)
+		printf("  sw: %lu us/verify\n", sw_us / count);
+	if (hw_us && sw_us) {
+		printf("  speedup: %lu.%02lux, result %s\n", sw_us / hw_us,
+		       (sw_us % hw_us) * 100 / hw_us,
+		       memcmp(hw_out, sw_out, len) ? "MISMATCH" : "match");
+	}
+	ret = 0;
+out:
+	free(sig);
+	free(hw_out);
+	free(sw_out);
+
+	return ret;
+}
+#endif
+
 static int do_crypto(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	return test_all_result();
+	if (argc == 1)
+		return test_all_result();
+
+#if CONFIG_IS_ENABLED(FIT_SIGNATURE)
+	if (argc >= 3 && !strcmp(argv[1], "bench") &&
+	    !strcmp(argv[2], "rsa")) {
+		int count = argc > 3 ? simple_strtoul(argv[3], NULL, 0) : 10;
+
+		if (count <= 0)
+			return CMD_RET_USAGE;
+
+		return bench_rsa(count) ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+	}
+#endif
+
+	return CMD_RET_USAGE;
 }
 
 U_BOOT_CMD(
-	crypto, 1, 1, do_crypto,
+	crypto, 4, 1, do_crypto,
 	"crypto test",
-	""
+	"\n"
+	"    - run all the crypto tests\n"
+	"crypto bench rsa [count]\n"
+	"    - compare hw and sw RSA verify latency with the FIT signature key"
 );
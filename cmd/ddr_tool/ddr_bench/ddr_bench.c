@@ -0,0 +1,363 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * (C) Copyright 2023 Rockchip Electronics Co., Ltd.
+ *
+ * DDR bandwidth and latency benchmark: STREAM like copy/scale/add/triad
+ * kernels on one and on all CPUs, and pointer chasing latency at several
+ * working set sizes. Results can be kept in the environment as a baseline
+ * to catch regressions of new DDR init blobs before the kernel boots.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <linux/sizes.h>
+#include "../ddr_tool_common.h"
+
+#define __version__ "v1.0.0"
+
+#define BENCH_ARRAY_MB		32
+#define BENCH_NTIMES		5
+#define BENCH_SCALAR		3
+#define BENCH_LINE		64
+#define BENCH_CHASE_STEPS	(1 << 20)
+#define BENCH_TOLERANCE		5	/* percent */
+#define BENCH_ENV		"ddr_bench_baseline"
+
+enum {
+	BENCH_COPY,
+	BENCH_SCALE,
+	BENCH_ADD,
+	BENCH_TRIAD,
+	BENCH_KERNELS,
+};
+
+static const struct {
+	const char *name;
+	int arrays;	/* arrays read plus written per element */
+} bench_kernels[BENCH_KERNELS] = {
+	{ "copy", 2 },
+	{ "scale", 2 },
+	{ "add", 3 },
+	{ "triad", 3 },
+};
+
+static const ulong bench_lat_sizes[] = {
+	SZ_16K, SZ_64K, SZ_256K, SZ_1M, SZ_4M, SZ_16M, SZ_64M,
+};
+
+#define BENCH_LAT_MAX		SZ_64M
+#define BENCH_RESULT_MAX	(2 * BENCH_KERNELS + ARRAY_SIZE(bench_lat_sizes))
+
+struct bench_result {
+	char name[16];
+	ulong val;
+	bool latency;	/* ps, lower is better; otherwise MB/s */
+};
+
+static struct bench_result bench_results[BENCH_RESULT_MAX];
+static int bench_result_num;
+
+/* Shared with the secondary CPUs */
+static struct {
+	u64 *a;
+	u64 *b;
+	u64 *c;
+	ulong n;	/* elements per array */
+	ulong share;	/* elements per CPU */
+	int kernel;
+	int cpus;
+} bench;
+
+static void * volatile bench_sink;
+
+static void bench_add_result(const char *name, ulong val, bool latency)
+{
+	struct bench_result *r = &bench_results[bench_result_num++];
+
+	strlcpy(r->name, name, sizeof(r->name));
+	r->val = val;
+	r->latency = latency;
+}
+
+static void bench_kernel_cpu(void *arg, int cpu)
+{
+	ulong off = bench.share * cpu;
+	ulong n = cpu == bench.cpus - 1 ? bench.n - off : bench.share;
+	u64 *a = bench.a + off;
+	u64 *b = bench.b + off;
+	u64 *c = bench.c + off;
+	ulong i;
+
+	switch (bench.kernel) {
+	case BENCH_COPY:
+		for (i = 0; i < n; i++)
+			c[i] = a[i];
+		break;
+	case BENCH_SCALE:
+		for (i = 0; i < n; i++)
+			b[i] = BENCH_SCALAR * c[i];
+		break;
+	case BENCH_ADD:
+		for (i = 0; i < n; i++)
+			c[i] = a[i] + b[i];
+		break;
+	case BENCH_TRIAD:
+		for (i = 0; i < n; i++)
+			a[i] = b[i] + BENCH_SCALAR * c[i];
+		break;
+	}
+}
+
+/* Best of BENCH_NTIMES runs in MB/s, as STREAM reports it */
+static ulong bench_stream(int kernel, int cpus)
+{
+	u64 bytes = (u64)bench_kernels[kernel].arrays * bench.n * sizeof(u64);
+	ulong start, us, mbps, best = 0;
+	int t;
+
+	bench.kernel = kernel;
+	bench.cpus = cpus;
+	bench.share = round_down(bench.n / cpus, BENCH_LINE / sizeof(u64));
+	flush_dcache_range((ulong)&bench, (ulong)&bench + sizeof(bench));
+
+	for (t = 0; t < BENCH_NTIMES; t++) {
+		start = timer_get_us();
+		if (cpus > 1)
+			ddr_tool_mp_start(bench_kernel_cpu, NULL);
+		bench_kernel_cpu(NULL, 0);
+		if (cpus > 1)
+			ddr_tool_mp_wait(0);
+		us = max(timer_get_us() - start, 1UL);
+		mbps = lldiv(bytes, us);
+		best = max(best, mbps);
+	}
+
+	return best;
+}
+
+/* Average load to use latency in ps over a random cycle of cache lines */
+static ulong bench_latency(void *buf, ulong size, u32 *perm)
+{
+	ulong lines = size / BENCH_LINE;
+	ulong i, j, start, us;
+	void **p;
+	u32 tmp;
+
+	/* Sattolo's algorithm gives a single cycle through all lines */
+	for (i = 0; i < lines; i++)
+		perm[i] = i;
+	for (i = lines - 1; i > 0; i--) {
+		j = rand() % i;
+		tmp = perm[i];
+		perm[i] = perm[j];
+		perm[j] = tmp;
+	}
+	for (i = 0; i < lines; i++)
+		*(void **)(buf + i * BENCH_LINE) = buf + perm[i] * BENCH_LINE;
+
+	/* One lap to warm up the caches and TLBs */
+	p = buf;
+	for (i = 0; i < lines; i++)
+		p = *p;
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_CHASE_STEPS; i += 8) {
+		p = *p;
+		p = *p;
+		p = *p;
+		p = *p;
+		p = *p;
+		p = *p;
+		p = *p;
+		p = *p;
+	}
+	us = timer_get_us() - start;
+	bench_sink = p;
+
+	return lldiv((u64)us * 1000000, BENCH_CHASE_STEPS);
+}
+
+static int bench_run(ulong array_mb)
+{
+	ulong start_adr[CONFIG_NR_DRAM_BANKS], length[CONFIG_NR_DRAM_BANKS];
+	ulong array_size = array_mb << 20;
+	char name[16];
+	ulong bw[2][BENCH_KERNELS];
+	int cpus, k;
+	void *base;
+	ulong i;
+
+	get_print_available_addr(start_adr, length, 0);
+	if (length[0] < max_t(ulong, 3 * array_size,
+				 BENCH_LAT_MAX + BENCH_LAT_MAX / 16)) {
+		printf("Not enough memory at 0x%lx for 3 x %lu MiB arrays\n",
+		       start_adr[0], array_mb);
+		return -ENOMEM;
+	}
+	base = (void *)start_adr[0];
+
+	cpus = ddr_tool_mp_init();
+	printf("DDR bench " __version__ ", 3 x %lu MiB arrays at 0x%lx, %d CPUs\n",
+	       array_mb, start_adr[0], cpus);
+
+	bench.n = array_size / sizeof(u64);
+	bench.a = base;
+	bench.b = base + array_size;
+	bench.c = base + 2 * array_size;
+	for (i = 0; i < bench.n; i++) {
+		bench.a[i] = 1;
+		bench.b[i] = 2;
+		bench.c[i] = 0;
+	}
+	flush_dcache_all();
+
+	bench_result_num = 0;
+	for (k = 0; k < BENCH_KERNELS; k++) {
+		bw[0][k] = bench_stream(k, 1);
+		bw[1][k] = cpus > 1 ? bench_stream(k, cpus) : bw[0][k];
+	}
+
+	printf("Function    1 CPU MB/s  %2d CPU MB/s\n", cpus);
+	for (k = 0; k < BENCH_KERNELS; k++) {
+		printf("%-10s %11lu %12lu\n", bench_kernels[k].name, bw[0][k],
+		       bw[1][k]);
+		bench_add_result(bench_kernels[k].name, bw[0][k], false);
+		snprintf(name, sizeof(name), "%s_mp", bench_kernels[k].name);
+		bench_add_result(name, bw[1][k], false);
+	}
+
+	printf("Working set  Latency\n");
+	for (i = 0; i < ARRAY_SIZE(bench_lat_sizes); i++) {
+		ulong size = bench_lat_sizes[i];
+		ulong ps;
+
+		ps = bench_latency(base, size, base + BENCH_LAT_MAX);
+		if (size >= SZ_1M)
+			snprintf(name, sizeof(name), "lat_%luM", size >> 20);
+		else
+			snprintf(name, sizeof(name), "lat_%luK", size >> 10);
+		printf("%7lu KiB %5lu.%lu ns\n", size >> 10, ps / 1000,
+		       ps % 1000 / 100);
+		bench_add_result(name, ps, true);
+	}
+
+	return 0;
+}
+
+/* name=value pairs separated by spaces, the same format as the baseline */
+static int bench_format(char *buf, int size)
+{
+	int i, len = 0;
+
+	for (i = 0; i < bench_result_num && len < size; i++)
+		len += snprintf(buf + len, size - len, "%s%s=%lu",
+				i ? " " : "", bench_results[i].name,
+				bench_results[i].val);
+
+	return len;
+}
+
+static bool bench_baseline_get(const char *baseline, const char *name,
+			       ulong *val)
+{
+	int len = strlen(name);
+	const char *p = baseline;
+
+	while ((p = strstr(p, name))) {
+		if ((p == baseline || p[-1] == ' ') && p[len] == '=') {
+			*val = simple_strtoul(p + len + 1, NULL, 10);
+			return true;
+		}
+		p += len;
+	}
+
+	return false;
+}
+
+/* Returns the number of results worse than the baseline by tolerance % */
+static int bench_check(const char *baseline, ulong tolerance)
+{
+	struct bench_result *r;
+	int i, fail = 0;
+	ulong base;
+	bool bad;
+
+	for (i = 0; i < bench_result_num; i++) {
+		r = &bench_results[i];
+		if (!bench_baseline_get(baseline, r->name, &base) || !base)
+			continue;
+		if (r->latency)
+			bad = r->val * 100 > base * (100 + tolerance);
+		else
+			bad = r->val * 100 < base * (100 - tolerance);
+		if (bad) {
+			printf("Regression: %s %lu, baseline %lu\n", r->name,
+			       r->val, base);
+			fail++;
+		}
+	}
+
+	return fail;
+}
+
+static int do_ddr_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	ulong array_mb = BENCH_ARRAY_MB;
+	ulong tolerance = BENCH_TOLERANCE;
+	const char *baseline = NULL;
+	char result[BENCH_RESULT_MAX * 24];
+	bool save = false;
+	int fail;
+
+	if (argc > 1 && !strcmp(argv[1], "save")) {
+		save = true;
+		argc--;
+		argv++;
+	} else if (argc > 1 && !strcmp(argv[1], "check")) {
+		baseline = env_get(BENCH_ENV);
+		if (!baseline) {
+			printf("No baseline, run 'ddr_bench save' first\n");
+			return CMD_RET_FAILURE;
+		}
+		if (argc > 2 && strict_strtoul(argv[2], 0, &tolerance) < 0)
+			return CMD_RET_USAGE;
+		if (tolerance >= 100)
+			return CMD_RET_USAGE;
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc > 1 && (strict_strtoul(argv[1], 0, &array_mb) < 0 ||
+			 !array_mb))
+		return CMD_RET_USAGE;
+
+	if (bench_run(array_mb))
+		return CMD_RET_FAILURE;
+
+	bench_format(result, sizeof(result));
+	if (save) {
+		env_set(BENCH_ENV, result);
+		printf("Baseline saved to '%s', run saveenv to keep it\n",
+		       BENCH_ENV);
+	}
+
+	fail = baseline ? bench_check(baseline, tolerance) : 0;
+	printf("DDR_BENCH_RESULT: result=%s %s\n", fail ? "FAIL" : "PASS",
+	       result);
+
+	return fail ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(ddr_bench, 4, 1, do_ddr_bench,
+	   "DDR bandwidth and latency benchmark",
+	   "[size]\n"
+	   "    - run the benchmark with 3 arrays of 'size' MiB (default 32)\n"
+	   "ddr_bench save [size]\n"
+	   "    - run and store the results in env '" BENCH_ENV "'\n"
+	   "ddr_bench check [tolerance [size]]\n"
+	   "    - run and fail if a result is worse than the baseline by\n"
+	   "      more than 'tolerance' percent (default 5)\n"
+	   "Bandwidth is in MB/s, latency in ps; the memory tested is\n"
+	   "overwritten.");
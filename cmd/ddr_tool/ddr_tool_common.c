@@ -4,7 +4,9 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <power/regulator.h>
+#include <asm/arch/rockchip_smccc.h>
 #include "ddr_tool_common.h"
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -159,3 +161,256 @@ int set_vdd_logic(u32 uv)
 	return ret;
 }
 
+ulong __sp;		/* set sp of secondary cpu */
+static ulong __gd;	/* set r9/x18 of secondary cpu to gd addr */
+
+u32 print_mutex;	/* 0: unlock, 1: lock */
+
+/*
+ * Secondary CPUs are brought up once and then poll for jobs: CPU0 bumps
+ * seq after setting fn/arg, each CPU runs fn and reports done_seq.
+ */
+static struct {
+	ddr_tool_mp_fn fn;
+	void *arg;
+	u32 seq;
+	u32 cpu_num;
+	u32 cpu_max;		/* CPUs listed, brought up or not */
+	ulong mpidr[DDR_TOOL_CPU_MAX];
+	bool init_finish[DDR_TOOL_CPU_MAX];
+	u32 done_seq[DDR_TOOL_CPU_MAX];
+} mp;
+
+static struct {
+	ulong addr;
+	ulong read;
+	ulong expect;
+} err_log[DDR_TOOL_ERR_MAX];
+static u32 err_num;
+
+static void ddr_tool_mp_flush(void)
+{
+	flush_dcache_range((ulong)&mp, (ulong)&mp + sizeof(mp));
+}
+
+#define MPIDR_MT	BIT(24)
+
+#ifdef CONFIG_ARM64
+#define MPIDR_HWID	0xff00ffffffUL	/* Aff3..Aff0 */
+
+static ulong ddr_tool_read_mpidr(void)
+{
+	ulong mpidr;
+
+	asm volatile("mrs %0, mpidr_el1" : "=r" (mpidr));
+
+	return mpidr;
+}
+#else
+#define MPIDR_HWID	0xffffffUL	/* Aff2..Aff0 */
+
+static ulong ddr_tool_read_mpidr(void)
+{
+	u32 mpidr;
+
+	asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r" (mpidr));
+
+	return mpidr;
+}
+#endif
+
+/*
+ * CPUs are numbered in the order of the /cpus node of the control FDT, with
+ * the boot CPU as CPU0. The affinity values of big.LITTLE parts like RK3399
+ * differ in Aff1 only, so the whole MPIDR is kept to tell CPUs apart.
+ * Without /cpus, CPUs are assumed to be numbered in Aff0, or in Aff1 for
+ * DynamIQ parts (RK3568/RK3588).
+ */
+static int ddr_tool_cpu_list(void)
+{
+	const void *blob = gd->fdt_blob;
+	ulong self = ddr_tool_read_mpidr();
+	const fdt32_t *reg;
+	const char *type;
+	int cpus, node, len, n;
+	ulong mpidr;
+
+	mp.mpidr[0] = self & MPIDR_HWID;
+	n = 1;
+
+	cpus = fdt_path_offset(blob, "/cpus");
+	if (cpus >= 0) {
+		fdt_for_each_subnode(node, blob, cpus) {
+			type = fdt_getprop(blob, node, "device_type", NULL);
+			reg = fdt_getprop(blob, node, "reg", &len);
+			if (!type || strcmp(type, "cpu") || !reg ||
+			    len < sizeof(*reg))
+				continue;
+			mpidr = fdt32_to_cpu(reg[len / sizeof(*reg) - 1]);
+			if (mpidr == mp.mpidr[0] || n == DDR_TOOL_CPU_MAX)
+				continue;
+			mp.mpidr[n++] = mpidr;
+		}
+	}
+	if (n > 1)
+		return n;
+
+	for (; n < DDR_TOOL_CPU_MAX; n++)
+		mp.mpidr[n] = self & MPIDR_MT ? n << 8 : n;
+
+	return n;
+}
+
+int ddr_tool_cpu_id(void)
+{
+	ulong mpidr = ddr_tool_read_mpidr() & MPIDR_HWID;
+	int i;
+
+	for (i = 0; i < mp.cpu_num; i++) {
+		if (mp.mpidr[i] == mpidr)
+			return i;
+	}
+
+	return -ENOENT;
+}
+
+void secondary_main(void)
+{
+	u32 seq = 0;
+	int cpu_id;
+
+#ifndef CONFIG_ARM64
+	asm volatile("mov r9, %0" : : "r" (__gd));	/* set r9 to gd addr */
+#else
+	asm volatile("mov x18, %0" : : "r" (__gd));	/* set x18 to gd addr */
+#endif
+	dcache_enable();
+	icache_enable();
+
+	udelay(100);
+
+	flush_dcache_all();
+
+	cpu_id = mp.cpu_num;
+	mp.init_finish[cpu_id] = 1;
+	ddr_tool_mp_flush();
+	printf("CPU%d start OK.\n", cpu_id);
+
+	while (1) {
+		udelay(10);
+		ddr_tool_mp_flush();
+		if (mp.seq == seq)
+			continue;
+
+		seq = mp.seq;
+		mp.fn(mp.arg, cpu_id);
+		mp.done_seq[cpu_id] = seq;
+		ddr_tool_mp_flush();
+	}
+}
+
+/* Bring up the secondary CPUs on first use, return the number of CPUs */
+int ddr_tool_mp_init(void)
+{
+	if (mp.cpu_num)
+		return mp.cpu_num;
+
+	mp.cpu_max = ddr_tool_cpu_list();
+	mp.cpu_num = 1;
+	print_mutex = 0;
+	if (!IS_ENABLED(CONFIG_CMD_DDR_TOOL_MP))
+		return mp.cpu_num;
+
+	asm volatile("clrex");
+	__gd = (ulong)gd;
+	asm volatile("mov %0, sp" : "=r" (__sp));
+	printf("CPU0 sp is at 0x%lx now.\n", __sp);
+	__sp &= ~(ulong)0xffff;
+	for (; mp.cpu_num < mp.cpu_max; mp.cpu_num++) {
+		__sp -= 0x10000;
+		flush_dcache_all();
+		if (psci_cpu_on(mp.mpidr[mp.cpu_num], (ulong)secondary_init))
+			break;
+		mdelay(10);
+		printf("Calling CPU%d, sp = 0x%lx\n", mp.cpu_num, __sp);
+		while (!mp.init_finish[mp.cpu_num]) {
+			udelay(1000);
+			ddr_tool_mp_flush();
+		}
+	}
+
+	return mp.cpu_num;
+}
+
+/* Run fn(arg, cpu) on every secondary CPU, CPU0 calls fn itself */
+void ddr_tool_mp_start(ddr_tool_mp_fn fn, void *arg)
+{
+	mp.fn = fn;
+	mp.arg = arg;
+	mp.seq++;
+	ddr_tool_mp_flush();
+}
+
+/* Returns the number of secondary CPUs still busy after timeout_ms (0: wait) */
+int ddr_tool_mp_wait(ulong timeout_ms)
+{
+	ulong start = get_timer(0);
+	int busy, i;
+
+	while (1) {
+		ddr_tool_mp_flush();
+		for (i = 1, busy = 0; i < mp.cpu_num; i++)
+			if (mp.done_seq[i] != mp.seq)
+				busy++;
+		if (!busy || (timeout_ms && get_timer(start) > timeout_ms))
+			break;
+		udelay(10);
+	}
+
+	return busy;
+}
+
+void ddr_tool_err_reset(void)
+{
+	err_num = 0;
+}
+
+/* Caller holds print_mutex when secondary CPUs are running */
+void ddr_tool_err_record(ulong addr, ulong read, ulong expect)
+{
+	if (err_num < DDR_TOOL_ERR_MAX) {
+		err_log[err_num].addr = addr;
+		err_log[err_num].read = read;
+		err_log[err_num].expect = expect;
+	}
+	err_num++;
+}
+
+u32 ddr_tool_err_count(void)
+{
+	return err_num;
+}
+
+/*
+ * One line summary for production test scripts, followed by the first
+ * DDR_TOOL_ERR_MAX error addresses:
+ * DDR_TOOL_RESULT: tool=<name> result=<PASS|FAIL> cpus=<n> start=<addr>
+ *		    size=<bytes> time_ms=<ms> mbps=<MB/s> errors=<n>
+ * DDR_TOOL_ERROR: addr=<addr> read=<val> expect=<val>
+ * mbps is bytes / time_us: DDR traffic for stressapptest, memory covered
+ * by each pattern for memtester.
+ */
+void ddr_tool_print_summary(const char *tool, bool pass, ulong start,
+			    ulong size, u64 bytes, u64 time_us)
+{
+	u32 i;
+
+	flush_dcache_range((ulong)err_log, (ulong)err_log + sizeof(err_log));
+	printf("DDR_TOOL_RESULT: tool=%s result=%s cpus=%u start=0x%lx size=0x%lx time_ms=%llu mbps=%llu errors=%u\n",
+	       tool, pass ? "PASS" : "FAIL", mp.cpu_num ? mp.cpu_num : 1,
+	       start, size, lldiv(time_us, 1000),
+	       lldiv(bytes, max_t(u64, time_us, 1)), err_num);
+	for (i = 0; i < min_t(u32, err_num, DDR_TOOL_ERR_MAX); i++)
+		printf("DDR_TOOL_ERROR: addr=0x%lx read=0x%lx expect=0x%lx\n",
+		       err_log[i].addr, err_log[i].read, err_log[i].expect);
+}
@@ -17,4 +17,26 @@ void print_memory(void *addr, ulong size);
 void get_print_available_addr(ulong *start_adr, ulong *length, int print_en);
 int judge_test_addr(ulong *arg, ulong *start_adr, ulong *length);
 int set_vdd_logic(u32 uv);
+
+#define DDR_TOOL_CPU_MAX		16
+/* error addresses kept for the summary */
+#define DDR_TOOL_ERR_MAX		16
+
+typedef void (*ddr_tool_mp_fn)(void *arg, int cpu);
+
+extern u32 print_mutex;	/* 0: unlock, 1: lock */
+
+void secondary_init(void);
+void lock_byte_mutex(u32 *flag);
+u32 unlock_byte_mutex(u32 *flag);
+
+int ddr_tool_cpu_id(void);
+int ddr_tool_mp_init(void);
+void ddr_tool_mp_start(ddr_tool_mp_fn fn, void *arg);
+int ddr_tool_mp_wait(ulong timeout_ms);
+void ddr_tool_err_reset(void);
+void ddr_tool_err_record(ulong addr, ulong read, ulong expect);
+u32 ddr_tool_err_count(void);
+void ddr_tool_print_summary(const char *tool, bool pass, ulong start,
+			    ulong size, u64 bytes, u64 time_us);
 #endif /* __CMD_DDR_TOOL_DDR_TOOL_COMMON_H */
@@ -53,6 +53,65 @@ struct test tests[] = {
 int use_phys;
 off_t physaddrbase;
 
+/* Per-CPU share of a test, in words, kept 4KiB aligned */
+#define MT_CPU_ALIGN		(0x1000 / sizeof(u32))
+
+static struct {
+	int test;
+	u32v *bufa;
+	u32v *bufb;
+	size_t count;
+	size_t share;
+	ul fix_bit;
+	ul fix_level;
+	int result[DDR_TOOL_CPU_MAX];
+} mt_job;
+
+static void memtester_cpu_test(void *arg, int cpu)
+{
+	size_t off = mt_job.share * cpu;
+	size_t count = mt_job.share;
+	int cpus = (ulong)arg;
+
+	if (cpu == cpus - 1)
+		count = mt_job.count - off;
+	mt_job.result[cpu] = tests[mt_job.test].fp(mt_job.bufa + off,
+						   mt_job.bufb + off, count,
+						   mt_job.fix_bit,
+						   mt_job.fix_level);
+	flush_dcache_range((ulong)&mt_job.result[cpu],
+			   (ulong)&mt_job.result[cpu + 1]);
+}
+
+/* Split the regions of one test into equal shares, one per CPU */
+static int memtester_run_test(int test, u32v *bufa, u32v *bufb, size_t count,
+			      ul fix_bit, ul fix_level, int cpus)
+{
+	int ret = 0;
+	int i;
+
+	mt_job.share = round_down(count / cpus, MT_CPU_ALIGN);
+	if (cpus < 2 || !mt_job.share)
+		return tests[test].fp(bufa, bufb, count, fix_bit, fix_level);
+
+	mt_job.test = test;
+	mt_job.bufa = bufa;
+	mt_job.bufb = bufb;
+	mt_job.count = count;
+	mt_job.fix_bit = fix_bit;
+	mt_job.fix_level = fix_level;
+	flush_dcache_range((ulong)&mt_job, (ulong)&mt_job + sizeof(mt_job));
+
+	ddr_tool_mp_start(memtester_cpu_test, (void *)(ulong)cpus);
+	memtester_cpu_test((void *)(ulong)cpus, 0);
+	ddr_tool_mp_wait(0);
+
+	for (i = 0; i < cpus; i++)
+		ret |= mt_job.result[i];
+
+	return ret;
+}
+
 /*
  * arg[0]: test start address
  * arg[1]: test length, unit: byte
@@ -71,6 +130,9 @@ int doing_memtester(ul *arg, ul testenable, ul loops, ul err_exit,
 	int exit_code = 0;
 	int abort = 0;
 	int test_banks;
+	ulong start_ms, size = 0;
+	u64 bytes = 0;
+	int cpus;
 
 	get_print_available_addr(start_adr, length, 0);
 
@@ -85,9 +147,14 @@ int doing_memtester(ul *arg, ul testenable, ul loops, ul err_exit,
 		bufa[i] = (u32v *)start_adr[i];
 		bufb[i] = (u32v *)(start_adr[i] + length[i] / 2);
 		count[i] = length[i] / 2 / sizeof(u32);
+		if (i < test_banks)
+			size += count[i] * 2 * sizeof(u32);
 	}
 
 	data_cpu_2_io_init();
+	cpus = ddr_tool_mp_init();
+	ddr_tool_err_reset();
+	start_ms = get_timer(0);
 
 	for (loop = 1; ((!loops) || loop <= loops); loop++) {
 		for (j = 0; j < test_banks; j++) {
@@ -116,8 +183,9 @@ int doing_memtester(ul *arg, ul testenable, ul loops, ul err_exit,
 				if (testenable && (!((1 << i) & testenable)))
 					continue;
 				printf("  %-20s: ", tests[i].name);
-				if (!tests[i].fp(bufa[j], bufb[j], count[j],
-						 fix_bit, fix_level)) {
+				if (!memtester_run_test(i, bufa[j], bufb[j],
+							count[j], fix_bit,
+							fix_level, cpus)) {
 					printf("ok\n");
 				} else {
 					exit_code |= EXIT_FAIL_OTHERTEST;
@@ -125,6 +193,7 @@ int doing_memtester(ul *arg, ul testenable, ul loops, ul err_exit,
 						goto out;
 					}
 				}
+				bytes += (u64)count[j] * 2 * sizeof(u32);
 				if (ctrlc()) {
 					abort = 1;
 					break;
@@ -145,6 +214,8 @@ out:
 		printf("Fail: EXIT_FAIL_ADDRESSLINES\n");
 	if (exit_code & EXIT_FAIL_OTHERTEST)
 		printf("Fail: EXIT_FAIL_OTHERTEST\n");
+	ddr_tool_print_summary("memtester", !exit_code, (ul)bufa[0], size,
+			       bytes, (u64)get_timer(start_ms) * 1000);
 
 	if (exit_code)
 		return -1;
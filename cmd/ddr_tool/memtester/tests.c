@@ -17,6 +17,7 @@
 #include "memtester.h"
 #include "sizes.h"
 #include "types.h"
+#include "../ddr_tool_common.h"
 #include "../io_map.h"
 
 union {
@@ -36,17 +37,63 @@ char progress[] = "-\\|/";
 
 #define fflush(n)
 
+/* Only the boot CPU draws progress, the others test their share quietly */
+#define progress_printf(fmt, args...)				\
+	do {							\
+		if (!ddr_tool_cpu_id())				\
+			printf(fmt, ##args);			\
+	} while (0)
+#define progress_putc(c)					\
+	do {							\
+		if (!ddr_tool_cpu_id())				\
+			putc(c);				\
+	} while (0)
+
+/* 4-word pattern in one NEON register on arm64, two ldp/stp otherwise */
+typedef u32 u32x4 __attribute__((vector_size(16)));
+
+static void fill_regions(u32v *bufa, u32v *bufb, const u32 *data,
+			 size_t count)
+{
+	volatile u32x4 *p1 = (volatile u32x4 *)bufa;
+	volatile u32x4 *p2 = (volatile u32x4 *)bufb;
+	u32x4 v = { data[0], data[1], data[2], data[3] };
+	size_t i;
+
+	for (i = 0; i < count / 4; i++) {
+		p1[i] = v;
+		p2[i] = v;
+	}
+	for (i = count & ~3; i < count; i++)
+		bufa[i] = bufb[i] = data[i & 3];
+}
+
 /* Function definitions. */
 int compare_regions(u32v *bufa, u32v *bufb, size_t count)
 {
+	volatile u32x4 *v1 = (volatile u32x4 *)bufa;
+	volatile u32x4 *v2 = (volatile u32x4 *)bufb;
+	u32x4 diff;
 	int r = 0;
 	size_t i;
 	u32v *p1 = bufa;
 	u32v *p2 = bufb;
 	off_t physaddr;
 
-	for (i = 0; i < count; i++, p1++, p2++) {
+	/* Compare 16 bytes at a time, go word by word from the first miss */
+	for (i = 0; i < count / 4; i++) {
+		diff = v1[i] ^ v2[i];
+		if (diff[0] | diff[1] | diff[2] | diff[3])
+			break;
+	}
+	i *= 4;
+	p1 += i;
+	p2 += i;
+
+	for (; i < count; i++, p1++, p2++) {
 		if (*p1 != *p2) {
+			lock_byte_mutex(&print_mutex);
+			ddr_tool_err_record((ul)p1, *p1, *p2);
 			if (use_phys) {
 				physaddr = physaddrbase + (i * sizeof(u32v));
 				fprintf(stderr,
@@ -59,6 +106,7 @@ int compare_regions(u32v *bufa, u32v *bufb, size_t count)
 					(ul)*p1, (ul)*p2,
 					(ul)(i * sizeof(u32v)));
 			}
+			unlock_byte_mutex(&print_mutex);
 			/* printf("Skipping to next test..."); */
 			r = -1;
 		}
@@ -73,19 +121,19 @@ int test_stuck_address(u32v *bufa, size_t count)
 	size_t i;
 	off_t physaddr;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < 16; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
 		p1 = (u32v *)bufa;
-		printf("setting %3u", j);
+		progress_printf("setting %3u", j);
 		fflush(stdout);
 		for (i = 0; i < count; i++) {
 			*p1 = ((j + i) % 2) == 0 ? (u32)(ul)p1 : ~((u32)(ul)p1);
 			*p1++;
 		}
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		p1 = (u32v *)bufa;
 		for (i = 0; i < count; i++, p1++) {
@@ -109,7 +157,7 @@ int test_stuck_address(u32v *bufa, size_t count)
 			}
 		}
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -122,17 +170,17 @@ int test_random_value(u32v *bufa, u32v *bufb, size_t count,
 	ul j = 0;
 	size_t i;
 
-	putc(' ');
+	progress_putc(' ');
 	fflush(stdout);
 	for (i = 0; i < count; i++) {
 		*p1++ = *p2++ = rand_ul();
 		if (!(i % PROGRESSOFTEN)) {
-			putc('\b');
-			putc(progress[++j % PROGRESSLEN]);
+			progress_putc('\b');
+			progress_putc(progress[++j % PROGRESSLEN]);
 			fflush(stdout);
 		}
 	}
-	printf("\b \b");
+	progress_printf("\b \b");
 	fflush(stdout);
 	return compare_regions(bufa, bufb, count);
 }
@@ -246,17 +294,14 @@ int test_seqinc_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_solidbits_comparison(u32v *bufa, u32v *bufb, size_t count,
 			      ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j;
 	u32 q;
 	u32 data[4];
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < 64; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
 		q = (j % 2) == 0 ? UL_ONEBITS : 0;
 		if (fix_level)
 			q |= fix_bit;
@@ -265,19 +310,16 @@ int test_solidbits_comparison(u32v *bufa, u32v *bufb, size_t count,
 		data[0] = data[2] = q;
 		data[1] = data[3] = ~q;
 		data_cpu_2_io(data, sizeof(data));
-		printf("setting %3u", j);
+		progress_printf("setting %3u", j);
 		fflush(stdout);
-		p1 = (u32v *)bufa;
-		p2 = (u32v *)bufb;
-		for (i = 0; i < count; i++)
-			*p1++ = *p2++ = data[i & 3];
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		fill_regions(bufa, bufb, data, count);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -285,17 +327,14 @@ int test_solidbits_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_checkerboard_comparison(u32v *bufa, u32v *bufb, size_t count,
 				 ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j;
 	u32 q;
 	u32 data[4];
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < 64; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
 		q = (j % 2) == 0 ? CHECKERBOARD1 : CHECKERBOARD2;
 		if (fix_level)
 			q |= fix_bit;
@@ -305,19 +344,16 @@ int test_checkerboard_comparison(u32v *bufa, u32v *bufb, size_t count,
 		data[0] = data[2] = q;
 		data[1] = data[3] = ~q;
 		data_cpu_2_io(data, sizeof(data));
-		printf("setting %3u", j);
+		progress_printf("setting %3u", j);
 		fflush(stdout);
-		p1 = (u32v *)bufa;
-		p2 = (u32v *)bufb;
-		for (i = 0; i < count; i++)
-			*p1++ = *p2++ = data[i & 3];
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		fill_regions(bufa, bufb, data, count);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -325,20 +361,15 @@ int test_checkerboard_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_blockseq_comparison(u32v *bufa, u32v *bufb, size_t count,
 			     ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j;
 	u32 data[4];
 	u32 q;
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < 256; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		p1 = (u32v *)bufa;
-		p2 = (u32v *)bufb;
-		printf("setting %3u", j);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("setting %3u", j);
 		fflush(stdout);
 		q = (u32)UL_BYTE(j);
 		if (fix_level)
@@ -353,15 +384,14 @@ int test_blockseq_comparison(u32v *bufa, u32v *bufb, size_t count,
 
 		data_cpu_2_io(data, sizeof(data));
 
-		for (i = 0; i < count; i++)
-			*p1++ = *p2++ = data[i & 3];
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		fill_regions(bufa, bufb, data, count);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -369,20 +399,15 @@ int test_blockseq_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_walkbits0_comparison(u32v *bufa, u32v *bufb, size_t count,
 			      ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j;
 	u32 data[4];
 	u32 q;
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < UL_LEN * 2; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		p1 = (u32v *)bufa;
-		p2 = (u32v *)bufb;
-		printf("setting %3u", j);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("setting %3u", j);
 		fflush(stdout);
 		if (j < UL_LEN)
 			q = ONE << j;
@@ -400,16 +425,14 @@ int test_walkbits0_comparison(u32v *bufa, u32v *bufb, size_t count,
 		data[3] = q;
 		data_cpu_2_io(data, sizeof(data));
 
-		for (i = 0; i < count; i++) {
-				*p1++ = *p2++ = data[i & 3];
-		}
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		fill_regions(bufa, bufb, data, count);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -417,20 +440,15 @@ int test_walkbits0_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_walkbits1_comparison(u32v *bufa, u32v *bufb, size_t count,
 			      ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j;
 	u32 data[4];
 	u32 q;
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < UL_LEN * 2; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		p1 = (u32v *)bufa;
-		p2 = (u32v *)bufb;
-		printf("setting %3u", j);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("setting %3u", j);
 		fflush(stdout);
 		if (j < UL_LEN)
 			q = UL_ONEBITS ^ (ONE << j);
@@ -447,16 +465,14 @@ int test_walkbits1_comparison(u32v *bufa, u32v *bufb, size_t count,
 		data[3] = q;
 		data_cpu_2_io(data, sizeof(data));
 
-		for (i = 0; i < count; i++) {
-				*p1++ = *p2++ = data[i & 3];
-		}
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		fill_regions(bufa, bufb, data, count);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -464,19 +480,14 @@ int test_walkbits1_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_bitspread_comparison(u32v *bufa, u32v *bufb, size_t count,
 			      ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j;
 	u32 data[4];
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (j = 0; j < UL_LEN * 2; j++) {
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		p1 = (u32v *)bufa;
-		p2 = (u32v *)bufb;
-		printf("setting %3u", j);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("setting %3u", j);
 		fflush(stdout);
 		if (j < UL_LEN) {
 			data[0] = (ONE << j) | (ONE << (j + 2));
@@ -498,16 +509,14 @@ int test_bitspread_comparison(u32v *bufa, u32v *bufb, size_t count,
 		data[3] = data[1];
 		data_cpu_2_io(data, sizeof(data));
 
-		for (i = 0; i < count; i++) {
-			*p1++ = *p2++ = data[i & 3];
-		}
-		printf("\b\b\b\b\b\b\b\b\b\b\b");
-		printf("testing %3u", j);
+		fill_regions(bufa, bufb, data, count);
+		progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+		progress_printf("testing %3u", j);
 		fflush(stdout);
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -515,21 +524,18 @@ int test_bitspread_comparison(u32v *bufa, u32v *bufb, size_t count,
 int test_bitflip_comparison(u32v *bufa, u32v *bufb, size_t count,
 			    ul fix_bit, ul fix_level)
 {
-	u32v *p1 = bufa;
-	u32v *p2 = bufb;
 	unsigned int j, k;
 	u32 q;
 	u32 data[4];
-	size_t i;
 
-	printf("           ");
+	progress_printf("           ");
 	fflush(stdout);
 	for (k = 0; k < UL_LEN; k++) {
 		q = ONE << k;
 		for (j = 0; j < 8; j++) {
-			printf("\b\b\b\b\b\b\b\b\b\b\b");
+			progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
 			q = ~q;
-			printf("setting %3u", k * 8 + j);
+			progress_printf("setting %3u", k * 8 + j);
 			fflush(stdout);
 			if (fix_level)
 				q |= fix_bit;
@@ -539,18 +545,15 @@ int test_bitflip_comparison(u32v *bufa, u32v *bufb, size_t count,
 			data[0] = data[2] = q;
 			data[1] = data[3] = ~q;
 			data_cpu_2_io(data, sizeof(data));
-			p1 = (u32v *)bufa;
-			p2 = (u32v *)bufb;
-			for (i = 0; i < count; i++)
-				*p1++ = *p2++ = data[i & 3];
-			printf("\b\b\b\b\b\b\b\b\b\b\b");
-			printf("testing %3u", k * 8 + j);
+			fill_regions(bufa, bufb, data, count);
+			progress_printf("\b\b\b\b\b\b\b\b\b\b\b");
+			progress_printf("testing %3u", k * 8 + j);
 			fflush(stdout);
 			if (compare_regions(bufa, bufb, count))
 				return -1;
 		}
 	}
-	printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
+	progress_printf("\b\b\b\b\b\b\b\b\b\b\b           \b\b\b\b\b\b\b\b\b\b\b");
 	fflush(stdout);
 	return 0;
 }
@@ -565,7 +568,7 @@ int test_8bit_wide_random(u32v *bufa, u32v *bufb, size_t count,
 	unsigned int b, j = 0;
 	size_t i;
 
-	putc(' ');
+	progress_putc(' ');
 	fflush(stdout);
 	for (attempt = 0; attempt < 2; attempt++) {
 		if (attempt & 1) {
@@ -581,15 +584,15 @@ int test_8bit_wide_random(u32v *bufa, u32v *bufb, size_t count,
 			for (b = 0; b < UL_LEN / 8; b++)
 				*p1++ = *t++;
 			if (!(i % PROGRESSOFTEN)) {
-				putc('\b');
-				putc(progress[++j % PROGRESSLEN]);
+				progress_putc('\b');
+				progress_putc(progress[++j % PROGRESSLEN]);
 				fflush(stdout);
 			}
 		}
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b \b");
+	progress_printf("\b \b");
 	fflush(stdout);
 	return 0;
 }
@@ -603,7 +606,7 @@ int test_16bit_wide_random(u32v *bufa, u32v *bufb, size_t count,
 	unsigned int b, j = 0;
 	size_t i;
 
-	putc(' ');
+	progress_putc(' ');
 	fflush(stdout);
 	for (attempt = 0; attempt < 2; attempt++) {
 		if (attempt & 1) {
@@ -619,15 +622,15 @@ int test_16bit_wide_random(u32v *bufa, u32v *bufb, size_t count,
 			for (b = 0; b < UL_LEN / 16; b++)
 				*p1++ = *t++;
 			if (!(i % PROGRESSOFTEN)) {
-				putc('\b');
-				putc(progress[++j % PROGRESSLEN]);
+				progress_putc('\b');
+				progress_putc(progress[++j % PROGRESSLEN]);
 				fflush(stdout);
 			}
 		}
 		if (compare_regions(bufa, bufb, count))
 			return -1;
 	}
-	printf("\b \b");
+	progress_printf("\b \b");
 	fflush(stdout);
 	return 0;
 }
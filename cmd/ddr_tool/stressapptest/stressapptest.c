@@ -20,7 +20,6 @@
 #include <amp.h>
 #include <div64.h>
 #include <malloc.h>
-#include <asm/arch/rockchip_smccc.h>
 #include "stressapptest.h"
 #include "../ddr_tool_common.h"
 
@@ -34,7 +33,7 @@
 #define PAT_NUM			26
 #define PATTERN_LIST_SIZE	(PAT_NUM * 2 * 4)
 
-#define CPU_NUM_MAX		16
+#define CPU_NUM_MAX		DDR_TOOL_CPU_MAX
 
 static u32 walking_1_data[] = {
 	0x00000001, 0x00000002, 0x00000004, 0x00000008,
@@ -414,22 +413,12 @@ static struct pat *pat_array[] = {
 
 static u32 cpu_copy_err[CPU_NUM_MAX];
 static u32 cpu_inv_err[CPU_NUM_MAX];
+/* bytes read plus written, for the bandwidth in the summary */
+static u64 cpu_bytes[CPU_NUM_MAX];
 
 static u64 start_time_us;
 static u64 test_time_us;
 
-static bool cpu_init_finish[CPU_NUM_MAX];
-static bool cpu_test_finish[CPU_NUM_MAX];
-static bool pattern_page_init_finish;
-
-#if (CPU_NUM_MAX > 1)
-static ulong test_count = 0;
-static ulong __gd;	/* set r9/x18 of secondary cpu to gd addr */
-#endif
-ulong __sp;		/* set sp of secondary cpu */
-
-u32 print_mutex;	/* 0: unlock, 1: lock */
-
 static u64 get_time_us(void)
 {
 	return lldiv(get_ticks(), CONFIG_SYS_HZ_CLOCK / (CONFIG_SYS_HZ * 1000));
@@ -598,6 +587,22 @@ static void page_init_empty(struct page *page)
 	page->valid = 0;
 }
 
+static struct pattern *page_init_patterns;
+
+static void page_init_cpu(void *arg, int cpu)
+{
+	struct stressapptest_params *sat = arg;
+	int i;
+
+	for (i = cpu; i < sat->page_num; i += sat->cpu_num) {
+		if (page_list[i].valid == 1)
+			page_init_valid(&page_list[i], page_init_patterns, sat);
+		else
+			page_init_empty(&page_list[i]);
+	}
+	flush_dcache_all();
+}
+
 static void page_init(struct pattern *pattern_list,
 		      struct stressapptest_params *sat)
 {
@@ -631,12 +636,11 @@ static void page_init(struct pattern *pattern_list,
 		}
 	}
 
-	for (i = 0; i < sat->page_num; i++) {
-		if (page_list[i].valid == 1)
-			page_init_valid(&page_list[i], pattern_list, sat);
-		else
-			page_init_empty(&page_list[i]);
-	}
+	/* Each CPU fills the pages it is going to test */
+	page_init_patterns = pattern_list;
+	ddr_tool_mp_start(page_init_cpu, sat);
+	page_init_cpu(sat, 0);
+	ddr_tool_mp_wait(0);
 	flush_dcache_all();
 }
 
@@ -705,6 +709,7 @@ static u32 block_mis_search(void *dst_addr, struct pattern *src_pattern, char *i
 				       *(print_addr + j + 4), *(print_addr + j + 5),
 				       *(print_addr + j + 6), *(print_addr + j + 7));
 
+			ddr_tool_err_record((ulong)&dst_mem[i], read, expected);
 			unlock_byte_mutex(&print_mutex);
 
 			/* fix the error */
@@ -955,65 +960,45 @@ static u32 page_copy(struct stressapptest_params *sat, u8 cpu_id)
 	return err;
 }
 
-void secondary_main(void)
+/* Copy/invert pages until the test time is up, CPU0 also reports progress */
+static void sat_cpu_test(void *arg, int cpu)
 {
-#if (CPU_NUM_MAX > 1)
-	u8 cpu_id;
-	ulong test = 0;
-
-#ifndef CONFIG_ARM64
-	asm volatile("mov r9, %0" : : "r" (__gd));	/* set r9 to gd addr */
-#else
-	asm volatile("mov x18, %0" : : "r" (__gd));	/* set x18 to gd addr */
-#endif
-	dcache_enable();
-	icache_enable();
+	struct stressapptest_params *sat = arg;
+	u32 pre_10s, now_10s;
 
-	udelay(100);
-
-	flush_dcache_all();
-
-	cpu_id = sat.cpu_num;
-	cpu_init_finish[cpu_id] = 1;
-	printf("CPU%d start OK.\n", cpu_id);
+	pre_10s = (u32)(run_time_us() / 1000000 / 10);
+	while (run_time_us() < test_time_us) {
+		if (rand() % 2 == 0) {
+			cpu_copy_err[cpu] += page_copy(sat, cpu);
+			cpu_bytes[cpu] += 2 * sat->page_size_byte;
+		} else {
+			cpu_inv_err[cpu] += page_inv(sat, cpu);
+			/* four read/write passes and the check */
+			cpu_bytes[cpu] += 9 * sat->page_size_byte;
+		}
 
-	while (pattern_page_init_finish == 0) {
-		udelay(100);
-		flush_dcache_all();
-	}
+		if (cpu)
+			continue;
 
-	while (1) {
-		udelay(100);
-		flush_dcache_all();
-		while (test < test_count) {
-			cpu_test_finish[cpu_id] = 0;
-			flush_dcache_all();
-			while (run_time_us() < test_time_us) {
-				if (rand() % 2 == 0)
-					cpu_copy_err[cpu_id] += page_copy(&sat, cpu_id);
-				else
-					cpu_inv_err[cpu_id] += page_inv(&sat, cpu_id);
-			}
-			test++;
-			cpu_test_finish[cpu_id] = 1;
-			flush_dcache_range((ulong)&cpu_test_finish[cpu_id],
-					   (ulong)&cpu_test_finish[cpu_id + 1]);
-			flush_dcache_range((ulong)&cpu_copy_err[cpu_id],
-					   (ulong)&cpu_copy_err[cpu_id + 1]);
-			flush_dcache_range((ulong)&cpu_inv_err[cpu_id],
-					   (ulong)&cpu_inv_err[cpu_id + 1]);
+		/* Print every 10 seconds */
+		now_10s = (u32)(run_time_us() / 1000000 / 10);
+		if (now_10s > pre_10s) {
+			pre_10s = now_10s;
+			lock_byte_mutex(&print_mutex);
+			print_time_stamp();
+			printf("Seconds remaining: %d\n", (u32)(test_time_us / 1000000 - now_10s * 10));
+			unlock_byte_mutex(&print_mutex);
 		}
 	}
-#else
-	return;
-#endif
+
+	flush_dcache_range((ulong)&cpu_copy_err[cpu], (ulong)&cpu_copy_err[cpu + 1]);
+	flush_dcache_range((ulong)&cpu_inv_err[cpu], (ulong)&cpu_inv_err[cpu + 1]);
+	flush_dcache_range((ulong)&cpu_bytes[cpu], (ulong)&cpu_bytes[cpu + 1]);
 }
 
 static int doing_stressapptest(void)
 {
 	int i;
-	u32 pre_10s;
-	u32 now_10s;
 
 	struct pattern pattern_list[PATTERN_LIST_SIZE];
 	void *page_info;
@@ -1021,43 +1006,19 @@ static int doing_stressapptest(void)
 	u32 all_copy_err = 0;
 	u32 all_inv_err = 0;
 	u32 cpu_no_response_err = 0;
+	u64 all_bytes = 0;
+	bool pass;
 
 	int ret = CMD_RET_SUCCESS;
 
 	for (i = 0; i < CPU_NUM_MAX; i++) {
 		cpu_copy_err[i] = 0;
 		cpu_inv_err[i] = 0;
-		cpu_init_finish[i] = 0;
-		cpu_test_finish[i] = 0;
-	}
-	pattern_page_init_finish = 0;
-	print_mutex = 0;
-	asm volatile("clrex");
-
-#if (CPU_NUM_MAX > 1)
-	if (test_count == 0) {
-		__gd = (ulong)gd;
-		asm volatile("mov %0, sp" : "=r" (__sp));
-		printf("CPU0 sp is at 0x%lx now.\n", __sp);
-		__sp &= ~(ulong)0xffff;
-		for (sat.cpu_num = 1; sat.cpu_num < CPU_NUM_MAX; sat.cpu_num++) {
-			__sp -= 0x10000;
-			flush_dcache_all();
-			if (psci_cpu_on(sat.cpu_num, (ulong)secondary_init) == 0) {
-				mdelay(10);
-				printf("Calling CPU%d, sp = 0x%lx\n", sat.cpu_num, __sp);
-			} else {
-				break;
-			}
-			while (cpu_init_finish[sat.cpu_num] == 0) {
-				udelay(1000);
-				flush_dcache_all();
-			}
-		}
+		cpu_bytes[i] = 0;
 	}
-#else
-	sat.cpu_num = 1;
-#endif
+	ddr_tool_err_reset();
+
+	sat.cpu_num = ddr_tool_mp_init();
 
 	if (sat.total_test_size_mb == 0)
 		sat.page_num = get_max_page_num(sat.page_size_byte);
@@ -1084,68 +1045,42 @@ static int doing_stressapptest(void)
 	pattern_list_init(pattern_list, &sat);
 	page_init(pattern_list, &sat);
 
-#if (CPU_NUM_MAX > 1)
-	if (sat.cpu_num > 1) {
-		pattern_page_init_finish = 1;
-		test_count++;
-		flush_dcache_all();
-	}
-#endif
-
-	pre_10s = (u32)(run_time_us() / 1000000 / 10);
 	lock_byte_mutex(&print_mutex);
 	print_time_stamp();
 	printf("Start StressAppTest in U-Boot:\n");
 	unlock_byte_mutex(&print_mutex);
 
-	while (run_time_us() < test_time_us) {
-		if (rand() % 2 == 0)
-			cpu_copy_err[0] += page_copy(&sat, 0);
-		else
-			cpu_inv_err[0] += page_inv(&sat, 0);
+	ddr_tool_mp_start(sat_cpu_test, &sat);
+	sat_cpu_test(&sat, 0);
 
-		/* Print every 10 seconds */
-		now_10s = (u32)(run_time_us() / 1000000 / 10);
-		if (now_10s > pre_10s) {
-			pre_10s = now_10s;
-			lock_byte_mutex(&print_mutex);
-			print_time_stamp();
-			printf("Seconds remaining: %d\n", (u32)(test_time_us / 1000000 - now_10s * 10));
-			unlock_byte_mutex(&print_mutex);
-		}
-	}
-
-#if (CPU_NUM_MAX > 1)
-	for (i = 1; i < sat.cpu_num; i++) {
-		while (cpu_test_finish[i] == 0) {
-			if ((u32)(run_time_us() / 1000000 / 10) > pre_10s + 6) {
-				/* wait for secondary CPU in 60s */
-				lock_byte_mutex(&print_mutex);
-				print_time_stamp();
-				printf("ERROR: Cannot wait for CPU%d to finish!\n", i);
-				unlock_byte_mutex(&print_mutex);
-				cpu_no_response_err++;
-				break;
-			}
-			mdelay(1);
-			flush_dcache_range((ulong)&cpu_test_finish[i],
-					   (ulong)&cpu_test_finish[i + 1]);
-		}
+	/* wait for secondary CPU in 60s */
+	cpu_no_response_err = ddr_tool_mp_wait(60000);
+	if (cpu_no_response_err) {
+		lock_byte_mutex(&print_mutex);
+		print_time_stamp();
+		printf("ERROR: Cannot wait for %d CPUs to finish!\n",
+		       cpu_no_response_err);
+		unlock_byte_mutex(&print_mutex);
 	}
 	flush_dcache_all();
-#endif
 
 	for (i = 0; i < sat.cpu_num; i++) {
 		all_copy_err += cpu_copy_err[i];
 		all_inv_err += cpu_inv_err[i];
+		all_bytes += cpu_bytes[i];
 	}
+	pass = all_copy_err == 0 && all_inv_err == 0 && cpu_no_response_err == 0;
 	print_time_stamp();
 	printf("StressAppTest Result: ");
-	if (all_copy_err == 0 && all_inv_err == 0 && cpu_no_response_err == 0)
+	if (pass)
 		printf("Pass.\n");
 	else
 		printf("FAIL!\nStressAppTest detects %d copy errors, %d inv errors.\n",
 		       all_copy_err, all_inv_err);
+	ddr_tool_print_summary("stressapptest", pass,
+			       (ulong)page_list[0].base_addr,
+			       sat.page_size_byte * sat.page_num, all_bytes,
+			       run_time_us());
 
 out:
 	free(page_info);
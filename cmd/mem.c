@@ -19,10 +19,13 @@
 #include <console.h>
 #include <hash.h>
 #include <inttypes.h>
+#include <malloc.h>
 #include <mapmem.h>
+#include <slab.h>
 #include <watchdog.h>
 #include <asm/io.h>
 #include <linux/compiler.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1187,6 +1190,147 @@ static int do_mem_info(cmd_tbl_t *cmdtp, int flag, int argc,
 }
 #endif
 
+#ifdef CONFIG_CMD_MEM_BENCH
+#define MEM_BENCH_SIZE		SZ_1M
+#define MEM_BENCH_TOTAL		SZ_64M
+#define MEM_BENCH_PAD		128
+
+enum {
+	MEM_BENCH_MEMCPY,
+	MEM_BENCH_MEMMOVE,
+	MEM_BENCH_MEMSET,
+	MEM_BENCH_MEMCMP,
+};
+
+struct mem_bench_case {
+	const char *name;
+	int op;
+	int dst_off;
+	int src_off;
+	int val;
+};
+
+/* memmove cases overlap, with dst above src so the copy runs backwards */
+static const struct mem_bench_case mem_bench_cases[] = {
+	{ "memcpy",  MEM_BENCH_MEMCPY,	0,  0 },
+	{ "memcpy",  MEM_BENCH_MEMCPY,	1,  3 },
+	{ "memmove", MEM_BENCH_MEMMOVE,	64, 0 },
+	{ "memmove", MEM_BENCH_MEMMOVE,	67, 2 },
+	{ "memset",  MEM_BENCH_MEMSET,	0,  0, 0 },
+	{ "memset",  MEM_BENCH_MEMSET,	0,  0, 0x5a },
+	{ "memset",  MEM_BENCH_MEMSET,	5,  0, 0x5a },
+	{ "memcmp",  MEM_BENCH_MEMCMP,	0,  0 },
+	{ "memcmp",  MEM_BENCH_MEMCMP,	1,  3 },
+};
+
+/* Returns the elapsed time in us, or 0 if memcmp() saw a difference */
+static ulong mem_bench_run(const struct mem_bench_case *bc, u8 *buf,
+			   ulong size, ulong loops)
+{
+	u8 *src = buf + bc->src_off;
+	u8 *dst = buf + size + MEM_BENCH_PAD + bc->dst_off;
+	ulong start, i;
+
+	if (bc->op == MEM_BENCH_MEMMOVE)
+		dst = buf + bc->dst_off;
+	else if (bc->op == MEM_BENCH_MEMCMP)
+		memcpy(dst, src, size);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		switch (bc->op) {
+		case MEM_BENCH_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case MEM_BENCH_MEMMOVE:
+			memmove(dst, src, size);
+			break;
+		case MEM_BENCH_MEMSET:
+			memset(dst, bc->val, size);
+			break;
+		case MEM_BENCH_MEMCMP:
+			if (memcmp(dst, src, size))
+				return 0;
+			break;
+		}
+	}
+
+	return max(timer_get_us() - start, 1UL);
+}
+
+static int do_mem_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	const struct mem_bench_case *bc;
+	ulong size = MEM_BENCH_SIZE;
+	ulong loops, us, rate;
+	u8 *buf;
+	int i;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+	if (argc > 1)
+		size = simple_strtoul(argv[1], NULL, 16);
+	if (!size)
+		return CMD_RET_USAGE;
+
+	buf = memalign(ARCH_DMA_MINALIGN, 2 * (size + MEM_BENCH_PAD));
+	if (!buf) {
+		printf("Can't allocate 2 x 0x%lx bytes\n", size);
+		return CMD_RET_FAILURE;
+	}
+	memset(buf, 0xa5, 2 * (size + MEM_BENCH_PAD));
+
+	loops = max(MEM_BENCH_TOTAL / size, 1UL);
+	printf("size 0x%lx, %lu loops, memcpy %s, memset %s\n", size, loops,
+	       CONFIG_IS_ENABLED(USE_ARCH_MEMCPY) ? "arch" : "generic",
+	       CONFIG_IS_ENABLED(USE_ARCH_MEMSET) ? "arch" : "generic");
+
+	for (i = 0; i < ARRAY_SIZE(mem_bench_cases); i++) {
+		bc = &mem_bench_cases[i];
+		us = mem_bench_run(bc, buf, size, loops);
+		if (!us) {
+			printf("%s: mismatch\n", bc->name);
+			free(buf);
+			return CMD_RET_FAILURE;
+		}
+
+		/* bytes per us is MB/s */
+		rate = size * loops / us;
+		printf("%-8s dst+%-3d src+%-3d", bc->name, bc->dst_off,
+		       bc->src_off);
+		if (bc->op == MEM_BENCH_MEMSET)
+			printf(" 0x%02x", bc->val);
+		else
+			printf("     ");
+		printf(" %3lu.%02lu GB/s\n", rate / 1000, rate % 1000 / 10);
+		if (ctrlc())
+			break;
+	}
+	free(buf);
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_mem_sub[] = {
+	U_BOOT_CMD_MKENT(bench, 2, 1, do_mem_bench, "", ""),
+};
+
+static int do_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *cp;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	cp = find_cmd_tbl(argv[1], cmd_mem_sub, ARRAY_SIZE(cmd_mem_sub));
+	if (!cp)
+		return CMD_RET_USAGE;
+
+	return cp->cmd(cmdtp, flag, argc - 1, argv + 1);
+}
+#endif
+
 U_BOOT_CMD(
 	base,	2,	1,	do_mem_base,
 	"print or set address offset",
@@ -1253,3 +1397,33 @@ U_BOOT_CMD(
 	""
 );
 #endif
+
+#ifdef CONFIG_CMD_MALLOC
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	if (argc != 2 || strcmp(argv[1], "stats"))
+		return CMD_RET_USAGE;
+
+	malloc_stats();
+	slab_stats();
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	malloc,	2,	1,	do_malloc,
+	"malloc statistics",
+	"stats - show call counts, peak usage, fragmentation, the top\n"
+	"    allocating call sites and the slab caches"
+);
+#endif
+
+#ifdef CONFIG_CMD_MEM_BENCH
+U_BOOT_CMD(
+	mem,	3,	1,	do_mem,
+	"memory utilities",
+	"bench [size] - measure memcpy/memmove/memset/memcmp throughput\n"
+	"    on 'size' (hex, default 1 MiB) byte buffers"
+);
+#endif
@@ -10,6 +10,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <dm.h>
 #include <net.h>
 #include <boot_rkimg.h>
 
@@ -555,3 +556,58 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_NET_STATS)
+static int do_net_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct eth_stats stats;
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_ETH, &uc);
+	if (ret)
+		return CMD_RET_FAILURE;
+
+	uclass_foreach_dev(dev, uc) {
+		if (argc > 2 && strcmp(dev->name, argv[2]))
+			continue;
+
+		ret = eth_get_stats(dev, &stats);
+		if (ret == -ENODEV) {
+			printf("%s: not active\n", dev->name);
+			continue;
+		} else if (ret) {
+			printf("%s: no counters (%d)\n", dev->name, ret);
+			continue;
+		}
+
+		printf("%s:\n", dev->name);
+		printf("  rx: %llu packets, %llu bytes, %llu errors, %llu dropped\n",
+		       stats.rx_packets, stats.rx_bytes, stats.rx_errors,
+		       stats.rx_dropped);
+		printf("  tx: %llu packets, %llu bytes, %llu errors\n",
+		       stats.tx_packets, stats.tx_bytes, stats.tx_errors);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_net(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	if (!strcmp(argv[1], "stats"))
+		return do_net_stats(cmdtp, flag, argc, argv);
+
+	return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	net,	3,	1,	do_net,
+	"network device information",
+	"stats [dev] - show packet, error and drop counters"
+);
+#endif	/* CONFIG_CMD_NET_STATS */
@@ -28,6 +28,10 @@ static int do_rksfc(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 			return ret;
 		}
+		if (strncmp(argv[1], "stats", 5) == 0) {
+			rkflash_print_stats();
+			return CMD_RET_SUCCESS;
+		}
 	}
 
 	if (argc == 3) {
@@ -46,6 +50,7 @@ U_BOOT_CMD(
 	rksfc, 8, 1, do_rksfc,
 	"rockchip sfc sub-system",
 	"scan - scan Sfc devices\n"
+	"rksfc stats - show and reset the read throughput counters\n"
 	"rksfc info - show all available Sfc devices\n"
 	"rksfc device [dev] - show or set current Sfc device\n"
 	"      dev 0 - spinand\n"
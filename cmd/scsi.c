@@ -46,6 +46,12 @@ static int do_scsi(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 				return CMD_RET_FAILURE;
 			return ret;
 		}
+		if (strncmp(argv[1], "inf", 3) == 0) {
+			blk_list_devices(IF_TYPE_SCSI);
+			printf("\nTransfer statistics:\n");
+			scsi_show_stats();
+			return 0;
+		}
 	}
 
 	return blk_common_cmd(argc, argv, IF_TYPE_SCSI, &scsi_curr_dev);
@@ -55,7 +61,7 @@ U_BOOT_CMD(
 	scsi, 5, 1, do_scsi,
 	"SCSI sub-system",
 	"reset - reset SCSI controller\n"
-	"scsi info  - show available SCSI devices\n"
+	"scsi info  - show available SCSI devices and their transfer rates\n"
 	"scsi scan  - (re-)scan SCSI bus\n"
 	"scsi device [dev] - show or set current device\n"
 	"scsi part [dev] - print partition table of one or all SCSI devices\n"
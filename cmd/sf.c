@@ -12,6 +12,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <jffs2/jffs2.h>
 #include <linux/mtd/mtd.h>
@@ -556,6 +557,91 @@ static int do_spi_flash_test(int argc, char * const argv[])
 }
 #endif /* CONFIG_CMD_SF_TEST */
 
+#ifdef CONFIG_CMD_SF_BENCH
+static int spi_flash_bench_read(const char *mode, const char *path,
+				uint8_t *buf, ulong offset, ulong len)
+{
+	ulong start, us;
+
+	start = timer_get_us();
+	if (spi_flash_read(flash, offset, len, buf)) {
+		printf("%-12s %-8s: read failed\n", mode, path);
+		return -1;
+	}
+	us = max(timer_get_us() - start, 1UL);
+
+	/* Bytes per microsecond is MB/s */
+	printf("%-12s %-8s: %lu.%02lu MB/s\n", mode, path, len / us,
+	       (ulong)((u64)len * 100 / us % 100));
+
+	return 0;
+}
+
+static int do_spi_flash_bench(int argc, char * const argv[])
+{
+	struct spi_nor_read_mode cur = {
+		.opcode = flash->read_opcode,
+		.dummy = flash->read_dummy,
+		.proto = flash->read_proto,
+	};
+	struct spi_mem_dirmap_desc *rdesc;
+	unsigned long offset, len;
+	char mode[16];
+	uint8_t *buf;
+	char *endp;
+	int ret = 0;
+	int i;
+
+	if (argc < 3)
+		return -1;
+	offset = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0)
+		return -1;
+	len = simple_strtoul(argv[2], &endp, 16);
+	if (*argv[2] == 0 || *endp != 0 || !len)
+		return -1;
+	if (offset + len > flash->size) {
+		printf("ERROR: attempting past flash size (%#x)\n",
+		       flash->size);
+		return 1;
+	}
+
+	buf = memalign(ARCH_DMA_MINALIGN, len);
+	if (!buf) {
+		printf("Cannot allocate memory (%lu bytes)\n", len);
+		return 1;
+	}
+
+	for (i = 0; i < flash->num_read_modes && !ret; i++) {
+		const struct spi_nor_read_mode *m = &flash->read_modes[i];
+
+		spi_nor_set_read_mode(flash, m);
+		snprintf(mode, sizeof(mode), "%d-%d-%d %02xh",
+			 spi_nor_get_protocol_inst_nbits(m->proto),
+			 spi_nor_get_protocol_addr_nbits(m->proto),
+			 spi_nor_get_protocol_data_nbits(m->proto),
+			 m->opcode);
+		ret = spi_flash_bench_read(mode, flash->rdesc &&
+					   !flash->rdesc->nodirmap ?
+					   "dirmap" : "spi-mem", buf, offset,
+					   len);
+	}
+
+	/* Back to the selected mode, and compare it with plain ops */
+	spi_nor_set_read_mode(flash, &cur);
+	rdesc = flash->rdesc;
+	if (!ret && rdesc && !rdesc->nodirmap) {
+		flash->rdesc = NULL;
+		ret = spi_flash_bench_read("selected", "spi-mem", buf, offset,
+					   len);
+		flash->rdesc = rdesc;
+	}
+	free(buf);
+
+	return ret ? 1 : 0;
+}
+#endif /* CONFIG_CMD_SF_BENCH */
+
 static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 			char * const argv[])
 {
@@ -591,6 +677,10 @@ static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 #ifdef CONFIG_CMD_SF_TEST
 	else if (!strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
+#endif
+#ifdef CONFIG_CMD_SF_BENCH
+	else if (!strcmp(cmd, "bench"))
+		ret = do_spi_flash_bench(argc, argv);
 #endif
 	else
 		ret = -1;
@@ -610,6 +700,13 @@ usage:
 #define SF_TEST_HELP
 #endif
 
+#ifdef CONFIG_CMD_SF_BENCH
+#define SF_BENCH_HELP "\nsf bench offset len		" \
+		"- measure read speed of each read mode"
+#else
+#define SF_BENCH_HELP
+#endif
+
 U_BOOT_CMD(
 	sf,	5,	1,	do_spi_flash,
 	"SPI flash sub-system",
@@ -630,4 +727,5 @@ U_BOOT_CMD(
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
 	SF_TEST_HELP
+	SF_BENCH_HELP
 );
@@ -56,7 +56,7 @@ static int create_func_list(int argc, char * const argv[])
 static int create_call_list(int argc, char * const argv[])
 {
 	size_t buff_size, avail, buff_ptr, used;
-	unsigned int needed;
+	unsigned int needed, samples;
 	char *buff;
 	int err;
 
@@ -65,6 +65,12 @@ static int create_call_list(int argc, char * const argv[])
 
 	avail = buff_size - buff_ptr;
 	err = trace_list_calls(buff + buff_ptr, avail, &needed);
+	used = min(avail, (size_t)needed);
+
+	/* Call stack samples, if any, follow the calls */
+	err |= trace_list_samples(buff + buff_ptr + used, avail - used,
+				  &samples);
+	needed += samples;
 	if (err)
 		printf("Error: truncated (%#x bytes needed)\n", needed);
 	used = min(avail, (size_t)needed);
@@ -78,6 +84,27 @@ static int create_call_list(int argc, char * const argv[])
 	return 0;
 }
 
+static int set_mode(int argc, char * const argv[])
+{
+	enum trace_mode mode;
+	ulong sample_us = 0;
+
+	if (argc < 3)
+		return -1;
+	if (!strcmp(argv[2], "linear")) {
+		mode = TRACE_MODE_LINEAR;
+	} else if (!strcmp(argv[2], "ring")) {
+		mode = TRACE_MODE_RING;
+	} else if (!strcmp(argv[2], "sample")) {
+		mode = TRACE_MODE_SAMPLE;
+		sample_us = argc > 3 ? simple_strtoul(argv[3], NULL, 10) : 100;
+	} else {
+		return -1;
+	}
+
+	return trace_set_mode(mode, sample_us);
+}
+
 int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -99,6 +126,10 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (create_func_list(argc, argv))
 			return cmd_usage(cmdtp);
 		break;
+	case 'm':
+		if (set_mode(argc, argv))
+			return cmd_usage(cmdtp);
+		break;
 	case 's':
 		trace_print_stats();
 		break;
@@ -117,5 +148,9 @@ U_BOOT_CMD(
 	"trace resume                       - resume tracing\n"
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
-		"- dump function call trace into buffer"
+		"- dump function call trace into buffer\n"
+	"trace mode linear|ring             - record calls until the buffer\n"
+	"                                     is full / keep the most recent\n"
+	"trace mode sample [<us>]           - record the call stack every\n"
+	"                                     <us> microseconds (default 100)"
 );
@@ -85,6 +85,9 @@ static void display_ubi_info(struct ubi_device *ubi)
 	ubi_msg("number of PEBs reserved for bad PEB handling: %d",
 			ubi->beb_rsvd_pebs);
 	ubi_msg("max/mean erase counter: %d/%d", ubi->max_ec, ubi->mean_ec);
+	ubi_msg("attached in %lu ms by %s, %d PEBs scanned", ubi->attach_ms,
+		ubi->attach_fastmap ? "fastmap" : "scanning",
+		ubi->attach_scanned);
 }
 
 static int ubi_info(int layout)
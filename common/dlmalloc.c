@@ -7,7 +7,7 @@
 #include <malloc.h>
 #include <asm/io.h>
 
-#ifdef DEBUG
+#if defined(DEBUG) || CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
 #if __STD_C
 static void malloc_update_mallinfo (void);
 void malloc_stats (void);
@@ -15,7 +15,7 @@ void malloc_stats (void);
 static void malloc_update_mallinfo ();
 void malloc_stats();
 #endif
-#endif	/* DEBUG */
+#endif	/* DEBUG || SYS_MALLOC_STATS */
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -612,6 +612,37 @@ void mem_malloc_init(ulong start, ulong size)
 	malloc_bin_reloc();
 }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+/*
+ * The allocator below is built as dl_*(). malloc() and friends at the end
+ * of this file wrap it to account each call to its caller, so that nested
+ * calls such as calloc() -> malloc() are only counted once.
+ */
+#undef cALLOc
+#undef fREe
+#undef mALLOc
+#undef mEMALIGn
+#undef rEALLOc
+#undef vALLOc
+#undef pvALLOc
+#define cALLOc		dl_calloc
+#define fREe		dl_free
+#define mALLOc		dl_malloc
+#define mEMALIGn	dl_memalign
+#define rEALLOc		dl_realloc
+#define vALLOc		dl_valloc
+#define pvALLOc		dl_pvalloc
+
+Void_t *dl_calloc(size_t n, size_t elem_size);
+void dl_free(Void_t *mem);
+Void_t *dl_malloc(size_t bytes);
+Void_t *dl_memalign(size_t alignment, size_t bytes);
+Void_t *dl_realloc(Void_t *oldmem, size_t bytes);
+Void_t *dl_valloc(size_t bytes);
+Void_t *dl_pvalloc(size_t bytes);
+static void malloc_stats_sites(void);
+#endif
+
 /* field-extraction macros */
 
 #define first(b) ((b)->fd)
@@ -699,9 +730,9 @@ static struct mallinfo current_mallinfo = {  0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 /* Tracking mmaps */
 
-#ifdef DEBUG
+#if defined(DEBUG) || CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
 static unsigned int n_mmaps = 0;
-#endif	/* DEBUG */
+#endif	/* DEBUG || SYS_MALLOC_STATS */
 static unsigned long mmapped_mem = 0;
 #if HAVE_MMAP
 static unsigned int max_n_mmaps = 0;
@@ -2249,7 +2280,9 @@ size_t malloc_usable_size(mem) Void_t* mem;
 
 /* Utility to update current_mallinfo for malloc_stats and mallinfo() */
 
-#ifdef DEBUG
+#if defined(DEBUG) || CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+static INTERNAL_SIZE_T max_free_chunk; /* largest binned chunk or top */
+
 static void malloc_update_mallinfo()
 {
   int i;
@@ -2262,6 +2295,8 @@ static void malloc_update_mallinfo()
   INTERNAL_SIZE_T avail = chunksize(top);
   int   navail = ((long)(avail) >= (long)MINSIZE)? 1 : 0;
 
+  max_free_chunk = avail;
+
   for (i = 1; i < NAV; ++i)
   {
     b = bin_at(i);
@@ -2276,6 +2311,8 @@ static void malloc_update_mallinfo()
 #endif
       avail += chunksize(p);
       navail++;
+      if (chunksize(p) > max_free_chunk)
+	max_free_chunk = chunksize(p);
     }
   }
 
@@ -2287,7 +2324,7 @@ static void malloc_update_mallinfo()
   current_mallinfo.keepcost = chunksize(top);
 
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || SYS_MALLOC_STATS */
 
 
 
@@ -2306,7 +2343,7 @@ static void malloc_update_mallinfo()
 
 */
 
-#ifdef DEBUG
+#if defined(DEBUG) || CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
 void malloc_stats()
 {
   malloc_update_mallinfo();
@@ -2320,8 +2357,11 @@ void malloc_stats()
   printf("max mmap regions = %10u\n",
 	  (unsigned int)max_n_mmaps);
 #endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+  malloc_stats_sites();
+#endif
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || SYS_MALLOC_STATS */
 
 /*
   mallinfo returns a copy of updated current mallinfo.
@@ -2388,6 +2428,180 @@ int initf_malloc(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+#define MALLOC_SITES		64
+#define MALLOC_SITE_PROBES	8
+
+struct malloc_site {
+	void *caller;
+	ulong calls;
+	ulong bytes;
+};
+
+/* Only updated once the full allocator runs, so BSS is fine */
+static struct {
+	ulong mallocs;
+	ulong frees;
+	ulong in_use;		/* usable bytes of live blocks */
+	ulong peak;
+	ulong lost_sites;	/* calls whose site did not fit the table */
+	struct malloc_site sites[MALLOC_SITES];
+} mstats;
+
+static bool malloc_stats_on(void *mem)
+{
+	return (gd->flags & GD_FLG_FULL_MALLOC_INIT) &&
+	       (ulong)mem >= mem_malloc_start && (ulong)mem < mem_malloc_end;
+}
+
+static void malloc_stats_alloc(void *mem, void *caller)
+{
+	struct malloc_site *site;
+	ulong size, hash;
+	int i;
+
+	if (!mem || !malloc_stats_on(mem))
+		return;
+
+	size = malloc_usable_size(mem);
+	mstats.mallocs++;
+	mstats.in_use += size;
+	if (mstats.in_use > mstats.peak)
+		mstats.peak = mstats.in_use;
+
+	hash = ((ulong)caller >> 2) % MALLOC_SITES;
+	for (i = 0; i < MALLOC_SITE_PROBES; i++) {
+		site = &mstats.sites[(hash + i) % MALLOC_SITES];
+		if (!site->caller)
+			site->caller = caller;
+		if (site->caller == caller) {
+			site->calls++;
+			site->bytes += size;
+			return;
+		}
+	}
+	mstats.lost_sites++;
+}
+
+static void malloc_stats_free(void *mem)
+{
+	if (!mem || !malloc_stats_on(mem))
+		return;
+
+	mstats.frees++;
+	mstats.in_use -= malloc_usable_size(mem);
+}
+
+static void malloc_stats_sites(void)
+{
+	struct malloc_site *site, *most;
+	bool shown[MALLOC_SITES] = { false };
+	ulong frag = 0;
+	int i, n, best;
+
+	if (current_mallinfo.fordblks)
+		frag = 100 - (ulong)max_free_chunk * 100 /
+			     current_mallinfo.fordblks;
+
+	printf("malloc calls     = %10lu\n", mstats.mallocs);
+	printf("free calls       = %10lu\n", mstats.frees);
+	printf("peak in use      = %10lu\n", mstats.peak);
+	printf("free blocks      = %10u (largest %u, %lu%% fragmented)\n",
+	       current_mallinfo.ordblks, (unsigned int)max_free_chunk, frag);
+	printf("\n      caller        calls        bytes\n");
+
+	/* Print the sites by allocated bytes, the table is small */
+	for (n = 0; n < MALLOC_SITES; n++) {
+		most = NULL;
+		best = 0;
+		for (i = 0; i < MALLOC_SITES; i++) {
+			site = &mstats.sites[i];
+			if (!site->caller || shown[i])
+				continue;
+			if (!most || site->bytes > most->bytes) {
+				most = site;
+				best = i;
+			}
+		}
+		if (!most)
+			break;
+		shown[best] = true;
+		printf("  0x%08lx %12lu %12lu\n",
+		       (ulong)most->caller - gd->reloc_off, most->calls,
+		       most->bytes);
+	}
+	if (mstats.lost_sites)
+		printf("  (%lu calls from sites not tracked)\n",
+		       mstats.lost_sites);
+}
+
+void *malloc(size_t bytes)
+{
+	void *mem = dl_malloc(bytes);
+
+	malloc_stats_alloc(mem, __builtin_return_address(0));
+	return mem;
+}
+
+void *calloc(size_t n, size_t elem_size)
+{
+	void *mem = dl_calloc(n, elem_size);
+
+	malloc_stats_alloc(mem, __builtin_return_address(0));
+	return mem;
+}
+
+void *memalign(size_t alignment, size_t bytes)
+{
+	void *mem = dl_memalign(alignment, bytes);
+
+	malloc_stats_alloc(mem, __builtin_return_address(0));
+	return mem;
+}
+
+void *valloc(size_t bytes)
+{
+	void *mem = dl_valloc(bytes);
+
+	malloc_stats_alloc(mem, __builtin_return_address(0));
+	return mem;
+}
+
+void *pvalloc(size_t bytes)
+{
+	void *mem = dl_pvalloc(bytes);
+
+	malloc_stats_alloc(mem, __builtin_return_address(0));
+	return mem;
+}
+
+void *realloc(void *oldmem, size_t bytes)
+{
+	ulong oldsize = 0;
+	void *mem;
+
+	if (oldmem && malloc_stats_on(oldmem))
+		oldsize = malloc_usable_size(oldmem);
+	mem = dl_realloc(oldmem, bytes);
+	if (!mem)
+		return NULL;
+
+	/* Count it as a free and an allocation from this caller */
+	if (oldsize) {
+		mstats.frees++;
+		mstats.in_use -= oldsize;
+	}
+	malloc_stats_alloc(mem, __builtin_return_address(0));
+	return mem;
+}
+
+void free(void *mem)
+{
+	malloc_stats_free(mem);
+	dl_free(mem);
+}
+#endif
+
 /*
 
 History:
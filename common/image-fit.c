@@ -1296,44 +1296,35 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 #endif
 }
 
-int fit_image_check_hash(const void *fit, int noffset, const void *data,
-			 size_t size, char **err_msgp)
+/**
+ * fit_image_check_hash_value - compare a calculated hash with the hash node
+ * @fit: pointer to the FIT format image header
+ * @noffset: hash node offset
+ * @value: calculated hash value
+ * @value_len: length of the calculated hash value
+ * @err_msgp: set to the error message on failure
+ *
+ * This is the second half of fit_image_check_hash(), for the callers which
+ * calculate the hash themselves, e.g. piece by piece while loading the data.
+ *
+ * returns:
+ *     0, on success
+ *    -1, on failure
+ */
+int fit_image_check_hash_value(const void *fit, int noffset,
+			       const uint8_t *value, int value_len,
+			       char **err_msgp)
 {
-	uint8_t value[FIT_MAX_HASH_LEN];
-	int value_len;
-	char *algo;
 	uint8_t *fit_value;
 	int fit_value_len;
-	int ignore;
 	int i;
 
-	*err_msgp = NULL;
-
-	if (fit_image_hash_get_algo(fit, noffset, &algo)) {
-		*err_msgp = "Can't get hash algo property";
-		return -1;
-	}
-	printf("%s", algo);
-
-	if (IMAGE_ENABLE_IGNORE) {
-		fit_image_hash_get_ignore(fit, noffset, &ignore);
-		if (ignore) {
-			printf("-skipped ");
-			return 0;
-		}
-	}
-
 	if (fit_image_hash_get_value(fit, noffset, &fit_value,
 				     &fit_value_len)) {
 		*err_msgp = "Can't get hash value property";
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
-		*err_msgp = "Unsupported hash algorithm";
-		return -1;
-	}
-
 	if (value_len != fit_value_len) {
 		*err_msgp = "Bad hash value len";
 		return -1;
@@ -1357,6 +1348,39 @@ int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	return 0;
 }
 
+int fit_image_check_hash(const void *fit, int noffset, const void *data,
+			 size_t size, char **err_msgp)
+{
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	char *algo;
+	int ignore;
+
+	*err_msgp = NULL;
+
+	if (fit_image_hash_get_algo(fit, noffset, &algo)) {
+		*err_msgp = "Can't get hash algo property";
+		return -1;
+	}
+	printf("%s", algo);
+
+	if (IMAGE_ENABLE_IGNORE) {
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (ignore) {
+			printf("-skipped ");
+			return 0;
+		}
+	}
+
+	if (calculate_hash(data, size, algo, value, &value_len)) {
+		*err_msgp = "Unsupported hash algorithm";
+		return -1;
+	}
+
+	return fit_image_check_hash_value(fit, noffset, value, value_len,
+					  err_msgp);
+}
+
 int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *data, size_t size)
 {
@@ -61,7 +61,7 @@ void write_sparse_image(
 	unsigned int offset;
 	uint64_t chunk_data_sz;
 	uint32_t *fill_buf = NULL;
-	uint32_t fill_val;
+	uint32_t fill_val, fill_buf_val = 0;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
@@ -138,7 +138,7 @@ void write_sparse_image(
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type Raw", response);
-				return;
+				goto out;
 			}
 
 			if (blk + blkcnt > info->start + info->size) {
@@ -147,7 +147,7 @@ void write_sparse_image(
 				    __func__);
 				fastboot_fail(
 				    "Request would exceed partition size!", response);
-				return;
+				goto out;
 			}
 
 			blks = info->write(info, blk, blkcnt, data);
@@ -158,7 +158,7 @@ void write_sparse_image(
 				       blk, blks);
 				fastboot_fail(
 					      "flash write failure", response);
-				return;
+				goto out;
 			}
 			blk += blks;
 			bytes_written += ((u64)blkcnt) * info->blksz;
@@ -171,28 +171,35 @@ void write_sparse_image(
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type FILL", response);
-				return;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL", response);
-				return;
+				goto out;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
+			/* One buffer for all FILL chunks, refilled on change */
+			if (!fill_buf) {
+				fill_buf = (uint32_t *)
+					   memalign(ARCH_DMA_MINALIGN,
+						    ROUNDUP(
+							info->blksz * fill_buf_num_blks,
+							ARCH_DMA_MINALIGN));
+				if (!fill_buf) {
+					fastboot_fail(
+						"Malloc failed for: CHUNK_TYPE_FILL", response);
+					return;
+				}
+				fill_buf_val = ~fill_val;
+			}
+
+			if (fill_val != fill_buf_val) {
+				for (i = 0;
+				     i < (info->blksz * fill_buf_num_blks /
+					  sizeof(fill_val));
+				     i++)
+					fill_buf[i] = fill_val;
+				fill_buf_val = fill_val;
+			}
 
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
@@ -200,7 +207,7 @@ void write_sparse_image(
 				    __func__);
 				fastboot_fail(
 				    "Request would exceed partition size!", response);
-				return;
+				goto out;
 			}
 
 			for (i = 0; i < blkcnt;) {
@@ -216,8 +223,7 @@ void write_sparse_image(
 					       blk, j);
 					fastboot_fail(
 						      "flash write failure", response);
-					free(fill_buf);
-					return;
+					goto out;
 				}
 				blk += blks;
 				i += j;
@@ -225,7 +231,6 @@ void write_sparse_image(
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
 							 sparse_header->blk_sz);
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
@@ -238,7 +243,7 @@ void write_sparse_image(
 			    sparse_header->chunk_hdr_sz) {
 				fastboot_fail(
 					"Bogus chunk size for chunk type Dont Care", response);
-				return;
+				goto out;
 			}
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -248,7 +253,7 @@ void write_sparse_image(
 			printf("%s: Unknown chunk type: %x\n", __func__,
 			       chunk_header->chunk_type);
 			fastboot_fail("Unknown chunk type", response);
-			return;
+			goto out;
 		}
 	}
 
@@ -261,5 +266,6 @@ void write_sparse_image(
 	else
 		fastboot_okay("", response);
 
-	return;
+out:
+	free(fill_buf);
 }
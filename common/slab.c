@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Slab caches for small fixed size objects
+ *
+ * Each cache takes blocks of at least SLAB_BLOCK_SIZE bytes from memalign(),
+ * aligned to their size so that an object finds its block by masking its
+ * address. Every block keeps its own free list and is freed again when its
+ * last object is, so a cache holds no memory beyond its live objects.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <slab.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SLAB_BLOCK_SIZE		SZ_4K
+#define SLAB_MIN_OBJS		8
+#define SLAB_ALIGN		(2 * sizeof(size_t))	/* as dlmalloc */
+
+struct slab_block {
+	struct list_head node;		/* in cache->partial, if not full */
+	void *free_list;
+	ulong in_use;
+};
+
+#define SLAB_HDR_SIZE		ALIGN(sizeof(struct slab_block), SLAB_ALIGN)
+
+static struct slab_cache *slab_caches;
+
+static size_t slab_obj_size(struct slab_cache *cache)
+{
+	/* Room for the free list link, and malloc() alignment */
+	return ALIGN(max(cache->size, sizeof(void *)), SLAB_ALIGN);
+}
+
+/* A power of two, so that the block of an object is found by masking */
+static size_t slab_block_size(struct slab_cache *cache)
+{
+	size_t size = SLAB_BLOCK_SIZE;
+
+	while ((size - SLAB_HDR_SIZE) / slab_obj_size(cache) < SLAB_MIN_OBJS)
+		size <<= 1;
+
+	return size;
+}
+
+static struct slab_block *slab_grow(struct slab_cache *cache)
+{
+	size_t obj = slab_obj_size(cache);
+	size_t size = slab_block_size(cache);
+	struct slab_block *block;
+	char *p, *end;
+
+	block = memalign(size, size);
+	if (!block)
+		return NULL;
+
+	block->free_list = NULL;
+	block->in_use = 0;
+	end = (char *)block + size;
+	for (p = (char *)block + SLAB_HDR_SIZE; p + obj <= end; p += obj) {
+		*(void **)p = block->free_list;
+		block->free_list = p;
+	}
+	list_add(&block->node, &cache->partial);
+	cache->slabs++;
+
+	if (!cache->registered) {
+		cache->next = slab_caches;
+		slab_caches = cache;
+		cache->registered = true;
+	}
+
+	return block;
+}
+
+void *slab_alloc(struct slab_cache *cache)
+{
+	struct slab_block *block;
+	void *ptr;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return malloc(cache->size);
+
+	if (list_empty(&cache->partial)) {
+		block = slab_grow(cache);
+		if (!block)
+			return NULL;
+	} else {
+		block = list_first_entry(&cache->partial, struct slab_block,
+					 node);
+	}
+
+	ptr = block->free_list;
+	block->free_list = *(void **)ptr;
+	if (!block->free_list)
+		list_del_init(&block->node);
+	block->in_use++;
+	cache->allocs++;
+	if (++cache->in_use > cache->peak)
+		cache->peak = cache->in_use;
+
+	return ptr;
+}
+
+void slab_free(struct slab_cache *cache, void *ptr)
+{
+	struct slab_block *block;
+
+	if (!ptr)
+		return;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		free(ptr);
+		return;
+	}
+
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+	/* Allocated from the early pool, which is gone after relocation */
+	if ((ulong)ptr >= gd->malloc_base &&
+	    (ulong)ptr < gd->malloc_base + gd->malloc_limit)
+		return;
+#endif
+
+	block = (struct slab_block *)((ulong)ptr &
+				      ~(ulong)(slab_block_size(cache) - 1));
+	cache->frees++;
+	cache->in_use--;
+	if (!--block->in_use) {
+		/* It holds SLAB_MIN_OBJS objects, so it's on the partial list */
+		list_del(&block->node);
+		free(block);
+		cache->slabs--;
+		return;
+	}
+
+	if (!block->free_list)
+		list_add(&block->node, &cache->partial);
+	*(void **)ptr = block->free_list;
+	block->free_list = ptr;
+}
+
+void slab_stats(void)
+{
+	struct slab_cache *cache;
+
+	printf("\n%-16s %6s %8s %8s %8s %8s %6s\n", "cache", "size",
+	       "allocs", "frees", "in use", "peak", "slabs");
+	for (cache = slab_caches; cache; cache = cache->next)
+		printf("%-16s %6lu %8lu %8lu %8lu %8lu %6lu\n", cache->name,
+		       (ulong)cache->size, cache->allocs, cache->frees,
+		       cache->in_use, cache->peak, cache->slabs);
+}
@@ -198,12 +198,25 @@ int spl_hash_android(struct task_data *data)
 }
 
 #else
+static int android_hash_region(struct image_region *region, int count,
+			       void *body, u32 *size)
+{
+	region[count].data = body;
+	region[count++].size = *size;
+	region[count].data = size;
+	region[count++].size = sizeof(*size);
+
+	return count;
+}
+
 int spl_hash_android(struct task_data *data)
 {
 	struct andr_img_hdr *hdr = (void *)CONFIG_SPL_BOOT_IMAGE_BUF;
 	struct udevice *dev;
 	sha_context ctx;
+	struct image_region region[10];
 	uchar hash[32];
+	int count = 0;
 	void *buf;
 
 	debug("== Android: hash start\n");
@@ -218,40 +231,28 @@ int spl_hash_android(struct task_data *data)
 		return -ENODEV;
 	}
 
-	ctx.length = hdr->kernel_size + sizeof(hdr->kernel_size) +
-	      hdr->ramdisk_size + sizeof(hdr->ramdisk_size) +
-	      hdr->second_size + sizeof(hdr->second_size);
-	if (hdr->header_version > 0)
-		ctx.length += hdr->recovery_dtbo_size + sizeof(hdr->recovery_dtbo_size);
-	if (hdr->header_version > 1)
-		ctx.length += hdr->dtb_size + sizeof(hdr->dtb_size);
-
-	crypto_sha_init(dev, &ctx);
-
 	buf = (void *)hdr + hdr->page_size;
-	crypto_sha_update(dev, buf, hdr->kernel_size);
-	crypto_sha_update(dev, &hdr->kernel_size, sizeof(hdr->kernel_size));
+	count = android_hash_region(region, count, buf, &hdr->kernel_size);
 
 	buf += ALIGN(hdr->kernel_size, hdr->page_size);
-	crypto_sha_update(dev, buf, hdr->ramdisk_size);
-	crypto_sha_update(dev, &hdr->ramdisk_size, sizeof(hdr->ramdisk_size));
+	count = android_hash_region(region, count, buf, &hdr->ramdisk_size);
 
 	buf += ALIGN(hdr->ramdisk_size, hdr->page_size);
-	crypto_sha_update(dev, buf, hdr->second_size);
-	crypto_sha_update(dev, &hdr->second_size, sizeof(hdr->second_size));
+	count = android_hash_region(region, count, buf, &hdr->second_size);
 
 	if (hdr->header_version > 0) {
 		buf += ALIGN(hdr->second_size, hdr->page_size);
-		crypto_sha_update(dev, buf, hdr->recovery_dtbo_size);
-		crypto_sha_update(dev, &hdr->recovery_dtbo_size, sizeof(hdr->recovery_dtbo_size));
+		count = android_hash_region(region, count, buf,
+					    &hdr->recovery_dtbo_size);
 	}
 	if (hdr->header_version > 1) {
 		buf += ALIGN(hdr->recovery_dtbo_size, hdr->page_size);
-		crypto_sha_update(dev, buf, hdr->dtb_size);
-		crypto_sha_update(dev, &hdr->dtb_size, sizeof(hdr->dtb_size));
+		count = android_hash_region(region, count, buf,
+					    &hdr->dtb_size);
 	}
 
-	crypto_sha_final(dev, &ctx, hash);
+	/* one scatter list, the image bodies are hashed in place */
+	crypto_sha_regions_csum(dev, &ctx, region, count, hash);
 
 	if (memcmp(hash, hdr->id, 20)) {
 		print_hash("Hash from header", (u8 *)hdr->id, 20);
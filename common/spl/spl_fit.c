@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <boot_rkimg.h>
+#include <crypto.h>
 #include <errno.h>
 #include <fdt_support.h>
 #include <image.h>
@@ -16,6 +17,8 @@
 #include <spl.h>
 #include <spl_ab.h>
 #include <linux/libfdt.h>
+#include <u-boot/lz4.h>
+#include <u-boot/zlib.h>
 
 #ifndef CONFIG_SYS_BOOTM_LEN
 #define CONFIG_SYS_BOOTM_LEN	(64 << 20)
@@ -147,6 +150,251 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+#if CONFIG_IS_ENABLED(FIT_PIPELINE)
+/*
+ * Pipelined loading of external image data:
+ *
+ * The data is read in chunks of CONFIG_SPL_FIT_PIPELINE_CHUNK_SIZE bytes, each
+ * chunk is fed to the hash engine (and the gzip inflater, if any) right after
+ * it arrives, while it is still hot in cache. So the data is walked only once
+ * instead of read + verify + decompress/memcpy passes.
+ */
+struct spl_fit_pipe {
+	int hash_node;
+	char *algo;
+	struct hash_algo *sw_algo;
+	void *sw_ctx;
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	struct udevice *dev;
+	sha_context csha;
+#endif
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+#if CONFIG_IS_ENABLED(GZIP)
+	bool inflate;
+	z_stream zs;
+#endif
+};
+
+/*
+ * Only an image with exactly one hash node and no signature node can be
+ * pipelined, others go the normal way.
+ */
+static int spl_fit_pipe_hash_node(const void *fit, int node)
+{
+	const char *name;
+	int noffset, hash_node = -ENOENT;
+
+	if (IS_ENABLED(CONFIG_SPL_FIT_PRINT))
+		return -ENOTSUPP;
+
+	fdt_for_each_subnode(noffset, fit, node) {
+		name = fit_get_name(fit, noffset, NULL);
+		if (!strncmp(name, FIT_SIG_NODENAME,
+			     strlen(FIT_SIG_NODENAME)))
+			return -ENOTSUPP;
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (hash_node >= 0)
+			return -ENOTSUPP;
+		hash_node = noffset;
+	}
+
+	return hash_node;
+}
+
+static int spl_fit_pipe_hash_init(struct spl_fit_pipe *pipe, u32 size)
+{
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	u32 cap;
+
+	if (!strcmp(pipe->algo, "sha1")) {
+		cap = CRYPTO_SHA1;
+		pipe->value_len = 20;
+	} else if (!strcmp(pipe->algo, "sha256")) {
+		cap = CRYPTO_SHA256;
+		pipe->value_len = SHA256_SUM_LEN;
+	} else if (!strcmp(pipe->algo, "md5")) {
+		cap = CRYPTO_MD5;
+		pipe->value_len = 16;
+	} else {
+		cap = 0;
+	}
+
+	if (cap) {
+		pipe->dev = crypto_get_device(cap);
+		if (!pipe->dev)
+			return -ENODEV;
+
+		pipe->csha.algo = cap;
+		pipe->csha.length = size;
+
+		return crypto_sha_init(pipe->dev, &pipe->csha);
+	}
+#endif
+	if (hash_progressive_lookup_algo(pipe->algo, &pipe->sw_algo))
+		return -ENOTSUPP;
+
+	pipe->value_len = pipe->sw_algo->digest_size;
+
+	return pipe->sw_algo->hash_init(pipe->sw_algo, &pipe->sw_ctx);
+}
+
+static int spl_fit_pipe_hash_update(struct spl_fit_pipe *pipe,
+				    const void *buf, u32 len, bool last)
+{
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_FIT_HASH, "spl_fit_hash");
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	if (pipe->dev)
+		ret = crypto_sha_update(pipe->dev, (u32 *)buf, len);
+	else
+#endif
+		ret = pipe->sw_algo->hash_update(pipe->sw_algo, pipe->sw_ctx,
+						 buf, len, last);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_FIT_HASH);
+
+	return ret;
+}
+
+static int spl_fit_pipe_hash_finish(struct spl_fit_pipe *pipe)
+{
+	int ret;
+
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	if (pipe->dev)
+		return crypto_sha_final(pipe->dev, &pipe->csha, pipe->value);
+#endif
+	ret = pipe->sw_algo->hash_finish(pipe->sw_algo, pipe->sw_ctx,
+					 pipe->value, sizeof(pipe->value));
+	/* FIT keeps crc32 in big-endian */
+	if (!ret && !strcmp(pipe->algo, "crc32"))
+		*(u32 *)pipe->value = cpu_to_uimage(*(u32 *)pipe->value);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(GZIP)
+static int spl_fit_pipe_inflate_init(struct spl_fit_pipe *pipe,
+				     void *src, u32 len, ulong dst)
+{
+	int offset;
+
+	offset = gzip_parse_header(src, len);
+	if (offset < 0)
+		return -EINVAL;
+
+	memset(&pipe->zs, 0, sizeof(pipe->zs));
+	if (inflateInit2(&pipe->zs, -MAX_WBITS) != Z_OK)
+		return -ENOMEM;
+
+	pipe->zs.next_in = src + offset;
+	pipe->zs.avail_in = 0;
+	pipe->zs.next_out = (void *)dst;
+	pipe->zs.avail_out = CONFIG_SYS_BOOTM_LEN;
+	pipe->inflate = true;
+
+	return 0;
+}
+
+static int spl_fit_pipe_inflate(struct spl_fit_pipe *pipe, u32 len)
+{
+	int ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+	pipe->zs.avail_in += len;
+	ret = inflate(&pipe->zs, Z_NO_FLUSH);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+	if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+		return -EIO;
+
+	return 0;
+}
+
+static int spl_fit_pipe_inflate_end(struct spl_fit_pipe *pipe, ulong *size)
+{
+	int ret;
+
+	ret = inflate(&pipe->zs, Z_FINISH);
+	*size = pipe->zs.total_out;
+	inflateEnd(&pipe->zs);
+	pipe->inflate = false;
+
+	return ret == Z_STREAM_END ? 0 : -EIO;
+}
+#endif
+
+/**
+ * spl_fit_pipe_load(): read, hash and inflate the image data chunk by chunk
+ * @info:	points to information about the device to load data from
+ * @sector:	the first sector (or byte offset for FS) to read
+ * @buf:	destination of the raw data
+ * @overhead:	offset of the image data from @buf
+ * @length:	size of the image data
+ * @pipe:	pipeline state, with the hash node and algo set up
+ * @inflate_dst: gzip output address, 0 if the data isn't to be inflated
+ *
+ * Return:	0 on success or a negative error number.
+ */
+static int spl_fit_pipe_load(struct spl_load_info *info, ulong sector,
+			     void *buf, ulong overhead, size_t length,
+			     struct spl_fit_pipe *pipe, ulong inflate_dst)
+{
+	ulong unit = info->filename ? 1 : info->bl_len;
+	ulong chunk = max_t(ulong, CONFIG_SPL_FIT_PIPELINE_CHUNK_SIZE / unit, 1);
+	ulong total = DIV_ROUND_UP(overhead + length, unit);
+	ulong done = 0, cnt, hashed = 0, end;
+	void *data = buf + overhead;
+	int ret;
+
+	ret = spl_fit_pipe_hash_init(pipe, length);
+	if (ret)
+		return ret;
+
+	while (done < total) {
+		cnt = min(chunk, total - done);
+
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_FIT_READ, "spl_fit_read");
+		if (info->read(info, sector + done, cnt,
+			       buf + done * unit) != cnt)
+			return -EIO;
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_FIT_READ);
+		done += cnt;
+
+		/* image data now available: [0, end) */
+		end = min_t(ulong, done * unit - overhead, length);
+		if (end <= hashed)
+			continue;
+
+		ret = spl_fit_pipe_hash_update(pipe, data + hashed,
+					       end - hashed, end == length);
+		if (ret)
+			return ret;
+#if CONFIG_IS_ENABLED(GZIP)
+		if (inflate_dst) {
+			if (!pipe->inflate) {
+				ret = spl_fit_pipe_inflate_init(pipe, data,
+								end, inflate_dst);
+				if (ret)
+					return ret;
+			}
+
+			ret = spl_fit_pipe_inflate(pipe, data + end -
+					(void *)(pipe->zs.next_in +
+						 pipe->zs.avail_in));
+			if (ret)
+				return ret;
+		}
+#endif
+		hashed = end;
+	}
+
+	return spl_fit_pipe_hash_finish(pipe);
+}
+#endif
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -180,8 +428,17 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	bool external_data = false;
+	bool verified = false;
+	bool decomp = false;
+#if CONFIG_IS_ENABLED(FIT_PIPELINE)
+	struct spl_fit_pipe pipe = { 0 };
+	ulong inflate_dst = 0;
+	char *err_msg;
+	int ret;
+#endif
 
-	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP)) {
+	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) &&
+	    (IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZ4))) {
 		if (fit_image_get_comp(fit, node, &image_comp))
 			puts("Cannot get image compression format.\n");
 		else
@@ -229,6 +486,44 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		overhead = get_aligned_image_overhead(info, offset);
 		nr_sectors = get_aligned_image_size(info, length, offset);
 
+#if CONFIG_IS_ENABLED(FIT_PIPELINE)
+		pipe.hash_node = spl_fit_pipe_hash_node(fit, node);
+		if (pipe.hash_node >= 0 &&
+		    !fit_image_hash_get_algo(fit, pipe.hash_node, &pipe.algo)) {
+			/*
+			 * Board post-processing must see the data as stored
+			 * in the FIT, so it's inflated afterwards then.
+			 */
+			if (IS_ENABLED(CONFIG_SPL_OS_BOOT) &&
+			    IS_ENABLED(CONFIG_SPL_GZIP) &&
+			    !IS_ENABLED(CONFIG_SPL_FIT_IMAGE_POST_PROCESS) &&
+			    image_comp == IH_COMP_GZIP &&
+			    type == IH_TYPE_KERNEL)
+				inflate_dst = load_addr;
+
+			printf("## Loading %s 0x%08lx ... %s",
+			       fit_get_name(fit, node, NULL), load_addr,
+			       pipe.algo);
+			ret = spl_fit_pipe_load(info,
+				sector + get_aligned_image_offset(info, offset),
+				(void *)load_ptr, overhead, length, &pipe,
+				inflate_dst);
+			if (ret) {
+				printf(" error %d\n", ret);
+				return ret;
+			}
+
+			if (fit_image_check_hash_value(fit, pipe.hash_node,
+						       pipe.value,
+						       pipe.value_len,
+						       &err_msg)) {
+				printf(" error!\n%s for '%s' image node\n",
+				       err_msg, fit_get_name(fit, node, NULL));
+				return -EPERM;
+			}
+			verified = true;
+		} else
+#endif
 		if (info->read(info,
 			       sector + get_aligned_image_offset(info, offset),
 			       nr_sectors, (void *)load_ptr) != nr_sectors)
@@ -248,6 +543,18 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		src = (void *)data;
 	}
 
+	if (verified) {
+		int verify_all;
+
+		/* image signatures still need the whole data */
+		if (IMAGE_ENABLE_VERIFY &&
+		    fit_image_verify_required_sigs(fit, node, src, length,
+						   gd_fdt_blob(), &verify_all))
+			return -EPERM;
+		puts("+ ");
+		goto post_process;
+	}
+
 	/* Check hashes and signature */
 	if (image_comp != IH_COMP_NONE && image_comp != IH_COMP_ZIMAGE)
 		printf("## Checking %s 0x%08lx (%s @0x%08lx) ... ",
@@ -266,16 +573,32 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 					 src, length))
 		return -EPERM;
 
+post_process:
+
 #ifdef CONFIG_SPL_FIT_IMAGE_POST_PROCESS
 	board_fit_image_post_process(fit, node, (ulong *)&load_addr,
 				     (ulong **)&src, &length, info);
 #endif
 	puts("OK\n");
 
-	if (IS_ENABLED(CONFIG_SPL_OS_BOOT)	&&
-	    IS_ENABLED(CONFIG_SPL_GZIP)		&&
-	    image_comp == IH_COMP_GZIP		&&
-	    type == IH_TYPE_KERNEL) {
+#if CONFIG_IS_ENABLED(FIT_PIPELINE) && CONFIG_IS_ENABLED(GZIP)
+	if (pipe.inflate) {
+		/* already inflated while loading */
+		if (spl_fit_pipe_inflate_end(&pipe, &size)) {
+			puts("Uncompressing error\n");
+			return -EIO;
+		}
+		length = size;
+		decomp = true;
+	}
+#endif
+
+	if (decomp) {
+		/* nothing to do */
+	} else if (IS_ENABLED(CONFIG_SPL_OS_BOOT)	&&
+		   IS_ENABLED(CONFIG_SPL_GZIP)		&&
+		   image_comp == IH_COMP_GZIP		&&
+		   type == IH_TYPE_KERNEL) {
 		size = length;
 		if (gunzip((void *)load_addr, CONFIG_SYS_BOOTM_LEN,
 			   src, &size)) {
@@ -283,10 +606,27 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			return -EIO;
 		}
 		length = size;
-	} else {
+#if CONFIG_IS_ENABLED(LZ4)
+	} else if (IS_ENABLED(CONFIG_SPL_OS_BOOT)	&&
+		   image_comp == IH_COMP_LZ4		&&
+		   type == IH_TYPE_KERNEL) {
+		size_t lz4_len = CONFIG_SYS_BOOTM_LEN;
+
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+		if (ulz4fn(src, length, (void *)load_addr, &lz4_len)) {
+			puts("Uncompressing error\n");
+			return -EIO;
+		}
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+		length = lz4_len;
+#endif
+	} else if ((ulong)src != load_addr) {
+		/* uncompressed data is read in place when it's aligned */
 		memcpy((void *)load_addr, src, length);
 	}
 
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, fit_get_name(fit, node, NULL));
+
 	if (image_info) {
 		image_info->load_addr = load_addr;
 		image_info->size = length;
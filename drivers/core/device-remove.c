@@ -12,6 +12,7 @@
 #include <common.h>
 #include <errno.h>
 #include <malloc.h>
+#include <slab.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/uclass.h>
@@ -115,7 +116,7 @@ int device_unbind(struct udevice *dev)
 
 	if (dev->flags & DM_FLAG_NAME_ALLOCED)
 		free((char *)dev->name);
-	free(dev);
+	slab_free(&udevice_cache, dev);
 
 	return 0;
 }
@@ -15,6 +15,7 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <slab.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -30,6 +31,8 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+SLAB_CACHE(udevice_cache, "udevice", sizeof(struct udevice));
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *platdata,
 			      ulong driver_data, ofnode node,
@@ -104,7 +107,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 	}
 #endif
-	dev = calloc(1, sizeof(struct udevice));
+	dev = slab_zalloc(&udevice_cache);
 	if (!dev)
 		return -ENOMEM;
 
@@ -315,7 +318,7 @@ fail_alloc2:
 fail_alloc1:
 	devres_release_all(dev);
 
-	free(dev);
+	slab_free(&udevice_cache, dev);
 
 	return ret;
 }
@@ -231,12 +231,16 @@ int crypto_sha_regions_csum(struct udevice *dev, sha_context *ctx,
 			    const struct image_region region[],
 			    int region_count, u8 *output)
 {
+	const struct dm_crypto_ops *ops = device_get_ops(dev);
 	int i, ret;
 
 	ctx->length = 0;
 	for (i = 0; i < region_count; i++)
 		ctx->length += region[i].size;
 
+	if (ops && ops->sha_regions && ctx->length)
+		return ops->sha_regions(dev, ctx, region, region_count, output);
+
 	ret = crypto_sha_init(dev, ctx);
 	if (ret)
 		return ret;
@@ -0,0 +1,259 @@
+/*
+ * Sandbox crypto device, emulates the DMA rules of the Rockchip hash engine
+ * on top of the software sha implementations.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <crypto.h>
+#include <dm.h>
+#include <malloc.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <asm/test.h>
+
+/* Same restrictions as the hardware: anything else is copied to the cache */
+#define SANDBOX_DATA_ADDR_ALIGN		8
+#define SANDBOX_DATA_LEN_ALIGN		64
+#define SANDBOX_CACHE_SIZE		8192
+
+/* Emulated link list item, mirrors struct crypto_lli_desc */
+struct sandbox_lli_desc {
+	const u8 *src;
+	u32 len;
+};
+
+struct sandbox_crypto_priv {
+	u32 algo;
+	u32 left;
+	union {
+		sha1_context sha1;
+		sha256_context sha256;
+	} ctx;
+	u8 *cache;
+	u32 cache_size;
+	bool use_cache;
+	struct sandbox_crypto_stats stats;
+};
+
+static u32 sandbox_crypto_capability(struct udevice *dev)
+{
+	u32 cap = CRYPTO_SHA256;
+
+	if (IS_ENABLED(CONFIG_SHA1))
+		cap |= CRYPTO_SHA1;
+
+	return cap;
+}
+
+/* What the DMA engine would read from memory */
+static void sandbox_dma_hash(struct sandbox_crypto_priv *priv,
+			     const u8 *data, u32 len)
+{
+	switch (priv->algo) {
+#ifdef CONFIG_SHA1
+	case CRYPTO_SHA1:
+		sha1_update(&priv->ctx.sha1, data, len);
+		break;
+#endif
+	case CRYPTO_SHA256:
+		sha256_update(&priv->ctx.sha256, data, len);
+		break;
+	}
+	priv->stats.dma_bytes += len;
+}
+
+static int sandbox_crypto_sha_init(struct udevice *dev, sha_context *ctx)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+
+	if (!ctx || !(ctx->algo & sandbox_crypto_capability(dev)))
+		return -EINVAL;
+
+	priv->algo = ctx->algo;
+	priv->left = ctx->length;
+	priv->cache_size = 0;
+	priv->use_cache = false;
+
+#ifdef CONFIG_SHA1
+	if (priv->algo == CRYPTO_SHA1)
+		sha1_starts(&priv->ctx.sha1);
+#endif
+	if (priv->algo == CRYPTO_SHA256)
+		sha256_starts(&priv->ctx.sha256);
+
+	return 0;
+}
+
+static int sandbox_crypto_sha_update(struct udevice *dev, u32 *input, u32 len)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+	const u8 *data = (const u8 *)input;
+	bool is_last;
+	u32 direct = 0;
+
+	if (!len || len > priv->left)
+		return -EINVAL;
+
+	is_last = len == priv->left;
+	priv->left -= len;
+
+	if (!priv->use_cache &&
+	    IS_ALIGNED((ulong)data, SANDBOX_DATA_ADDR_ALIGN)) {
+		direct = is_last ? len :
+			 round_down(len, SANDBOX_DATA_LEN_ALIGN);
+		if (direct) {
+			sandbox_dma_hash(priv, data, direct);
+			priv->stats.descs++;
+		}
+	}
+
+	data += direct;
+	len -= direct;
+	if (!len)
+		return 0;
+
+	priv->use_cache = true;
+	while (len) {
+		u32 n = min_t(u32, len, SANDBOX_CACHE_SIZE - priv->cache_size);
+
+		memcpy(priv->cache + priv->cache_size, data, n);
+		priv->stats.bounce_bytes += n;
+		priv->cache_size += n;
+		data += n;
+		len -= n;
+
+		if (priv->cache_size == SANDBOX_CACHE_SIZE ||
+		    (is_last && !len)) {
+			sandbox_dma_hash(priv, priv->cache, priv->cache_size);
+			priv->stats.descs++;
+			priv->cache_size = 0;
+		}
+	}
+
+	return 0;
+}
+
+static int sandbox_crypto_sha_final(struct udevice *dev, sha_context *ctx,
+				    u8 *output)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+
+	if (priv->left)
+		return -EIO;
+
+#ifdef CONFIG_SHA1
+	if (priv->algo == CRYPTO_SHA1)
+		sha1_finish(&priv->ctx.sha1, output);
+#endif
+	if (priv->algo == CRYPTO_SHA256)
+		sha256_finish(&priv->ctx.sha256, output);
+
+	return 0;
+}
+
+static int sandbox_crypto_sha_regions(struct udevice *dev, sha_context *ctx,
+				      const struct image_region region[],
+				      int region_count, u8 *output)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+	struct sandbox_lli_desc *lli;
+	int direct, i, ret;
+
+	ret = sandbox_crypto_sha_init(dev, ctx);
+	if (ret)
+		return ret;
+
+	/* Chain the leading regions the DMA engine can read in place */
+	for (direct = 0; direct < region_count; direct++) {
+		const struct image_region *r = &region[direct];
+
+		if (!IS_ALIGNED((ulong)r->data, SANDBOX_DATA_ADDR_ALIGN))
+			break;
+		if (direct != region_count - 1 &&
+		    !IS_ALIGNED(r->size, SANDBOX_DATA_LEN_ALIGN))
+			break;
+	}
+
+	if (direct) {
+		lli = calloc(direct, sizeof(*lli));
+		if (!lli)
+			return -ENOMEM;
+
+		for (i = 0; i < direct; i++) {
+			lli[i].src = region[i].data;
+			lli[i].len = region[i].size;
+		}
+		for (i = 0; i < direct; i++) {
+			sandbox_dma_hash(priv, lli[i].src, lli[i].len);
+			priv->left -= lli[i].len;
+		}
+		priv->stats.descs += direct;
+		free(lli);
+	}
+
+	for (i = direct; i < region_count; i++) {
+		if (!region[i].size)
+			continue;
+		ret = sandbox_crypto_sha_update(dev, (u32 *)region[i].data,
+						region[i].size);
+		if (ret)
+			return ret;
+	}
+
+	return sandbox_crypto_sha_final(dev, ctx, output);
+}
+
+void sandbox_crypto_get_stats(struct udevice *dev,
+			      struct sandbox_crypto_stats *stats, bool reset)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+
+	*stats = priv->stats;
+	if (reset)
+		memset(&priv->stats, '\0', sizeof(priv->stats));
+}
+
+static int sandbox_crypto_probe(struct udevice *dev)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+
+	priv->cache = malloc(SANDBOX_CACHE_SIZE);
+	if (!priv->cache)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static int sandbox_crypto_remove(struct udevice *dev)
+{
+	struct sandbox_crypto_priv *priv = dev_get_priv(dev);
+
+	free(priv->cache);
+
+	return 0;
+}
+
+static const struct dm_crypto_ops sandbox_crypto_ops = {
+	.capability	= sandbox_crypto_capability,
+	.sha_init	= sandbox_crypto_sha_init,
+	.sha_update	= sandbox_crypto_sha_update,
+	.sha_final	= sandbox_crypto_sha_final,
+	.sha_regions	= sandbox_crypto_sha_regions,
+};
+
+static const struct udevice_id sandbox_crypto_ids[] = {
+	{ .compatible = "sandbox,crypto" },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_crypto) = {
+	.name		= "sandbox_crypto",
+	.id		= UCLASS_CRYPTO,
+	.of_match	= sandbox_crypto_ids,
+	.probe		= sandbox_crypto_probe,
+	.remove		= sandbox_crypto_remove,
+	.priv_auto_alloc_size = sizeof(struct sandbox_crypto_priv),
+	.ops		= &sandbox_crypto_ops,
+};
@@ -406,32 +406,31 @@ exit:
 	return ret;
 }
 
-static int rk_hash_direct_calc(void *hw_data, const u8 *data,
-			       u32 data_len, u8 *started_flag, u8 is_last)
+/*
+ * Submit a chain of @count descriptors to the hash engine. The chain is
+ * either the last part of the message, or is paused with its tail pointing
+ * back to hash_ctx->data_lli so that following updates can restart DMA.
+ */
+static int rk_hash_lli_calc(struct rockchip_crypto_priv *priv,
+			    struct crypto_lli_desc *lli, u32 count,
+			    u32 data_len, u8 *started_flag, u8 is_last)
 {
-	struct rockchip_crypto_priv *priv = hw_data;
 	struct rk_hash_ctx *hash_ctx = priv->hw_ctx;
-	struct crypto_lli_desc *lli = &hash_ctx->data_lli;
+	struct crypto_lli_desc *tail = &lli[count - 1];
 	int ret = -EINVAL;
 	u32 tmp = 0, mask = 0;
+	u32 i;
 
-	assert(IS_ALIGNED((ulong)data, DATA_ADDR_ALIGN_SIZE));
-	assert(is_last || IS_ALIGNED(data_len, DATA_LEN_ALIGN_SIZE));
-
-	debug("%s: data = %p, len = %u, s = %x, l = %x\n",
-	      __func__, data, data_len, *started_flag, is_last);
-
-	memset(lli, 0x00, sizeof(*lli));
-	lli->src_addr = (u32)virt_to_phys(data);
-	lli->src_len = data_len;
-	lli->dma_ctrl = LLI_DMA_CTRL_SRC_DONE;
+	for (i = 0; i < count - 1; i++)
+		lli[i].next_addr = (u32)virt_to_phys(&lli[i + 1]);
 
+	tail->dma_ctrl |= LLI_DMA_CTRL_SRC_DONE;
 	if (is_last) {
-		lli->user_define |= LLI_USER_STRING_LAST;
-		lli->dma_ctrl |= LLI_DMA_CTRL_LAST;
+		tail->user_define |= LLI_USER_STRING_LAST;
+		tail->dma_ctrl |= LLI_DMA_CTRL_LAST;
 	} else {
-		lli->next_addr = (u32)virt_to_phys(lli);
-		lli->dma_ctrl |= LLI_DMA_CTRL_PAUSE;
+		tail->next_addr = (u32)virt_to_phys(&hash_ctx->data_lli);
+		tail->dma_ctrl |= LLI_DMA_CTRL_PAUSE;
 	}
 
 	if (!(*started_flag)) {
@@ -447,8 +446,9 @@ static int rk_hash_direct_calc(void *hw_data, const u8 *data,
 	}
 
 	/* flush cache */
-	crypto_flush_cacheline((ulong)lli, sizeof(*lli));
-	crypto_flush_cacheline((ulong)data, data_len);
+	crypto_flush_cacheline((ulong)lli, sizeof(*lli) * count);
+	for (i = 0; i < count; i++)
+		crypto_flush_cacheline((ulong)lli[i].src_addr, lli[i].src_len);
 
 	/* start calculate */
 	crypto_write(tmp << CRYPTO_WRITE_MASK_SHIFT | tmp,
@@ -457,9 +457,9 @@ static int rk_hash_direct_calc(void *hw_data, const u8 *data,
 	/* mask CRYPTO_SYNC_LOCKSTEP_INT_ST flag */
 	mask = ~(mask | CRYPTO_SYNC_LOCKSTEP_INT_ST);
 
-	/* wait calc ok */
+	/* wait calc ok, every descriptor carries up to HASH_UPDATE_LIMIT */
 	ret = RK_POLL_TIMEOUT(!(crypto_read(CRYPTO_DMA_INT_ST) & mask),
-			      RK_CRYPTO_TIMEOUT);
+			      RK_CRYPTO_TIMEOUT * count);
 
 	/* clear interrupt status */
 	tmp = crypto_read(CRYPTO_DMA_INT_ST);
@@ -478,6 +478,26 @@ exit:
 	return ret;
 }
 
+static int rk_hash_direct_calc(void *hw_data, const u8 *data,
+			       u32 data_len, u8 *started_flag, u8 is_last)
+{
+	struct rockchip_crypto_priv *priv = hw_data;
+	struct rk_hash_ctx *hash_ctx = priv->hw_ctx;
+	struct crypto_lli_desc *lli = &hash_ctx->data_lli;
+
+	assert(IS_ALIGNED((ulong)data, DATA_ADDR_ALIGN_SIZE));
+	assert(is_last || IS_ALIGNED(data_len, DATA_LEN_ALIGN_SIZE));
+
+	debug("%s: data = %p, len = %u, s = %x, l = %x\n",
+	      __func__, data, data_len, *started_flag, is_last);
+
+	memset(lli, 0x00, sizeof(*lli));
+	lli->src_addr = (u32)virt_to_phys(data);
+	lli->src_len = data_len;
+
+	return rk_hash_lli_calc(priv, lli, 1, data_len, started_flag, is_last);
+}
+
 int rk_hash_update(void *ctx, const u8 *data, u32 data_len)
 {
 	struct rk_hash_ctx *tmp_ctx = (struct rk_hash_ctx *)ctx;
@@ -638,6 +658,101 @@ exit:
 	return ret;
 }
 
+static bool rk_hash_region_direct(const struct image_region *region,
+				  bool is_last)
+{
+	if (!IS_ALIGNED((ulong)region->data, DATA_ADDR_ALIGN_SIZE))
+		return false;
+
+	return is_last || IS_ALIGNED(region->size, DATA_LEN_ALIGN_SIZE);
+}
+
+/*
+ * Hash discontiguous regions with one descriptor chain built over the
+ * caller buffers. The leading regions that meet the DMA alignment rules
+ * are chained directly, the remaining ones go through the hash cache.
+ */
+static int rockchip_crypto_sha_regions(struct udevice *dev, sha_context *ctx,
+				       const struct image_region region[],
+				       int region_count, u8 *output)
+{
+	struct rockchip_crypto_priv *priv = dev_get_priv(dev);
+	struct rk_hash_ctx *hash_ctx = priv->hw_ctx;
+	struct crypto_hash_cache *hash_cache;
+	struct crypto_lli_desc *lli = NULL;
+	u32 count = 0, direct_len = 0, i, n;
+	int direct, ret;
+
+	for (direct = 0; direct < region_count; direct++) {
+		if (!rk_hash_region_direct(&region[direct],
+					   direct == region_count - 1))
+			break;
+		count += DIV_ROUND_UP(region[direct].size, HASH_UPDATE_LIMIT);
+		direct_len += region[direct].size;
+	}
+
+	ret = rockchip_crypto_sha_init(dev, ctx);
+	if (ret)
+		return ret;
+
+	hash_cache = hash_ctx->hash_cache;
+
+	if (count) {
+		lli = align_malloc(sizeof(*lli) * count, LLI_ADDR_ALIGN_SIZE);
+		if (!lli) {
+			ret = -ENOMEM;
+			goto exit;
+		}
+		memset(lli, 0x00, sizeof(*lli) * count);
+
+		for (i = 0, n = 0; i < direct; i++) {
+			const u8 *p = (const u8 *)region[i].data;
+			u32 left = region[i].size;
+
+			while (left) {
+				u32 len = min_t(u32, left, HASH_UPDATE_LIMIT);
+
+				lli[n].src_addr = (u32)virt_to_phys(p);
+				lli[n].src_len = len;
+				p += len;
+				left -= len;
+				n++;
+			}
+		}
+
+		debug("%s: %d regions, %u descs, %u bytes direct\n",
+		      __func__, direct, count, direct_len);
+
+		ret = rk_hash_lli_calc(priv, lli, count, direct_len,
+				       &hash_cache->is_started,
+				       direct == region_count);
+		align_free(lli);
+		if (ret)
+			goto exit;
+
+		hash_cache->left_len -= direct_len;
+	}
+
+	for (i = direct; i < region_count; i++) {
+		if (!region[i].size)
+			continue;
+
+		ret = rk_hash_update(hash_ctx, (const u8 *)region[i].data,
+				     region[i].size);
+		if (ret) {
+			rk_crypto_disable_clk(dev);
+			return ret;
+		}
+	}
+
+	return rockchip_crypto_sha_final(dev, ctx, output);
+exit:
+	hw_hash_clean_ctx(hash_ctx);
+	rk_crypto_disable_clk(dev);
+
+	return ret;
+}
+
 #if CONFIG_IS_ENABLED(ROCKCHIP_HMAC)
 int rk_hmac_init(void *hw_ctx, u32 algo, u8 *key, u32 key_len)
 {
@@ -1430,6 +1545,7 @@ static const struct dm_crypto_ops rockchip_crypto_ops = {
 	.sha_init     = rockchip_crypto_sha_init,
 	.sha_update   = rockchip_crypto_sha_update,
 	.sha_final    = rockchip_crypto_sha_final,
+	.sha_regions  = rockchip_crypto_sha_regions,
 #if CONFIG_IS_ENABLED(ROCKCHIP_RSA)
 	.rsa_verify   = rockchip_crypto_rsa_verify,
 #endif
@@ -267,7 +267,6 @@ static int spinand_read_from_cache_op(struct spinand_device *spinand,
 	}
 
 	spinand_cache_op_adjust_colum(spinand, &adjreq, &column);
-	op.addr.val = column;
 
 	/*
 	 * Some controllers are limited in term of max RX data size. In this
@@ -275,19 +274,33 @@ static int spinand_read_from_cache_op(struct spinand_device *spinand,
 	 * column.
 	 */
 	while (nbytes) {
-		op.data.buf.in = buf;
-		op.data.nbytes = nbytes;
-		ret = spi_mem_adjust_op_size(spinand->slave, &op);
-		if (ret)
-			return ret;
+		ssize_t len;
+
+		if (spinand->rdesc) {
+			len = spi_mem_dirmap_read(spinand->rdesc, column,
+						  nbytes, buf);
+			if (len < 0)
+				return len;
+			if (!len)
+				return -EIO;
+		} else {
+			op.addr.val = column;
+			op.data.buf.in = buf;
+			op.data.nbytes = nbytes;
+			ret = spi_mem_adjust_op_size(spinand->slave, &op);
+			if (ret)
+				return ret;
 
-		ret = spi_mem_exec_op(spinand->slave, &op);
-		if (ret)
-			return ret;
+			ret = spi_mem_exec_op(spinand->slave, &op);
+			if (ret)
+				return ret;
 
-		buf += op.data.nbytes;
-		nbytes -= op.data.nbytes;
-		op.addr.val += op.data.nbytes;
+			len = op.data.nbytes;
+		}
+
+		buf += len;
+		nbytes -= len;
+		column += len;
 	}
 
 	if (req->datalen)
@@ -1107,6 +1120,35 @@ static const struct mtd_ooblayout_ops spinand_noecc_ooblayout = {
 	.rfree = spinand_noecc_ooblayout_free,
 };
 
+static void spinand_create_dirmap(struct spinand_device *spinand)
+{
+	struct nand_device *nand = spinand_to_nand(spinand);
+	struct spi_mem_dirmap_info info = {
+		.length = nanddev_page_size(nand) +
+			  nanddev_per_page_oobsize(nand),
+	};
+	struct spi_mem_dirmap_desc *desc;
+
+	/* Offsets are columns, plane bits included */
+	info.op_tmpl = *spinand->op_templates.read_cache;
+	desc = spi_mem_dirmap_create(spinand->slave, &info);
+	if (IS_ERR(desc)) {
+		dev_dbg(spinand->slave->dev, "no read dirmap: %ld\n",
+			PTR_ERR(desc));
+		return;
+	}
+
+	spinand->rdesc = desc;
+}
+
+static void spinand_destroy_dirmap(struct spinand_device *spinand)
+{
+	if (spinand->rdesc) {
+		spi_mem_dirmap_destroy(spinand->rdesc);
+		spinand->rdesc = NULL;
+	}
+}
+
 static int spinand_init(struct spinand_device *spinand)
 {
 	struct mtd_info *mtd = spinand_to_mtd(spinand);
@@ -1178,6 +1220,8 @@ static int spinand_init(struct spinand_device *spinand)
 			goto err_free_bufs;
 	}
 
+	spinand_create_dirmap(spinand);
+
 	nand->bbt.option = NANDDEV_BBT_USE_FLASH;
 	ret = nanddev_init(nand, &spinand_ops, THIS_MODULE);
 	if (ret)
@@ -1215,6 +1259,7 @@ err_cleanup_nanddev:
 	nanddev_cleanup(nand);
 
 err_manuf_cleanup:
+	spinand_destroy_dirmap(spinand);
 	spinand_manufacturer_cleanup(spinand);
 
 err_free_bufs:
@@ -1228,6 +1273,7 @@ static void spinand_cleanup(struct spinand_device *spinand)
 	struct nand_device *nand = spinand_to_nand(spinand);
 
 	nanddev_cleanup(nand);
+	spinand_destroy_dirmap(spinand);
 	spinand_manufacturer_cleanup(spinand);
 	kfree(spinand->databuf);
 	kfree(spinand->scratchbuf);
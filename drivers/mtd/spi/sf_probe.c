@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <malloc.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 
 #include "sf_internal.h"
@@ -59,6 +60,16 @@ err_read_id:
 	return ret;
 }
 
+static void spi_flash_release(struct spi_flash *flash)
+{
+#if !CONFIG_IS_ENABLED(SPI_FLASH_TINY)
+	if (flash->rdesc) {
+		spi_mem_dirmap_destroy(flash->rdesc);
+		flash->rdesc = NULL;
+	}
+#endif
+}
+
 #ifndef CONFIG_DM_SPI_FLASH
 struct spi_flash *spi_flash_probe(unsigned int busnum, unsigned int cs,
 				  unsigned int max_hz, unsigned int spi_mode)
@@ -79,6 +90,7 @@ struct spi_flash *spi_flash_probe(unsigned int busnum, unsigned int cs,
 
 	flash->spi = bus;
 	if (spi_flash_probe_slave(flash)) {
+		spi_flash_release(flash);
 		spi_free_slave(bus);
 		free(flash);
 		return NULL;
@@ -92,6 +104,7 @@ void spi_flash_free(struct spi_flash *flash)
 #ifdef CONFIG_SPI_FLASH_MTD
 	spi_flash_mtd_unregister();
 #endif
+	spi_flash_release(flash);
 	spi_free_slave(flash->spi);
 	free(flash);
 }
@@ -176,6 +189,8 @@ static int spi_flash_std_remove(struct udevice *dev)
 #ifdef CONFIG_SPI_FLASH_MTD
 	spi_flash_mtd_unregister();
 #endif
+	spi_flash_release(dev_get_uclass_priv(dev));
+
 	return 0;
 }
 
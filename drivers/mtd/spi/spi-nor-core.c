@@ -70,25 +70,41 @@ static int spi_nor_write_reg(struct spi_nor *nor, u8 opcode, u8 *buf, int len)
 	return spi_nor_read_write_reg(nor, &op, buf);
 }
 
+static void spi_nor_init_read_op(struct spi_mem_op *op, u8 opcode, u8 dummy,
+				 enum spi_nor_protocol proto, u8 addr_width)
+{
+	struct spi_mem_op tmpl =
+			SPI_MEM_OP(SPI_MEM_OP_CMD(opcode, 1),
+				   SPI_MEM_OP_ADDR(addr_width, 0, 1),
+				   SPI_MEM_OP_DUMMY(dummy, 1),
+				   SPI_MEM_OP_DATA_IN(0, NULL, 1));
+
+	/* get transfer protocols. */
+	tmpl.cmd.buswidth = spi_nor_get_protocol_inst_nbits(proto);
+	tmpl.addr.buswidth = spi_nor_get_protocol_addr_nbits(proto);
+	tmpl.dummy.buswidth = tmpl.addr.buswidth;
+	tmpl.data.buswidth = spi_nor_get_protocol_data_nbits(proto);
+
+	/* convert the dummy cycles to the number of bytes */
+	tmpl.dummy.nbytes = (dummy * tmpl.dummy.buswidth) / 8;
+
+	*op = tmpl;
+}
+
 static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 				 u_char *buf)
 {
-	struct spi_mem_op op =
-			SPI_MEM_OP(SPI_MEM_OP_CMD(nor->read_opcode, 1),
-				   SPI_MEM_OP_ADDR(nor->addr_width, from, 1),
-				   SPI_MEM_OP_DUMMY(nor->read_dummy, 1),
-				   SPI_MEM_OP_DATA_IN(len, buf, 1));
+	struct spi_mem_op op;
 	size_t remaining = len;
 	int ret;
 
-	/* get transfer protocols. */
-	op.cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
-	op.addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
-	op.dummy.buswidth = op.addr.buswidth;
-	op.data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+	if (nor->rdesc)
+		return spi_mem_dirmap_read(nor->rdesc, from, len, buf);
 
-	/* convert the dummy cycles to the number of bytes */
-	op.dummy.nbytes = (nor->read_dummy * op.dummy.buswidth) / 8;
+	spi_nor_init_read_op(&op, nor->read_opcode, nor->read_dummy,
+			     nor->read_proto, nor->addr_width);
+	op.addr.val = from;
+	op.data.buf.in = buf;
 
 	while (remaining) {
 		op.data.nbytes = remaining < UINT_MAX ? remaining : UINT_MAX;
@@ -2290,13 +2306,57 @@ static int spi_nor_hwcaps_pp2cmd(u32 hwcaps)
 				  ARRAY_SIZE(hwcaps_pp2cmd));
 }
 
+static bool spi_nor_read_supported(struct spi_nor *nor,
+				   const struct spi_nor_read_command *read)
+{
+	struct spi_mem_op op;
+
+	spi_nor_init_read_op(&op, read->opcode,
+			     read->num_mode_clocks + read->num_wait_states,
+			     read->proto, nor->addr_width ? nor->addr_width : 3);
+	/* Let the controller check the data lines too */
+	op.data.nbytes = 1;
+
+	return spi_mem_supports_op(nor->spi, &op);
+}
+
 static int spi_nor_select_read(struct spi_nor *nor,
 			       const struct spi_nor_flash_parameter *params,
 			       u32 shared_hwcaps)
 {
-	int cmd, best_match = fls(shared_hwcaps & SNOR_HWCAPS_READ_MASK) - 1;
+	u32 read_hwcaps = shared_hwcaps & SNOR_HWCAPS_READ_MASK;
 	const struct spi_nor_read_command *read;
+	struct spi_nor_read_mode *mode;
+	int cmd, best_match, i, last = fls(read_hwcaps);
+
+	/*
+	 * The SPI mode bits only tell how many lines are wired, drop the
+	 * commands the controller itself cannot issue (e.g. opcodes with
+	 * wide address or dummy phases) before picking the fastest one.
+	 */
+	nor->num_read_modes = 0;
+	for (i = 0; i < last; i++) {
+		if (!(read_hwcaps & BIT(i)))
+			continue;
+
+		cmd = spi_nor_hwcaps_read2cmd(BIT(i));
+		read = cmd < 0 ? NULL : &params->reads[cmd];
+		if (!read || !spi_nor_read_supported(nor, read)) {
+			read_hwcaps &= ~BIT(i);
+			continue;
+		}
+
+		if (nor->num_read_modes == SPI_NOR_MAX_READ_MODES)
+			continue;
+
+		mode = &nor->read_modes[nor->num_read_modes++];
+		mode->hwcaps = BIT(i);
+		mode->opcode = read->opcode;
+		mode->dummy = read->num_mode_clocks + read->num_wait_states;
+		mode->proto = read->proto;
+	}
 
+	best_match = fls(read_hwcaps) - 1;
 	if (best_match < 0)
 		return -EINVAL;
 
@@ -2472,6 +2532,40 @@ static int spi_nor_init(struct spi_nor *nor)
 	return 0;
 }
 
+static int spi_nor_create_read_dirmap(struct spi_nor *nor)
+{
+	struct spi_mem_dirmap_info info = {
+		.offset = 0,
+		.length = nor->mtd.size,
+	};
+	struct spi_mem_dirmap_desc *desc;
+
+	if (nor->rdesc) {
+		spi_mem_dirmap_destroy(nor->rdesc);
+		nor->rdesc = NULL;
+	}
+
+	spi_nor_init_read_op(&info.op_tmpl, nor->read_opcode, nor->read_dummy,
+			     nor->read_proto, nor->addr_width);
+	desc = spi_mem_dirmap_create(nor->spi, &info);
+	if (IS_ERR(desc))
+		return PTR_ERR(desc);
+
+	nor->rdesc = desc;
+
+	return 0;
+}
+
+int spi_nor_set_read_mode(struct spi_nor *nor,
+			  const struct spi_nor_read_mode *mode)
+{
+	nor->read_opcode = mode->opcode;
+	nor->read_dummy = mode->dummy;
+	nor->read_proto = mode->proto;
+
+	return spi_nor_create_read_dirmap(nor);
+}
+
 int spi_nor_scan(struct spi_nor *nor)
 {
 	struct spi_nor_flash_parameter params;
@@ -2621,6 +2715,19 @@ int spi_nor_scan(struct spi_nor *nor)
 		return -EINVAL;
 	}
 
+#ifndef CONFIG_SPI_FLASH_BAR
+	/* Keep the alternative read commands in the same addressing mode */
+	if (nor->num_read_modes &&
+	    nor->read_opcode !=
+	    nor->read_modes[nor->num_read_modes - 1].opcode) {
+		struct spi_nor_read_mode *mode;
+
+		for (mode = nor->read_modes;
+		     mode < nor->read_modes + nor->num_read_modes; mode++)
+			mode->opcode = spi_nor_convert_3to4_read(mode->opcode);
+	}
+#endif
+
 	/* Send all the required SPI flash commands to initialize device */
 	nor->info = info;
 	ret = spi_nor_init(nor);
@@ -2632,6 +2739,11 @@ int spi_nor_scan(struct spi_nor *nor)
 	nor->erase_size = mtd->erasesize;
 	nor->sector_size = mtd->erasesize;
 
+	/* Reads fall back to plain spi_mem ops if this fails */
+	ret = spi_nor_create_read_dirmap(nor);
+	if (ret)
+		dev_dbg(dev, "no read dirmap: %d\n", ret);
+
 #ifndef CONFIG_SPL_BUILD
 	printf("SF: Detected %s with page size ", nor->name);
 	print_size(nor->page_size, ", erase size ");
@@ -829,6 +829,9 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi->attach_scanned++;
+	ubi_io_prefetch_hdrs(ubi, pnum);
+
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1327,6 +1330,10 @@ static struct ubi_attach_info *alloc_ai(void)
  * @ubi: UBI device description object
  * @ai: attach info object
  *
+ * The first %UBI_FM_MAX_START PEBs are scanned into @ai in order to find the
+ * fastmap anchor. If the fastmap turns out to be unusable, @ai is kept so
+ * that the full scan can continue from there instead of starting over.
+ *
  * Returns 0 on success, negative return values indicate an internal
  * error.
  * UBI_NO_FASTMAP denotes that no fastmap was found.
@@ -1336,6 +1343,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 {
 	int err, pnum, fm_anchor = -1;
 	unsigned long long max_sqnum = 0;
+	struct ubi_attach_info *fm_ai;
 
 	err = -ENOMEM;
 
@@ -1369,12 +1377,21 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (fm_anchor < 0)
 		return UBI_NO_FASTMAP;
 
-	destroy_ai(*ai);
-	*ai = alloc_ai();
-	if (!*ai)
+	fm_ai = alloc_ai();
+	if (!fm_ai)
 		return -ENOMEM;
 
-	return ubi_scan_fastmap(ubi, *ai, fm_anchor);
+	err = ubi_scan_fastmap(ubi, fm_ai, fm_anchor);
+	if (err) {
+		destroy_ai(fm_ai);
+		return err;
+	}
+
+	destroy_ai(*ai);
+	*ai = fm_ai;
+	ubi->attach_fastmap = 1;
+
+	return 0;
 
 out_vidh:
 	ubi_free_vid_hdr(ubi, vidh);
@@ -1399,10 +1416,18 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	int err;
 	struct ubi_attach_info *ai;
 
+	ubi->attach_ms = get_timer(0);
+	ubi->attach_scanned = 0;
+	ubi->attach_fastmap = 0;
+
 	ai = alloc_ai();
 	if (!ai)
 		return -ENOMEM;
 
+	err = ubi_io_prefetch_start(ubi);
+	if (err)
+		goto out_ai;
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	/* On small flash devices we disable fastmap in any case. */
 	if ((int)mtd_div_by_eb(ubi->mtd->size, ubi->mtd) <= UBI_FM_MAX_START) {
@@ -1415,11 +1440,18 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	else {
 		err = scan_fast(ubi, &ai);
 		if (err > 0 || mtd_is_eccerr(err)) {
-			if (err != UBI_NO_FASTMAP) {
+			/*
+			 * The first PEBs were scanned completely while looking
+			 * for the anchor, only go over them again if that scan
+			 * itself went wrong.
+			 */
+			if (err != UBI_NO_FASTMAP && err != UBI_BAD_FASTMAP) {
 				destroy_ai(ai);
 				ai = alloc_ai();
-				if (!ai)
+				if (!ai) {
+					ubi_io_prefetch_stop(ubi);
 					return -ENOMEM;
+				}
 
 				err = scan_all(ubi, ai, 0);
 			} else {
@@ -1430,6 +1462,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 #else
 	err = scan_all(ubi, ai, 0);
 #endif
+	ubi_io_prefetch_stop(ubi);
 	if (err)
 		goto out_ai;
 
@@ -1477,6 +1510,11 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 #endif
 
 	destroy_ai(ai);
+
+	ubi->attach_ms = get_timer(ubi->attach_ms);
+	ubi_msg(ubi, "attached in %lu ms, %d of %d PEBs scanned%s",
+		ubi->attach_ms, ubi->attach_scanned, ubi->peb_count,
+		ubi->attach_fastmap ? " (fastmap)" : "");
 	return 0;
 
 out_wl:
@@ -494,6 +494,9 @@ static int scan_pool(struct ubi_device *ubi, struct ubi_attach_info *ai,
 			goto out;
 		}
 
+		ubi->attach_scanned++;
+		ubi_io_prefetch_hdrs(ubi, pnum);
+
 		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 		if (err && err != UBI_IO_BITFLIPS) {
 			ubi_err(ubi, "unable to read EC header! PEB:%i err:%i",
@@ -133,6 +133,18 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	/* Headers already read together by ubi_io_prefetch_hdrs() */
+	if (ubi->hdr_buf && pnum == ubi->hdr_buf_pnum &&
+	    offset + len <= ubi->hdr_buf_len) {
+		memcpy(buf, ubi->hdr_buf + offset, len);
+		if (ubi->hdr_buf_bitflips) {
+			ubi_msg(ubi, "fixable bit-flip detected at PEB %d",
+				pnum);
+			return UBI_IO_BITFLIPS;
+		}
+		return 0;
+	}
+
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
@@ -208,6 +220,64 @@ retry:
 	return err;
 }
 
+/**
+ * ubi_io_prefetch_start - prepare for reading headers in one go.
+ * @ubi: UBI device description object
+ *
+ * While attaching, both the EC and the VID header of every PEB are read.
+ * This allocates a buffer covering both of them so that
+ * ubi_io_prefetch_hdrs() can fetch them with a single MTD read instead of
+ * two. Returns zero in case of success and %-ENOMEM otherwise.
+ */
+int ubi_io_prefetch_start(struct ubi_device *ubi)
+{
+	ubi->hdr_buf_pnum = -1;
+	ubi->hdr_buf_len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	ubi->hdr_buf = kmalloc(ubi->hdr_buf_len, GFP_KERNEL);
+	if (!ubi->hdr_buf)
+		return -ENOMEM;
+
+	return 0;
+}
+
+/**
+ * ubi_io_prefetch_hdrs - read the EC and VID headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to read from
+ *
+ * Following header reads of @pnum are served from the buffer. Read errors
+ * other than corrected bit-flips are not cached: the regular read path
+ * retries and reports them.
+ */
+void ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum)
+{
+	size_t read;
+	int err;
+
+	ubi->hdr_buf_pnum = -1;
+	if (!ubi->hdr_buf)
+		return;
+
+	err = mtd_read(ubi->mtd, (loff_t)pnum * ubi->peb_size,
+		       ubi->hdr_buf_len, &read, ubi->hdr_buf);
+	if ((err && !mtd_is_bitflip(err)) || read != ubi->hdr_buf_len)
+		return;
+
+	ubi->hdr_buf_pnum = pnum;
+	ubi->hdr_buf_bitflips = !!err;
+}
+
+/**
+ * ubi_io_prefetch_stop - release the header buffer.
+ * @ubi: UBI device description object
+ */
+void ubi_io_prefetch_stop(struct ubi_device *ubi)
+{
+	kfree(ubi->hdr_buf);
+	ubi->hdr_buf = NULL;
+	ubi->hdr_buf_pnum = -1;
+}
+
 /**
  * ubi_io_write - write data to a physical eraseblock.
  * @ubi: UBI device description object
@@ -248,6 +318,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	if (pnum == ubi->hdr_buf_pnum)
+		ubi->hdr_buf_pnum = -1;
+
 	/* The area we are writing to has to contain all 0xFF bytes */
 	err = ubi_self_check_all_ff(ubi, pnum, offset, len);
 	if (err)
@@ -573,6 +646,9 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 		return -EROFS;
 	}
 
+	if (pnum == ubi->hdr_buf_pnum)
+		ubi->hdr_buf_pnum = -1;
+
 	if (ubi->nor_flash) {
 		err = nor_erase_prepare(ubi, pnum);
 		if (err)
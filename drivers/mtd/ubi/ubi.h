@@ -520,6 +520,14 @@ struct ubi_debug_info {
  * @max_write_size: maximum amount of bytes the underlying flash can write at a
  *                  time (MTD write buffer size)
  * @mtd: MTD device descriptor
+ * @hdr_buf: EC and VID headers of the PEB being scanned, read in one go
+ * @hdr_buf_len: size of @hdr_buf, covers both headers
+ * @hdr_buf_pnum: PEB whose headers are in @hdr_buf, %-1 if none
+ * @hdr_buf_bitflips: non-zero if reading @hdr_buf reported bit-flips
+ *
+ * @attach_ms: time spent in ubi_attach() in milliseconds
+ * @attach_scanned: count of PEBs whose headers were read by ubi_attach()
+ * @attach_fastmap: non-zero if the device was attached from a fastmap
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
@@ -619,6 +627,14 @@ struct ubi_device {
 	unsigned int nor_flash:1;
 	int max_write_size;
 	struct mtd_info *mtd;
+	void *hdr_buf;
+	int hdr_buf_len;
+	int hdr_buf_pnum;
+	int hdr_buf_bitflips;
+
+	unsigned long attach_ms;
+	int attach_scanned;
+	int attach_fastmap;
 
 	void *peb_buf;
 	struct mutex buf_mutex;
@@ -885,6 +901,9 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		 int len);
 int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture);
+int ubi_io_prefetch_start(struct ubi_device *ubi);
+void ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum);
+void ubi_io_prefetch_stop(struct ubi_device *ubi);
 int ubi_io_is_bad(const struct ubi_device *ubi, int pnum);
 int ubi_io_mark_bad(const struct ubi_device *ubi, int pnum);
 int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
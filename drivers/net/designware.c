@@ -214,6 +214,7 @@ static void rx_descs_init(struct dw_eth_dev *priv)
 
 	writel((ulong)&desc_table_p[0], &dma_p->rxdesclistaddr);
 	priv->rx_currdescnum = 0;
+	priv->rx_ready = 0;
 }
 
 static int _dw_write_hwaddr(struct dw_eth_dev *priv, u8 *mac_id)
@@ -261,6 +262,16 @@ static int dw_adjust_link(struct dw_eth_dev *priv, struct eth_mac_regs *mac_p,
 	return 0;
 }
 
+/* The hardware counters clear on read and on reset, so accumulate them */
+static void dw_update_missed(struct dw_eth_dev *priv)
+{
+	u32 missed = readl(&priv->dma_regs_p->missedframes);
+
+	priv->stats.rx_dropped += missed & MISSEDFRAMES_DMAMSK;
+	priv->stats.rx_dropped += (missed & MISSEDFRAMES_FIFOMSK) >>
+				  MISSEDFRAMES_FIFOSHFT;
+}
+
 static void _dw_eth_halt(struct dw_eth_dev *priv)
 {
 	struct eth_mac_regs *mac_p = priv->mac_regs_p;
@@ -268,6 +279,7 @@ static void _dw_eth_halt(struct dw_eth_dev *priv)
 
 	writel(readl(&mac_p->conf) & ~(RXENABLE | TXENABLE), &mac_p->conf);
 	writel(readl(&dma_p->opmode) & ~(RXSTART | TXSTART), &dma_p->opmode);
+	dw_update_missed(priv);
 
 	phy_shutdown(priv->phydev);
 }
@@ -279,6 +291,8 @@ int designware_eth_init(struct dw_eth_dev *priv, u8 *enetaddr)
 	unsigned int start;
 	int ret;
 
+	/* Don't lose what was counted before the soft reset */
+	dw_update_missed(priv);
 	writel(readl(&dma_p->busmode) | DMAMAC_SRST, &dma_p->busmode);
 
 	start = get_timer(0);
@@ -366,6 +380,7 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	/* Check if the descriptor is owned by CPU */
 	if (desc_p->txrx_status & DESC_TXSTS_OWNBYDMA) {
 		printf("CPU not owner of tx frame\n");
+		priv->stats.tx_errors++;
 		return -EPERM;
 	}
 
@@ -401,36 +416,65 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	/* Start the transmission */
 	writel(POLL_DATA, &dma_p->txpolldemand);
 
+	priv->stats.tx_packets++;
+	priv->stats.tx_bytes += length;
+
 	return 0;
 }
 
+/*
+ * Invalidate up to DW_RX_BATCH descriptors from the current one in a single
+ * cache operation and return how many of them the DMA has handed back to
+ * the CPU. The DMA never touches a descriptor the CPU owns, so the cached
+ * copies stay valid until the descriptor is given back in free_pkt.
+ */
+static u32 dw_rx_refresh(struct dw_eth_dev *priv)
+{
+	u32 desc_num = priv->rx_currdescnum;
+	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
+	u32 count = min_t(u32, DW_RX_BATCH, CONFIG_RX_DESCR_NUM - desc_num);
+	u32 ready;
+
+	invalidate_dcache_range((ulong)desc_p, (ulong)(desc_p + count));
+
+	for (ready = 0; ready < count; ready++) {
+		if (desc_p[ready].txrx_status & DESC_RXSTS_OWNBYDMA)
+			break;
+	}
+
+	return ready;
+}
+
 static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 {
 	u32 status, desc_num = priv->rx_currdescnum;
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
-	int length = -EAGAIN;
-	ulong desc_start = (ulong)desc_p;
-	ulong desc_end = desc_start +
-		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
+	int length;
 	ulong data_start = desc_p->dmamac_addr;
 	ulong data_end;
 
-	/* Invalidate entire buffer descriptor */
-	invalidate_dcache_range(desc_start, desc_end);
+	if (!priv->rx_ready)
+		priv->rx_ready = dw_rx_refresh(priv);
+	if (!priv->rx_ready)
+		return -EAGAIN;
 
 	status = desc_p->txrx_status;
+	*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
 
-	/* Check  if the owner is the CPU */
-	if (!(status & DESC_RXSTS_OWNBYDMA)) {
+	/* Hand damaged frames straight back to the DMA */
+	if (status & DESC_RXSTS_ERROR) {
+		priv->stats.rx_errors++;
+		return 0;
+	}
 
-		length = (status & DESC_RXSTS_FRMLENMSK) >>
-			 DESC_RXSTS_FRMLENSHFT;
+	length = (status & DESC_RXSTS_FRMLENMSK) >> DESC_RXSTS_FRMLENSHFT;
 
-		/* Invalidate received data */
-		data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
-		invalidate_dcache_range(data_start, data_end);
-		*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
-	}
+	/* Invalidate received data */
+	data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
+	invalidate_dcache_range(data_start, data_end);
+
+	priv->stats.rx_packets++;
+	priv->stats.rx_bytes += length;
 
 	return length;
 }
@@ -456,6 +500,8 @@ static int _dw_free_pkt(struct dw_eth_dev *priv)
 	if (++desc_num >= CONFIG_RX_DESCR_NUM)
 		desc_num = 0;
 	priv->rx_currdescnum = desc_num;
+	if (priv->rx_ready)
+		priv->rx_ready--;
 
 	return 0;
 }
@@ -514,7 +560,8 @@ static int dw_eth_recv(struct eth_device *dev)
 	length = _dw_eth_recv(dev->priv, &packet);
 	if (length == -EAGAIN)
 		return 0;
-	net_process_received_packet(packet, length);
+	if (length > 0)
+		net_process_received_packet(packet, length);
 
 	_dw_free_pkt(dev->priv);
 
@@ -638,6 +685,16 @@ int designware_eth_write_hwaddr(struct udevice *dev)
 	return _dw_write_hwaddr(priv, pdata->enetaddr);
 }
 
+int designware_eth_get_stats(struct udevice *dev, struct eth_stats *stats)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+
+	dw_update_missed(priv);
+	*stats = priv->stats;
+
+	return 0;
+}
+
 static int designware_eth_bind(struct udevice *dev)
 {
 #ifdef CONFIG_DM_PCI
@@ -727,6 +784,7 @@ const struct eth_ops designware_eth_ops = {
 	.free_pkt		= designware_eth_free_pkt,
 	.stop			= designware_eth_stop,
 	.write_hwaddr		= designware_eth_write_hwaddr,
+	.get_stats		= designware_eth_get_stats,
 };
 
 int designware_eth_ofdata_to_platdata(struct udevice *dev)
@@ -12,8 +12,17 @@
 #include <asm-generic/gpio.h>
 #endif
 
-#define CONFIG_TX_DESCR_NUM	16
-#define CONFIG_RX_DESCR_NUM	16
+#ifndef CONFIG_DW_ETH_TX_DESCR_NUM
+#define CONFIG_DW_ETH_TX_DESCR_NUM	16
+#endif
+#ifndef CONFIG_DW_ETH_RX_DESCR_NUM
+#define CONFIG_DW_ETH_RX_DESCR_NUM	16
+#endif
+
+#define CONFIG_TX_DESCR_NUM	CONFIG_DW_ETH_TX_DESCR_NUM
+#define CONFIG_RX_DESCR_NUM	CONFIG_DW_ETH_RX_DESCR_NUM
+/* RX descriptors checked per cache invalidation */
+#define DW_RX_BATCH		8
 #define CONFIG_ETH_BUFSIZE	2048
 #define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
 #define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
@@ -72,7 +81,8 @@ struct eth_dma_regs {
 	u32 status;		/* 0x14 */
 	u32 opmode;		/* 0x18 */
 	u32 intenable;		/* 0x1c */
-	u32 reserved1[2];
+	u32 missedframes;	/* 0x20 */
+	u32 reserved1;
 	u32 axibus;		/* 0x28 */
 	u32 reserved2[7];
 	u32 currhosttxdesc;	/* 0x48 */
@@ -108,6 +118,11 @@ struct eth_dma_regs {
 #define TXSECONDFRAME		(1 << 2)
 #define RXSTART			(1 << 1)
 
+/* Missed frame counter definitions, cleared on read */
+#define MISSEDFRAMES_DMAMSK	(0xFFFF << 0)
+#define MISSEDFRAMES_FIFOMSK	(0x7FF << 17)
+#define MISSEDFRAMES_FIFOSHFT	(17)
+
 /* Descriptior related definitions */
 #define MAC_MAX_FRAME_SZ	(1600)
 
@@ -230,6 +245,8 @@ struct dw_eth_dev {
 	u32 max_speed;
 	u32 tx_currdescnum;
 	u32 rx_currdescnum;
+	u32 rx_ready;		/* descriptors known to be owned by the CPU */
+	struct eth_stats stats;
 
 	struct eth_mac_regs *mac_regs_p;
 	struct eth_dma_regs *dma_regs_p;
@@ -262,6 +279,7 @@ int designware_eth_free_pkt(struct udevice *dev, uchar *packet,
 				   int length);
 void designware_eth_stop(struct udevice *dev);
 int designware_eth_write_hwaddr(struct udevice *dev);
+int designware_eth_get_stats(struct udevice *dev, struct eth_stats *stats);
 #endif
 
 #endif
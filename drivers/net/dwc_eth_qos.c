@@ -137,7 +137,7 @@ struct eqos_mtl_regs {
 	uint32_t txq0_quantum_weight;			/* 0xd18 */
 	uint32_t unused_d1c[(0xd30 - 0xd1c) / 4];	/* 0xd1c */
 	uint32_t rxq0_operation_mode;			/* 0xd30 */
-	uint32_t unused_d34;				/* 0xd34 */
+	uint32_t rxq0_missed_packet_overflow_cnt;	/* 0xd34 */
 	uint32_t rxq0_debug;				/* 0xd38 */
 };
 
@@ -164,6 +164,10 @@ struct eqos_mtl_regs {
 #define EQOS_MTL_RXQ0_OPERATION_MODE_FEP		BIT(4)
 #define EQOS_MTL_RXQ0_OPERATION_MODE_FUP		BIT(3)
 
+#define EQOS_MTL_RXQ0_MISSED_MISPKTCNT_SHIFT		16
+#define EQOS_MTL_RXQ0_MISSED_MISPKTCNT_MASK		0x7ff
+#define EQOS_MTL_RXQ0_MISSED_OVFPKTCNT_MASK		0x7ff
+
 #define EQOS_MTL_RXQ0_DEBUG_PRXQ_SHIFT			16
 #define EQOS_MTL_RXQ0_DEBUG_PRXQ_MASK			0x7fff
 #define EQOS_MTL_RXQ0_DEBUG_RXQSTS_SHIFT		4
@@ -233,11 +237,33 @@ struct eqos_tegra186_regs {
 #define EQOS_DESCRIPTOR_SIZE	(EQOS_DESCRIPTOR_WORDS * 4)
 /* We assume ARCH_DMA_MINALIGN >= 16; 16 is the EQOS HW minimum */
 #define EQOS_DESCRIPTOR_ALIGN	ARCH_DMA_MINALIGN
+#ifndef CONFIG_DWC_ETH_QOS_RX_DESCR_NUM
+#define CONFIG_DWC_ETH_QOS_RX_DESCR_NUM	16
+#endif
 #define EQOS_DESCRIPTORS_TX	4
-#define EQOS_DESCRIPTORS_RX	4
-#define EQOS_DESCRIPTORS_NUM	(EQOS_DESCRIPTORS_TX + EQOS_DESCRIPTORS_RX)
-#define EQOS_DESCRIPTORS_SIZE	ALIGN(EQOS_DESCRIPTORS_NUM * \
-				      EQOS_DESCRIPTOR_SIZE, ARCH_DMA_MINALIGN)
+/* The RX ring starts on its own cache line, after the TX ring */
+#define EQOS_DESCRIPTORS_TX_SIZE	ALIGN(EQOS_DESCRIPTORS_TX * \
+					      EQOS_DESCRIPTOR_SIZE, \
+					      ARCH_DMA_MINALIGN)
+#define EQOS_DESCRIPTORS_SIZE	(EQOS_DESCRIPTORS_TX_SIZE + \
+				 ALIGN(EQOS_DESCRIPTORS_RX * \
+				       EQOS_DESCRIPTOR_SIZE, ARCH_DMA_MINALIGN))
+/* RX descriptors sharing a cache line, handed back to the DMA together */
+#if defined(CONFIG_SYS_NONCACHED_MEMORY) || \
+	ARCH_DMA_MINALIGN <= EQOS_DESCRIPTOR_SIZE
+#define EQOS_RX_DESCS_PER_LINE	1
+#else
+#define EQOS_RX_DESCS_PER_LINE	(ARCH_DMA_MINALIGN / EQOS_DESCRIPTOR_SIZE)
+#endif
+/*
+ * Whole cache lines of RX descriptors, and at least two: the DMA can only
+ * fill one line while the CPU still holds the other.
+ */
+#define EQOS_RX_DESC_LINES	DIV_ROUND_UP(CONFIG_DWC_ETH_QOS_RX_DESCR_NUM, \
+					     EQOS_RX_DESCS_PER_LINE)
+#define EQOS_DESCRIPTORS_RX	((EQOS_RX_DESC_LINES > 2 ? \
+				  EQOS_RX_DESC_LINES : 2) * \
+				 EQOS_RX_DESCS_PER_LINE)
 #define EQOS_BUFFER_ALIGN	ARCH_DMA_MINALIGN
 #define EQOS_MAX_PACKET_SIZE	ALIGN(1568, ARCH_DMA_MINALIGN)
 #define EQOS_RX_BUFFER_SIZE	(EQOS_DESCRIPTORS_RX * EQOS_MAX_PACKET_SIZE)
@@ -270,6 +296,7 @@ struct eqos_desc {
 #define EQOS_DESC3_FD		BIT(29)
 #define EQOS_DESC3_LD		BIT(28)
 #define EQOS_DESC3_BUF1V	BIT(24)
+#define EQOS_DESC3_ES		BIT(15)
 
 /*
  * TX and RX descriptors are 16 bytes. This causes problems with the cache
@@ -1270,6 +1297,7 @@ void eqos_enable(struct udevice *dev)
 
 	eqos->tx_desc_idx = 0;
 	eqos->rx_desc_idx = 0;
+	eqos->rx_ready = 0;
 
 	/* Configure MTL */
 	writel(0x60, &eqos->mtl_regs->txq0_quantum_weight - 0x100);
@@ -1505,6 +1533,16 @@ static int __maybe_unused eqos_start(struct udevice *dev)
 	return 0;
 }
 
+/* The MTL counters clear on read and on reset, so accumulate them */
+static void eqos_update_missed(struct eqos_priv *eqos)
+{
+	u32 val = readl(&eqos->mtl_regs->rxq0_missed_packet_overflow_cnt);
+
+	eqos->stats.rx_dropped += (val >> EQOS_MTL_RXQ0_MISSED_MISPKTCNT_SHIFT) &
+				  EQOS_MTL_RXQ0_MISSED_MISPKTCNT_MASK;
+	eqos->stats.rx_dropped += val & EQOS_MTL_RXQ0_MISSED_OVFPKTCNT_MASK;
+}
+
 void eqos_stop(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1514,6 +1552,7 @@ void eqos_stop(struct udevice *dev)
 
 	if (!eqos->started)
 		return;
+	eqos_update_missed(eqos);
 	eqos->started = false;
 	eqos->reg_access_ok = false;
 
@@ -1591,12 +1630,16 @@ int eqos_send(struct udevice *dev, void *packet, int length)
 
 	for (i = 0; i < 1000000; i++) {
 		eqos->config->ops->eqos_inval_desc(tx_desc);
-		if (!(readl(&tx_desc->des3) & EQOS_DESC3_OWN))
+		if (!(readl(&tx_desc->des3) & EQOS_DESC3_OWN)) {
+			eqos->stats.tx_packets++;
+			eqos->stats.tx_bytes += length;
 			return 0;
+		}
 		udelay(1);
 	}
 
 	debug("%s: TX timeout\n", __func__);
+	eqos->stats.tx_errors++;
 
 	return -ETIMEDOUT;
 }
@@ -1605,23 +1648,45 @@ int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
 	struct eqos_desc *rx_desc;
-	int length;
+	int idx = eqos->rx_desc_idx;
+	int length, end;
 
 	debug("%s(dev=%p, flags=%x):\n", __func__, dev, flags);
 
-	rx_desc = &(eqos->rx_descs[eqos->rx_desc_idx]);
-	eqos->config->ops->eqos_inval_desc(rx_desc);
-	if (rx_desc->des3 & EQOS_DESC3_OWN) {
+	/*
+	 * One invalidate covers every descriptor in the cache line. The DMA
+	 * leaves descriptors it has completed alone, so the ones already seen
+	 * owned by the CPU need no further cache maintenance.
+	 */
+	if (!eqos->rx_ready) {
+		eqos->config->ops->eqos_inval_desc(&eqos->rx_descs[idx]);
+		end = roundup(idx + 1, EQOS_RX_DESCS_PER_LINE);
+		while (idx + eqos->rx_ready < end &&
+		       !(eqos->rx_descs[idx + eqos->rx_ready].des3 &
+			 EQOS_DESC3_OWN))
+			eqos->rx_ready++;
+	}
+	if (!eqos->rx_ready) {
 		debug("%s: RX packet not available\n", __func__);
 		return -EAGAIN;
 	}
 
-	*packetp = eqos->rx_dma_buf +
-		(eqos->rx_desc_idx * EQOS_MAX_PACKET_SIZE);
+	rx_desc = &eqos->rx_descs[idx];
+	*packetp = eqos->rx_dma_buf + (idx * EQOS_MAX_PACKET_SIZE);
+
+	/* Damaged frames are handed straight back to the DMA */
+	if (rx_desc->des3 & EQOS_DESC3_ES) {
+		debug("%s: RX error, des3=%x\n", __func__, rx_desc->des3);
+		eqos->stats.rx_errors++;
+		return 0;
+	}
+
 	length = rx_desc->des3 & 0x7fff;
 	debug("%s: *packetp=%p, length=%d\n", __func__, *packetp, length);
 
 	eqos->config->ops->eqos_inval_buffer(*packetp, length);
+	eqos->stats.rx_packets++;
+	eqos->stats.rx_bytes += length;
 
 	return length;
 }
@@ -1631,6 +1696,7 @@ int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 	struct eqos_priv *eqos = dev_get_priv(dev);
 	uchar *packet_expected;
 	struct eqos_desc *rx_desc;
+	int first, i;
 
 	debug("%s(packet=%p, length=%d)\n", __func__, packet, length);
 
@@ -1644,31 +1710,55 @@ int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 
 	eqos->config->ops->eqos_inval_buffer(packet, length);
 
-	rx_desc = &(eqos->rx_descs[eqos->rx_desc_idx]);
+	eqos->rx_desc_idx++;
+	if (eqos->rx_ready)
+		eqos->rx_ready--;
 
-	rx_desc->des0 = 0;
-	mb();
-	eqos->config->ops->eqos_flush_desc(rx_desc);
-	eqos->config->ops->eqos_inval_buffer(packet, length);
-	rx_desc->des0 = (u32)(ulong)packet;
-	rx_desc->des1 = 0;
-	rx_desc->des2 = 0;
 	/*
-	 * Make sure that if HW sees the _OWN write below, it will see all the
-	 * writes to the rest of the descriptor too.
+	 * Writing back a descriptor writes back its whole cache line, which
+	 * would clobber any neighbour the DMA completed meanwhile. Requeue
+	 * only once every descriptor of the line has been consumed.
 	 */
-	mb();
-	rx_desc->des3 = EQOS_DESC3_OWN | EQOS_DESC3_BUF1V;
-	eqos->config->ops->eqos_flush_desc(rx_desc);
+	if (eqos->rx_desc_idx % EQOS_RX_DESCS_PER_LINE == 0) {
+		first = eqos->rx_desc_idx - EQOS_RX_DESCS_PER_LINE;
+		for (i = first; i < eqos->rx_desc_idx; i++) {
+			rx_desc = &eqos->rx_descs[i];
+			rx_desc->des0 = (u32)(ulong)(eqos->rx_dma_buf +
+						     (i * EQOS_MAX_PACKET_SIZE));
+			rx_desc->des1 = 0;
+			rx_desc->des2 = 0;
+		}
+		/*
+		 * Make sure that if HW sees the _OWN write below, it will see
+		 * all the writes to the rest of the descriptor too.
+		 */
+		mb();
+		for (i = first; i < eqos->rx_desc_idx; i++)
+			eqos->rx_descs[i].des3 = EQOS_DESC3_OWN |
+						 EQOS_DESC3_BUF1V;
+		eqos->config->ops->eqos_flush_desc(&eqos->rx_descs[first]);
 
-	writel((ulong)rx_desc, &eqos->dma_regs->ch0_rxdesc_tail_pointer);
+		writel((ulong)&eqos->rx_descs[eqos->rx_desc_idx - 1],
+		       &eqos->dma_regs->ch0_rxdesc_tail_pointer);
+	}
 
-	eqos->rx_desc_idx++;
 	eqos->rx_desc_idx %= EQOS_DESCRIPTORS_RX;
 
 	return 0;
 }
 
+int eqos_get_stats(struct udevice *dev, struct eth_stats *stats)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+
+	/* The registers may be clocked off while the device is stopped */
+	if (eqos->started)
+		eqos_update_missed(eqos);
+	*stats = eqos->stats;
+
+	return 0;
+}
+
 static int eqos_probe_resources_core(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1684,7 +1774,8 @@ static int eqos_probe_resources_core(struct udevice *dev)
 		goto err;
 	}
 	eqos->tx_descs = (struct eqos_desc *)eqos->descs;
-	eqos->rx_descs = (eqos->tx_descs + EQOS_DESCRIPTORS_TX);
+	eqos->rx_descs = (struct eqos_desc *)(eqos->descs +
+					      EQOS_DESCRIPTORS_TX_SIZE);
 	debug("%s: tx_descs=%p, rx_descs=%p\n", __func__, eqos->tx_descs,
 	      eqos->rx_descs);
 
@@ -2108,6 +2199,7 @@ static const struct eth_ops eqos_ops = {
 	.free_pkt = eqos_free_pkt,
 	.write_hwaddr = eqos_write_hwaddr,
 	.read_rom_hwaddr	= eqos_read_rom_hwaddr,
+	.get_stats = eqos_get_stats,
 };
 
 static struct eqos_ops eqos_tegra186_ops = {
@@ -69,12 +69,14 @@ struct eqos_priv {
 	struct eqos_desc *tx_descs;
 	struct eqos_desc *rx_descs;
 	int tx_desc_idx, rx_desc_idx;
+	int rx_ready;		/* descriptors known to be owned by the CPU */
 	void *tx_dma_buf;
 	void *rx_dma_buf;
 	void *rx_pkt;
 	bool started;
 	bool reg_access_ok;
 	bool mii_reseted;
+	struct eth_stats stats;
 };
 
 int eqos_init(struct udevice *dev);
@@ -85,6 +87,7 @@ int eqos_send(struct udevice *dev, void *packet, int length);
 int eqos_recv(struct udevice *dev, int flags, uchar **packetp);
 int eqos_free_pkt(struct udevice *dev, uchar *packet, int length);
 int eqos_write_hwaddr(struct udevice *dev);
+int eqos_get_stats(struct udevice *dev, struct eth_stats *stats);
 
 extern struct eqos_ops eqos_rockchip_ops;
 
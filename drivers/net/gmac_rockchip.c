@@ -2065,6 +2065,16 @@ static int gmac_rockchip_eth_recv(struct udevice *dev, int flags,
 #endif
 }
 
+static int gmac_rockchip_eth_get_stats(struct udevice *dev,
+				       struct eth_stats *stats)
+{
+#ifdef CONFIG_DWC_ETH_QOS
+	return eqos_get_stats(dev, stats);
+#else
+	return designware_eth_get_stats(dev, stats);
+#endif
+}
+
 static int gmac_rockchip_eth_start(struct udevice *dev)
 {
 	struct rockchip_eth_dev *priv = dev_get_priv(dev);
@@ -2118,6 +2128,7 @@ const struct eth_ops gmac_rockchip_eth_ops = {
 	.free_pkt		= gmac_rockchip_eth_free_pkt,
 	.stop			= gmac_rockchip_eth_stop,
 	.write_hwaddr		= gmac_rockchip_eth_write_hwaddr,
+	.get_stats		= gmac_rockchip_eth_get_stats,
 };
 
 #ifndef CONFIG_DWC_ETH_QOS
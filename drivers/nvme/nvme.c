@@ -14,15 +14,16 @@
 #include <dm/device-internal.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		64
 #define NVME_AQ_DEPTH		2
+#define NVME_IO_SLOTS		16
+#define NVME_MAX_TRANSFER_SHIFT	20
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
 #define NVME_CQ_ALLOCATION	ALIGN(NVME_CQ_SIZE(NVME_Q_DEPTH), \
 				      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -69,12 +70,12 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp_list, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
+	u64 *prp_pool = prp_list;
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = page_size >> 3;
@@ -95,24 +96,12 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 		return 0;
 	}
 
+	/* The last entry of each full page points to the next page */
 	nprps = DIV_ROUND_UP(length, page_size);
-	num_pages = DIV_ROUND_UP(nprps + 1, prps_per_page);
+	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
+	if (num_pages * page_size > dev->prp_list_size)
+		return -EINVAL;
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
-	}
-
-	prp_pool = dev->prp_pool;
 	i = 0;
 	while (nprps) {
 		if (i == prps_per_page) {
@@ -120,16 +109,16 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 			*(prp_pool + i - 1) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 1;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	flush_dcache_range((ulong)prp_list,
+			   ALIGN((ulong)(prp_pool + i), ARCH_DMA_MINALIGN));
 
 	return 0;
 }
@@ -141,7 +130,7 @@ static __le16 nvme_get_cmd_id(void)
 	return cpu_to_le16((cmdid < USHRT_MAX) ? cmdid++ : 0);
 }
 
-static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
+static void nvme_invalidate_cq(struct nvme_queue *nvmeq)
 {
 	/*
 	 * Single CQ entries are always smaller than a cache line, so we
@@ -153,17 +142,25 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 	ulong stop = start + NVME_CQ_ALLOCATION;
 
 	invalidate_dcache_range(start, stop);
+}
+
+static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
+{
+	nvme_invalidate_cq(nvmeq);
 
 	return readw(&(nvmeq->cqes[index].status));
 }
 
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_queue_cmd() - copy a command into a queue
+ *
+ * The doorbell is not rung, so that several commands can be handed to the
+ * controller with one register write.
  *
  * @nvmeq:	The queue to use
  * @cmd:	The command to send
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
 	u16 tail = nvmeq->sq_tail;
 
@@ -173,10 +170,21 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 
 	if (++tail == nvmeq->q_depth)
 		tail = 0;
-	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
 }
 
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_queue_cmd(nvmeq, cmd);
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -654,10 +662,46 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 		dev->max_transfer_shift = 20;
 	}
 
+	/* This bounds the PRP lists kept for each outstanding command */
+	dev->max_transfer_shift = min_t(u32, dev->max_transfer_shift,
+					NVME_MAX_TRANSFER_SHIFT);
+
 	free(ctrl);
 	return 0;
 }
 
+static int nvme_alloc_io_slots(struct nvme_dev *dev)
+{
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 nprps, num_pages;
+	int i;
+
+	/* Enough PRP list pages for the largest transfer */
+	nprps = (1 << dev->max_transfer_shift) / page_size;
+	num_pages = max_t(u32, DIV_ROUND_UP(nprps - 1, prps_per_page - 1), 1);
+	dev->prp_list_size = num_pages * page_size;
+
+	/* Leave one queue entry free so the queue never looks empty */
+	dev->io_slot_num = min(NVME_IO_SLOTS, dev->q_depth - 1);
+	dev->io_slots = calloc(dev->io_slot_num, sizeof(*dev->io_slots));
+	if (!dev->io_slots)
+		return -ENOMEM;
+
+	dev->prp_pool = memalign(page_size,
+				 dev->io_slot_num * dev->prp_list_size);
+	if (!dev->prp_pool) {
+		free(dev->io_slots);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < dev->io_slot_num; i++)
+		dev->io_slots[i].prp_list = (void *)dev->prp_pool +
+					    i * dev->prp_list_size;
+
+	return 0;
+}
+
 int nvme_get_namespace_id(struct udevice *udev, u32 *ns_id, u8 *eui64)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
@@ -730,22 +774,87 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/**
+ * nvme_reap_io() - wait for I/O completions and handle all that are ready
+ *
+ * The completions found are acknowledged with a single write to the
+ * completion queue head doorbell.
+ *
+ * @dev:	NVMe device
+ * @nvmeq:	I/O queue to poll
+ * @inflight:	Number of commands outstanding, updated
+ * @fail:	Index of the lowest command which failed, updated
+ * @return 0 if any command completed, -ETIMEDOUT if none did
+ */
+static int nvme_reap_io(struct nvme_dev *dev, struct nvme_queue *nvmeq,
+			int *inflight, ulong *fail)
+{
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	ulong timeout_us = IO_TIMEOUT * 100000;
+	struct nvme_io_slot *slot;
+	ulong start_time;
+	int reaped = 0;
+	u16 status, id;
+
+	start_time = timer_get_us();
+	while (!reaped) {
+		nvme_invalidate_cq(nvmeq);
+		for (;;) {
+			status = readw(&nvmeq->cqes[head].status);
+			if ((status & 0x01) != phase)
+				break;
+
+			id = readw(&nvmeq->cqes[head].command_id);
+			slot = id < dev->io_slot_num ? &dev->io_slots[id] :
+			       NULL;
+			if (slot && slot->busy) {
+				if (status >> 1) {
+					printf("ERROR: status = %x, phase = %d, head = %d\n",
+					       status >> 1, phase, head);
+					*fail = min(*fail, slot->chunk);
+				}
+				slot->busy = false;
+				(*inflight)--;
+			}
+			if (++head == nvmeq->q_depth) {
+				head = 0;
+				phase = !phase;
+			}
+			reaped++;
+		}
+		if (!reaped && timer_get_us() - start_time >= timeout_us)
+			return -ETIMEDOUT;
+	}
+
+	writel(head, nvmeq->q_db + dev->db_stride);
+	nvmeq->cq_head = head;
+	nvmeq->cq_phase = phase;
+
+	return 0;
+}
+
+/*
+ * Requests are split at the maximum transfer size. Up to io_slot_num of the
+ * resulting commands are kept outstanding, each with its own PRP list.
+ */
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
-	u64 prp2;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
+	u32 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
+	ulong chunks = DIV_ROUND_UP(blkcnt, lbas);
+	ulong next = 0, fail = chunks;
+	struct nvme_io_slot *slot;
+	int inflight = 0, queued, i;
 	uintptr_t temp_buffer;
-
-	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	u64 prp2;
+	u32 n;
 
 	struct bounce_buffer bb;
 	unsigned int bb_flags;
@@ -759,49 +868,65 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 	ret = bounce_buffer_start(&bb, buffer, total_len, bb_flags);
 	if (ret)
 		return -ENOMEM;
-	temp_buffer = (unsigned long)bb.bounce_buffer;
 
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
 
 	/* Enable FUA for data integrity if vwc is enabled */
 	if (dev->vwc)
 		c.rw.control |= NVME_RW_FUA;
 
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
+	while (inflight || (next < chunks && fail == chunks)) {
+		/* Fill all free slots, then ring the doorbell once */
+		queued = 0;
+		for (i = 0; i < dev->io_slot_num; i++) {
+			if (next == chunks || fail != chunks)
+				break;
+			slot = &dev->io_slots[i];
+			if (slot->busy)
+				continue;
+
+			n = min_t(lbaint_t, blkcnt - next * lbas, lbas);
+			temp_buffer = (uintptr_t)bb.bounce_buffer +
+				((u64)next * lbas << ns->lba_shift);
+			if (nvme_setup_prps(dev, slot->prp_list, &prp2,
+					    n << ns->lba_shift, temp_buffer)) {
+				fail = next;
+				break;
+			}
+			c.rw.command_id = cpu_to_le16(i);
+			c.rw.slba = cpu_to_le64(blknr + next * lbas);
+			c.rw.length = cpu_to_le16(n - 1);
+			c.rw.prp1 = cpu_to_le64(temp_buffer);
+			c.rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, &c);
+
+			slot->chunk = next++;
+			slot->busy = true;
+			inflight++;
+			queued++;
 		}
+		if (queued)
+			writel(nvmeq->sq_tail, nvmeq->q_db);
+		if (!inflight)
+			break;
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		if (nvme_reap_io(dev, nvmeq, &inflight, &fail)) {
+			printf("ERROR: %s: I/O timeout\n", udev->name);
+			for (i = 0; i < dev->io_slot_num; i++) {
+				slot = &dev->io_slots[i];
+				if (slot->busy)
+					fail = min(fail, slot->chunk);
+				slot->busy = false;
+			}
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
+		}
 	}
 
 	bounce_buffer_stop(&bb);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return fail == chunks ? blkcnt : fail * lbas;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -873,21 +998,19 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate after the page and transfer sizes are known */
+	ret = nvme_alloc_io_slots(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	/* Create a blk device for each namespace */
 
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
@@ -934,9 +1057,15 @@ free_nvme:
 	return ret;
 }
 
+static const struct udevice_id nvme_ids[] = {
+	{ .compatible = "pciclass,010802" },
+	{ }
+};
+
 U_BOOT_DRIVER(nvme) = {
 	.name	= "nvme",
 	.id	= UCLASS_NVME,
+	.of_match = nvme_ids,
 	.bind	= nvme_bind,
 	.probe	= nvme_probe,
 	.priv_auto_alloc_size = sizeof(struct nvme_dev),
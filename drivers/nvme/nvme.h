@@ -603,6 +603,13 @@ enum {
 	NVME_CSTS_SHST_MASK	= 3 << 2,
 };
 
+/* An I/O command which can be outstanding on the I/O queue */
+struct nvme_io_slot {
+	u64 *prp_list;		/* PRP list used by this command */
+	ulong chunk;		/* Index of the command within the request */
+	bool busy;
+};
+
 /* Represents an NVM Express device. Each nvme_dev is a PCI function. */
 struct nvme_dev {
 	struct list_head node;
@@ -626,7 +633,9 @@ struct nvme_dev {
 	u32 page_size;
 	u8 vwc;
 	u64 *prp_pool;
-	u32 prp_entry_num;
+	u32 prp_list_size;
+	struct nvme_io_slot *io_slots;
+	int io_slot_num;
 	u32 nn;
 };
 
@@ -0,0 +1,498 @@
+/*
+ * PCI emulation of an NVMe controller with one namespace held in memory
+ *
+ * Completions for the commands seen by each I/O doorbell are posted in
+ * reverse order, so that the driver's handling of several outstanding
+ * commands is exercised.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pci.h>
+#include <asm/test.h>
+#include <asm/unaligned.h>
+#include "nvme.h"
+
+#define SANDBOX_NVME_DEVICE_ID	0x5679
+#define SANDBOX_NVME_BAR_SIZE	0x2000
+#define SANDBOX_NVME_DB_BASE	0x1000
+#define SANDBOX_NVME_Q_DEPTH	64
+#define SANDBOX_NVME_QUEUES	2
+#define SANDBOX_NVME_MDTS	2	/* 16KiB transfers, so several PRPs */
+#define SANDBOX_NVME_LBA_SHIFT	9
+#define SANDBOX_NVME_SECTORS	8192
+#define SANDBOX_NVME_PAGE_SIZE	4096
+
+/**
+ * struct sandbox_nvme_platdata - PCI configuration of the emulator
+ *
+ * @config:	Standard configuration header, apart from the BARs
+ * @bar:	Current value of BAR 0
+ */
+struct sandbox_nvme_platdata {
+	u8 config[PCI_BASE_ADDRESS_0];
+	u32 bar;
+};
+
+struct sandbox_nvme_queue {
+	struct nvme_command *sq;
+	struct nvme_completion *cq;
+	u16 size;
+	u16 sq_head;
+	u16 cq_tail;
+	u8 phase;
+	bool valid;
+};
+
+struct sandbox_nvme_priv {
+	u8 regs[SANDBOX_NVME_BAR_SIZE] __aligned(8);
+	struct sandbox_nvme_queue queues[SANDBOX_NVME_QUEUES];
+	struct sandbox_nvme_stats stats;
+	u8 *disk;
+};
+
+static int sandbox_nvme_get_devfn(struct udevice *emul)
+{
+	struct pci_child_platdata *plat = dev_get_parent_platdata(emul->parent);
+
+	return plat->devfn;
+}
+
+static int sandbox_nvme_read_config(struct udevice *emul, uint offset,
+				    ulong *valuep, enum pci_size_t size)
+{
+	struct sandbox_nvme_platdata *plat = dev_get_platdata(emul);
+	u8 *reg = plat->config + offset;
+
+	if (offset == PCI_BASE_ADDRESS_0) {
+		if (plat->bar == 0xffffffff)
+			*valuep = ~(SANDBOX_NVME_BAR_SIZE - 1) &
+				  PCI_BASE_ADDRESS_MEM_MASK;
+		else
+			*valuep = plat->bar;
+		return 0;
+	}
+
+	if (offset >= PCI_BASE_ADDRESS_0) {
+		*valuep = 0;
+		return 0;
+	}
+
+	switch (size) {
+	case PCI_SIZE_8:
+		*valuep = *reg;
+		break;
+	case PCI_SIZE_16:
+		*valuep = get_unaligned_le16(reg);
+		break;
+	case PCI_SIZE_32:
+		*valuep = get_unaligned_le32(reg);
+		break;
+	}
+
+	return 0;
+}
+
+static int sandbox_nvme_write_config(struct udevice *emul, uint offset,
+				     ulong value, enum pci_size_t size)
+{
+	struct sandbox_nvme_platdata *plat = dev_get_platdata(emul);
+
+	switch (offset) {
+	case PCI_COMMAND:
+		put_unaligned_le16(value, plat->config + offset);
+		break;
+	case PCI_BASE_ADDRESS_0:
+		plat->bar = value;
+		break;
+	}
+
+	return 0;
+}
+
+static int sandbox_nvme_map_physmem(struct udevice *emul, phys_addr_t addr,
+				    unsigned long *lenp, void **ptrp)
+{
+	struct sandbox_nvme_platdata *plat = dev_get_platdata(emul);
+	struct sandbox_nvme_priv *priv = dev_get_priv(emul);
+	unsigned int offset;
+
+	if (addr < plat->bar || addr >= plat->bar + SANDBOX_NVME_BAR_SIZE)
+		return -ENOENT;
+
+	offset = addr - plat->bar;
+	*ptrp = priv->regs + offset;
+	*lenp = min(*lenp, (ulong)(SANDBOX_NVME_BAR_SIZE - offset));
+
+	return 0;
+}
+
+static int sandbox_nvme_unmap_physmem(struct udevice *emul,
+				      const void *vaddr, unsigned long len)
+{
+	return 0;
+}
+
+static void sandbox_nvme_post(struct sandbox_nvme_queue *q, u16 sqid,
+			      u16 command_id, u16 status, u32 result)
+{
+	struct nvme_completion *cqe = &q->cq[q->cq_tail];
+
+	cqe->result = cpu_to_le32(result);
+	cqe->sq_head = cpu_to_le16(q->sq_head);
+	cqe->sq_id = cpu_to_le16(sqid);
+	cqe->command_id = command_id;
+	cqe->status = cpu_to_le16(status << 1 | q->phase);
+
+	if (++q->cq_tail == q->size) {
+		q->cq_tail = 0;
+		q->phase = !q->phase;
+	}
+}
+
+static void sandbox_nvme_identify(struct nvme_command *cmd)
+{
+	void *buf = (void *)(uintptr_t)le64_to_cpu(cmd->identify.prp1);
+	struct nvme_id_ctrl *ctrl = buf;
+	struct nvme_id_ns *ns = buf;
+
+	memset(buf, '\0', SANDBOX_NVME_PAGE_SIZE);
+	if (le32_to_cpu(cmd->identify.cns)) {
+		ctrl->vid = cpu_to_le16(SANDBOX_PCI_VENDOR_ID);
+		memset(ctrl->sn, ' ', sizeof(ctrl->sn));
+		memcpy(ctrl->sn, "SANDBOX0001", 11);
+		memset(ctrl->mn, ' ', sizeof(ctrl->mn));
+		memcpy(ctrl->mn, "sandbox-nvme", 12);
+		memset(ctrl->fr, ' ', sizeof(ctrl->fr));
+		memcpy(ctrl->fr, "1.0", 3);
+		ctrl->mdts = SANDBOX_NVME_MDTS;
+		ctrl->nn = cpu_to_le32(1);
+	} else if (le32_to_cpu(cmd->identify.nsid) == 1) {
+		ns->nsze = cpu_to_le64(SANDBOX_NVME_SECTORS);
+		ns->ncap = ns->nsze;
+		ns->nuse = ns->nsze;
+		ns->lbaf[0].ds = SANDBOX_NVME_LBA_SHIFT;
+	}
+}
+
+static u16 sandbox_nvme_create_queue(struct sandbox_nvme_priv *priv,
+				     struct nvme_command *cmd)
+{
+	struct sandbox_nvme_queue *q;
+	u16 qid, size;
+	void *base;
+
+	/* The queue ID and size are at the same place for SQ and CQ */
+	qid = le16_to_cpu(cmd->create_cq.cqid);
+	size = le16_to_cpu(cmd->create_cq.qsize) + 1;
+	base = (void *)(uintptr_t)le64_to_cpu(cmd->create_cq.prp1);
+	if (!qid || qid >= SANDBOX_NVME_QUEUES)
+		return NVME_SC_QID_INVALID;
+	if (size > SANDBOX_NVME_Q_DEPTH)
+		return NVME_SC_QUEUE_SIZE;
+
+	q = &priv->queues[qid];
+	q->size = size;
+	if (cmd->common.opcode == nvme_admin_create_cq) {
+		q->cq = base;
+		q->cq_tail = 0;
+		q->phase = 1;
+	} else {
+		q->sq = base;
+		q->sq_head = 0;
+		q->valid = true;
+	}
+
+	return NVME_SC_SUCCESS;
+}
+
+static u16 sandbox_nvme_admin(struct sandbox_nvme_priv *priv,
+			      struct nvme_command *cmd, u32 *result)
+{
+	u16 qid;
+
+	switch (cmd->common.opcode) {
+	case nvme_admin_identify:
+		sandbox_nvme_identify(cmd);
+		break;
+	case nvme_admin_set_features:
+	case nvme_admin_get_features:
+		/* One I/O queue pair, which is also the zero-based count */
+		*result = 0;
+		break;
+	case nvme_admin_create_cq:
+	case nvme_admin_create_sq:
+		return sandbox_nvme_create_queue(priv, cmd);
+	case nvme_admin_delete_cq:
+	case nvme_admin_delete_sq:
+		qid = le16_to_cpu(cmd->delete_queue.qid);
+		if (!qid || qid >= SANDBOX_NVME_QUEUES)
+			return NVME_SC_QID_INVALID;
+		priv->queues[qid].valid = false;
+		break;
+	default:
+		return NVME_SC_INVALID_OPCODE;
+	}
+
+	return NVME_SC_SUCCESS;
+}
+
+static void sandbox_nvme_copy(void *host, u8 *disk, ulong len, bool read)
+{
+	if (read)
+		memcpy(host, disk, len);
+	else
+		memcpy(disk, host, len);
+}
+
+/* Walk PRP1, then PRP2 or the PRP list it points to, with chaining */
+static void sandbox_nvme_xfer(struct nvme_command *cmd, u8 *disk, ulong len,
+			      bool read)
+{
+	ulong page = SANDBOX_NVME_PAGE_SIZE;
+	u64 addr = le64_to_cpu(cmd->rw.prp1);
+	ulong chunk;
+	u64 *list;
+	int i;
+
+	chunk = min(len, page - (ulong)(addr & (page - 1)));
+	sandbox_nvme_copy((void *)(uintptr_t)addr, disk, chunk, read);
+	disk += chunk;
+	len -= chunk;
+	if (!len)
+		return;
+
+	addr = le64_to_cpu(cmd->rw.prp2);
+	if (len <= page) {
+		sandbox_nvme_copy((void *)(uintptr_t)addr, disk, len, read);
+		return;
+	}
+
+	list = (u64 *)(uintptr_t)addr;
+	for (i = 0; len; i++) {
+		addr = le64_to_cpu(list[i]);
+		if (!((ulong)&list[i + 1] & (page - 1)) && len > page) {
+			list = (u64 *)(uintptr_t)addr;
+			i = -1;
+			continue;
+		}
+		chunk = min(len, page);
+		sandbox_nvme_copy((void *)(uintptr_t)addr, disk, chunk, read);
+		disk += chunk;
+		len -= chunk;
+	}
+}
+
+static u16 sandbox_nvme_io(struct sandbox_nvme_priv *priv,
+			   struct nvme_command *cmd)
+{
+	u64 slba = le64_to_cpu(cmd->rw.slba);
+	ulong nlb = le16_to_cpu(cmd->rw.length) + 1;
+
+	switch (cmd->rw.opcode) {
+	case nvme_cmd_read:
+	case nvme_cmd_write:
+		break;
+	case nvme_cmd_flush:
+		return NVME_SC_SUCCESS;
+	default:
+		return NVME_SC_INVALID_OPCODE;
+	}
+
+	if (le32_to_cpu(cmd->rw.nsid) != 1)
+		return NVME_SC_INVALID_NS;
+	if (slba + nlb > SANDBOX_NVME_SECTORS)
+		return NVME_SC_LBA_RANGE;
+	if (nlb << SANDBOX_NVME_LBA_SHIFT >
+	    SANDBOX_NVME_PAGE_SIZE << SANDBOX_NVME_MDTS)
+		return NVME_SC_INVALID_FIELD;
+
+	sandbox_nvme_xfer(cmd, priv->disk + (slba << SANDBOX_NVME_LBA_SHIFT),
+			  nlb << SANDBOX_NVME_LBA_SHIFT,
+			  cmd->rw.opcode == nvme_cmd_read);
+
+	return NVME_SC_SUCCESS;
+}
+
+/* Run the commands up to the new tail and post their completions */
+static void sandbox_nvme_doorbell(struct sandbox_nvme_priv *priv, u16 qid,
+				  u16 tail)
+{
+	struct sandbox_nvme_queue *q = &priv->queues[qid];
+	u16 ids[SANDBOX_NVME_Q_DEPTH], status[SANDBOX_NVME_Q_DEPTH];
+	u32 result[SANDBOX_NVME_Q_DEPTH];
+	struct nvme_command *cmd;
+	int i, n = 0;
+
+	if (!q->valid || tail >= q->size)
+		return;
+
+	while (q->sq_head != tail) {
+		cmd = &q->sq[q->sq_head];
+		if (++q->sq_head == q->size)
+			q->sq_head = 0;
+		ids[n] = cmd->common.command_id;
+		result[n] = 0;
+		if (qid)
+			status[n] = sandbox_nvme_io(priv, cmd);
+		else
+			status[n] = sandbox_nvme_admin(priv, cmd, &result[n]);
+		n++;
+	}
+	if (!n)
+		return;
+
+	if (!qid) {
+		for (i = 0; i < n; i++)
+			sandbox_nvme_post(q, qid, ids[i], status[i], result[i]);
+		return;
+	}
+
+	priv->stats.doorbells++;
+	priv->stats.cmds += n;
+	priv->stats.max_batch = max(priv->stats.max_batch, (ulong)n);
+	priv->stats.reordered += n - 1;
+	while (n--)
+		sandbox_nvme_post(q, qid, ids[n], status[n], result[n]);
+}
+
+static void sandbox_nvme_set_cc(struct sandbox_nvme_priv *priv, u32 cc)
+{
+	struct nvme_bar *bar = (struct nvme_bar *)priv->regs;
+	struct sandbox_nvme_queue *q = &priv->queues[0];
+	int i;
+
+	if (!(cc & NVME_CC_ENABLE)) {
+		for (i = 0; i < SANDBOX_NVME_QUEUES; i++)
+			priv->queues[i].valid = false;
+		bar->csts &= ~NVME_CSTS_RDY;
+		return;
+	}
+	if (bar->csts & NVME_CSTS_RDY)
+		return;
+
+	q->sq = (void *)(uintptr_t)bar->asq;
+	q->cq = (void *)(uintptr_t)bar->acq;
+	q->size = (bar->aqa & 0xfff) + 1;
+	q->sq_head = 0;
+	q->cq_tail = 0;
+	q->phase = 1;
+	q->valid = true;
+	bar->csts |= NVME_CSTS_RDY;
+}
+
+static int sandbox_nvme_write_mmio(struct udevice *emul, void *addr,
+				   ulong value, enum pci_size_t size)
+{
+	struct sandbox_nvme_priv *priv = dev_get_priv(emul);
+	ulong offset = (u8 *)addr - priv->regs;
+	int db;
+
+	if (addr < (void *)priv->regs || offset >= SANDBOX_NVME_BAR_SIZE)
+		return -ENOENT;
+
+	if (offset >= SANDBOX_NVME_DB_BASE) {
+		/* Doorbells alternate SQ tail and CQ head, with stride 4 */
+		db = (offset - SANDBOX_NVME_DB_BASE) / 4;
+		if (db / 2 < SANDBOX_NVME_QUEUES && !(db & 1))
+			sandbox_nvme_doorbell(priv, db / 2, value);
+		return 0;
+	}
+
+	switch (size) {
+	case PCI_SIZE_8:
+		*(u8 *)addr = value;
+		break;
+	case PCI_SIZE_16:
+		*(u16 *)addr = value;
+		break;
+	case PCI_SIZE_32:
+		*(u32 *)addr = value;
+		break;
+	}
+	if (offset == offsetof(struct nvme_bar, cc))
+		sandbox_nvme_set_cc(priv, value);
+
+	return 0;
+}
+
+void sandbox_nvme_get_stats(struct udevice *emul,
+			    struct sandbox_nvme_stats *stats, bool reset)
+{
+	struct sandbox_nvme_priv *priv = dev_get_priv(emul);
+
+	*stats = priv->stats;
+	if (reset)
+		memset(&priv->stats, '\0', sizeof(priv->stats));
+}
+
+static int sandbox_nvme_bind(struct udevice *emul)
+{
+	struct sandbox_nvme_platdata *plat = dev_get_platdata(emul);
+
+	put_unaligned_le16(SANDBOX_PCI_VENDOR_ID, plat->config + PCI_VENDOR_ID);
+	put_unaligned_le16(SANDBOX_NVME_DEVICE_ID,
+			   plat->config + PCI_DEVICE_ID);
+	put_unaligned_le32(PCI_CLASS_STORAGE_EXPRESS << 8,
+			   plat->config + PCI_CLASS_REVISION);
+
+	return 0;
+}
+
+static int sandbox_nvme_probe(struct udevice *emul)
+{
+	struct sandbox_nvme_priv *priv = dev_get_priv(emul);
+	struct nvme_bar *bar = (struct nvme_bar *)priv->regs;
+
+	priv->disk = calloc(SANDBOX_NVME_SECTORS, 1 << SANDBOX_NVME_LBA_SHIFT);
+	if (!priv->disk)
+		return -ENOMEM;
+
+	/* MQES, a 500ms timeout, 4-byte doorbell stride and 4KiB pages */
+	bar->cap = SANDBOX_NVME_Q_DEPTH - 1;
+	bar->cap |= 1 << 24;
+	bar->vs = NVME_VS(1, 2);
+
+	return 0;
+}
+
+static int sandbox_nvme_remove(struct udevice *emul)
+{
+	struct sandbox_nvme_priv *priv = dev_get_priv(emul);
+
+	free(priv->disk);
+	/* Tests enable this to reach the emulator, so turn it off again */
+	sandbox_set_enable_memio(false);
+
+	return 0;
+}
+
+static struct dm_pci_emul_ops sandbox_nvme_emul_ops = {
+	.get_devfn = sandbox_nvme_get_devfn,
+	.read_config = sandbox_nvme_read_config,
+	.write_config = sandbox_nvme_write_config,
+	.map_physmem = sandbox_nvme_map_physmem,
+	.unmap_physmem = sandbox_nvme_unmap_physmem,
+	.write_mmio = sandbox_nvme_write_mmio,
+};
+
+static const struct udevice_id sandbox_nvme_ids[] = {
+	{ .compatible = "sandbox,nvme" },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_nvme_emul) = {
+	.name		= "sandbox_nvme_emul",
+	.id		= UCLASS_PCI_EMUL,
+	.of_match	= sandbox_nvme_ids,
+	.bind		= sandbox_nvme_bind,
+	.probe		= sandbox_nvme_probe,
+	.remove		= sandbox_nvme_remove,
+	.ops		= &sandbox_nvme_emul_ops,
+	.priv_auto_alloc_size = sizeof(struct sandbox_nvme_priv),
+	.platdata_auto_alloc_size = sizeof(struct sandbox_nvme_platdata),
+};
@@ -18,6 +18,8 @@ ulong rkflash_bread(struct udevice *udev, lbaint_t start,
 {
 	struct blk_desc *block_dev = dev_get_uclass_platdata(udev);
 	struct rkflash_info *priv = dev_get_priv(udev->parent);
+	ulong us;
+	int ret;
 
 	debug("%s lba %x cnt %x\n", __func__, (u32)start, (u32)blkcnt);
 	if (blkcnt == 0)
@@ -29,7 +31,17 @@ ulong rkflash_bread(struct udevice *udev, lbaint_t start,
 	if (!priv->read)
 		return -EINVAL;
 
-	return (ulong)priv->read(udev->parent, (u32)start, (u32)blkcnt, dst);
+	us = timer_get_us();
+	ret = priv->read(udev->parent, (u32)start, (u32)blkcnt, dst);
+	us = timer_get_us() - us;
+
+	rkflash_stats.reads++;
+	rkflash_stats.read_sectors += (u32)blkcnt;
+	rkflash_stats.read_us += us;
+	rkflash_print_bio("%s %x %x %lu us\n", __func__, (u32)start,
+			  (u32)blkcnt, us);
+
+	return (ulong)ret;
 }
 
 ulong rkflash_bwrite(struct udevice *udev, lbaint_t start,
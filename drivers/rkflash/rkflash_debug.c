@@ -6,12 +6,14 @@
 
 #include <blk.h>
 #include <common.h>
+#include <div64.h>
 
 #include "rkflash_debug.h"
 #include "rkflash_blk.h"
 #include "boot_rkimg.h"
 
 static unsigned int rkflash_debug;
+struct rkflash_stats rkflash_stats;
 
 __printf(1, 2) int rkflash_print_dio(const char *fmt, ...)
 {
@@ -85,6 +87,25 @@ void rkflash_print_hex(const char *s, const void *buf, int w, size_t len)
 {
 }
 
+void rkflash_print_stats(void)
+{
+	struct rkflash_stats *st = &rkflash_stats;
+	u64 kib_s = 0;
+
+	if (st->read_us) {
+		kib_s = (u64)st->read_sectors * 1000000 / 2;
+		do_div(kib_s, st->read_us);
+	}
+
+	printf("rkflash: %u reads, %u KiB in %lu ms (%llu KiB/s)\n",
+	       st->reads, st->read_sectors / 2, st->read_us / 1000, kib_s);
+	printf("         %u nand pages, %u from cache read\n",
+	       st->pages, st->cached_pages);
+	printf("         %u dma, %u fifo transfers\n",
+	       st->dma_xfers, st->pio_xfers);
+	memset(st, 0, sizeof(*st));
+}
+
 #if (BLK_STRESS_TEST_EN)
 #define max_test_sector 64
 static u8 pwrite[max_test_sector * 512];
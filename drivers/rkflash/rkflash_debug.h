@@ -34,6 +34,19 @@
 #define	PRINT_BIT_CON_IO	BIT(0)
 #define	PRINT_BIT_BLK_IO	BIT(4)
 
+/* Read throughput counters, see rkflash_print_stats() */
+struct rkflash_stats {
+	u32 reads;		/* block read requests */
+	u32 read_sectors;
+	ulong read_us;		/* time spent in them */
+	u32 pages;		/* SPI Nand pages read */
+	u32 cached_pages;	/* pages prefetched by a cache read */
+	u32 dma_xfers;		/* SFC data transfers done by DMA */
+	u32 pio_xfers;		/* SFC data transfers through the FIFO */
+};
+
+extern struct rkflash_stats rkflash_stats;
+
 __printf(1, 2) int rkflash_print_info(const char *fmt, ...);
 __printf(1, 2) int rkflash_print_error(const char *fmt, ...);
 void rkflash_print_hex(const char *s, const void *buf, int w, size_t len);
@@ -42,5 +55,6 @@ __printf(1, 2) int rkflash_print_dio(const char *fmt, ...);
 __printf(1, 2) int rkflash_print_bio(const char *fmt, ...);
 
 void rkflash_test(struct udevice *p_dev);
+void rkflash_print_stats(void);
 
 #endif
@@ -9,6 +9,7 @@
 #include <bouncebuf.h>
 #include <asm/io.h>
 
+#include "rkflash_debug.h"
 #include "sfc.h"
 
 #define SFC_MAX_IOSIZE_VER3		(1024 * 8)
@@ -136,6 +137,8 @@ int sfc_request(struct rk_sfc_op *op, u32 addr, void *data, u32 size)
 		if (ret)
 			return ret;
 
+		rkflash_stats.dma_xfers++;
+
 		writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
 		writel(~((u32)DMA_INT), g_sfc_reg + SFC_IMR);
 		writel((unsigned long)bb.bounce_buffer, g_sfc_reg + SFC_DMA_ADDR);
@@ -157,6 +160,7 @@ int sfc_request(struct rk_sfc_op *op, u32 addr, void *data, u32 size)
 		union SFCFSR_DATA    fifostat;
 		u32 *p_data = (u32 *)data;
 
+		rkflash_stats.pio_xfers++;
 		if (cmd.b.rw == SFC_WRITE) {
 			words  = (size + 3) >> 2;
 
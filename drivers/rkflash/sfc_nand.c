@@ -42,19 +42,19 @@ static struct nand_info spi_nand_tbl[] = {
 	/* MX35LF2GE4AB */
 	{ 0xC2, 0x22, 0x00, 4, 0x40, 2, 1024, 0x0C, 19, 0x4, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status1 },
 	/* MX35LF2GE4AD */
-	{ 0xC2, 0x26, 0x00, 4, 0x40, 1, 2048, 0x0C, 19, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
+	{ 0xC2, 0x26, 0x00, 4, 0x40, 1, 2048, 0x8C, 19, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
 	/* MX35LF4GE4AD */
-	{ 0xC2, 0x37, 0x00, 8, 0x40, 1, 2048, 0x0C, 20, 0x8, 1, { 0x04, 0x08, 0x14, 0x18 }, &sfc_nand_get_ecc_status0 },
+	{ 0xC2, 0x37, 0x00, 8, 0x40, 1, 2048, 0x8C, 20, 0x8, 1, { 0x04, 0x08, 0x14, 0x18 }, &sfc_nand_get_ecc_status0 },
 	/* MX35UF1GE4AC */
 	{ 0xC2, 0x92, 0x00, 4, 0x40, 1, 1024, 0x0C, 18, 0x4, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
 	/* MX35UF2GE4AC */
 	{ 0xC2, 0xA2, 0x00, 4, 0x40, 1, 2048, 0x0C, 19, 0x4, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
 	/* MX35UF1GE4AD */
-	{ 0xC2, 0x96, 0x00, 4, 0x40, 1, 1024, 0x0C, 18, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
+	{ 0xC2, 0x96, 0x00, 4, 0x40, 1, 1024, 0x8C, 18, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
 	/* MX35UF2GE4AD */
-	{ 0xC2, 0xA6, 0x00, 4, 0x40, 1, 2048, 0x0C, 19, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
+	{ 0xC2, 0xA6, 0x00, 4, 0x40, 1, 2048, 0x8C, 19, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
 	/* MX35UF4GE4AD */
-	{ 0xC2, 0xB7, 0x00, 8, 0x40, 1, 2048, 0x0C, 20, 0x8, 1, { 0x04, 0x08, 0x14, 0x18 }, &sfc_nand_get_ecc_status0 },
+	{ 0xC2, 0xB7, 0x00, 8, 0x40, 1, 2048, 0x8C, 20, 0x8, 1, { 0x04, 0x08, 0x14, 0x18 }, &sfc_nand_get_ecc_status0 },
 
 	/* GD5F1GQ4UAYIG */
 	{ 0xC8, 0xF1, 0x00, 4, 0x40, 1, 1024, 0x0C, 18, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
@@ -188,9 +188,9 @@ static struct nand_info spi_nand_tbl[] = {
 	{ 0x0B, 0x15, 0x00, 4, 0x40, 1, 1024, 0x4C, 18, 0x8, 1, { 0x04, 0x08, 0xFF, 0xFF }, &sfc_nand_get_ecc_status0 },
 
 	/* MT29F2G01ABA, XT26G02E, F50L2G41XA */
-	{ 0x2C, 0x24, 0x00, 4, 0x40, 2, 1024, 0x4C, 19, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
+	{ 0x2C, 0x24, 0x00, 4, 0x40, 2, 1024, 0xCC, 19, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
 	/* MT29F1G01ABA, F50L1G41XA */
-	{ 0x2C, 0x14, 0x00, 4, 0x40, 1, 1024, 0x4C, 18, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
+	{ 0x2C, 0x14, 0x00, 4, 0x40, 1, 1024, 0xCC, 18, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
 
 	/* FM25S01 */
 	{ 0xA1, 0xA1, 0x00, 4, 0x40, 1, 1024, 0x4C, 18, 0x1, 0, { 0x00, 0x04, 0xFF, 0xFF }, &sfc_nand_get_ecc_status1 },
@@ -228,7 +228,7 @@ static struct nand_info spi_nand_tbl[] = {
 };
 
 static struct nand_info *p_nand_info;
-static u32 gp_page_buf[SFC_NAND_PAGE_MAX_SIZE / 4];
+static u32 gp_page_buf[SFC_NAND_PAGE_MAX_SIZE / 4] __aligned(ARCH_DMA_MINALIGN);
 static struct SFNAND_DEV sfc_nand_dev;
 
 static struct nand_info *sfc_nand_get_info(u8 *nand_id)
@@ -789,6 +789,43 @@ static u32 sfc_nand_get_ecc_status9(void)
 	return ret;
 }
 
+static int sfc_nand_cache_read_cmd(u8 cmd)
+{
+	int ret;
+	struct rk_sfc_op op;
+
+	op.sfcmd.d32 = 0;
+	op.sfcmd.b.cmd = cmd;
+
+	op.sfctrl.d32 = 0;
+
+	ret = sfc_request(&op, 0, NULL, 0);
+
+	if (sfc_nand_dev.read_lines == DATA_LINES_X4 &&
+	    p_nand_info->feature & FEA_SOFT_QOP_BIT &&
+	    sfc_get_version() < SFC_VER_3)
+		sfc_nand_rw_preset();
+
+	return ret;
+}
+
+/*
+ * End a running cache read sequence. The device is still loading the next
+ * page in the background and has to finish that before it takes any other
+ * command.
+ */
+static void sfc_nand_cache_read_end(void)
+{
+	u8 status;
+
+	if (sfc_nand_dev.cache_row == INVALID_UINT32)
+		return;
+
+	sfc_nand_dev.cache_row = INVALID_UINT32;
+	sfc_nand_cache_read_cmd(CMD_READ_CACHE_END);
+	sfc_nand_wait_busy(&status, 1000 * 1000);
+}
+
 u32 sfc_nand_erase_block(u8 cs, u32 addr)
 {
 	int ret;
@@ -796,6 +833,7 @@ u32 sfc_nand_erase_block(u8 cs, u32 addr)
 	u8 status;
 
 	rkflash_print_dio("%s %x\n", __func__, addr);
+	sfc_nand_cache_read_end();
 	op.sfcmd.d32 = 0;
 	op.sfcmd.b.cmd = 0xd8;
 	op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
@@ -831,6 +869,8 @@ static u32 sfc_nand_read_cache(u32 row, u32 *p_page_buf, u32 column, u32 len)
 	op.sfctrl.d32 = 0;
 	op.sfctrl.b.datalines = sfc_nand_dev.read_lines;
 	op.sfctrl.b.addrbits = 16;
+	if (!(len & 0x3) && len >= 4)
+		op.sfctrl.b.enbledma = 1;
 
 	plane = p_nand_info->plane_per_die == 2 ? ((row >> 6) & 0x1) << 12 : 0;
 
@@ -851,6 +891,7 @@ u32 sfc_nand_prog_page_raw(u8 cs, u32 addr, u32 *p_page_buf)
 	u32 data_area_size = SFC_NAND_SECTOR_SIZE * p_nand_info->sec_per_page;
 
 	rkflash_print_dio("%s %x %x\n", __func__, addr, p_page_buf[0]);
+	sfc_nand_cache_read_end();
 	sfc_nand_write_en();
 
 	if (sfc_nand_dev.prog_lines == DATA_LINES_X4 &&
@@ -866,6 +907,7 @@ u32 sfc_nand_prog_page_raw(u8 cs, u32 addr, u32 *p_page_buf)
 	op.sfctrl.d32 = 0;
 	op.sfctrl.b.datalines = sfc_nand_dev.prog_lines;
 	op.sfctrl.b.addrbits = 16;
+	op.sfctrl.b.enbledma = 1;
 	plane = p_nand_info->plane_per_die == 2 ? ((addr >> 6) & 0x1) << 12 : 0;
 	sfc_request(&op, plane, p_page_buf, page_size);
 
@@ -924,13 +966,10 @@ u32 sfc_nand_prog_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
 	return ret;
 }
 
-u32 sfc_nand_read(u32 row, u32 *p_page_buf, u32 column, u32 len)
+/* Start loading a page from the array into the cache */
+static void sfc_nand_load_page(u32 row)
 {
-	int ret;
-	u32 plane;
 	struct rk_sfc_op op;
-	u32 ecc_result;
-	u8 status;
 
 	op.sfcmd.d32 = 0;
 	op.sfcmd.b.cmd = 0x13;
@@ -939,27 +978,69 @@ u32 sfc_nand_read(u32 row, u32 *p_page_buf, u32 column, u32 len)
 
 	op.sfctrl.d32 = 0;
 
-	sfc_request(&op, row, p_page_buf, 0);
+	sfc_request(&op, row, NULL, 0);
 
 	if (sfc_nand_dev.read_lines == DATA_LINES_X4 &&
 	    p_nand_info->feature & FEA_SOFT_QOP_BIT &&
 	    sfc_get_version() < SFC_VER_3)
 		sfc_nand_rw_preset();
+}
+
+u32 sfc_nand_read(u32 row, u32 *p_page_buf, u32 column, u32 len)
+{
+	int ret;
+	u32 ecc_result;
+	u8 status;
+
+	sfc_nand_cache_read_end();
+	sfc_nand_load_page(row);
 
 	sfc_nand_wait_busy(&status, 1000 * 1000);
 	ecc_result = p_nand_info->ecc_status();
 
-	op.sfcmd.d32 = 0;
-	op.sfcmd.b.cmd = sfc_nand_dev.page_read_cmd;
-	op.sfcmd.b.addrbits = SFC_ADDR_XBITS;
-	op.sfcmd.b.dummybits = 8;
+	ret = sfc_nand_read_cache(row, p_page_buf, column, len);
+	rkflash_print_dio("%s %x %x\n", __func__, row, p_page_buf[0]);
 
-	op.sfctrl.d32 = 0;
-	op.sfctrl.b.datalines = sfc_nand_dev.read_lines;
-	op.sfctrl.b.addrbits = 16;
+	if (ret != SFC_OK)
+		return SFC_NAND_HW_ERROR;
 
-	plane = p_nand_info->plane_per_die == 2 ? ((row >> 6) & 0x1) << 12 : 0;
-	ret = sfc_request(&op, plane | column, p_page_buf, len);
+	return ecc_result;
+}
+
+/*
+ * Read a page with the cache read sequential command. While a page is
+ * transferred out of the cache, the device already loads the next page of
+ * the block from the array, so a run of sequential page reads, which is
+ * what the FTL does for large requests, only waits for the array once.
+ * The sequence ends at the end of the block or at the first request for
+ * another page.
+ */
+static u32 sfc_nand_read_seq(u32 row, u32 *p_page_buf, u32 len)
+{
+	bool more = (row + 1) % p_nand_info->page_per_blk != 0;
+	int ret;
+	u32 ecc_result;
+	u8 status;
+
+	if (sfc_nand_dev.cache_row == row) {
+		/* Loaded while the previous page was transferred */
+		rkflash_stats.cached_pages++;
+		sfc_nand_cache_read_cmd(more ? CMD_READ_CACHE_SEQ :
+					CMD_READ_CACHE_END);
+	} else {
+		sfc_nand_cache_read_end();
+		sfc_nand_load_page(row);
+		if (more) {
+			sfc_nand_wait_busy(&status, 1000 * 1000);
+			sfc_nand_cache_read_cmd(CMD_READ_CACHE_SEQ);
+		}
+	}
+	sfc_nand_dev.cache_row = more ? row + 1 : INVALID_UINT32;
+
+	/* Waits for the page to be in the cache */
+	ecc_result = p_nand_info->ecc_status();
+
+	ret = sfc_nand_read_cache(row, p_page_buf, 0, len);
 	rkflash_print_dio("%s %x %x\n", __func__, row, p_page_buf[0]);
 
 	if (ret != SFC_OK)
@@ -982,7 +1063,12 @@ u32 sfc_nand_read_page(u8 cs, u32 addr, u32 *p_data, u32 *p_spare)
 	u32 data_size = sec_per_page * SFC_NAND_SECTOR_SIZE;
 	struct nand_mega_area *meta = &p_nand_info->meta;
 
-	ret = sfc_nand_read_page_raw(cs, addr, gp_page_buf);
+	if (p_nand_info->feature & FEA_CACHE_READ)
+		ret = sfc_nand_read_seq(addr, gp_page_buf, sec_per_page *
+					SFC_NAND_SECTOR_FULL_SIZE);
+	else
+		ret = sfc_nand_read_page_raw(cs, addr, gp_page_buf);
+	rkflash_stats.pages++;
 	memcpy(p_data, gp_page_buf, data_size);
 	p_spare[0] = gp_page_buf[(data_size + meta->off0) / 4];
 	p_spare[1] = gp_page_buf[(data_size + meta->off1) / 4];
@@ -1161,6 +1247,7 @@ u32 sfc_nand_init(void)
 	sfc_nand_dev.capacity = p_nand_info->density;
 	sfc_nand_dev.block_size = p_nand_info->page_per_blk * p_nand_info->sec_per_page;
 	sfc_nand_dev.page_size = p_nand_info->sec_per_page;
+	sfc_nand_dev.cache_row = INVALID_UINT32;
 
 	/* disable block lock */
 	sfc_nand_write_feature(0xA0, 0);
@@ -1196,6 +1283,8 @@ u32 sfc_nand_init(void)
 	rkflash_print_info("prog_lines = %x\n", sfc_nand_dev.prog_lines);
 	rkflash_print_info("page_read_cmd = %x\n", sfc_nand_dev.page_read_cmd);
 	rkflash_print_info("page_prog_cmd = %x\n", sfc_nand_dev.page_prog_cmd);
+	rkflash_print_info("cache_read = %d\n",
+			   !!(p_nand_info->feature & FEA_CACHE_READ));
 
 	return SFC_OK;
 }
@@ -1203,6 +1292,7 @@ u32 sfc_nand_init(void)
 void sfc_nand_deinit(void)
 {
 	/* to-do */
+	sfc_nand_cache_read_end();
 	kfree(sfc_nand_dev.recheck_buffer);
 }
 
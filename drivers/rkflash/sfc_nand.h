@@ -28,6 +28,7 @@
 #define FEA_4BYTE_ADDR          BIT(4)
 #define FEA_4BYTE_ADDR_MODE	BIT(5)
 #define FEA_SOFT_QOP_BIT	BIT(6)
+#define FEA_CACHE_READ		BIT(7)
 
 /* Command Set */
 #define CMD_READ_JEDECID        (0x9F)
@@ -67,6 +68,8 @@
 /* X1 cmd, X4 addr, X4 data, SUPPORT MARCONIX */
 #define CMD_PAGE_PROG_A4        (0x38)
 #define CMD_RESET_NAND          (0xFF)
+#define CMD_READ_CACHE_SEQ      (0x31)
+#define CMD_READ_CACHE_END      (0x3F)
 
 #define CMD_ENTER_4BYTE_MODE    (0xB7)
 #define CMD_EXIT_4BYTE_MODE     (0xE9)
@@ -84,6 +87,8 @@ struct SFNAND_DEV {
 	u8 page_read_cmd;
 	u8 page_prog_cmd;
 	u8 *recheck_buffer;
+	/* Page loading in a cache read sequence, INVALID_UINT32 if none */
+	u32 cache_row;
 };
 
 struct nand_mega_area {
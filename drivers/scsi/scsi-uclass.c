@@ -23,6 +23,22 @@ int scsi_exec(struct udevice *dev, struct scsi_cmd *pccb)
 	return ops->exec(dev, pccb);
 }
 
+int scsi_exec_batch(struct udevice *dev, struct scsi_cmd *cmds, int count)
+{
+	struct scsi_ops *ops = scsi_get_ops(dev);
+	int i;
+
+	if (ops->exec_batch)
+		return ops->exec_batch(dev, cmds, count);
+
+	for (i = 0; i < count; i++) {
+		if (scsi_exec(dev, &cmds[i]))
+			break;
+	}
+
+	return i;
+}
+
 int scsi_bus_reset(struct udevice *dev)
 {
 	struct scsi_ops *ops = scsi_get_ops(dev);
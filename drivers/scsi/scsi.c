@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <div64.h>
 #include <inttypes.h>
 #include <pci.h>
 #include <scsi.h>
@@ -47,23 +48,56 @@ static struct blk_desc scsi_dev_desc[CONFIG_SYS_SCSI_MAX_DEVICE];
 
 /* almost the maximum amount of the scsi_ext command.. */
 #define SCSI_MAX_READ_BLK 0xFFFF
+#define SCSI_MAX_READ16_BLK 0xFFFFFFFF
 #define SCSI_LBA48_READ	0xFFFFFFF
 
+/* READ commands handed to the controller at once */
+#define SCSI_MAX_BATCH	32
+
+static struct scsi_cmd scsi_batch[SCSI_MAX_BATCH];
+
+/**
+ * struct scsi_stats - transfer counters of one LUN, shown by 'scsi info'
+ *
+ * @bytes:	Bytes transferred, read and write
+ * @us:		Time spent transferring them, read and write
+ * @cmds:	READ and WRITE commands issued
+ * @max_batch:	Most READ commands queued to the controller at once
+ */
+struct scsi_stats {
+	u64 bytes[2];
+	u64 us[2];
+	ulong cmds[2];
+	int max_batch;
+};
+
+#if !CONFIG_IS_ENABLED(BLK)
+static struct scsi_stats scsi_dev_stats[CONFIG_SYS_SCSI_MAX_DEVICE];
+#endif
+
+static struct scsi_stats *scsi_get_stats(struct blk_desc *block_dev)
+{
+#if CONFIG_IS_ENABLED(BLK)
+	return dev_get_platdata(block_dev->bdev);
+#else
+	return &scsi_dev_stats[block_dev->devnum];
+#endif
+}
+
 static void scsi_print_error(struct scsi_cmd *pccb)
 {
 	/* Dummy function that could print an error for debugging */
 }
 
-#ifdef CONFIG_SYS_64BIT_LBA
-void scsi_setup_read16(struct scsi_cmd *pccb, lbaint_t start,
-		       unsigned long blocks)
+static void scsi_setup_read16(struct scsi_cmd *pccb, lbaint_t start,
+			      unsigned long blocks)
 {
 	pccb->cmd[0] = SCSI_READ16;
 	pccb->cmd[1] = pccb->lun << 5;
-	pccb->cmd[2] = (unsigned char)(start >> 56) & 0xff;
-	pccb->cmd[3] = (unsigned char)(start >> 48) & 0xff;
-	pccb->cmd[4] = (unsigned char)(start >> 40) & 0xff;
-	pccb->cmd[5] = (unsigned char)(start >> 32) & 0xff;
+	pccb->cmd[2] = (unsigned char)((u64)start >> 56) & 0xff;
+	pccb->cmd[3] = (unsigned char)((u64)start >> 48) & 0xff;
+	pccb->cmd[4] = (unsigned char)((u64)start >> 40) & 0xff;
+	pccb->cmd[5] = (unsigned char)((u64)start >> 32) & 0xff;
 	pccb->cmd[6] = (unsigned char)(start >> 24) & 0xff;
 	pccb->cmd[7] = (unsigned char)(start >> 16) & 0xff;
 	pccb->cmd[8] = (unsigned char)(start >> 8) & 0xff;
@@ -82,7 +116,6 @@ void scsi_setup_read16(struct scsi_cmd *pccb, lbaint_t start,
 	      pccb->cmd[6], pccb->cmd[7], pccb->cmd[8], pccb->cmd[9],
 	      pccb->cmd[11], pccb->cmd[12], pccb->cmd[13], pccb->cmd[14]);
 }
-#endif
 
 static void scsi_setup_read_ext(struct scsi_cmd *pccb, lbaint_t start,
 				unsigned short blocks)
@@ -142,6 +175,38 @@ static void scsi_setup_inquiry(struct scsi_cmd *pccb)
 	pccb->msgout[0] = SCSI_IDENTIFY; /* NOT USED */
 }
 
+/* Blocks per READ, limited by what the controller can take in one command */
+static lbaint_t scsi_max_read_blocks(struct udevice *bdev,
+				     struct blk_desc *block_dev)
+{
+#ifdef CONFIG_DM_SCSI
+	struct scsi_platdata *uc_plat = dev_get_uclass_platdata(bdev);
+
+	if (uc_plat->max_bytes_per_req)
+		return clamp_t(ulong,
+			       uc_plat->max_bytes_per_req / block_dev->blksz,
+			       1, SCSI_MAX_READ16_BLK);
+#endif
+	return SCSI_MAX_READ_BLK;
+}
+
+static int scsi_exec_cmds(struct udevice *bdev, struct scsi_cmd *cmds,
+			  int count)
+{
+#ifdef CONFIG_DM_SCSI
+	return scsi_exec_batch(bdev, cmds, count);
+#else
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (scsi_exec(bdev, &cmds[i]))
+			break;
+	}
+
+	return i;
+#endif
+}
+
 #ifdef CONFIG_BLK
 static ulong scsi_read(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		       void *buffer)
@@ -156,60 +221,57 @@ static ulong scsi_read(struct blk_desc *block_dev, lbaint_t blknr,
 #else
 	struct udevice *bdev = NULL;
 #endif
-	lbaint_t start, blks;
+	struct scsi_stats *stats = scsi_get_stats(block_dev);
+	lbaint_t start, blks, blocks, max_blks, done = 0;
 	uintptr_t buf_addr;
-	unsigned short smallblks = 0;
-	struct scsi_cmd *pccb = (struct scsi_cmd *)&tempccb;
+	struct scsi_cmd *pccb;
+	ulong start_us;
+	int num, ok, i;
 
-	/* Setup device */
-	pccb->target = block_dev->target;
-	pccb->lun = block_dev->lun;
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
+	max_blks = scsi_max_read_blocks(bdev, block_dev);
 	debug("\nscsi_read: dev %d startblk " LBAF
 	      ", blccnt " LBAF " buffer %lx\n",
 	      block_dev->devnum, start, blks, (unsigned long)buffer);
-	do {
-		pccb->pdata = (unsigned char *)buf_addr;
-		pccb->dma_dir = DMA_FROM_DEVICE;
-#ifdef CONFIG_SYS_64BIT_LBA
-		if (start > SCSI_LBA48_READ) {
-			unsigned long blocks;
-			blocks = min_t(lbaint_t, blks, SCSI_MAX_READ_BLK);
+	start_us = timer_get_us();
+	while (blks) {
+		/* Queue as many READs as fit in the batch, then run them */
+		for (num = 0; num < SCSI_MAX_BATCH && blks; num++) {
+			pccb = &scsi_batch[num];
+			blocks = min(blks, max_blks);
+			pccb->target = block_dev->target;
+			pccb->lun = block_dev->lun;
+			pccb->pdata = (unsigned char *)buf_addr;
+			pccb->dma_dir = DMA_FROM_DEVICE;
 			pccb->datalen = block_dev->blksz * blocks;
-			scsi_setup_read16(pccb, start, blocks);
+			if (blocks > SCSI_MAX_READ_BLK ||
+			    (u64)start > SCSI_LBA48_READ)
+				scsi_setup_read16(pccb, start, blocks);
+			else
+				scsi_setup_read_ext(pccb, start, blocks);
 			start += blocks;
 			blks -= blocks;
-		} else
-#endif
-		if (blks > SCSI_MAX_READ_BLK) {
-			pccb->datalen = block_dev->blksz *
-				SCSI_MAX_READ_BLK;
-			smallblks = SCSI_MAX_READ_BLK;
-			scsi_setup_read_ext(pccb, start, smallblks);
-			start += SCSI_MAX_READ_BLK;
-			blks -= SCSI_MAX_READ_BLK;
-		} else {
-			pccb->datalen = block_dev->blksz * blks;
-			smallblks = (unsigned short)blks;
-			scsi_setup_read_ext(pccb, start, smallblks);
-			start += blks;
-			blks = 0;
+			buf_addr += pccb->datalen;
 		}
-		debug("scsi_read_ext: startblk " LBAF
-		      ", blccnt %x buffer %" PRIXPTR "\n",
-		      start, smallblks, buf_addr);
-		if (scsi_exec(bdev, pccb)) {
-			scsi_print_error(pccb);
-			blkcnt -= blks;
+		debug("scsi_read: %d commands up to startblk " LBAF
+		      " buffer %" PRIXPTR "\n", num, start, buf_addr);
+
+		ok = scsi_exec_cmds(bdev, scsi_batch, num);
+		for (i = 0; i < ok; i++)
+			done += scsi_batch[i].datalen / block_dev->blksz;
+		stats->cmds[0] += ok;
+		stats->max_batch = max(stats->max_batch, num);
+		if (ok < num) {
+			scsi_print_error(&scsi_batch[ok]);
 			break;
 		}
-		buf_addr += pccb->datalen;
-	} while (blks != 0);
-	debug("scsi_read_ext: end startblk " LBAF
-	      ", blccnt %x buffer %" PRIXPTR "\n", start, smallblks, buf_addr);
-	return blkcnt;
+	}
+	stats->bytes[0] += (u64)done * block_dev->blksz;
+	stats->us[0] += timer_get_us() - start_us;
+	debug("scsi_read: end " LBAF " of " LBAF " blocks\n", done, blkcnt);
+	return done;
 }
 
 /*******************************************************************************
@@ -233,10 +295,12 @@ static ulong scsi_write(struct blk_desc *block_dev, lbaint_t blknr,
 #else
 	struct udevice *bdev = NULL;
 #endif
+	struct scsi_stats *stats = scsi_get_stats(block_dev);
 	lbaint_t start, blks;
 	uintptr_t buf_addr;
 	unsigned short smallblks;
 	struct scsi_cmd *pccb = (struct scsi_cmd *)&tempccb;
+	ulong start_us;
 
 	/* Setup device */
 	pccb->target = block_dev->target;
@@ -246,6 +310,7 @@ static ulong scsi_write(struct blk_desc *block_dev, lbaint_t blknr,
 	blks = blkcnt;
 	debug("\n%s: dev %d startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
 	      __func__, block_dev->devnum, start, blks, (unsigned long)buffer);
+	start_us = timer_get_us();
 	do {
 		pccb->pdata = (unsigned char *)buf_addr;
 		pccb->dma_dir = DMA_TO_DEVICE;
@@ -267,11 +332,14 @@ static ulong scsi_write(struct blk_desc *block_dev, lbaint_t blknr,
 		      __func__, start, smallblks, buf_addr);
 		if (scsi_exec(bdev, pccb)) {
 			scsi_print_error(pccb);
-			blkcnt -= blks;
+			blkcnt -= blks + smallblks;
 			break;
 		}
+		stats->cmds[1]++;
 		buf_addr += pccb->datalen;
 	} while (blks != 0);
+	stats->bytes[1] += (u64)blkcnt * block_dev->blksz;
+	stats->us[1] += timer_get_us() - start_us;
 	debug("%s: end startblk " LBAF ", blccnt %x buffer %" PRIXPTR "\n",
 	      __func__, start, smallblks, buf_addr);
 	return blkcnt;
@@ -662,6 +730,9 @@ int scsi_scan(bool verbose)
 		printf("scanning bus for devices...\n");
 	for (i = 0; i < CONFIG_SYS_SCSI_MAX_DEVICE; i++)
 		scsi_init_dev_desc(&scsi_dev_desc[i], i);
+#if !CONFIG_IS_ENABLED(BLK)
+	memset(scsi_dev_stats, 0, sizeof(scsi_dev_stats));
+#endif
 
 	scsi_max_devs = 0;
 	for (i = 0; i < CONFIG_SYS_SCSI_MAX_SCSI_ID; i++) {
@@ -692,6 +763,33 @@ int scsi_scan(bool verbose)
 }
 #endif
 
+static void scsi_print_rate(const char *name, u64 bytes, u64 us, ulong cmds)
+{
+	printf("  %s: %llu KiB in %lu cmds", name, bytes >> 10, cmds);
+	if (us)
+		printf(", %llu KiB/s", lldiv(bytes * 1000000 / 1024, us));
+	printf("\n");
+}
+
+void scsi_show_stats(void)
+{
+	struct blk_desc *block_dev;
+	struct scsi_stats *stats;
+	int i;
+
+	for (i = 0; (block_dev = blk_get_devnum_by_type(IF_TYPE_SCSI, i)); i++) {
+		if (block_dev->type == DEV_TYPE_UNKNOWN)
+			continue;
+		stats = scsi_get_stats(block_dev);
+		printf("Device %d: id %d lun %d, up to %d READs queued\n", i,
+		       block_dev->target, block_dev->lun, stats->max_batch);
+		scsi_print_rate("Read", stats->bytes[0], stats->us[0],
+				stats->cmds[0]);
+		scsi_print_rate("Write", stats->bytes[1], stats->us[1],
+				stats->cmds[1]);
+	}
+}
+
 #ifdef CONFIG_BLK
 static const struct blk_ops scsi_blk_ops = {
 	.read	= scsi_read,
@@ -702,6 +800,7 @@ U_BOOT_DRIVER(scsi_blk) = {
 	.name		= "scsi_blk",
 	.id		= UCLASS_BLK,
 	.ops		= &scsi_blk_ops,
+	.platdata_auto_alloc_size = sizeof(struct scsi_stats),
 };
 #else
 U_BOOT_LEGACY_BLK(scsi) = {
@@ -655,6 +655,77 @@ static int rockchip_sfc_adjust_op_size(struct spi_slave *mem, struct spi_mem_op
 	return 0;
 }
 
+static int rockchip_sfc_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct rockchip_sfc *sfc = dev_get_platdata(desc->slave->dev->parent);
+
+	/* Without the DMA master every chunk goes through the FIFO anyway */
+	if (!sfc->use_dma)
+		return -ENOTSUPP;
+
+	if (!spi_mem_default_supports_op(desc->slave, &desc->info.op_tmpl))
+		return -ENOTSUPP;
+
+	return 0;
+}
+
+/*
+ * Stream the whole request with back-to-back DMA commands into one bounce
+ * buffer, so a large read costs a single cache maintenance pass and no
+ * per-chunk op validation, bus claiming or buffer allocation.
+ */
+static ssize_t rockchip_sfc_dirmap_read(struct spi_mem_dirmap_desc *desc,
+					u64 offs, size_t len, void *buf)
+{
+	struct spi_slave *mem = desc->slave;
+	struct rockchip_sfc *sfc = dev_get_platdata(mem->dev->parent);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	struct bounce_buffer bb;
+	size_t done;
+	int ret;
+
+	if (sfc->last_async_size) {
+		rockchip_sfc_wait_for_dma_finished(sfc, sfc->last_async_size);
+		sfc->last_async_size = 0;
+	}
+
+	op.addr.val = desc->info.offset + offs;
+	if (len < SFC_DMA_TRANS_THRETHOLD) {
+		op.data.buf.in = buf;
+		rockchip_sfc_xfer_setup(sfc, mem, &op, len);
+		ret = rockchip_sfc_xfer_data_poll(sfc, &op, len);
+		if (ret != len)
+			return -EIO;
+
+		ret = rockchip_sfc_xfer_done(sfc, 100000);
+
+		return ret ? ret : len;
+	}
+
+	ret = bounce_buffer_start(&bb, buf, len, GEN_BB_WRITE);
+	if (ret)
+		return ret;
+
+	for (done = 0; done < len; done += op.data.nbytes) {
+		op.data.nbytes = min_t(size_t, len - done, sfc->max_iosize);
+		rockchip_sfc_xfer_setup(sfc, mem, &op, op.data.nbytes);
+		rockchip_sfc_fifo_transfer_dma(sfc,
+					       (dma_addr_t)bb.bounce_buffer + done,
+					       op.data.nbytes);
+		ret = rockchip_sfc_wait_for_dma_finished(sfc,
+							 op.data.nbytes * 10);
+		if (!ret)
+			ret = rockchip_sfc_xfer_done(sfc, 100000);
+		if (ret)
+			break;
+
+		op.addr.val += op.data.nbytes;
+	}
+	bounce_buffer_stop(&bb);
+
+	return ret ? ret : len;
+}
+
 #if CONFIG_IS_ENABLED(CLK)
 static int rockchip_sfc_exec_op_bypass(struct rockchip_sfc *sfc,
 				       struct spi_slave *mem,
@@ -794,6 +865,8 @@ static int rockchip_sfc_set_mode(struct udevice *bus, uint mode)
 static const struct spi_controller_mem_ops rockchip_sfc_mem_ops = {
 	.adjust_op_size	= rockchip_sfc_adjust_op_size,
 	.exec_op	= rockchip_sfc_exec_op,
+	.dirmap_create	= rockchip_sfc_dirmap_create,
+	.dirmap_read	= rockchip_sfc_dirmap_read,
 };
 
 static const struct dm_spi_ops rockchip_sfc_ops = {
@@ -3,8 +3,10 @@
  * Copyright (C) 2018 Texas Instruments Incorporated - http://www.ti.com/
  */
 
+#include <malloc.h>
 #include <spi.h>
 #include <spi-mem.h>
+#include <linux/err.h>
 
 int spi_mem_exec_op(struct spi_slave *slave,
 		    const struct spi_mem_op *op)
@@ -103,3 +105,53 @@ int spi_mem_adjust_op_size(struct spi_slave *slave,
 
 	return 0;
 }
+
+/* Without driver model every direct mapping is a plain exec_op() loop */
+struct spi_mem_dirmap_desc *
+spi_mem_dirmap_create(struct spi_slave *slave,
+		      const struct spi_mem_dirmap_info *info)
+{
+	struct spi_mem_dirmap_desc *desc;
+
+	if (!info->op_tmpl.addr.nbytes || info->op_tmpl.addr.nbytes > 8 ||
+	    info->op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return ERR_PTR(-EINVAL);
+
+	desc = calloc(1, sizeof(*desc));
+	if (!desc)
+		return ERR_PTR(-ENOMEM);
+
+	desc->slave = slave;
+	desc->info = *info;
+	desc->nodirmap = true;
+
+	return desc;
+}
+
+void spi_mem_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	free(desc);
+}
+
+ssize_t spi_mem_dirmap_read(struct spi_mem_dirmap_desc *desc,
+			    u64 offs, size_t len, void *buf)
+{
+	struct spi_mem_op op = desc->info.op_tmpl;
+	int ret;
+
+	if (!len)
+		return 0;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.buf.in = buf;
+	op.data.nbytes = len;
+	ret = spi_mem_adjust_op_size(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	ret = spi_mem_exec_op(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	return op.data.nbytes;
+}
@@ -44,7 +44,7 @@
 /* Timeout after 30 msecs if NOP OUT hangs without response */
 #define NOP_OUT_TIMEOUT    30 /* msecs */
 
-/* Only use one Task Tag for all requests */
+/* Device management commands always use the first slot */
 #define TASK_TAG	0
 
 /* Expose the flag value from utp_upiu_query.value */
@@ -598,21 +598,26 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
 	dma_addr_t cmd_desc_dma_addr;
 	u16 response_offset;
 	u16 prdt_offset;
+	int i;
 
-	utrdlp = hba->utrdl;
-	cmd_desc_dma_addr = (dma_addr_t)hba->ucdl;
+	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
+	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
 
-	utrdlp->command_desc_base_addr_lo =
+	for (i = 0; i < hba->nutrs; i++) {
+		utrdlp = &hba->utrdl[i];
+		cmd_desc_dma_addr = (dma_addr_t)&hba->ucdl[i];
+
+		utrdlp->command_desc_base_addr_lo =
 				cpu_to_le32(lower_32_bits(cmd_desc_dma_addr));
-	utrdlp->command_desc_base_addr_hi =
+		utrdlp->command_desc_base_addr_hi =
 				cpu_to_le32(upper_32_bits(cmd_desc_dma_addr));
 
-	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
-	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
-
-	utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
-	utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
-	utrdlp->response_upiu_length = cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+		utrdlp->response_upiu_offset =
+				cpu_to_le16(response_offset >> 2);
+		utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
+		utrdlp->response_upiu_length =
+				cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+	}
 
 	hba->ucd_req_ptr = (struct utp_upiu_req *)hba->ucdl;
 	hba->ucd_rsp_ptr =
@@ -626,19 +631,21 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
  */
 static int ufshcd_memory_alloc(struct ufs_hba *hba)
 {
-	/* Allocate one Transfer Request Descriptor
+	/* Allocate one Transfer Request Descriptor per slot
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->utrdl = memalign(1024, sizeof(struct utp_transfer_req_desc));
+	hba->utrdl = memalign(1024, hba->nutrs *
+			      sizeof(struct utp_transfer_req_desc));
 	if (!hba->utrdl) {
 		dev_err(hba->dev, "Transfer Descriptor memory allocation failed\n");
 		return -ENOMEM;
 	}
 
-	/* Allocate one Command Descriptor
+	/* Allocate one Command Descriptor per slot
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->ucdl = memalign(1024, sizeof(struct utp_transfer_cmd_desc));
+	hba->ucdl = memalign(1024, hba->nutrs *
+			     sizeof(struct utp_transfer_cmd_desc));
 	if (!hba->ucdl) {
 		dev_err(hba->dev, "Command descriptor memory allocation failed\n");
 		return -ENOMEM;
@@ -807,36 +814,91 @@ static int ufshcd_comp_devman_upiu(struct ufs_hba *hba,
 	return ret;
 }
 
-static int ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
+static void ufshcd_cache_flush(void *addr, unsigned long size)
+{
+	uintptr_t start = (uintptr_t)addr & ~(ARCH_DMA_MINALIGN - 1);
+	uintptr_t end = ALIGN((uintptr_t)addr + size, ARCH_DMA_MINALIGN);
+
+	flush_dcache_range(start, end);
+}
+
+static void ufshcd_cache_invalidate(void *addr, unsigned long size)
+{
+	uintptr_t start = (uintptr_t)addr & ~(ARCH_DMA_MINALIGN - 1);
+	uintptr_t end = ALIGN((uintptr_t)addr + size, ARCH_DMA_MINALIGN);
+
+	invalidate_dcache_range(start, end);
+}
+
+/**
+ * ufshcd_send_commands - ring the doorbell once for all slots in @tags
+ *
+ * The slots must be fully prepared. Returns once every one of them has
+ * completed; slots still outstanding after an error are cleared.
+ */
+static int ufshcd_send_commands(struct ufs_hba *hba, u32 tags)
 {
 	unsigned long start;
 	u32 intr_status;
 	u32 enabled_intr_status;
+	u32 pending, last;
+	int tag, err = 0;
+
+	ufshcd_cache_flush(hba->utrdl,
+			   hba->nutrs * sizeof(struct utp_transfer_req_desc));
+	for (tag = 0; tag < hba->nutrs; tag++) {
+		if (tags & BIT(tag))
+			ufshcd_cache_flush(&hba->ucdl[tag],
+					   sizeof(struct utp_transfer_cmd_desc));
+	}
 
-	ufshcd_writel(hba, 1 << task_tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+	ufshcd_writel(hba, tags, REG_UTP_TRANSFER_REQ_DOOR_BELL);
 
+	/* The doorbell bit of a slot clears when its command completes */
 	start = get_timer(0);
+	last = tags;
 	do {
 		intr_status = ufshcd_readl(hba, REG_INTERRUPT_STATUS);
 		enabled_intr_status = intr_status & hba->intr_mask;
 		ufshcd_writel(hba, intr_status, REG_INTERRUPT_STATUS);
 
-		if (get_timer(start) > QUERY_REQ_TIMEOUT) {
-			dev_err(hba->dev,
-				"Timedout waiting for UTP response\n");
-
-			return -ETIMEDOUT;
-		}
-
 		if (enabled_intr_status & UFSHCD_ERROR_MASK) {
 			dev_err(hba->dev, "Error in status:%08x\n",
 				enabled_intr_status);
+			err = -EIO;
+			break;
+		}
 
-			return -1;
+		pending = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL) &
+			  tags;
+		/* Time out per command, not for the whole batch */
+		if (pending != last) {
+			last = pending;
+			start = get_timer(0);
+		} else if (get_timer(start) > QUERY_REQ_TIMEOUT) {
+			dev_err(hba->dev,
+				"Timedout waiting for UTP response\n");
+			err = -ETIMEDOUT;
+			break;
 		}
-	} while (!(enabled_intr_status & UTP_TRANSFER_REQ_COMPL));
+	} while (pending);
 
-	return 0;
+	if (err) {
+		pending = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+		if (pending & tags)
+			ufshcd_writel(hba, ~(pending & tags),
+				      REG_UTP_TRANSFER_REQ_LIST_CLEAR);
+	}
+
+	ufshcd_cache_invalidate(hba->utrdl,
+				hba->nutrs * sizeof(struct utp_transfer_req_desc));
+	for (tag = 0; tag < hba->nutrs; tag++) {
+		if (tags & BIT(tag))
+			ufshcd_cache_invalidate(hba->ucdl[tag].response_upiu,
+						ALIGNED_UPIU_SIZE);
+	}
+
+	return err;
 }
 
 /**
@@ -851,9 +913,9 @@ static inline int ufshcd_get_req_rsp(struct utp_upiu_rsp *ucd_rsp_ptr)
  * ufshcd_get_tr_ocs - Get the UTRD Overall Command Status
  *
  */
-static inline int ufshcd_get_tr_ocs(struct ufs_hba *hba)
+static inline int ufshcd_get_tr_ocs(struct ufs_hba *hba, int tag)
 {
-	return le32_to_cpu(hba->utrdl->header.dword_2) & MASK_OCS;
+	return le32_to_cpu(hba->utrdl[tag].header.dword_2) & MASK_OCS;
 }
 
 static inline int ufshcd_get_rsp_upiu_result(struct utp_upiu_rsp *ucd_rsp_ptr)
@@ -920,11 +982,11 @@ static int ufshcd_exec_dev_cmd(struct ufs_hba *hba, enum dev_cmd_type cmd_type,
 	if (err)
 		return err;
 
-	err = ufshcd_send_command(hba, TASK_TAG);
+	err = ufshcd_send_commands(hba, BIT(TASK_TAG));
 	if (err)
 		return err;
 
-	err = ufshcd_get_tr_ocs(hba);
+	err = ufshcd_get_tr_ocs(hba, TASK_TAG);
 	if (err) {
 		dev_err(hba->dev, "Error in OCS:%d\n", err);
 		return -EINVAL;
@@ -1379,16 +1441,17 @@ static int ufshcd_uic_change_pwr_mode(struct ufs_hba *hba, u8 mode)
 }
 
 static
-void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
+void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba, int tag,
 				      struct scsi_cmd *pccb, u32 upiu_flags)
 {
-	struct utp_upiu_req *ucd_req_ptr = hba->ucd_req_ptr;
+	struct utp_transfer_cmd_desc *ucd = &hba->ucdl[tag];
+	struct utp_upiu_req *ucd_req_ptr = (void *)ucd->command_upiu;
 	unsigned int cdb_len;
 
 	/* command descriptor fields */
 	ucd_req_ptr->header.dword_0 =
 			UPIU_HEADER_DWORD(UPIU_TRANSACTION_COMMAND, upiu_flags,
-					  pccb->lun, TASK_TAG);
+					  pccb->lun, tag);
 	ucd_req_ptr->header.dword_1 =
 			UPIU_HEADER_DWORD(UPIU_COMMAND_SET_TYPE_SCSI, 0, 0, 0);
 
@@ -1401,7 +1464,7 @@ void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
 	memset(ucd_req_ptr->sc.cdb, 0, UFS_CDB_SIZE);
 	memcpy(ucd_req_ptr->sc.cdb, pccb->cmd, cdb_len);
 
-	memset(hba->ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
+	memset(ucd->response_upiu, 0, sizeof(struct utp_upiu_rsp));
 }
 
 static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
@@ -1412,10 +1475,11 @@ static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
 	entry->upper_addr = cpu_to_le32(upper_32_bits((unsigned long)buf));
 }
 
-static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
+static int prepare_prdt_table(struct ufs_hba *hba, int tag,
+			      struct scsi_cmd *pccb)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	struct ufshcd_sg_entry *prd_table = hba->ucd_prdt_ptr;
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[tag];
+	struct ufshcd_sg_entry *prd_table = hba->ucdl[tag].prd_table;
 	ulong datalen = pccb->datalen;
 	int table_length;
 	u8 *buf;
@@ -1423,10 +1487,16 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 
 	if (!datalen) {
 		req_desc->prd_table_length = 0;
-		return;
+		return 0;
 	}
 
 	table_length = DIV_ROUND_UP(pccb->datalen, MAX_PRDT_ENTRY);
+	if (table_length > MAX_BUFF) {
+		dev_err(hba->dev, "Transfer of %lu bytes too large\n",
+			pccb->datalen);
+		return -E2BIG;
+	}
+
 	buf = pccb->pdata;
 	i = table_length;
 	while (--i) {
@@ -1439,29 +1509,30 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 	prepare_prdt_desc(&prd_table[table_length - i - 1], buf, datalen - 1);
 
 	req_desc->prd_table_length = table_length;
+
+	/* Reads are invalidated again once the data has arrived */
+	ufshcd_cache_flush(pccb->pdata, pccb->datalen);
+
+	return 0;
 }
 
-static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+static int ufshcd_get_scsi_result(struct ufs_hba *hba, int tag,
+				  struct scsi_cmd *pccb)
 {
-	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	u32 upiu_flags;
-	int ocs, result = 0;
+	struct utp_upiu_rsp *ucd_rsp_ptr = (void *)hba->ucdl[tag].response_upiu;
+	int ocs, result;
 	u8 scsi_status;
 
-	ufshcd_prepare_req_desc_hdr(req_desc, &upiu_flags, pccb->dma_dir);
-	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags);
-	prepare_prdt_table(hba, pccb);
-
-	ufshcd_send_command(hba, TASK_TAG);
+	if (pccb->dma_dir == DMA_FROM_DEVICE && pccb->datalen)
+		ufshcd_cache_invalidate(pccb->pdata, pccb->datalen);
 
-	ocs = ufshcd_get_tr_ocs(hba);
+	ocs = ufshcd_get_tr_ocs(hba, tag);
 	switch (ocs) {
 	case OCS_SUCCESS:
-		result = ufshcd_get_req_rsp(hba->ucd_rsp_ptr);
+		result = ufshcd_get_req_rsp(ucd_rsp_ptr);
 		switch (result) {
 		case UPIU_TRANSACTION_RESPONSE:
-			result = ufshcd_get_rsp_upiu_result(hba->ucd_rsp_ptr);
+			result = ufshcd_get_rsp_upiu_result(ucd_rsp_ptr);
 
 			scsi_status = result & MASK_SCSI_STATUS;
 			if (scsi_status)
@@ -1488,6 +1559,51 @@ static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
 	return 0;
 }
 
+/*
+ * Each command gets its own slot, so up to hba->nutrs of them are handed
+ * to the controller with a single doorbell write and run concurrently.
+ */
+static int ufs_scsi_exec_batch(struct udevice *scsi_dev,
+			       struct scsi_cmd *cmds, int count)
+{
+	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
+	int done, num, tag;
+	u32 upiu_flags;
+	u32 tags;
+
+	for (done = 0; done < count; done += num) {
+		num = min(count - done, hba->nutrs);
+		tags = 0;
+		for (tag = 0; tag < num; tag++) {
+			struct scsi_cmd *pccb = &cmds[done + tag];
+
+			ufshcd_prepare_req_desc_hdr(&hba->utrdl[tag],
+						    &upiu_flags,
+						    pccb->dma_dir);
+			ufshcd_prepare_utp_scsi_cmd_upiu(hba, tag, pccb,
+							 upiu_flags);
+			if (prepare_prdt_table(hba, tag, pccb))
+				break;
+			tags |= BIT(tag);
+		}
+		if (!tags || ufshcd_send_commands(hba, tags))
+			return done;
+
+		for (tag = 0; tag < num; tag++) {
+			if (!(tags & BIT(tag)) ||
+			    ufshcd_get_scsi_result(hba, tag, &cmds[done + tag]))
+				return done + tag;
+		}
+	}
+
+	return done;
+}
+
+static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+{
+	return ufs_scsi_exec_batch(scsi_dev, pccb, 1) == 1 ? 0 : -EINVAL;
+}
+
 static inline int ufshcd_read_desc(struct ufs_hba *hba, enum desc_idn desc_id,
 				   int desc_index, u8 *buf, u32 size)
 {
@@ -1592,6 +1708,11 @@ static int ufs_get_device_desc(struct ufs_hba *hba,
 
 	model_index = desc_buf[DEVICE_DESC_PARAM_PRDCT_NAME];
 
+	/* A queue depth of zero means the LUs are queued independently */
+	if (desc_buf[DEVICE_DESC_PARAM_Q_DPTH])
+		hba->nutrs = min_t(int, hba->nutrs,
+				   desc_buf[DEVICE_DESC_PARAM_Q_DPTH]);
+
 	/* Zero-pad entire buffer for string termination. */
 	memset(desc_buf, 0, buff_len);
 
@@ -1872,7 +1993,7 @@ int ufshcd_probe(struct udevice *ufs_dev, struct ufs_hba_ops *hba_ops)
 	scsi_plat = dev_get_uclass_platdata(scsi_dev);
 	scsi_plat->max_id = UFSHCD_MAX_ID;
 	scsi_plat->max_lun = UFS_MAX_LUNS;
-	//scsi_plat->max_bytes_per_req = UFS_MAX_BYTES;
+	scsi_plat->max_bytes_per_req = UFS_MAX_BYTES;
 
 	hba->dev = ufs_dev;
 	hba->ops = hba_ops;
@@ -1885,6 +2006,7 @@ int ufshcd_probe(struct udevice *ufs_dev, struct ufs_hba_ops *hba_ops)
 
 	/* Read capabilties registers */
 	hba->capabilities = ufshcd_readl(hba, REG_CONTROLLER_CAPABILITIES);
+	hba->nutrs = (hba->capabilities & MASK_TRANSFER_REQUESTS_SLOTS) + 1;
 
 	/* Get UFS version supported by the controller */
 	hba->version = ufshcd_get_ufs_version(hba);
@@ -1940,6 +2062,7 @@ int ufs_scsi_bind(struct udevice *ufs_dev, struct udevice **scsi_devp)
 
 static struct scsi_ops ufs_ops = {
 	.exec		= ufs_scsi_exec,
+	.exec_batch	= ufs_scsi_exec_batch,
 };
 
 int ufs_probe_dev(int index)
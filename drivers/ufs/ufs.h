@@ -710,6 +710,8 @@ struct ufs_hba {
 	u32			version;
 	u32			intr_mask;
 	u32			quirks;
+	/* Transfer request slots in use, from CAP.NUTRS and bQueueDepth */
+	int			nutrs;
 /*
  * If UFS host controller is having issue in processing LCC (Line
  * Control Command) coming from device then enable this quirk.
@@ -719,12 +721,13 @@ struct ufs_hba {
  */
 #define UFSHCD_QUIRK_BROKEN_LCC				0x1
 
-	/* Virtual memory reference */
+	/* Virtual memory reference, one UCD and UTRD per slot */
 	struct utp_transfer_cmd_desc *ucdl;
 	struct utp_transfer_req_desc *utrdl;
 	/* TODO: Add Task Manegement Support */
 	struct utp_task_req_desc *utmrdl;
 
+	/* Slot 0, used for device management commands */
 	struct utp_upiu_req *ucd_req_ptr;
 	struct utp_upiu_rsp *ucd_rsp_ptr;
 	struct ufshcd_sg_entry *ucd_prdt_ptr;
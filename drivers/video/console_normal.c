@@ -14,6 +14,17 @@
 #include <video_console.h>
 #include <video_font.h>		/* Get font data, width and height */
 
+/**
+ * struct console_normal_priv - Private data for this driver
+ *
+ * @nibble:	Pixel values for each 4-bit pattern of font bits, most
+ *		significant bit (left-most pixel) first, so that a row of a
+ *		character can be written without testing each bit
+ */
+struct console_normal_priv {
+	u32 nibble[16][4];
+};
+
 static int console_normal_set_row(struct udevice *dev, uint row, int clr)
 {
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
@@ -53,6 +64,8 @@ static int console_normal_set_row(struct udevice *dev, uint row, int clr)
 	default:
 		return -ENOSYS;
 	}
+	video_damage(dev->parent, 0, row * VIDEO_FONT_HEIGHT, vid_priv->xsize,
+		     VIDEO_FONT_HEIGHT);
 
 	return 0;
 }
@@ -67,6 +80,8 @@ static int console_normal_move_rows(struct udevice *dev, uint rowdst,
 	dst = vid_priv->fb + rowdst * VIDEO_FONT_HEIGHT * vid_priv->line_length;
 	src = vid_priv->fb + rowsrc * VIDEO_FONT_HEIGHT * vid_priv->line_length;
 	memmove(dst, src, VIDEO_FONT_HEIGHT * vid_priv->line_length * count);
+	video_damage(dev->parent, 0, rowdst * VIDEO_FONT_HEIGHT,
+		     vid_priv->xsize, count * VIDEO_FONT_HEIGHT);
 
 	return 0;
 }
@@ -75,8 +90,11 @@ static int console_normal_putc_xy(struct udevice *dev, uint x_frac, uint y,
 				  char ch)
 {
 	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(dev);
+	struct console_normal_priv *priv = dev_get_priv(dev);
 	struct udevice *vid = dev->parent;
 	struct video_priv *vid_priv = dev_get_uclass_priv(vid);
+	const uchar *font = video_fontdata + (uchar)ch * VIDEO_FONT_HEIGHT;
+	const u32 *hi, *lo;
 	int i, row;
 	void *line = vid_priv->fb + y * vid_priv->line_length +
 		VID_TO_PIXEL(x_frac) * VNBYTES(vid_priv->bpix);
@@ -84,51 +102,57 @@ static int console_normal_putc_xy(struct udevice *dev, uint x_frac, uint y,
 	if (x_frac + VID_TO_POS(vc_priv->x_charsize) > vc_priv->xsize_frac)
 		return -EAGAIN;
 
-	for (row = 0; row < VIDEO_FONT_HEIGHT; row++) {
-		uchar bits = video_fontdata[ch * VIDEO_FONT_HEIGHT + row];
-
-		switch (vid_priv->bpix) {
+	switch (vid_priv->bpix) {
 #ifdef CONFIG_VIDEO_BPP8
-		case VIDEO_BPP8: {
+	case VIDEO_BPP8:
+		for (row = 0; row < VIDEO_FONT_HEIGHT; row++) {
 			uint8_t *dst = line;
 
-			for (i = 0; i < VIDEO_FONT_WIDTH; i++) {
-				*dst++ = (bits & 0x80) ? vid_priv->colour_fg
-					: vid_priv->colour_bg;
-				bits <<= 1;
+			hi = priv->nibble[font[row] >> 4];
+			lo = priv->nibble[font[row] & 0xf];
+			for (i = 0; i < 4; i++) {
+				dst[i] = hi[i];
+				dst[i + 4] = lo[i];
 			}
-			break;
+			line += vid_priv->line_length;
 		}
+		break;
 #endif
 #ifdef CONFIG_VIDEO_BPP16
-		case VIDEO_BPP16: {
+	case VIDEO_BPP16:
+		for (row = 0; row < VIDEO_FONT_HEIGHT; row++) {
 			uint16_t *dst = line;
 
-			for (i = 0; i < VIDEO_FONT_WIDTH; i++) {
-				*dst++ = (bits & 0x80) ? vid_priv->colour_fg
-					: vid_priv->colour_bg;
-				bits <<= 1;
+			hi = priv->nibble[font[row] >> 4];
+			lo = priv->nibble[font[row] & 0xf];
+			for (i = 0; i < 4; i++) {
+				dst[i] = hi[i];
+				dst[i + 4] = lo[i];
 			}
-			break;
+			line += vid_priv->line_length;
 		}
+		break;
 #endif
 #ifdef CONFIG_VIDEO_BPP32
-		case VIDEO_BPP32: {
+	case VIDEO_BPP32:
+		for (row = 0; row < VIDEO_FONT_HEIGHT; row++) {
 			uint32_t *dst = line;
 
-			for (i = 0; i < VIDEO_FONT_WIDTH; i++) {
-				*dst++ = (bits & 0x80) ? vid_priv->colour_fg
-					: vid_priv->colour_bg;
-				bits <<= 1;
+			hi = priv->nibble[font[row] >> 4];
+			lo = priv->nibble[font[row] & 0xf];
+			for (i = 0; i < 4; i++) {
+				dst[i] = hi[i];
+				dst[i + 4] = lo[i];
 			}
-			break;
+			line += vid_priv->line_length;
 		}
+		break;
 #endif
-		default:
-			return -ENOSYS;
-		}
-		line += vid_priv->line_length;
+	default:
+		return -ENOSYS;
 	}
+	video_damage(vid, VID_TO_PIXEL(x_frac), y, VIDEO_FONT_WIDTH,
+		     VIDEO_FONT_HEIGHT);
 
 	return VID_TO_POS(VIDEO_FONT_WIDTH);
 }
@@ -136,14 +160,24 @@ static int console_normal_putc_xy(struct udevice *dev, uint x_frac, uint y,
 static int console_normal_probe(struct udevice *dev)
 {
 	struct vidconsole_priv *vc_priv = dev_get_uclass_priv(dev);
+	struct console_normal_priv *priv = dev_get_priv(dev);
 	struct udevice *vid_dev = dev->parent;
 	struct video_priv *vid_priv = dev_get_uclass_priv(vid_dev);
+	int i, bit;
 
 	vc_priv->x_charsize = VIDEO_FONT_WIDTH;
 	vc_priv->y_charsize = VIDEO_FONT_HEIGHT;
 	vc_priv->cols = vid_priv->xsize / VIDEO_FONT_WIDTH;
 	vc_priv->rows = vid_priv->ysize / VIDEO_FONT_HEIGHT;
 
+	/* The colours are fixed, so the pixels for each pattern are too */
+	for (i = 0; i < 16; i++) {
+		for (bit = 0; bit < 4; bit++) {
+			priv->nibble[i][bit] = i & (8 >> bit) ?
+				vid_priv->colour_fg : vid_priv->colour_bg;
+		}
+	}
+
 	return 0;
 }
 
@@ -158,4 +192,5 @@ U_BOOT_DRIVER(vidconsole_normal) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_normal_ops,
 	.probe	= console_normal_probe,
+	.priv_auto_alloc_size	= sizeof(struct console_normal_priv),
 };
@@ -55,6 +55,9 @@ static int console_set_row_1(struct udevice *dev, uint row, int clr)
 		}
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent,
+		     vid_priv->xsize - (row + 1) * VIDEO_FONT_HEIGHT, 0,
+		     VIDEO_FONT_HEIGHT, vid_priv->ysize);
 
 	return 0;
 }
@@ -78,6 +81,9 @@ static int console_move_rows_1(struct udevice *dev, uint rowdst, uint rowsrc,
 		src += vid_priv->line_length;
 		dst += vid_priv->line_length;
 	}
+	video_damage(dev->parent,
+		     vid_priv->xsize - (rowdst + count) * VIDEO_FONT_HEIGHT, 0,
+		     count * VIDEO_FONT_HEIGHT, vid_priv->ysize);
 
 	return 0;
 }
@@ -139,6 +145,8 @@ static int console_putc_xy_1(struct udevice *dev, uint x_frac, uint y, char ch)
 		line += vid_priv->line_length;
 		mask >>= 1;
 	}
+	video_damage(vid, vid_priv->xsize - y - VIDEO_FONT_HEIGHT,
+		     VID_TO_PIXEL(x_frac), VIDEO_FONT_HEIGHT, VIDEO_FONT_HEIGHT);
 
 	return VID_TO_POS(VIDEO_FONT_WIDTH);
 }
@@ -184,6 +192,9 @@ static int console_set_row_2(struct udevice *dev, uint row, int clr)
 	default:
 		return -ENOSYS;
 	}
+	video_damage(dev->parent, 0,
+		     vid_priv->ysize - (row + 1) * VIDEO_FONT_HEIGHT,
+		     vid_priv->xsize, VIDEO_FONT_HEIGHT);
 
 	return 0;
 }
@@ -202,6 +213,9 @@ static int console_move_rows_2(struct udevice *dev, uint rowdst, uint rowsrc,
 	src = end - (rowsrc + count) * VIDEO_FONT_HEIGHT *
 		vid_priv->line_length;
 	memmove(dst, src, VIDEO_FONT_HEIGHT * vid_priv->line_length * count);
+	video_damage(dev->parent, 0,
+		     vid_priv->ysize - (rowdst + count) * VIDEO_FONT_HEIGHT,
+		     vid_priv->xsize, count * VIDEO_FONT_HEIGHT);
 
 	return 0;
 }
@@ -267,6 +281,10 @@ static int console_putc_xy_2(struct udevice *dev, uint x_frac, uint y, char ch)
 		}
 		line -= vid_priv->line_length;
 	}
+	video_damage(vid, vid_priv->xsize - VID_TO_PIXEL(x_frac) -
+		     2 * VIDEO_FONT_WIDTH,
+		     vid_priv->ysize - y - VIDEO_FONT_HEIGHT, VIDEO_FONT_WIDTH,
+		     VIDEO_FONT_HEIGHT);
 
 	return VID_TO_POS(VIDEO_FONT_WIDTH);
 }
@@ -313,6 +331,8 @@ static int console_set_row_3(struct udevice *dev, uint row, int clr)
 		}
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent, row * VIDEO_FONT_HEIGHT, 0, VIDEO_FONT_HEIGHT,
+		     vid_priv->ysize);
 
 	return 0;
 }
@@ -334,6 +354,8 @@ static int console_move_rows_3(struct udevice *dev, uint rowdst, uint rowsrc,
 		src += vid_priv->line_length;
 		dst += vid_priv->line_length;
 	}
+	video_damage(dev->parent, rowdst * VIDEO_FONT_HEIGHT, 0,
+		     count * VIDEO_FONT_HEIGHT, vid_priv->ysize);
 
 	return 0;
 }
@@ -395,6 +417,8 @@ static int console_putc_xy_3(struct udevice *dev, uint x_frac, uint y, char ch)
 		line -= vid_priv->line_length;
 		mask >>= 1;
 	}
+	video_damage(vid, y, vid_priv->ysize - VID_TO_PIXEL(x_frac) -
+		     VIDEO_FONT_HEIGHT, VIDEO_FONT_HEIGHT, VIDEO_FONT_HEIGHT);
 
 	return VID_TO_POS(VIDEO_FONT_WIDTH);
 }
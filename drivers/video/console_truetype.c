@@ -92,6 +92,35 @@ struct pos_info {
  */
 #define POS_HISTORY_SIZE	(CONFIG_SYS_CBSIZE * 11 / 10)
 
+/**
+ * struct tt_glyph - A rendered character, ready to copy to the display
+ *
+ * The 8-bit coverage image from the STB library is converted to the pixel
+ * format of the display when the character is rendered, so drawing it is a
+ * plain OR (or AND, for black text) of each row into the frame buffer.
+ *
+ * @valid:	true if this entry holds a character
+ * @invert:	true if the image was inverted for a non-black background
+ * @ch:		Character
+ * @x_shift:	Sub-pixel X offset the character was rendered at
+ * @width:	Width of the image in pixels
+ * @height:	Height of the image in pixels
+ * @xoff:	X offset of the image from the cursor position
+ * @yoff:	Y offset of the image from the baseline
+ * @bits:	Image, @width x @height pixels in the display's format
+ */
+struct tt_glyph {
+	bool valid;
+	bool invert;
+	u8 ch;
+	double x_shift;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	void *bits;
+};
+
 /**
  * struct console_tt_priv - Private data for this driver
  *
@@ -111,6 +140,10 @@ struct pos_info {
  * @scale:	Scale of the font. This is calculated from the pixel height
  *		of the font. It is used by the STB library to generate images
  *		of the correct size.
+ * @glyphs:	Cache of rendered characters, CONFIG_CONSOLE_TRUETYPE_CACHE
+ *		entries indexed by console_truetype_hash()
+ * @hits:	Number of characters drawn from the cache
+ * @misses:	Number of characters which had to be rendered
  */
 struct console_tt_priv {
 	int font_size;
@@ -120,6 +153,9 @@ struct console_tt_priv {
 	int pos_ptr;
 	int baseline;
 	double scale;
+	struct tt_glyph *glyphs;
+	ulong hits;
+	ulong misses;
 };
 
 static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
@@ -127,7 +163,7 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	void *line;
-	int pixels = priv->font_size * vid_priv->line_length;
+	int pixels = priv->font_size * vid_priv->xsize;
 	int i;
 
 	line = vid_priv->fb + row * priv->font_size * vid_priv->line_length;
@@ -162,6 +198,8 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	default:
 		return -ENOSYS;
 	}
+	video_damage(dev->parent, 0, row * priv->font_size, vid_priv->xsize,
+		     priv->font_size);
 
 	return 0;
 }
@@ -178,6 +216,8 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	dst = vid_priv->fb + rowdst * priv->font_size * vid_priv->line_length;
 	src = vid_priv->fb + rowsrc * priv->font_size * vid_priv->line_length;
 	memmove(dst, src, priv->font_size * vid_priv->line_length * count);
+	video_damage(dev->parent, 0, rowdst * priv->font_size, vid_priv->xsize,
+		     count * priv->font_size);
 
 	/* Scroll up our position history */
 	diff = (rowsrc - rowdst) * priv->font_size;
@@ -187,6 +227,109 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	return 0;
 }
 
+/* Spread the sub-pixel positions of each character over the cache */
+static uint console_truetype_hash(u8 ch, double x_shift)
+{
+	return (ch * 61 + (uint)(x_shift * VID_FRAC_DIV)) %
+		CONFIG_CONSOLE_TRUETYPE_CACHE;
+}
+
+/**
+ * console_truetype_get_glyph() - Get a rendered character
+ *
+ * This returns the character from the cache if it is there. Otherwise the
+ * STB library renders it into an 8-bit-per-pixel image, which is converted
+ * to the display format and stored in the cache, replacing whatever
+ * character was in that entry.
+ *
+ * @dev:	Device to draw on
+ * @ch:		Character to render
+ * @x_shift:	How far past the start of a pixel the character starts
+ * @glyphp:	Returns the character. Its @bits are NULL if the character
+ *		has nothing to draw, such as ' '
+ * @return 0 if OK, -ENOMEM if out of memory, -ENOSYS if the display depth
+ * is not supported
+ */
+static int console_truetype_get_glyph(struct udevice *dev, u8 ch,
+				      double x_shift, struct tt_glyph **glyphp)
+{
+	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	bool invert = vid_priv->colour_bg != 0;
+	struct tt_glyph *glyph;
+	int width, height, xoff, yoff;
+	u8 *data;
+	void *bits;
+	int i, pixels;
+
+	glyph = &priv->glyphs[console_truetype_hash(ch, x_shift)];
+	*glyphp = glyph;
+	if (glyph->valid && glyph->ch == ch && glyph->x_shift == x_shift &&
+	    glyph->invert == invert) {
+		priv->hits++;
+		return 0;
+	}
+	priv->misses++;
+
+	/*
+	 * Pass in how much past the start of a pixel we are, and the library
+	 * will return a 8-bit-per-pixel image of the character. For empty
+	 * characters, like ' ', data will return NULL.
+	 */
+	glyph->valid = false;
+	data = stbtt_GetCodepointBitmapSubpixel(&priv->font, priv->scale,
+						priv->scale, x_shift, 0, ch,
+						&width, &height, &xoff, &yoff);
+	pixels = data ? width * height : 0;
+	if (pixels) {
+		bits = realloc(glyph->bits, pixels * VNBYTES(vid_priv->bpix));
+		if (!bits) {
+			free(data);
+			return -ENOMEM;
+		}
+	} else {
+		free(glyph->bits);
+		bits = NULL;
+	}
+	glyph->bits = bits;
+
+	for (i = 0; i < pixels; i++) {
+		int val = data[i];
+
+		if (invert)
+			val = 255 - val;
+		switch (vid_priv->bpix) {
+#ifdef CONFIG_VIDEO_BPP16
+		case VIDEO_BPP16:
+			((uint16_t *)bits)[i] = val >> 3 |
+				(val >> 2) << 5 |
+				(val >> 3) << 11;
+			break;
+#endif
+#ifdef CONFIG_VIDEO_BPP32
+		case VIDEO_BPP32:
+			((uint32_t *)bits)[i] = val | val << 8 | val << 16;
+			break;
+#endif
+		default:
+			free(data);
+			return -ENOSYS;
+		}
+	}
+	free(data);
+
+	glyph->valid = true;
+	glyph->invert = invert;
+	glyph->ch = ch;
+	glyph->x_shift = x_shift;
+	glyph->width = width;
+	glyph->height = height;
+	glyph->xoff = xoff;
+	glyph->yoff = yoff;
+
+	return 0;
+}
+
 static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 				    char ch)
 {
@@ -195,15 +338,14 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	struct video_priv *vid_priv = dev_get_uclass_priv(vid);
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	stbtt_fontinfo *font = &priv->font;
-	int width, height, xoff, yoff;
+	struct tt_glyph *glyph;
 	double xpos, x_shift;
 	int lsb;
 	int width_frac, linenum;
 	struct pos_info *pos;
-	u8 *bits, *data;
 	int advance;
-	void *line;
-	int row;
+	void *line, *bits;
+	int row, ret;
 
 	/* First get some basic metrics about this character */
 	stbtt_GetCodepointHMetrics(font, ch, &advance, &lsb);
@@ -238,64 +380,67 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 		priv->pos_ptr++;
 	}
 
-	/*
-	 * Figure out how much past the start of a pixel we are, and pass this
-	 * information into the render, which will return a 8-bit-per-pixel
-	 * image of the character. For empty characters, like ' ', data will
-	 * return NULL;
-	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, priv->scale, priv->scale,
-						x_shift, 0, ch, &width, &height,
-						&xoff, &yoff);
-	if (!data)
+	ret = console_truetype_get_glyph(dev, ch, x_shift, &glyph);
+	if (ret)
+		return ret;
+	if (!glyph->bits)
 		return width_frac;
 
 	/* Figure out where to write the character in the frame buffer */
-	bits = data;
 	line = vid_priv->fb + y * vid_priv->line_length +
 		VID_TO_PIXEL(x) * VNBYTES(vid_priv->bpix);
-	linenum = priv->baseline + yoff;
+	linenum = priv->baseline + glyph->yoff;
 	if (linenum > 0)
 		line += linenum * vid_priv->line_length;
 
 	/*
-	 * Write a row at a time, converting the 8bpp image into the colour
-	 * depth of the display. We only expect white-on-black or the reverse
-	 * so the code only handles this simple case.
+	 * Write a row at a time. We only expect white-on-black or the reverse
+	 * so the image only ever needs to be ORed or ANDed into the display.
 	 */
-	for (row = 0; row < height; row++) {
+	bits = glyph->bits;
+	for (row = 0; row < glyph->height; row++) {
 		switch (vid_priv->bpix) {
 #ifdef CONFIG_VIDEO_BPP16
 		case VIDEO_BPP16: {
-			uint16_t *dst = (uint16_t *)line + xoff;
+			uint16_t *dst = (uint16_t *)line + glyph->xoff;
+			const uint16_t *src = bits;
 			int i;
 
-			for (i = 0; i < width; i++) {
-				int val = *bits;
-				int out;
-
-				if (vid_priv->colour_bg)
-					val = 255 - val;
-				out = val >> 3 |
-					(val >> 2) << 5 |
-					(val >> 3) << 11;
-				if (vid_priv->colour_fg)
-					*dst++ |= out;
-				else
-					*dst++ &= out;
-				bits++;
+			if (vid_priv->colour_fg) {
+				for (i = 0; i < glyph->width; i++)
+					dst[i] |= src[i];
+			} else {
+				for (i = 0; i < glyph->width; i++)
+					dst[i] &= src[i];
+			}
+			break;
+		}
+#endif
+#ifdef CONFIG_VIDEO_BPP32
+		case VIDEO_BPP32: {
+			uint32_t *dst = (uint32_t *)line + glyph->xoff;
+			const uint32_t *src = bits;
+			int i;
+
+			if (vid_priv->colour_fg) {
+				for (i = 0; i < glyph->width; i++)
+					dst[i] |= src[i];
+			} else {
+				for (i = 0; i < glyph->width; i++)
+					dst[i] &= src[i];
 			}
 			break;
 		}
 #endif
 		default:
-			free(data);
 			return -ENOSYS;
 		}
 
 		line += vid_priv->line_length;
+		bits += glyph->width * VNBYTES(vid_priv->bpix);
 	}
-	free(data);
+	video_damage(vid, VID_TO_PIXEL(x) + glyph->xoff, y + max(linenum, 0),
+		     glyph->width, glyph->height);
 
 	return width_frac;
 }
@@ -358,6 +503,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 		}
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent, xstart, ystart, pixels, yend - ystart);
 
 	return 0;
 }
@@ -525,6 +671,11 @@ static int console_truetype_probe(struct udevice *dev)
 		return -EPERM;
 	}
 
+	priv->glyphs = calloc(CONFIG_CONSOLE_TRUETYPE_CACHE,
+			      sizeof(struct tt_glyph));
+	if (!priv->glyphs)
+		return -ENOMEM;
+
 	/* Pre-calculate some things we will need regularly */
 	priv->scale = stbtt_ScaleForPixelHeight(font, priv->font_size);
 	stbtt_GetFontVMetrics(font, &ascent, 0, 0);
@@ -534,6 +685,20 @@ static int console_truetype_probe(struct udevice *dev)
 	return 0;
 }
 
+static int console_truetype_remove(struct udevice *dev)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	int i;
+
+	debug("%s: %lu cached, %lu rendered\n", __func__, priv->hits,
+	      priv->misses);
+	for (i = 0; i < CONFIG_CONSOLE_TRUETYPE_CACHE; i++)
+		free(priv->glyphs[i].bits);
+	free(priv->glyphs);
+
+	return 0;
+}
+
 struct vidconsole_ops console_truetype_ops = {
 	.putc_xy	= console_truetype_putc_xy,
 	.move_rows	= console_truetype_move_rows,
@@ -547,5 +712,6 @@ U_BOOT_DRIVER(vidconsole_truetype) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_truetype_ops,
 	.probe	= console_truetype_probe,
+	.remove	= console_truetype_remove,
 	.priv_auto_alloc_size	= sizeof(struct console_tt_priv),
 };
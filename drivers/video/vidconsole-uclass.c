@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <dm.h>
 #include <video.h>
 #include <video_console.h>
@@ -77,7 +78,6 @@ static int vidconsole_back(struct udevice *dev)
 		if (priv->ycur < 0)
 			priv->ycur = 0;
 	}
-	video_sync(dev->parent);
 
 	return 0;
 }
@@ -103,8 +103,6 @@ static void vidconsole_newline(struct udevice *dev)
 		priv->ycur -= rows * priv->y_charsize;
 	}
 	priv->last_ch = 0;
-
-	video_sync(dev->parent);
 }
 
 int vidconsole_put_char(struct udevice *dev, char ch)
@@ -262,8 +260,6 @@ static int do_video_puts(cmd_tbl_t *cmdtp, int flag, int argc,
 		vidconsole_put_char(dev, *s);
 	video_sync(dev->parent);
 
-	video_sync(dev->parent);
-
 	return 0;
 }
 
@@ -278,3 +274,64 @@ U_BOOT_CMD(
 	"print string on video framebuffer",
 	"    <string>"
 );
+
+#ifdef CONFIG_CMD_VIDEO_BENCH
+static const char video_bench_text[] =
+	"The quick brown fox jumps over the lazy dog 0123456789 ({[<>]})";
+
+static int do_video_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct vidconsole_priv *priv;
+	struct udevice *dev;
+	ulong start, text_us, scroll_us;
+	ulong lines = 100;
+	const char *s;
+	int i, chars;
+
+	if (argc < 2 || strcmp(argv[1], "bench"))
+		return CMD_RET_USAGE;
+	if (argc > 2 && (strict_strtoul(argv[2], 10, &lines) < 0 || !lines))
+		return CMD_RET_USAGE;
+
+	if (uclass_first_device_err(UCLASS_VIDEO_CONSOLE, &dev))
+		return CMD_RET_FAILURE;
+	priv = dev_get_uclass_priv(dev);
+	chars = min_t(int, priv->cols - 1, sizeof(video_bench_text) - 1);
+
+	/* Each line is synced as puts() would */
+	vidconsole_position_cursor(dev, 0, 0);
+	start = timer_get_us();
+	for (i = 0; i < lines; i++) {
+		for (s = video_bench_text; s < video_bench_text + chars; s++)
+			vidconsole_put_char(dev, *s);
+		vidconsole_put_char(dev, '\n');
+		video_sync(dev->parent);
+	}
+	text_us = max(timer_get_us() - start, 1UL);
+
+	/* From the bottom row every new line scrolls the display */
+	vidconsole_position_cursor(dev, 0, (priv->rows - 1) * priv->y_charsize);
+	start = timer_get_us();
+	for (i = 0; i < lines; i++) {
+		vidconsole_put_char(dev, '\n');
+		video_sync(dev->parent);
+	}
+	scroll_us = max(timer_get_us() - start, 1UL);
+
+	printf("text:   %lu lines of %d chars in %lu us, %lu chars/s\n", lines,
+	       chars, text_us, (ulong)lldiv((u64)lines * chars * 1000000,
+					    text_us));
+	printf("scroll: %lu lines in %lu us, %lu us per line\n", lines,
+	       scroll_us, scroll_us / lines);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	video, 3,	1,	do_video_bench,
+	"video console benchmark",
+	"bench [lines] - time writing and scrolling 'lines' lines of text\n"
+	"    (default 100) on the video console"
+);
+#endif
@@ -118,35 +118,90 @@ static int video_clear(struct udevice *dev)
 	} else {
 		memset(priv->fb, priv->colour_bg, priv->fb_size);
 	}
+	video_damage(dev, 0, 0, priv->xsize, priv->ysize);
 
 	return 0;
 }
 
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int xend = min(x + width, (int)priv->xsize);
+	int yend = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= xend || y >= yend)
+		return;
+
+	if (!priv->damage.xend) {
+		priv->damage.xstart = x;
+		priv->damage.ystart = y;
+		priv->damage.xend = xend;
+		priv->damage.yend = yend;
+		return;
+	}
+	priv->damage.xstart = min(priv->damage.xstart, x);
+	priv->damage.ystart = min(priv->damage.ystart, y);
+	priv->damage.xend = max(priv->damage.xend, xend);
+	priv->damage.yend = max(priv->damage.yend, yend);
+}
+
+#if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
+static void video_flush_range(ulong start, ulong end)
+{
+	flush_dcache_range(round_down(start, CONFIG_SYS_CACHELINE_SIZE),
+			   ALIGN(end, CONFIG_SYS_CACHELINE_SIZE));
+}
+
+/* Flush the damaged lines, in one go if the damage is full width */
+static void video_flush_damage(struct video_priv *priv)
+{
+	ulong line = (ulong)priv->fb +
+		priv->damage.ystart * priv->line_length;
+	ulong xstart = priv->damage.xstart * VNBYTES(priv->bpix);
+	ulong xend = priv->damage.xend * VNBYTES(priv->bpix);
+	int y;
+
+	if (!priv->damage.xstart && priv->damage.xend == priv->xsize) {
+		video_flush_range(line, line + (priv->damage.yend -
+				  priv->damage.ystart) * priv->line_length);
+		return;
+	}
+
+	for (y = priv->damage.ystart; y < priv->damage.yend; y++) {
+		video_flush_range(line + xstart, line + xend);
+		line += priv->line_length;
+	}
+}
+#endif
+
 /* Flush video activity to the caches */
 void video_sync(struct udevice *vid)
 {
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+
+	if (!priv->damage.xend)
+		return;
+
 	/*
 	 * flush_dcache_range() is declared in common.h but it seems that some
 	 * architectures do not actually implement it. Is there a way to find
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-
-	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   ALIGN((ulong)priv->fb + priv->fb_size,
-					 CONFIG_SYS_CACHELINE_SIZE));
-	}
+	if (priv->flush_dcache)
+		video_flush_damage(priv);
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
 	static ulong last_sync;
 
-	if (get_timer(last_sync) > 10) {
-		sandbox_sdl_sync(priv->fb);
-		last_sync = get_timer(0);
-	}
+	/* Keep the damage so that a later sync picks it up */
+	if (get_timer(last_sync) <= 10)
+		return;
+	sandbox_sdl_sync(priv->fb);
+	last_sync = get_timer(0);
 #endif
+	priv->damage.xend = 0;
 }
 
 void video_sync_all(void)
@@ -392,88 +392,39 @@ out:
 static int ubifs_finddir(struct super_block *sb, char *dirname,
 			 unsigned long root_inum, unsigned long *inum)
 {
-	int err;
-	struct qstr nm;
-	union ubifs_key key;
+	struct ubifs_info *c = sb->s_fs_info;
 	struct ubifs_dent_node *dent;
-	struct ubifs_info *c;
-	struct file *file;
-	struct dentry *dentry;
-	struct inode *dir;
-	int ret = 0;
-
-	file = kzalloc(sizeof(struct file), 0);
-	dentry = kzalloc(sizeof(struct dentry), 0);
-	dir = kzalloc(sizeof(struct inode), 0);
-	if (!file || !dentry || !dir) {
-		printf("%s: Error, no memory for malloc!\n", __func__);
-		err = -ENOMEM;
-		goto out;
-	}
-
-	dir->i_sb = sb;
-	file->f_path.dentry = dentry;
-	file->f_path.dentry->d_parent = dentry;
-	file->f_path.dentry->d_inode = dir;
-	file->f_path.dentry->d_inode->i_ino = root_inum;
-	c = sb->s_fs_info;
-
-	dbg_gen("dir ino %lu, f_pos %#llx", dir->i_ino, file->f_pos);
-
-	/* Find the first entry in TNC and save it */
-	lowest_dent_key(c, &key, dir->i_ino);
-	nm.name = NULL;
-	dent = ubifs_tnc_next_ent(c, &key, &nm);
-	if (IS_ERR(dent)) {
-		err = PTR_ERR(dent);
-		goto out;
-	}
-
-	file->f_pos = key_hash_flash(c, &dent->key);
-	file->private_data = dent;
-
-	while (1) {
-		dbg_gen("feed '%s', ino %llu, new f_pos %#x",
-			dent->name, (unsigned long long)le64_to_cpu(dent->inum),
-			key_hash_flash(c, &dent->key));
-#ifndef __UBOOT__
-		ubifs_assert(le64_to_cpu(dent->ch.sqnum) > ubifs_inode(dir)->creat_sqnum);
-#endif
-
-		nm.len = le16_to_cpu(dent->nlen);
-		if ((strncmp(dirname, (char *)dent->name, nm.len) == 0) &&
-		    (strlen(dirname) == nm.len)) {
-			*inum = le64_to_cpu(dent->inum);
-			ret = 1;
-			goto out_free;
-		}
+	union ubifs_key key;
+	struct qstr nm;
+	int err;
 
-		/* Switch to the next entry */
-		key_read(c, &dent->key, &key);
-		nm.name = (char *)dent->name;
-		dent = ubifs_tnc_next_ent(c, &key, &nm);
-		if (IS_ERR(dent)) {
-			err = PTR_ERR(dent);
-			goto out;
-		}
+	nm.name = dirname;
+	nm.len = strlen(dirname);
+	if (nm.len > UBIFS_MAX_NLEN)
+		return 0;
 
-		kfree(file->private_data);
-		file->f_pos = key_hash_flash(c, &dent->key);
-		file->private_data = dent;
-		cond_resched();
+	dent = kmalloc(UBIFS_MAX_DENT_NODE_SZ, GFP_NOFS);
+	if (!dent) {
+		printf("%s: Error, no memory for malloc!\n", __func__);
+		return 0;
 	}
 
-out:
-	if (err != -ENOENT)
-		dbg_gen("cannot find next direntry, error %d", err);
+	/*
+	 * Entries are keyed by the hash of their name, so look the name up
+	 * in the TNC instead of reading every entry of the directory. The
+	 * TNC and the leaf node cache stay populated while mounted, which
+	 * makes repeated lookups of the same path free of flash reads.
+	 */
+	dent_key_init(c, &key, root_inum, &nm);
+	err = ubifs_tnc_lookup_nm(c, &key, dent, &nm);
+	if (!err)
+		*inum = le64_to_cpu(dent->inum);
+	else if (err != -ENOENT)
+		dbg_gen("cannot find direntry, error %d", err);
 
-out_free:
-	kfree(file->private_data);
-	free(file);
-	free(dentry);
-	free(dir);
+	kfree(dent);
 
-	return ret;
+	return err ? 0 : 1;
 }
 
 static unsigned long ubifs_findfile(struct super_block *sb, char *filename)
@@ -683,23 +634,20 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/* Read statistics of the last ubifs_read() */
+static struct {
+	unsigned int bulk_reads;	/* flash reads covering several nodes */
+	unsigned int bulk_blocks;	/* blocks filled by them */
+	unsigned int single_blocks;	/* blocks read one node at a time */
+} read_stats;
+
+static int decompress_block(struct ubifs_info *c, struct inode *inode,
+			    void *addr, unsigned int block,
+			    struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -730,6 +678,96 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	read_stats.single_blocks++;
+
+	return decompress_block(c, inode, addr, block, dn);
+}
+
+/*
+ * read_blocks_bulk - read consecutive data nodes with one flash read.
+ *
+ * Data nodes of a file which were written together sit back to back in one
+ * LEB. Read up to @max_blocks of them in one go and decompress them straight
+ * into @addr, zeroing holes in between. Returns the number of blocks filled,
+ * 0 if the single node path should be used for @block, or a negative error.
+ */
+static int read_blocks_bulk(struct ubifs_info *c, struct inode *inode,
+			    void *addr, unsigned int block, int max_blocks)
+{
+	struct bu_info *bu = &c->bu;
+	unsigned int next = block;
+	void *node;
+	int err, i;
+
+	if (UBIFS_BLOCKS_PER_PAGE != 1 || max_blocks < 2)
+		return 0;
+
+	/* Kept until unmount, like the TNC itself */
+	if (!bu->buf) {
+		bu->buf = kmalloc(c->max_bu_buf_len, GFP_NOFS);
+		if (!bu->buf)
+			return 0;
+	}
+
+	bu->buf_len = c->max_bu_buf_len;
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+
+	/* Leave holes at @block and lone nodes to read_block() */
+	if (bu->cnt < 2 || key_block(c, &bu->zbranch[0].key) != block)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err == -EAGAIN ? 0 : err;
+
+	node = bu->buf;
+	for (i = 0; i < bu->cnt; i++) {
+		unsigned int b = key_block(c, &bu->zbranch[i].key);
+
+		if (b - block >= max_blocks)
+			break;
+
+		while (next < b) {
+			memset(addr + (next - block) * UBIFS_BLOCK_SIZE, 0,
+			       UBIFS_BLOCK_SIZE);
+			next++;
+		}
+
+		err = decompress_block(c, inode,
+				       addr + (b - block) * UBIFS_BLOCK_SIZE,
+				       b, node);
+		if (err)
+			return err;
+
+		next = b + 1;
+		node += ALIGN(bu->zbranch[i].len, 8);
+	}
+
+	read_stats.bulk_reads++;
+	read_stats.bulk_blocks += next - block;
+
+	return next - block;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -851,7 +889,7 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -901,19 +939,34 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	page.addr = buf;
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	memset(&read_stats, 0, sizeof(read_stats));
+	for (i = 0; i < count; i += n) {
 		/*
-		 * Make sure to not read beyond the requested size
+		 * Whole pages ahead of the last one can go straight to the
+		 * destination, several data nodes per flash read.
 		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
-
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
+		n = read_blocks_bulk(c, inode, page.addr, page.index,
+				     count - 1 - i);
+		if (n < 0) {
+			err = n;
 			break;
+		}
+
+		if (!n) {
+			/*
+			 * Make sure to not read beyond the requested size
+			 */
+			if (((i + 1) == count) && (size < inode->i_size))
+				last_block_size = size - (i * PAGE_SIZE);
+
+			err = do_readpage(c, inode, &page, last_block_size);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
 
 	if (err) {
@@ -941,11 +994,20 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	loff_t actread;
 	int err;
 
+	unsigned long time;
+
 	printf("Loading file '%s' to addr 0x%08x...\n", filename, addr);
 
+	time = get_timer(0);
 	err = ubifs_read(filename, (void *)(uintptr_t)addr, 0, size, &actread);
+	time = max(get_timer(time), 1UL);
 	if (err == 0) {
 		env_set_hex("filesize", actread);
+		printf("%llu bytes read in %lu ms (", actread, time);
+		print_size(div_u64(actread, time) * 1000, "/s)\n");
+		printf("%u blocks in %u bulk reads, %u single blocks\n",
+		       read_stats.bulk_blocks, read_stats.bulk_reads,
+		       read_stats.single_blocks);
 		printf("Done\n");
 	}
 
@@ -14,8 +14,12 @@
 #include <dm/ofnode.h>
 
 struct device_node;
+struct slab_cache;
 struct udevice;
 
+/* struct udevice is allocated from this cache, see device_bind() */
+extern struct slab_cache udevice_cache;
+
 /**
  * device_bind() - Create a device and bind it to a driver
  *
@@ -404,6 +404,22 @@ struct efi_block_io {
 	efi_status_t (EFIAPI *flush_blocks)(struct efi_block_io *this);
 };
 
+#define DISK_IO_GUID \
+	EFI_GUID(0xce345171, 0xba0b, 0x11d2, \
+		 0x8e, 0x4f, 0x00, 0xa0, 0xc9, 0x69, 0x72, 0x3b)
+
+#define EFI_DISK_IO_PROTOCOL_REVISION	0x00010000
+
+struct efi_disk_io {
+	u64 revision;
+	efi_status_t (EFIAPI *read_disk)(struct efi_disk_io *this,
+			u32 media_id, u64 offset, unsigned long buffer_size,
+			void *buffer);
+	efi_status_t (EFIAPI *write_disk)(struct efi_disk_io *this,
+			u32 media_id, u64 offset, unsigned long buffer_size,
+			void *buffer);
+};
+
 struct simple_text_output_mode {
 	s32 max_mode;
 	s32 mode;
@@ -131,6 +131,17 @@ extern struct list_head efi_obj_list;
 int efi_console_register(void);
 /* Called by bootefi to make all disk storage accessible as EFI objects */
 int efi_disk_register(void);
+#ifdef CONFIG_PARTITIONS
+/* Called by bootefi to read ahead for the payload, and when it is done */
+void efi_disk_readahead_start(void);
+void efi_disk_readahead_stop(void);
+/* Called when the payload is done with the disks, to show and reset stats */
+void efi_disk_show_stats(void);
+#else
+static inline void efi_disk_readahead_start(void) {}
+static inline void efi_disk_readahead_stop(void) {}
+static inline void efi_disk_show_stats(void) {}
+#endif
 /* Called by bootefi to make GOP (graphical) interface available */
 int efi_gop_register(void);
 /* Called by bootefi to make the network interface available */
@@ -178,6 +189,8 @@ efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 			       void **buffer);
 /* EFI pool memory free function. */
 efi_status_t efi_free_pool(void *buffer);
+/* Called when the payload is done with the memory services, to show stats */
+void efi_memory_show_stats(void);
 /* Returns the EFI memory map */
 efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 				struct efi_mem_desc *memory_map,
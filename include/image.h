@@ -1034,6 +1034,9 @@ int fit_image_hash_get_value(const void *fit, int noffset, uint8_t **value,
 				int *value_len);
 int fit_image_check_hash(const void *fit, int noffset, const void *data,
 			 size_t size, char **err_msgp);
+int fit_image_check_hash_value(const void *fit, int noffset,
+			       const uint8_t *value, int value_len,
+			       char **err_msgp);
 
 int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
 int fit_set_totalsize(void *fit, int noffset, int totalsize);
@@ -1063,6 +1066,26 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 			      const char *comment, int require_keys,
 			      const char *engine_id);
 
+/**
+ * fit_prepare_hashes() - calculate image hash values ahead of
+ *			   fit_add_verification_data()
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @jobs:	Number of threads to use, 0 for one per CPU
+ * @cache_file:	File to reuse hash values from and add them to, or NULL
+ * @verbose:	Print the time taken
+ *
+ * The values are kept until fit_release_hashes(), so that the FIT can be
+ * processed several times without hashing the image data again.
+ *
+ * returns
+ *     0, on success
+ *     -ENOMEM, on failure
+ */
+int fit_prepare_hashes(const void *fit, int jobs, const char *cache_file,
+		       bool verbose);
+void fit_release_hashes(void);
+
 int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *data, size_t size);
 int fit_image_verify(const void *fit, int noffset);
@@ -257,6 +257,23 @@ enum spi_nor_option_flags {
  *		       spi_nor_scan()
  */
 struct flash_info;
+struct spi_mem_dirmap_desc;
+
+#define SPI_NOR_MAX_READ_MODES	8
+
+/**
+ * struct spi_nor_read_mode - a (Fast) Read command usable with this flash
+ * @hwcaps:	the SNOR_HWCAPS_READ_* capability implemented by the command
+ * @opcode:	the read opcode, already converted for 4-byte addressing
+ * @dummy:	the number of mode clocks plus wait states
+ * @proto:	the SPI protocol used by the command
+ */
+struct spi_nor_read_mode {
+	u32			hwcaps;
+	u8			opcode;
+	u8			dummy;
+	enum spi_nor_protocol	proto;
+};
 
 /* TODO: Remove, once all users of spi_flash interface are moved to MTD */
 #define spi_flash spi_nor
@@ -282,6 +299,10 @@ struct flash_info;
  * @write_proto:	the SPI protocol for write operations
  * @reg_proto		the SPI protocol for read_reg/write_reg/erase operations
  * @cmd_buf:		used by the write_reg
+ * @rdesc:		direct mapping used for reads, NULL if not available
+ * @read_modes:		read commands supported by both the flash and the
+ *			controller, slowest first
+ * @num_read_modes:	number of valid entries in @read_modes
  * @prepare:		[OPTIONAL] do some preparations for the
  *			read/write/erase/lock/unlock operations
  * @unprepare:		[OPTIONAL] do some post work after the
@@ -322,6 +343,9 @@ struct spi_nor {
 	bool			sst_write_second;
 	u32			flags;
 	u8			cmd_buf[SPI_NOR_MAX_CMD_SIZE];
+	struct spi_mem_dirmap_desc *rdesc;
+	struct spi_nor_read_mode read_modes[SPI_NOR_MAX_READ_MODES];
+	u8			num_read_modes;
 
 	int (*prepare)(struct spi_nor *nor, enum spi_nor_ops ops);
 	void (*unprepare)(struct spi_nor *nor, enum spi_nor_ops ops);
@@ -432,4 +456,14 @@ struct spi_nor_hwcaps {
  */
 int spi_nor_scan(struct spi_nor *nor);
 
+/**
+ * spi_nor_set_read_mode() - switch the command used for reads
+ * @nor:	the spi_nor structure
+ * @mode:	one of @nor->read_modes
+ *
+ * Return: 0 for success, others for failure.
+ */
+int spi_nor_set_read_mode(struct spi_nor *nor,
+			  const struct spi_nor_read_mode *mode);
+
 #endif
@@ -386,6 +386,7 @@ struct spinand_info {
  * @op_templates.read_cache: read cache op template
  * @op_templates.write_cache: write cache op template
  * @op_templates.update_cache: update cache op template
+ * @rdesc: direct mapping used for page cache reads, NULL if not available
  * @select_target: select a specific target/die. Usually called before sending
  *		   a command addressing a page or an eraseblock embedded in
  *		   this die. Only required if your chip exposes several dies
@@ -418,6 +419,8 @@ struct spinand_device {
 		const struct spi_mem_op *update_cache;
 	} op_templates;
 
+	struct spi_mem_dirmap_desc *rdesc;
+
 	int (*select_target)(struct spinand_device *spinand,
 			     unsigned int target);
 	unsigned int cur_target;
@@ -11,16 +11,26 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 
+#ifdef CONFIG_LMB_MAX_REGIONS
+#define MAX_LMB_REGIONS CONFIG_LMB_MAX_REGIONS
+#else
 #define MAX_LMB_REGIONS 16
+#endif
 
 struct lmb_property {
 	phys_addr_t base;
 	phys_size_t size;
 };
 
+/*
+ * Regions are sorted by base and looked up by binary search. Reserved
+ * regions may overlap, max_size bounds how far below an address a region
+ * overlapping it can start.
+ */
 struct lmb_region {
 	unsigned long cnt;
 	phys_size_t size;
+	phys_size_t max_size;
 	struct lmb_property region[MAX_LMB_REGIONS+1];
 };
 
@@ -40,6 +50,8 @@ extern phys_addr_t lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align
 extern phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align,
 			      phys_addr_t max_addr);
 extern int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr);
+extern int lmb_is_reserved_range(struct lmb *lmb, phys_addr_t base,
+				 phys_size_t size);
 extern long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 
 extern void lmb_dump_all(struct lmb *lmb);
@@ -107,6 +107,27 @@ enum eth_recv_flags {
 	ETH_RECV_CHECK_DEVICE		= 1 << 0,
 };
 
+/**
+ * struct eth_stats - packet counters of an Ethernet MAC controller
+ *
+ * rx_packets: Frames handed to the network stack
+ * rx_bytes: Bytes in those frames
+ * rx_errors: Frames the MAC flagged as damaged (CRC, length, overflow, ...)
+ * rx_dropped: Frames the MAC dropped because no receive buffer was free
+ * tx_packets: Frames queued for transmission
+ * tx_bytes: Bytes in those frames
+ * tx_errors: Frames that could not be queued or did not complete
+ */
+struct eth_stats {
+	u64 rx_packets;
+	u64 rx_bytes;
+	u64 rx_errors;
+	u64 rx_dropped;
+	u64 tx_packets;
+	u64 tx_bytes;
+	u64 tx_errors;
+};
+
 /**
  * struct eth_ops - functions of Ethernet MAC controllers
  *
@@ -132,6 +153,7 @@ enum eth_recv_flags {
  *		    ROM on the board. This is how the driver should expose it
  *		    to the network stack. This function should fill in the
  *		    eth_pdata::enetaddr field - optional
+ * get_stats: Fill in the packet counters accumulated since probe - optional
  */
 struct eth_ops {
 	int (*start)(struct udevice *dev);
@@ -144,6 +166,7 @@ struct eth_ops {
 #endif
 	int (*write_hwaddr)(struct udevice *dev);
 	int (*read_rom_hwaddr)(struct udevice *dev);
+	int (*get_stats)(struct udevice *dev, struct eth_stats *stats);
 };
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
@@ -155,6 +178,8 @@ struct udevice *eth_get_dev(void); /* get the current device */
  */
 struct udevice *eth_get_dev_by_name(const char *devname);
 unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
+/* Read the packet counters of a device, -ENOSYS if it keeps none */
+int eth_get_stats(struct udevice *dev, struct eth_stats *stats);
 
 /* Used only when NetConsole is enabled */
 int eth_is_active(struct udevice *dev); /* Test device for active state */
@@ -485,6 +510,11 @@ struct icmp_hdr {
 #define PKTSIZE			1522
 #define PKTSIZE_ALIGN		1536
 
+/* Biggest IP datagram net_defragment() reassembles with CONFIG_IP_DEFRAG */
+#ifndef CONFIG_NET_MAXDEFRAG
+#define CONFIG_NET_MAXDEFRAG	16384
+#endif
+
 /*
  * Maximum receive ring size; that is, the number of packets
  * we can buffer before overflow happens. Basically, this just
@@ -1383,6 +1383,22 @@ struct dm_pci_emul_ops {
 	 */
 	int (*unmap_physmem)(struct udevice *dev, const void *vaddr,
 			     unsigned long len);
+	/**
+	 * write_mmio() - Handle a write to memory mapped by map_physmem()
+	 *
+	 * This lets a device act on register writes, such as doorbells. It
+	 * is only used when sandbox_set_enable_memio() is enabled.
+	 *
+	 * @dev:	Emulated device to write to
+	 * @addr:	Address written, within an area returned by
+	 *		map_physmem()
+	 * @value:	Value to write
+	 * @size:	Access size
+	 * @return 0 if OK, -ENOENT if @addr is not mapped by this device,
+	 *		other -ve value on error
+	 */
+	int (*write_mmio)(struct udevice *dev, void *addr, ulong value,
+			  enum pci_size_t size);
 };
 
 /* Get access to a PCI device emulator's operations */
@@ -17,4 +17,13 @@
  * @return:	0 on success, -ve on error
  */
 int rksfc_scan_namespace(void);
+
+/**
+ * rkflash_print_stats - print and reset the read throughput counters
+ *
+ * The counters cover all reads since the last call: block requests and
+ * the time spent in them, SPI Nand pages and how many of them came from
+ * a cache read, and how the SFC moved the data.
+ */
+void rkflash_print_stats(void);
 #endif
@@ -168,11 +168,15 @@ struct scsi_cmd {
  * @base: Controller base address
  * @max_lun: Maximum number of logical units
  * @max_id: Maximum number of target ids
+ * @max_bytes_per_req: Largest transfer of one command, 0 if only READ(10)
+ *	sized requests (up to 0xffff blocks) are supported. When set, longer
+ *	reads are issued as READ(16).
  */
 struct scsi_platdata {
 	unsigned long base;
 	unsigned long max_lun;
 	unsigned long max_id;
+	unsigned long max_bytes_per_req;
 };
 
 /* Operations for SCSI */
@@ -186,6 +190,21 @@ struct scsi_ops {
 	 */
 	int (*exec)(struct udevice *dev, struct scsi_cmd *cmd);
 
+	/**
+	 * exec_batch() - execute several commands at once (optional)
+	 *
+	 * Controllers with more than one command slot can queue the whole
+	 * batch before waiting for any of it to complete.
+	 *
+	 * @dev:	SCSI bus
+	 * @cmds:	Array of commands to execute
+	 * @count:	Number of commands in @cmds
+	 * @return number of commands, from the start of @cmds, that
+	 *	completed successfully; @count if all did
+	 */
+	int (*exec_batch)(struct udevice *dev, struct scsi_cmd *cmds,
+			  int count);
+
 	/**
 	 * bus_reset() - reset the bus
 	 *
@@ -208,6 +227,18 @@ extern struct scsi_ops scsi_ops;
  */
 int scsi_exec(struct udevice *dev, struct scsi_cmd *cmd);
 
+/**
+ * scsi_exec_batch() - execute several commands
+ *
+ * Falls back to one exec() call per command if the bus has no exec_batch().
+ *
+ * @dev:	SCSI bus
+ * @cmds:	Array of commands to execute
+ * @count:	Number of commands in @cmds
+ * @return number of leading commands that completed successfully
+ */
+int scsi_exec_batch(struct udevice *dev, struct scsi_cmd *cmds, int count);
+
 /**
  * scsi_bus_reset() - reset the bus
  *
@@ -231,6 +262,11 @@ int scsi_scan(bool verbose);
  */
 int scsi_scan_dev(struct udevice *dev, bool verbose);
 
+/**
+ * scsi_show_stats() - print the transfer counters of each SCSI device
+ */
+void scsi_show_stats(void);
+
 #ifndef CONFIG_DM_SCSI
 void scsi_low_level_init(int busdevfunc);
 void scsi_init(void);
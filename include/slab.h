@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Slab caches for small fixed size objects
+ *
+ * Objects that are allocated and freed often, like struct udevice, are
+ * carved from larger malloc() blocks and recycled through a free list
+ * instead of going through dlmalloc each time. A block is given back to
+ * malloc() as soon as all its objects are free, so memory use (and
+ * mallinfo()) returns to where it was once the objects are freed.
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include <malloc.h>
+#include <linux/list.h>
+
+struct slab_cache {
+	const char *name;
+	size_t size;
+	struct list_head partial;	/* blocks with free objects */
+	struct slab_cache *next;	/* all caches in use, for slab_stats() */
+	bool registered;
+	ulong allocs;
+	ulong frees;
+	ulong in_use;
+	ulong peak;
+	ulong slabs;
+};
+
+/* Caches are defined statically, e.g. in the file owning the object type */
+#define SLAB_CACHE(_var, _name, _size)					\
+	struct slab_cache _var = {					\
+		.name = _name,						\
+		.size = _size,						\
+		.partial = LIST_HEAD_INIT(_var.partial),		\
+	}
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+/**
+ * slab_alloc() - Allocate an object from a slab cache
+ *
+ * Before relocation this falls back to malloc(), as the early pool is a
+ * bump allocator anyway.
+ *
+ * @cache: Cache to allocate from
+ * @return pointer to the uninitialised object, or NULL if out of memory
+ */
+void *slab_alloc(struct slab_cache *cache);
+
+/**
+ * slab_free() - Return an object to its slab cache
+ *
+ * @cache: Cache the object was allocated from
+ * @ptr: Object to free, may be NULL
+ */
+void slab_free(struct slab_cache *cache, void *ptr);
+
+/**
+ * slab_stats() - Print the usage of all slab caches
+ */
+void slab_stats(void);
+#else
+static inline void *slab_alloc(struct slab_cache *cache)
+{
+	return malloc(cache->size);
+}
+
+static inline void slab_free(struct slab_cache *cache, void *ptr)
+{
+	free(ptr);
+}
+
+static inline void slab_stats(void) {}
+#endif
+
+/**
+ * slab_zalloc() - Allocate a zeroed object from a slab cache
+ *
+ * @cache: Cache to allocate from
+ * @return pointer to the object, or NULL if out of memory
+ */
+static inline void *slab_zalloc(struct slab_cache *cache)
+{
+	void *ptr = slab_alloc(cache);
+
+	if (ptr)
+		memset(ptr, '\0', cache->size);
+
+	return ptr;
+}
+
+#endif /* _SLAB_H */
@@ -25,6 +25,15 @@ struct sysmem {
 	ulong kmem_resv_cnt;
 	bool has_initf;
 	bool has_initr;
+
+	/* Allocation cost, reported by sysmem_stats */
+	ulong alloc_calls;
+	ulong alloc_fails;
+	ulong free_calls;
+	ulong alloc_us;
+	ulong alloc_max_us;
+	ulong free_us;
+	ulong rgn_peak;
 };
 
 #ifdef CONFIG_SYSMEM
@@ -133,6 +142,11 @@ void sysmem_dump(void);
  */
 void sysmem_overflow_check(void);
 
+/**
+ * sysmem_stats() - Dump sysmem allocation count and cost
+ */
+void sysmem_stats(void);
+
 /**
  * board_sysmem_reserve() - Weak function for board to implement
  *
@@ -148,6 +162,7 @@ static inline int sysmem_initr(void) { return 0; }
 static inline int sysmem_free(phys_addr_t base) { return 0; }
 static inline void sysmem_dump(void) {}
 static inline void sysmem_overflow_check(void) {}
+static inline void sysmem_stats(void) {}
 __weak int board_sysmem_reserve(struct sysmem *sysmem) { return 0; }
 
 static inline void *sysmem_alloc(enum memblk_id id, phys_size_t size)
@@ -24,11 +24,25 @@ enum {
 	 * this value.
 	 */
 	FUNC_SITE_SIZE	= 4,	/* distance between function sites */
+
+	/*
+	 * Depth of the shadow call stack kept for sampling and for working
+	 * out the caller of each call record when the trace is exported.
+	 */
+	TRACE_STACK_MAX	= 256,
 };
 
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,
+};
+
+/* What is recorded in the trace buffer beyond the per-function counts */
+enum trace_mode {
+	TRACE_MODE_LINEAR,	/* Each call until the buffer is full */
+	TRACE_MODE_RING,	/* The most recent calls, oldest overwritten */
+	TRACE_MODE_SAMPLE,	/* Call stacks sampled at a fixed interval */
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -80,6 +94,38 @@ struct trace_call {
 
 int trace_list_calls(void *buff, int buff_size, unsigned int *needed);
 
+/*
+ * A TRACE_CHUNK_SAMPLES chunk holds rec_count samples. Each is a header
+ * word followed by the offsets of the functions on the call stack,
+ * outermost first. The weight is the number of sample periods which
+ * elapsed since the previous sample.
+ */
+#define TRACE_SAMPLE_FRAMES(word)	((word) & 0xffff)
+#define TRACE_SAMPLE_WEIGHT(word)	((word) >> 16)
+#define TRACE_SAMPLE_HDR(frames, weight)	((weight) << 16 | (frames))
+#define TRACE_SAMPLE_WEIGHT_MAX		0xffff
+
+/**
+ * Dump the call stack samples into a buffer
+ *
+ * Nothing is written unless samples were collected in TRACE_MODE_SAMPLE.
+ *
+ * @param buff		Buffer in which to place data, or NULL to count size
+ * @param buff_size	Size of buffer
+ * @param needed	Returns number of bytes used / needed
+ * @return 0 if ok, -1 on error (buffer exhausted)
+ */
+int trace_list_samples(void *buff, int buff_size, unsigned int *needed);
+
+/**
+ * Select what is recorded, discarding the call records collected so far
+ *
+ * @param mode		New trace mode
+ * @param sample_us	Sample interval in microseconds, for TRACE_MODE_SAMPLE
+ * @return 0 if ok, -1 if trace is not initialised or sample_us is 0
+ */
+int trace_set_mode(enum trace_mode mode, ulong sample_us);
+
 /**
  * Turn function tracing on and off
  *
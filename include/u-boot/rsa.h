@@ -107,6 +107,23 @@ int padding_pkcs_15_verify(struct image_sign_info *info,
 #ifdef CONFIG_SPL_FIT_HW_CRYPTO
 int rsa_burn_key_hash(struct image_sign_info *info);
 #endif
+
+/**
+ * rsa_key_mod_exp() - Run RSA modular exponentiation with a key of FDT
+ *
+ * Operation: out[] = sig ^ exponent % modulus, with the key which is parsed
+ * once and cached, like what rsa_verify() does.
+ *
+ * @blob:	FDT blob containing the key, usually the control FDT
+ * @node:	Key node offset in @blob, e.g. /signature/key-dev
+ * @sig:	Input data, big-endian and must be smaller than the modulus
+ * @sig_len:	Length of @sig, must be the key length in bytes
+ * @out:	Result, with the same length as @sig
+ * @hw:		true to use the crypto uclass, false for the UCLASS_MOD_EXP device
+ * @return 0 if ok, -ve on error
+ */
+int rsa_key_mod_exp(const void *blob, int node, const uint8_t *sig,
+		    uint32_t sig_len, uint8_t *out, bool hw);
 #endif
 
 #ifdef CONFIG_FIT_ENABLE_RSASSA_PSS_SUPPORT
@@ -67,6 +67,9 @@ enum video_log2_bpp {
  * @flush_dcache:	true to enable flushing of the data cache after
  *		the LCD is updated
  * @cmap:	Colour map for 8-bit-per-pixel displays
+ * @damage:	Rectangle of the frame buffer written since the last
+ *		video_sync(), in pixels. @xstart..@xend and @ystart..@yend
+ *		are half-open ranges; the region is empty if @xend is 0
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -88,6 +91,12 @@ struct video_priv {
 	int colour_bg;
 	bool flush_dcache;
 	ushort *cmap;
+	struct {
+		int xstart;
+		int ystart;
+		int xend;
+		int yend;
+	} damage;
 };
 
 /* Placeholder - there are no video operations at present */
@@ -114,12 +123,28 @@ struct video_ops {
  */
 int video_reserve(ulong *addrp);
 
+/**
+ * video_damage() - Record that part of the frame buffer has been written
+ *
+ * Anything which writes to the frame buffer must call this so that the next
+ * video_sync() pushes the change out. The rectangle is clipped to the
+ * display and merged with any other damage since the last sync.
+ *
+ * @vid:	Video device
+ * @x:		X position of the top left corner, in pixels from the left
+ * @y:		Y position of the top left corner, in pixels from the top
+ * @width:	Width in pixels
+ * @height:	Height in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+
 /**
  * video_sync() - Sync a device's frame buffer with its hardware
  *
  * Some frame buffers are cached or have a secondary frame buffer. This
  * function syncs these up so that the current contents of the U-Boot frame
- * buffer are displayed to the user.
+ * buffer are displayed to the user. Only the lines covered by the damage
+ * recorded with video_damage() are flushed, and the damage is then cleared.
  *
  * @dev:	Device to sync
  */
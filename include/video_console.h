@@ -168,6 +168,9 @@ int vidconsole_set_row(struct udevice *dev, uint row, int clr);
  * The device always starts with the cursor at position 0,0 (top left). It
  * can be adjusted manually using vidconsole_position_cursor().
  *
+ * The display is not synced, so that a string can be written with a single
+ * video_sync() at the end.
+ *
  * @dev:	Device to adjust
  * @ch:		Character to write
  * @return 0 if OK, -ve on error
@@ -248,6 +248,10 @@ struct memblock *bidram_reserved_is_overlap(phys_addr_t base, phys_size_t size)
 	if (!bidram_has_init())
 		return false;
 
+	/* Every reserved memblock is in LMB, which is searched in O(log n) */
+	if (!lmb_is_reserved_range(&bidram->lmb, base, size))
+		return NULL;
+
 	list_for_each(node, &bidram->reserved_head) {
 		mem = list_entry(node, struct memblock, node);
 		if (bidram_is_overlap(mem->base, mem->size, base, size))
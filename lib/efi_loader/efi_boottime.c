@@ -887,6 +887,9 @@ static efi_status_t EFIAPI efi_exit_boot_services(void *image_handle,
 {
 	EFI_ENTRY("%p, %ld", image_handle, map_key);
 
+	efi_disk_readahead_stop();
+	efi_disk_show_stats();
+	efi_memory_show_stats();
 	board_quiesce_devices(NULL);
 
 	/* Fix up caches for EFI payloads if necessary */
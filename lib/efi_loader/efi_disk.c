@@ -8,6 +8,7 @@
 
 #include <common.h>
 #include <blk.h>
+#include <div64.h>
 #include <dm.h>
 #include <efi_loader.h>
 #include <inttypes.h>
@@ -15,12 +16,41 @@
 #include <malloc.h>
 
 static const efi_guid_t efi_block_io_guid = BLOCK_IO_GUID;
+static const efi_guid_t efi_disk_io_guid = DISK_IO_GUID;
+
+/*
+ * Payloads like GRUB read file systems a few blocks at a time. Reads smaller
+ * than the read-ahead window are widened to the whole window, which then
+ * stays in the block cache for the reads that follow.
+ */
+#ifdef CONFIG_EFI_LOADER_READAHEAD
+#define EFI_DISK_READAHEAD	(CONFIG_EFI_LOADER_READAHEAD_SIZE * 1024)
+#define EFI_DISK_CACHE_ENTRIES	32
+
+static void *efi_disk_ra_buf;
+static bool efi_disk_ra_active;
+/* Block cache configuration to restore when the payload is done */
+static struct block_cache_stats efi_disk_ra_saved;
+#endif
+
+/* Counters for the current payload, see efi_disk_show_stats() */
+static struct {
+	ulong block_reads;	/* ReadBlocks() calls */
+	u64 block_read_bytes;
+	ulong disk_reads;	/* ReadDisk() calls */
+	u64 disk_read_bytes;
+	ulong cache_hits;	/* reads served from the block cache */
+	ulong dev_reads;	/* reads passed to the block device */
+	u64 dev_read_bytes;
+} efi_disk_stats;
 
 struct efi_disk_obj {
 	/* Generic EFI object parent class data */
 	struct efi_object parent;
 	/* EFI Interface callback struct for block I/O */
 	struct efi_block_io ops;
+	/* EFI Interface callback struct for byte-granular disk I/O */
+	struct efi_disk_io disk_io;
 	/* U-Boot ifname for block device */
 	const char *ifname;
 	/* U-Boot dev_index for block device */
@@ -33,6 +63,8 @@ struct efi_disk_obj {
 	unsigned int part;
 	/* Offset into disk for simple partitions */
 	lbaint_t offset;
+	/* Number of blocks from offset */
+	lbaint_t size;
 	/* Internal block device */
 	struct blk_desc *desc;
 };
@@ -49,6 +81,45 @@ enum efi_disk_direction {
 	EFI_DISK_WRITE,
 };
 
+/* Read blocks through the block cache, reading ahead for small reads */
+static ulong efi_disk_dread(struct blk_desc *desc, lbaint_t lba,
+			    lbaint_t blocks, void *buffer)
+{
+	ulong n;
+#ifdef CONFIG_EFI_LOADER_READAHEAD
+	lbaint_t ra_blocks = EFI_DISK_READAHEAD / desc->blksz;
+	lbaint_t start, count;
+
+	if (efi_disk_ra_active && blocks < ra_blocks) {
+		if (blkcache_read(desc->if_type, desc->devnum, lba, blocks,
+				  desc->blksz, buffer)) {
+			efi_disk_stats.cache_hits++;
+			return blocks;
+		}
+
+		/* Read the window holding @lba, or the one starting there */
+		start = lba & ~(lbaint_t)(ra_blocks - 1);
+		if (lba + blocks > start + ra_blocks)
+			start = lba;
+		count = min(ra_blocks, desc->lba - start);
+		n = blk_dread(desc, start, count, efi_disk_ra_buf);
+		if (n == count) {
+			efi_disk_stats.dev_reads++;
+			efi_disk_stats.dev_read_bytes += count * desc->blksz;
+			memcpy(buffer, efi_disk_ra_buf + (lba - start) *
+			       desc->blksz, blocks * desc->blksz);
+			return blocks;
+		}
+		/* Perhaps a bad block in the window, so just read the blocks */
+	}
+#endif
+	n = blk_dread(desc, lba, blocks, buffer);
+	efi_disk_stats.dev_reads++;
+	efi_disk_stats.dev_read_bytes += n * desc->blksz;
+
+	return n;
+}
+
 static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, unsigned long buffer_size,
 			void *buffer, enum efi_disk_direction direction)
@@ -73,7 +144,7 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 		return EFI_DEVICE_ERROR;
 
 	if (direction == EFI_DISK_READ)
-		n = blk_dread(desc, lba, blocks, buffer);
+		n = efi_disk_dread(desc, lba, blocks, buffer);
 	else
 		n = blk_dwrite(desc, lba, blocks, buffer);
 
@@ -88,20 +159,20 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 	return EFI_SUCCESS;
 }
 
-static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
-			u32 media_id, u64 lba, unsigned long buffer_size,
-			void *buffer)
+static efi_status_t efi_disk_read(struct efi_block_io *this, u32 media_id,
+				  u64 lba, unsigned long buffer_size,
+				  void *buffer)
 {
 	void *real_buffer = buffer;
 	efi_status_t r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
-		r = efi_disk_read_blocks(this, media_id, lba,
+		r = efi_disk_read(this, media_id, lba,
 			EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
 		if (r != EFI_SUCCESS)
 			return r;
-		return efi_disk_read_blocks(this, media_id, lba +
+		return efi_disk_read(this, media_id, lba +
 			EFI_LOADER_BOUNCE_BUFFER_SIZE / this->media->block_size,
 			buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
 			buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
@@ -110,9 +181,6 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 	real_buffer = efi_bounce_buffer;
 #endif
 
-	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, lba,
-		  buffer_size, buffer);
-
 	r = efi_disk_rw_blocks(this, media_id, lba, buffer_size, real_buffer,
 			       EFI_DISK_READ);
 
@@ -120,23 +188,24 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 	if ((r == EFI_SUCCESS) && (real_buffer != buffer))
 		memcpy(buffer, real_buffer, buffer_size);
 
-	return EFI_EXIT(r);
+	return r;
 }
 
-static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
-			u32 media_id, u64 lba, unsigned long buffer_size,
-			void *buffer)
+static efi_status_t efi_disk_write(struct efi_block_io *this, u32 media_id,
+				   u64 lba, unsigned long buffer_size,
+				   void *buffer)
 {
 	void *real_buffer = buffer;
-	efi_status_t r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
-		r = efi_disk_write_blocks(this, media_id, lba,
+		efi_status_t r;
+
+		r = efi_disk_write(this, media_id, lba,
 			EFI_LOADER_BOUNCE_BUFFER_SIZE, buffer);
 		if (r != EFI_SUCCESS)
 			return r;
-		return efi_disk_write_blocks(this, media_id, lba +
+		return efi_disk_write(this, media_id, lba +
 			EFI_LOADER_BOUNCE_BUFFER_SIZE / this->media->block_size,
 			buffer_size - EFI_LOADER_BOUNCE_BUFFER_SIZE,
 			buffer + EFI_LOADER_BOUNCE_BUFFER_SIZE);
@@ -145,17 +214,37 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 	real_buffer = efi_bounce_buffer;
 #endif
 
-	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, lba,
-		  buffer_size, buffer);
-
 	/* Populate bounce buffer if necessary */
 	if (real_buffer != buffer)
 		memcpy(real_buffer, buffer, buffer_size);
 
-	r = efi_disk_rw_blocks(this, media_id, lba, buffer_size, real_buffer,
-			       EFI_DISK_WRITE);
+	return efi_disk_rw_blocks(this, media_id, lba, buffer_size,
+				  real_buffer, EFI_DISK_WRITE);
+}
+
+static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
+			u32 media_id, u64 lba, unsigned long buffer_size,
+			void *buffer)
+{
+	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, lba,
+		  buffer_size, buffer);
+
+	efi_disk_stats.block_reads++;
+	efi_disk_stats.block_read_bytes += buffer_size;
+
+	return EFI_EXIT(efi_disk_read(this, media_id, lba, buffer_size,
+				      buffer));
+}
+
+static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
+			u32 media_id, u64 lba, unsigned long buffer_size,
+			void *buffer)
+{
+	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, lba,
+		  buffer_size, buffer);
 
-	return EFI_EXIT(r);
+	return EFI_EXIT(efi_disk_write(this, media_id, lba, buffer_size,
+				       buffer));
 }
 
 static efi_status_t EFIAPI efi_disk_flush_blocks(struct efi_block_io *this)
@@ -172,11 +261,166 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+/*
+ * Access any byte range of the disk through the block functions. Partial
+ * blocks at either end go through a bounce block, and are read back first
+ * when writing.
+ */
+static efi_status_t efi_disk_rw_bytes(struct efi_disk_io *this, u32 media_id,
+				      u64 offset, unsigned long buffer_size,
+				      void *buffer,
+				      enum efi_disk_direction direction)
+{
+	struct efi_disk_obj *diskobj;
+	struct efi_block_io *bio;
+	u32 blksz;
+	unsigned long len;
+	void *block = NULL;
+	efi_status_t r = EFI_SUCCESS;
+	u64 lba = offset;
+	uint skip;
+
+	diskobj = container_of(this, struct efi_disk_obj, disk_io);
+	bio = &diskobj->ops;
+	blksz = diskobj->media.block_size;
+	if (offset + buffer_size < offset ||
+	    offset + buffer_size > (u64)diskobj->size * blksz)
+		return EFI_INVALID_PARAMETER;
+	skip = do_div(lba, blksz);
+
+	while (buffer_size) {
+		if (!skip && buffer_size >= blksz) {
+			len = buffer_size - buffer_size % blksz;
+			if (direction == EFI_DISK_READ)
+				r = efi_disk_read(bio, media_id, lba, len,
+						  buffer);
+			else
+				r = efi_disk_write(bio, media_id, lba, len,
+						   buffer);
+			if (r != EFI_SUCCESS)
+				break;
+			lba += len / blksz;
+		} else {
+			len = min_t(unsigned long, blksz - skip, buffer_size);
+			if (!block)
+				block = malloc(blksz);
+			if (!block) {
+				r = EFI_OUT_OF_RESOURCES;
+				break;
+			}
+			r = efi_disk_read(bio, media_id, lba, blksz, block);
+			if (r != EFI_SUCCESS)
+				break;
+			if (direction == EFI_DISK_READ) {
+				memcpy(buffer, block + skip, len);
+			} else {
+				memcpy(block + skip, buffer, len);
+				r = efi_disk_write(bio, media_id, lba, blksz,
+						   block);
+				if (r != EFI_SUCCESS)
+					break;
+			}
+			lba++;
+			skip = 0;
+		}
+		buffer += len;
+		buffer_size -= len;
+	}
+	free(block);
+
+	return r;
+}
+
+static efi_status_t EFIAPI efi_disk_read_disk(struct efi_disk_io *this,
+			u32 media_id, u64 offset, unsigned long buffer_size,
+			void *buffer)
+{
+	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, offset,
+		  buffer_size, buffer);
+
+	efi_disk_stats.disk_reads++;
+	efi_disk_stats.disk_read_bytes += buffer_size;
+
+	return EFI_EXIT(efi_disk_rw_bytes(this, media_id, offset, buffer_size,
+					  buffer, EFI_DISK_READ));
+}
+
+static efi_status_t EFIAPI efi_disk_write_disk(struct efi_disk_io *this,
+			u32 media_id, u64 offset, unsigned long buffer_size,
+			void *buffer)
+{
+	EFI_ENTRY("%p, %x, %"PRIx64", %lx, %p", this, media_id, offset,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_rw_bytes(this, media_id, offset, buffer_size,
+					  buffer, EFI_DISK_WRITE));
+}
+
+static const struct efi_disk_io disk_io_template = {
+	.revision = EFI_DISK_IO_PROTOCOL_REVISION,
+	.read_disk = &efi_disk_read_disk,
+	.write_disk = &efi_disk_write_disk,
+};
+
+/*
+ * The block cache must take whole windows of 512-byte blocks while the
+ * payload runs. Its previous configuration is restored afterwards, so that
+ * the rest of U-Boot keeps its own cache size.
+ */
+void efi_disk_readahead_start(void)
+{
+#ifdef CONFIG_EFI_LOADER_READAHEAD
+	if (efi_disk_ra_active)
+		return;
+	if (!efi_disk_ra_buf)
+		efi_disk_ra_buf = memalign(ARCH_DMA_MINALIGN,
+					   EFI_DISK_READAHEAD);
+	if (!efi_disk_ra_buf)
+		return;
+
+	blkcache_stats(&efi_disk_ra_saved);
+	blkcache_configure(max_t(uint, efi_disk_ra_saved.max_blocks_per_entry,
+				 EFI_DISK_READAHEAD / 512),
+			   max_t(uint, efi_disk_ra_saved.max_entries,
+				 EFI_DISK_CACHE_ENTRIES));
+	efi_disk_ra_active = true;
+#endif
+}
+
+void efi_disk_readahead_stop(void)
+{
+#ifdef CONFIG_EFI_LOADER_READAHEAD
+	if (!efi_disk_ra_active)
+		return;
+
+	blkcache_configure(efi_disk_ra_saved.max_blocks_per_entry,
+			   efi_disk_ra_saved.max_entries);
+	efi_disk_ra_active = false;
+#endif
+}
+
+void efi_disk_show_stats(void)
+{
+	if (!efi_disk_stats.block_reads && !efi_disk_stats.disk_reads)
+		return;
+
+	debug("EFI disk: %lu ReadBlocks (%llu KiB), %lu ReadDisk (%llu KiB)\n",
+	      efi_disk_stats.block_reads,
+	      efi_disk_stats.block_read_bytes >> 10,
+	      efi_disk_stats.disk_reads,
+	      efi_disk_stats.disk_read_bytes >> 10);
+	debug("          %lu from cache, %lu device reads (%llu KiB)\n",
+	      efi_disk_stats.cache_hits, efi_disk_stats.dev_reads,
+	      efi_disk_stats.dev_read_bytes >> 10);
+	memset(&efi_disk_stats, '\0', sizeof(efi_disk_stats));
+}
+
 static void efi_disk_add_dev(const char *name,
 			     const char *if_typename,
 			     struct blk_desc *desc,
 			     int dev_index,
 			     lbaint_t offset,
+			     lbaint_t size,
 			     unsigned int part)
 {
 	struct efi_disk_obj *diskobj;
@@ -194,11 +438,15 @@ static void efi_disk_add_dev(const char *name,
 	diskobj->parent.protocols[0].protocol_interface = &diskobj->ops;
 	diskobj->parent.protocols[1].guid = &efi_guid_device_path;
 	diskobj->parent.protocols[1].protocol_interface = diskobj->dp;
+	diskobj->parent.protocols[2].guid = &efi_disk_io_guid;
+	diskobj->parent.protocols[2].protocol_interface = &diskobj->disk_io;
 	diskobj->parent.handle = diskobj;
 	diskobj->ops = block_io_disk_template;
+	diskobj->disk_io = disk_io_template;
 	diskobj->ifname = if_typename;
 	diskobj->dev_index = dev_index;
 	diskobj->offset = offset;
+	diskobj->size = size;
 	diskobj->desc = desc;
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
@@ -232,13 +480,13 @@ static int efi_disk_create_eltorito(struct blk_desc *desc,
 		snprintf(devname, sizeof(devname), "%s:%d", pdevname,
 			 part);
 		efi_disk_add_dev(devname, if_typename, desc, diskid,
-				 info.start, part);
+				 info.start, info.size, part);
 		part++;
 		disks++;
 	}
 
 	/* ... and add block device: */
-	efi_disk_add_dev(devname, if_typename, desc, diskid, 0, 0);
+	efi_disk_add_dev(devname, if_typename, desc, diskid, 0, desc->lba, 0);
 #endif
 
 	return disks;
@@ -255,6 +503,7 @@ static int efi_disk_create_eltorito(struct blk_desc *desc,
  *
  * This gets called from do_bootefi_exec().
  */
+
 int efi_disk_register(void)
 {
 	int disks = 0;
@@ -274,13 +523,13 @@ int efi_disk_register(void)
 		/* add devices for each partition: */
 		while (!part_get_info(desc, part, &info)) {
 			efi_disk_add_dev(dev->name, if_typename, desc,
-					 desc->devnum, 0, part);
+					 desc->devnum, 0, desc->lba, part);
 			part++;
 		}
 
 		/* ... and add block device: */
 		efi_disk_add_dev(dev->name, if_typename, desc,
-				 desc->devnum, 0, 0);
+				 desc->devnum, 0, desc->lba, 0);
 
 		disks++;
 
@@ -317,7 +566,8 @@ int efi_disk_register(void)
 
 			snprintf(devname, sizeof(devname), "%s%d",
 				 if_typename, i);
-			efi_disk_add_dev(devname, if_typename, desc, i, 0, 0);
+			efi_disk_add_dev(devname, if_typename, desc, i, 0,
+					 desc->lba, 0);
 			disks++;
 
 			/*
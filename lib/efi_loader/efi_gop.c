@@ -29,6 +29,9 @@ struct efi_gop_obj {
 	/* Fields we only have acces to during init */
 	u32 bpix;
 	void *fb;
+#ifdef CONFIG_DM_VIDEO
+	struct udevice *vdev;
+#endif
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -117,6 +120,7 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this, void *buffer,
 	}
 
 #ifdef CONFIG_DM_VIDEO
+	video_damage(gopobj->vdev, dx, dy, width, height);
 	video_sync_all();
 #else
 	lcd_sync();
@@ -205,6 +209,9 @@ int efi_gop_register(void)
 
 	gopobj->bpix = bpix;
 	gopobj->fb = fb;
+#ifdef CONFIG_DM_VIDEO
+	gopobj->vdev = vdev;
+#endif
 
 	/* Hook up to the device list */
 	list_add_tail(&gopobj->parent.link, &efi_obj_list);
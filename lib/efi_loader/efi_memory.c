@@ -11,7 +11,7 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <linux/libfdt_env.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree_augmented.h>
 #include <inttypes.h>
 #include <watchdog.h>
 
@@ -19,140 +19,256 @@ DECLARE_GLOBAL_DATA_PTR;
 
 struct efi_mem_list {
 	struct list_head link;
+	/* Node in efi_mem_tree, keyed by physical_start */
+	struct rb_node rb;
+	/* Largest free (conventional) entry in this subtree, in pages */
+	u64 max_free;
 	struct efi_mem_desc desc;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
+/*
+ * This list contains all memory map items, from highest address to lowest
+ * address. When allocating memory we should always start from the highest
+ * address chunk, so the first list iterator gets the highest address and
+ * goes lower from there.
+ *
+ * The same items are indexed in efi_mem_tree so that the entry covering
+ * an address, and the highest free entry that is large enough for an
+ * allocation, can be found without walking the list.
+ */
 LIST_HEAD(efi_mem);
+static struct rb_root efi_mem_tree = RB_ROOT;
+static int efi_mem_entries;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
 #endif
 
 /*
- * U-Boot services each EFI AllocatePool request as a separate
- * (multiple) page allocation.  We have to track the number of pages
- * to be able to free the correct amount later.
- * EFI requires 8 byte alignment for pool allocations, so we can
- * prepend each allocation with an 64 bit header tracking the
- * allocation size, and hand out the remainder to the caller.
+ * Pool allocations of more than EFI_POOL_MAX_SIZE bytes are serviced as a
+ * separate (multiple) page allocation. We have to track the number of
+ * pages to be able to free the correct amount later. EFI requires 8 byte
+ * alignment for pool allocations, so we can prepend each allocation with
+ * a header tracking the allocation size, and hand out the remainder to
+ * the caller.
  */
 struct efi_pool_allocation {
+	u64 magic;
 	u64 num_pages;
 	char data[];
 };
 
 /*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * Smaller pool allocations are carved from pages of fixed size objects,
+ * one power-of-two size class per page. The page header sits at the start
+ * of the page and the objects follow it, so the owner of an object is
+ * found by rounding its address down to the page.
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+struct efi_pool_page {
+	u64 magic;
+	/* Link in efi_pool->partial[], while the page has free objects */
+	struct list_head link;
+	struct efi_pool *pool;
+	/* Singly linked list of free objects */
+	void **free;
+	u16 size;
+	u16 count;
+	u16 used;
+	u16 class;
+};
+
+#define EFI_POOL_MAGIC_PAGES	0x7365676170696665ULL	/* "efipages" */
+#define EFI_POOL_MAGIC_OBJS	0x736a626f6c6f6f70ULL	/* "poolobjs" */
+#define EFI_POOL_MIN_SHIFT	4
+#define EFI_POOL_CLASSES	7
+#define EFI_POOL_MAX_SIZE	(1 << (EFI_POOL_MIN_SHIFT + EFI_POOL_CLASSES - 1))
+#define EFI_POOL_HDR_SIZE	ALIGN(sizeof(struct efi_pool_page), 16)
+
+/* Small object pages for one memory type */
+struct efi_pool {
+	struct list_head link;
+	int type;
+	struct list_head partial[EFI_POOL_CLASSES];
+};
+
+static LIST_HEAD(efi_pools);
+
+/* Counters for the current payload, see efi_memory_show_stats() */
+static struct {
+	ulong alloc_pages;	/* AllocatePages() calls */
+	ulong free_pages;	/* FreePages() calls */
+	ulong pages_us;		/* time spent in both */
+	ulong alloc_pool;	/* AllocatePool() calls */
+	ulong free_pool;	/* FreePool() calls */
+	ulong pool_us;		/* time spent in both */
+	ulong pool_pages;	/* pages holding small pool objects */
+} efi_mem_stats;
+
+static inline u64 efi_mem_end(struct efi_mem_list *map)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	return map->desc.physical_start +
+	       (map->desc.num_pages << EFI_PAGE_SHIFT);
+}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
+static inline u64 efi_mem_free_pages(struct efi_mem_list *map)
+{
+	if (map->desc.type != EFI_CONVENTIONAL_MEMORY)
 		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
+
+	return map->desc.num_pages;
+}
+
+static u64 efi_mem_compute_max_free(struct efi_mem_list *map)
+{
+	u64 max_free = efi_mem_free_pages(map);
+	struct efi_mem_list *child;
+
+	if (map->rb.rb_left) {
+		child = rb_entry(map->rb.rb_left, struct efi_mem_list, rb);
+		max_free = max(max_free, child->max_free);
+	}
+	if (map->rb.rb_right) {
+		child = rb_entry(map->rb.rb_right, struct efi_mem_list, rb);
+		max_free = max(max_free, child->max_free);
+	}
+
+	return max_free;
+}
+
+RB_DECLARE_CALLBACKS(static, efi_mem_augment, struct efi_mem_list, rb,
+		     u64, max_free, efi_mem_compute_max_free)
+
+/* Call after changing the size or type of an entry already in the map */
+static void efi_mem_update(struct efi_mem_list *map)
+{
+	efi_mem_augment_propagate(&map->rb, NULL);
+}
+
+static void efi_mem_insert(struct efi_mem_list *newmap)
+{
+	struct rb_node **link = &efi_mem_tree.rb_node, *parent = NULL;
+	struct efi_mem_list *map, *below = NULL;
+	u64 start = newmap->desc.physical_start;
+
+	newmap->max_free = efi_mem_free_pages(newmap);
+	while (*link) {
+		parent = *link;
+		map = rb_entry(parent, struct efi_mem_list, rb);
+		/* The new entry ends up in the subtree of each node on the way */
+		map->max_free = max(map->max_free, newmap->max_free);
+		if (start < map->desc.physical_start) {
+			link = &parent->rb_left;
+		} else {
+			below = map;
+			link = &parent->rb_right;
+		}
+	}
+
+	rb_link_node(&newmap->rb, parent, link);
+	rb_insert_augmented(&newmap->rb, &efi_mem_tree, &efi_mem_augment);
+
+	/* Keep the list in descending order: go in front of the next lower */
+	if (below)
+		list_add_tail(&newmap->link, &below->link);
 	else
-		return -1;
+		list_add_tail(&newmap->link, &efi_mem);
+	efi_mem_entries++;
 }
 
-static void efi_mem_sort(void)
+static void efi_mem_remove(struct efi_mem_list *map)
 {
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	rb_erase_augmented(&map->rb, &efi_mem_tree, &efi_mem_augment);
+	list_del(&map->link);
+	free(map);
+	efi_mem_entries--;
+}
+
+/* Returns the entry with the highest start address below @addr, or NULL */
+static struct efi_mem_list *efi_mem_find_below(u64 addr)
+{
+	struct rb_node *node = efi_mem_tree.rb_node;
+	struct efi_mem_list *map, *found = NULL;
+
+	while (node) {
+		map = rb_entry(node, struct efi_mem_list, rb);
+		if (map->desc.physical_start < addr) {
+			found = map;
+			node = node->rb_right;
+		} else {
+			node = node->rb_left;
+		}
+	}
+
+	return found;
+}
+
+/* Returns the next lower entry in the map, or NULL */
+static struct efi_mem_list *efi_mem_lower(struct efi_mem_list *map)
+{
+	if (map->link.next == &efi_mem)
+		return NULL;
+
+	return list_entry(map->link.next, struct efi_mem_list, link);
+}
+
+/* Two adjacent entries can be merged if they only differ in their range */
+static bool efi_mem_can_merge(struct efi_mem_list *lower,
+			      struct efi_mem_list *upper)
+{
+	return lower->desc.type == upper->desc.type &&
+	       lower->desc.attribute == upper->desc.attribute &&
+	       efi_mem_end(lower) == upper->desc.physical_start;
 }
 
 /*
- * Unmaps all memory occupied by the carve_desc region from the
- * list entry pointed to by map.
- *
- * Returns EFI_CARVE_NO_OVERLAP if the regions don't overlap.
- * Returns EFI_CARVE_OVERLAPS_NONRAM if the carve and map overlap,
- *    and the map contains anything but free ram.
- *    (only when overlap_only_ram is true)
- * Returns EFI_CARVE_LOOP_AGAIN if the mapping list should be traversed
- *    again, as it has been altered
- * Returns the number of overlapping pages. The pages are removed from
- *     the mapping list.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to readd the already carved out pages to the mapping.
+ * Unmaps all memory occupied by [carve_start, carve_end) from the map
+ * entry, shrinking, splitting or removing it.
  */
-static int efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static void efi_mem_carve_out(struct efi_mem_list *map, u64 carve_start,
+			      u64 carve_end)
 {
 	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
-		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
-		}
+	u64 map_start = map->desc.physical_start;
+	u64 map_end = efi_mem_end(map);
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+	if (carve_start <= map_start && carve_end >= map_end) {
+		/* Full overlap, just remove map */
+		efi_mem_remove(map);
+		return;
 	}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+	if (carve_start <= map_start) {
+		/* Carving at the beginning of our map? Just move it! */
+		map->desc.physical_start = carve_end;
+		map->desc.virtual_start = carve_end;
+		map->desc.num_pages = (map_end - carve_end) >> EFI_PAGE_SHIFT;
+		efi_mem_update(map);
+		return;
+	}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+	if (carve_end < map_end) {
+		/*
+		 * Carving from the middle of the map, keep the top part
+		 * [ carve_end ... map_end ] as a new entry
+		 */
+		newmap = calloc(1, sizeof(*newmap));
+		newmap->desc = map->desc;
+		newmap->desc.physical_start = carve_end;
+		newmap->desc.virtual_start = carve_end;
+		newmap->desc.num_pages = (map_end - carve_end) >> EFI_PAGE_SHIFT;
+		efi_mem_insert(newmap);
+	}
 
 	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
-
-	return EFI_CARVE_LOOP_AGAIN;
+	map->desc.num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	efi_mem_update(map);
 }
 
 uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 			    bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
+	struct efi_mem_list *newlist, *map, *lower;
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
 	uint64_t carved_pages = 0;
 
 	debug("%s: 0x%" PRIx64 " 0x%" PRIx64 " %d %s\n", __func__,
@@ -161,6 +277,40 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 	if (!pages)
 		return start;
 
+	/*
+	 * The entries overlapping our range all start below its end and are
+	 * consecutive in the (descending) list from there on.
+	 */
+	if (overlap_only_ram) {
+		for (map = efi_mem_find_below(end);
+		     map && efi_mem_end(map) > start;
+		     map = efi_mem_lower(map)) {
+			/*
+			 * The user requested to only have RAM overlaps,
+			 * but we hit a non-RAM region. Error out.
+			 */
+			if (map->desc.type != EFI_CONVENTIONAL_MEMORY)
+				return 0;
+			carved_pages += (min(end, efi_mem_end(map)) -
+					 max(start, map->desc.physical_start)) >>
+					EFI_PAGE_SHIFT;
+		}
+
+		/*
+		 * The payload wanted to have RAM overlaps, but we overlapped
+		 * with an unallocated region. Error out.
+		 */
+		if (carved_pages != pages)
+			return 0;
+	}
+
+	for (map = efi_mem_find_below(end);
+	     map && efi_mem_end(map) > start;
+	     map = lower) {
+		lower = efi_mem_lower(map);
+		efi_mem_carve_out(map, start, end);
+	}
+
 	newlist = calloc(1, sizeof(*newlist));
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
@@ -182,101 +332,68 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 	}
 
 	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			int r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return 0;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
+	efi_mem_insert(newlist);
+
+	/* Merge it with its neighbours, so that the map stays short */
+	if (newlist->link.prev != &efi_mem) {
+		map = list_entry(newlist->link.prev, struct efi_mem_list, link);
+		if (efi_mem_can_merge(newlist, map)) {
+			newlist->desc.num_pages += map->desc.num_pages;
+			efi_mem_remove(map);
+			efi_mem_update(newlist);
 		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return 0;
 	}
-
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	lower = efi_mem_lower(newlist);
+	if (lower && efi_mem_can_merge(lower, newlist)) {
+		lower->desc.num_pages += newlist->desc.num_pages;
+		efi_mem_remove(newlist);
+		efi_mem_update(lower);
+	}
 
 	return start;
 }
 
-static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+/*
+ * Returns the highest address at which @len bytes of free memory end at or
+ * below @max_addr, searching @node and its subtree, or 0 if there is none.
+ * Subtrees without a large enough free entry are skipped, as are the ones
+ * starting above @max_addr.
+ */
+static uint64_t efi_find_free_memory_in(struct rb_node *node, uint64_t pages,
+					uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
+	struct efi_mem_list *map;
+	uint64_t ret, top;
 
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
+	if (!node)
+		return 0;
+	map = rb_entry(node, struct efi_mem_list, rb);
+	if (map->max_free < pages)
+		return 0;
 
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
+	if (map->desc.physical_start < max_addr) {
+		ret = efi_find_free_memory_in(node->rb_right, pages, max_addr);
+		if (ret)
+			return ret;
 
 		/* Return the highest address in this map within bounds */
-		return ret;
+		top = min(max_addr, efi_mem_end(map));
+		if (efi_mem_free_pages(map) >= pages &&
+		    top - map->desc.physical_start >= pages << EFI_PAGE_SHIFT)
+			return top - (pages << EFI_PAGE_SHIFT);
 	}
 
-	return 0;
+	return efi_find_free_memory_in(node->rb_left, pages, max_addr);
 }
 
-efi_status_t efi_allocate_pages(int type, int memory_type,
-				unsigned long pages, uint64_t *memory)
+static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
+{
+	return efi_find_free_memory_in(efi_mem_tree.rb_node,
+				       len >> EFI_PAGE_SHIFT, max_addr);
+}
+
+static efi_status_t efi_alloc_pages(int type, int memory_type,
+				    unsigned long pages, uint64_t *memory)
 {
 	u64 len = pages << EFI_PAGE_SHIFT;
 	efi_status_t r = EFI_SUCCESS;
@@ -325,6 +442,19 @@ efi_status_t efi_allocate_pages(int type, int memory_type,
 	return r;
 }
 
+efi_status_t efi_allocate_pages(int type, int memory_type,
+				unsigned long pages, uint64_t *memory)
+{
+	ulong start = timer_get_us();
+	efi_status_t r;
+
+	r = efi_alloc_pages(type, memory_type, pages, memory);
+	efi_mem_stats.alloc_pages++;
+	efi_mem_stats.pages_us += timer_get_us() - start;
+
+	return r;
+}
+
 void *efi_alloc(uint64_t len, int memory_type)
 {
 	uint64_t ret = 0;
@@ -338,12 +468,12 @@ void *efi_alloc(uint64_t len, int memory_type)
 	return NULL;
 }
 
-efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
+static efi_status_t efi_release_pages(uint64_t memory, unsigned long pages)
 {
 	uint64_t r = 0;
 
+	/* Adjacent free regions are merged by efi_add_memory_map() */
 	r = efi_add_memory_map(memory, pages, EFI_CONVENTIONAL_MEMORY, false);
-	/* Merging of adjacent free regions is missing */
 
 	if (r == memory)
 		return EFI_SUCCESS;
@@ -351,22 +481,156 @@ efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 	return EFI_NOT_FOUND;
 }
 
-efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
-			       void **buffer)
+efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
+{
+	ulong start = timer_get_us();
+	efi_status_t r;
+
+	r = efi_release_pages(memory, pages);
+	efi_mem_stats.free_pages++;
+	efi_mem_stats.pages_us += timer_get_us() - start;
+
+	return r;
+}
+
+static struct efi_pool *efi_pool_get(int type)
+{
+	struct efi_pool *pool;
+	int i;
+
+	list_for_each_entry(pool, &efi_pools, link) {
+		if (pool->type == type)
+			return pool;
+	}
+
+	pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+	pool->type = type;
+	for (i = 0; i < EFI_POOL_CLASSES; i++)
+		INIT_LIST_HEAD(&pool->partial[i]);
+	list_add(&pool->link, &efi_pools);
+
+	return pool;
+}
+
+/* Sets up a new page of objects for a size class of a pool */
+static struct efi_pool_page *efi_pool_add_page(struct efi_pool *pool,
+					       int class)
+{
+	struct efi_pool_page *page;
+	uint64_t addr;
+	void **obj;
+	int i;
+
+	if (efi_alloc_pages(0, pool->type, 1, &addr) != EFI_SUCCESS)
+		return NULL;
+
+	page = (void *)(uintptr_t)addr;
+	page->magic = EFI_POOL_MAGIC_OBJS;
+	page->pool = pool;
+	page->size = 1 << (class + EFI_POOL_MIN_SHIFT);
+	page->count = (EFI_PAGE_SIZE - EFI_POOL_HDR_SIZE) / page->size;
+	page->used = 0;
+	page->class = class;
+
+	/* Chain up all objects, lowest address first */
+	page->free = (void *)page + EFI_POOL_HDR_SIZE;
+	for (i = 0, obj = page->free; i < page->count - 1; i++) {
+		*obj = (void *)obj + page->size;
+		obj = *obj;
+	}
+	*obj = NULL;
+
+	list_add(&page->link, &pool->partial[class]);
+	efi_mem_stats.pool_pages++;
+
+	return page;
+}
+
+static void *efi_pool_alloc_obj(int pool_type, unsigned long size)
+{
+	struct efi_pool_page *page;
+	struct efi_pool *pool;
+	void **obj;
+	int class;
+
+	class = size <= (1 << EFI_POOL_MIN_SHIFT) ? 0 :
+		fls(size - 1) - EFI_POOL_MIN_SHIFT;
+	pool = efi_pool_get(pool_type);
+	if (!pool)
+		return NULL;
+
+	if (list_empty(&pool->partial[class])) {
+		page = efi_pool_add_page(pool, class);
+		if (!page)
+			return NULL;
+	} else {
+		page = list_first_entry(&pool->partial[class],
+					struct efi_pool_page, link);
+	}
+
+	obj = page->free;
+	page->free = *obj;
+	page->used++;
+	/* Full pages are only found again through their objects */
+	if (!page->free)
+		list_del(&page->link);
+
+	return obj;
+}
+
+static efi_status_t efi_pool_free_obj(struct efi_pool_page *page,
+				      void *buffer)
+{
+	struct list_head *partial = &page->pool->partial[page->class];
+	ulong offset = buffer - (void *)page - EFI_POOL_HDR_SIZE;
+	void **obj = buffer;
+
+	/* Sanity check, was the supplied address returned by allocate_pool */
+	if (offset % page->size || offset / page->size >= page->count)
+		return EFI_INVALID_PARAMETER;
+
+	if (!page->free)
+		list_add(&page->link, partial);
+	*obj = page->free;
+	page->free = obj;
+	page->used--;
+
+	/* Keep the last page of the class around for the next allocation */
+	if (!page->used && !list_is_singular(partial)) {
+		list_del(&page->link);
+		page->magic = 0;
+		efi_mem_stats.pool_pages--;
+		return efi_release_pages((uintptr_t)page, 1);
+	}
+
+	return EFI_SUCCESS;
+}
+
+static efi_status_t efi_alloc_pool(int pool_type, unsigned long size,
+				   void **buffer)
 {
 	efi_status_t r;
 	efi_physical_addr_t t;
-	u64 num_pages = (size + sizeof(u64) + EFI_PAGE_MASK) >> EFI_PAGE_SHIFT;
+	u64 num_pages = (size + sizeof(struct efi_pool_allocation) +
+			 EFI_PAGE_MASK) >> EFI_PAGE_SHIFT;
 
 	if (size == 0) {
 		*buffer = NULL;
 		return EFI_SUCCESS;
 	}
 
-	r = efi_allocate_pages(0, pool_type, num_pages, &t);
+	if (size <= EFI_POOL_MAX_SIZE) {
+		*buffer = efi_pool_alloc_obj(pool_type, size);
+		return *buffer ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
+	}
+
+	r = efi_alloc_pages(0, pool_type, num_pages, &t);
 
 	if (r == EFI_SUCCESS) {
 		struct efi_pool_allocation *alloc = (void *)(uintptr_t)t;
+		alloc->magic = EFI_POOL_MAGIC_PAGES;
 		alloc->num_pages = num_pages;
 		*buffer = alloc->data;
 	}
@@ -374,19 +638,51 @@ efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
 	return r;
 }
 
-efi_status_t efi_free_pool(void *buffer)
+efi_status_t efi_allocate_pool(int pool_type, unsigned long size,
+			       void **buffer)
 {
+	ulong start = timer_get_us();
 	efi_status_t r;
+
+	r = efi_alloc_pool(pool_type, size, buffer);
+	efi_mem_stats.alloc_pool++;
+	efi_mem_stats.pool_us += timer_get_us() - start;
+
+	return r;
+}
+
+static efi_status_t efi_release_pool(void *buffer)
+{
 	struct efi_pool_allocation *alloc;
+	u64 num_pages;
 
 	if (buffer == NULL)
 		return EFI_INVALID_PARAMETER;
 
-	alloc = container_of(buffer, struct efi_pool_allocation, data);
+	/* Both kinds of allocation keep their header at the page start */
+	alloc = (void *)((uintptr_t)buffer & ~EFI_PAGE_MASK);
+	if (alloc->magic == EFI_POOL_MAGIC_OBJS)
+		return efi_pool_free_obj((void *)alloc, buffer);
+
 	/* Sanity check, was the supplied address returned by allocate_pool */
-	assert(((uintptr_t)alloc & EFI_PAGE_MASK) == 0);
+	if (alloc->magic != EFI_POOL_MAGIC_PAGES ||
+	    buffer != (void *)alloc->data)
+		return EFI_INVALID_PARAMETER;
 
-	r = efi_free_pages((uintptr_t)alloc, alloc->num_pages);
+	alloc->magic = 0;
+	num_pages = alloc->num_pages;
+
+	return efi_release_pages((uintptr_t)alloc, num_pages);
+}
+
+efi_status_t efi_free_pool(void *buffer)
+{
+	ulong start = timer_get_us();
+	efi_status_t r;
+
+	r = efi_release_pool(buffer);
+	efi_mem_stats.free_pool++;
+	efi_mem_stats.pool_us += timer_get_us() - start;
 
 	return r;
 }
@@ -398,13 +694,10 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 			       uint32_t *descriptor_version)
 {
 	ulong map_size = 0;
-	int map_entries = 0;
+	int map_entries = efi_mem_entries;
 	struct list_head *lhandle;
 	unsigned long provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
 	map_size = map_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
@@ -436,6 +729,27 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 	return EFI_SUCCESS;
 }
 
+void efi_memory_show_stats(void)
+{
+	if (!efi_mem_stats.alloc_pages && !efi_mem_stats.alloc_pool)
+		return;
+
+	debug("EFI memory: %lu AllocatePages, %lu FreePages (%lu us)\n",
+	      efi_mem_stats.alloc_pages, efi_mem_stats.free_pages,
+	      efi_mem_stats.pages_us);
+	debug("            %lu AllocatePool, %lu FreePool (%lu us)\n",
+	      efi_mem_stats.alloc_pool, efi_mem_stats.free_pool,
+	      efi_mem_stats.pool_us);
+	debug("            %d map entries, %lu pool pages\n",
+	      efi_mem_entries, efi_mem_stats.pool_pages);
+	efi_mem_stats.alloc_pages = 0;
+	efi_mem_stats.free_pages = 0;
+	efi_mem_stats.pages_us = 0;
+	efi_mem_stats.alloc_pool = 0;
+	efi_mem_stats.free_pool = 0;
+	efi_mem_stats.pool_us = 0;
+}
+
 __weak void efi_add_known_memory(void)
 {
 	int i;
@@ -477,9 +791,9 @@ int efi_memory_init(void)
 	/* Request a 32bit 64MB bounce buffer region */
 	uint64_t efi_bounce_buffer_addr = 0xffffffff;
 
-	if (efi_allocate_pages(1, EFI_LOADER_DATA,
-			       (64 * 1024 * 1024) >> EFI_PAGE_SHIFT,
-			       &efi_bounce_buffer_addr) != EFI_SUCCESS)
+	if (efi_alloc_pages(1, EFI_LOADER_DATA,
+			    (64 * 1024 * 1024) >> EFI_PAGE_SHIFT,
+			    &efi_bounce_buffer_addr) != EFI_SUCCESS)
 		return -1;
 
 	efi_bounce_buffer = (void*)(uintptr_t)efi_bounce_buffer_addr;
@@ -97,81 +97,138 @@ void lmb_init(struct lmb *lmb)
 	lmb->memory.region[0].size = 0;
 	lmb->memory.cnt = 1;
 	lmb->memory.size = 0;
+	lmb->memory.max_size = 0;
 
 	/* Ditto. */
 	lmb->reserved.region[0].base = 0;
 	lmb->reserved.region[0].size = 0;
 	lmb->reserved.cnt = 1;
 	lmb->reserved.size = 0;
+	lmb->reserved.max_size = 0;
+}
+
+/*
+ * Regions are kept sorted by base, so this returns the number of regions
+ * whose base is <= addr, i.e. the index to insert a region at addr.
+ */
+static unsigned long lmb_search(struct lmb_region *rgn, phys_addr_t addr)
+{
+	unsigned long lo = 0, hi = rgn->cnt, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (rgn->region[mid].base <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
 }
 
 /* This routine called with relocation disabled. */
 static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
 {
 	unsigned long coalesced = 0;
-	long adjacent, i;
+	long adjacent, i, j;
 
 	if ((rgn->cnt == 1) && (rgn->region[0].size == 0)) {
 		rgn->region[0].base = base;
 		rgn->region[0].size = size;
+		rgn->max_size = size;
 		return 0;
 	}
 
-	/* First try and coalesce this LMB with another. */
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
+	i = lmb_search(rgn, base);
 
-		if ((rgnbase == base) && (rgnsize == size))
+	/*
+	 * Regions may overlap, so check every region below that can still
+	 * reach base, not just the nearest one.
+	 */
+	for (j = i - 1; j >= 0; j--) {
+		phys_addr_t rgnbase = rgn->region[j].base;
+
+		if (base - rgnbase >= rgn->max_size)
+			break;
+		if (base + size <= rgnbase + rgn->region[j].size)
 			/* Already have this region, so we're done */
 			return 0;
+	}
 
-		adjacent = lmb_addrs_adjacent(base,size,rgnbase,rgnsize);
-		if ( adjacent > 0 ) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
+	/*
+	 * First try and coalesce this LMB with its neighbours, which are the
+	 * only regions it can be adjacent to.
+	 */
+	if (i > 0) {
+		phys_addr_t rgnbase = rgn->region[i - 1].base;
+		phys_size_t rgnsize = rgn->region[i - 1].size;
+
+		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
+		if (adjacent < 0) {
+			rgn->region[i - 1].size += size;
 			coalesced++;
-			break;
+			i--;
 		}
-		else if ( adjacent < 0 ) {
+	}
+	if (!coalesced && i < rgn->cnt) {
+		adjacent = lmb_addrs_adjacent(base, size, rgn->region[i].base,
+					      rgn->region[i].size);
+		if (adjacent > 0) {
+			rgn->region[i].base -= size;
 			rgn->region[i].size += size;
 			coalesced++;
-			break;
 		}
 	}
 
-	if ((i < rgn->cnt-1) && lmb_regions_adjacent(rgn, i, i+1) ) {
-		lmb_coalesce_regions(rgn, i, i+1);
-		coalesced++;
-	}
-
-	if (coalesced)
+	if (coalesced) {
+		if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
+			lmb_coalesce_regions(rgn, i, i + 1);
+			coalesced++;
+		}
+		rgn->max_size = max(rgn->max_size, rgn->region[i].size);
 		return coalesced;
+	}
 	if (rgn->cnt >= MAX_LMB_REGIONS)
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i+1].base = rgn->region[i].base;
-			rgn->region[i+1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i+1].base = base;
-			rgn->region[i+1].size = size;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-	}
-
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(rgn->region[0]));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->max_size = max(rgn->max_size, size);
 	rgn->cnt++;
 
 	return 0;
 }
 
+/*
+ * Reserved regions may overlap each other, so the regions overlapping
+ * [base, base + size) are found by walking down from the last one starting
+ * below the end, until no region can reach base any more. Returns the
+ * lowest overlapping region like a linear scan would.
+ */
+static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
+				phys_size_t size)
+{
+	long i, found = -1;
+
+	if (!size)
+		return -1;
+
+	for (i = lmb_search(rgn, base + size - 1) - 1; i >= 0; i--) {
+		phys_addr_t rgnbase = rgn->region[i].base;
+		phys_size_t rgnsize = rgn->region[i].size;
+
+		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
+			found = i;
+		else if (rgnbase <= base && base - rgnbase >= rgn->max_size)
+			break;
+	}
+
+	return found;
+}
+
 /* This routine may be called with relocation disabled. */
 long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 {
@@ -185,23 +242,28 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size;
-	int i;
+	long i, found = -1;
 
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
-
-	/* Find the region where (base, size) belongs to */
-	for (i=0; i < rgn->cnt; i++) {
+	/*
+	 * Find the lowest region where (base, size) belongs to, walking down
+	 * until no region can reach the end any more.
+	 */
+	for (i = lmb_search(rgn, base) - 1; i >= 0; i--) {
 		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
+		if (end - rgnbegin > rgn->max_size)
 			break;
+		if (end <= rgnbegin + rgn->region[i].size)
+			found = i;
 	}
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (found < 0)
 		return -1;
 
+	i = found;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size;
+
 	/* Check to see if we are removing entire region */
 	if ((rgnbegin == base) && (rgnend == end)) {
 		lmb_remove_region(rgn, i);
@@ -236,22 +298,6 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	return lmb_add_region(_rgn, base, size);
 }
 
-static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
-				phys_size_t size)
-{
-	unsigned long i;
-
-	for (i=0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if ( lmb_addrs_overlap(base,size,rgnbase,rgnsize) ) {
-			break;
-		}
-	}
-
-	return (i < rgn->cnt) ? i : -1;
-}
-
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
 {
 	return lmb_alloc_base(lmb, size, align, LMB_ALLOC_ANYWHERE);
@@ -324,15 +370,12 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
+}
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+int lmb_is_reserved_range(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	return lmb_overlaps_region(&lmb->reserved, base, size) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
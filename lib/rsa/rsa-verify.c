@@ -27,6 +27,34 @@
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+#if !defined(USE_HOSTCC)
+/*
+ * The key properties are parsed from the control FDT only once, and the key
+ * in the word order of the crypto uclass is converted only once, for all
+ * the following signatures verified by the same key.
+ */
+#define RSA_KEY_CACHE_NUM	4
+
+struct rsa_key_cache {
+	const void *blob;
+	int node;
+	struct key_prop prop;
+#if CONFIG_IS_ENABLED(DM_CRYPTO)
+	rsa_key hw_key;
+	u32 key_len;
+	bool hw_ready;
+#endif
+};
+
+static struct rsa_key_cache rsa_key_cache[RSA_KEY_CACHE_NUM];
+static int rsa_key_cache_next;
+
+/* Without FIT_HW_CRYPTO the np/c factor is only needed by the crypto uclass */
+#define RSA_FACTOR_REQUIRED	CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+#else
+#define RSA_FACTOR_REQUIRED	1
+#endif
+
 /**
  * rsa_verify_padding() - Verify RSA message padding is valid
  *
@@ -62,7 +90,7 @@ static int rsa_verify_padding(const uint8_t *msg, const int pad_len,
 }
 
 #if !defined(USE_HOSTCC)
-#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+#if CONFIG_IS_ENABLED(DM_CRYPTO)
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src,
 				   int total_len, int convert_len)
 {
@@ -77,83 +105,114 @@ static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src,
 		dst[i] = fdt32_to_cpu(src[total_wd - 1 - i]);
 }
 
-static int rsa_mod_exp_hw(struct key_prop *prop, const uint8_t *sig,
-			  const uint32_t sig_len, const uint32_t key_len,
-			  uint8_t *output)
+static const void *rsa_key_factor(struct key_prop *prop)
 {
-	struct udevice *dev;
-	uint8_t sig_reverse[sig_len];
-	uint8_t buf[sig_len];
-	rsa_key rsa_key;
-	int i, ret;
+#ifdef CONFIG_ROCKCHIP_CRYPTO_V1
+	return prop->factor_c;
+#else
+	return prop->factor_np;
+#endif
+}
+
+/* Convert the key into the word order of crypto uclass, done once per key */
+static int rsa_key_prepare_hw(struct rsa_key_cache *key, u32 key_len)
+{
+	struct key_prop *prop = &key->prop;
+	rsa_key *rsa_key = &key->hw_key;
+
+	if (key->hw_ready)
+		return key->key_len == key_len ? 0 : -EINVAL;
+
 #ifdef CONFIG_FIT_ENABLE_RSA4096_SUPPORT
 	if (key_len != RSA4096_BYTES)
 		return -EINVAL;
 
-	rsa_key.algo = CRYPTO_RSA4096;
+	rsa_key->algo = CRYPTO_RSA4096;
 #else
 	if (key_len != RSA2048_BYTES)
 		return -EINVAL;
 
-	rsa_key.algo = CRYPTO_RSA2048;
+	rsa_key->algo = CRYPTO_RSA2048;
 #endif
-	rsa_key.n = malloc(key_len);
-	rsa_key.e = malloc(key_len);
-	rsa_key.c = malloc(key_len);
-	if (!rsa_key.n || !rsa_key.e || !rsa_key.c)
+	if (!prop->public_exponent_BN || !rsa_key_factor(prop))
+		return -ENOENT;
+
+	rsa_key->n = malloc(3 * key_len);
+	if (!rsa_key->n)
 		return -ENOMEM;
 
-	rsa_convert_big_endian(rsa_key.n, (uint32_t *)prop->modulus,
+	rsa_key->e = (void *)rsa_key->n + key_len;
+	rsa_key->c = (void *)rsa_key->e + key_len;
+
+	rsa_convert_big_endian(rsa_key->n, (uint32_t *)prop->modulus,
 			       key_len, key_len);
-	rsa_convert_big_endian(rsa_key.e, (uint32_t *)prop->public_exponent_BN,
+	rsa_convert_big_endian(rsa_key->e, (uint32_t *)prop->public_exponent_BN,
 			       key_len, key_len);
-#ifdef CONFIG_ROCKCHIP_CRYPTO_V1
-	rsa_convert_big_endian(rsa_key.c, (uint32_t *)prop->factor_c,
+	rsa_convert_big_endian(rsa_key->c, (uint32_t *)rsa_key_factor(prop),
 			       key_len, key_len);
-#else
-	rsa_convert_big_endian(rsa_key.c, (uint32_t *)prop->factor_np,
-			       key_len, key_len);
-#endif
 #if defined(CONFIG_ROCKCHIP_PRELOADER_ATAGS) && defined(CONFIG_SPL_BUILD)
-	char *rsa_key_data = malloc(3 * key_len);
 	int flag = 0;
 
-	if (rsa_key_data) {
-		memcpy(rsa_key_data, rsa_key.n, key_len);
-		memcpy(rsa_key_data + key_len, rsa_key.e, key_len);
-		memcpy(rsa_key_data + 2 * key_len, rsa_key.c, key_len);
-		if (fit_board_verify_required_sigs())
-			flag = PUBKEY_FUSE_PROGRAMMED;
+	/* n, e and c are contiguous */
+	if (fit_board_verify_required_sigs())
+		flag = PUBKEY_FUSE_PROGRAMMED;
 
-		if (atags_set_pub_key(rsa_key_data, 3 * key_len, flag))
-			printf("Send public key through atags fail.");
-	}
+	if (atags_set_pub_key(rsa_key->n, 3 * key_len, flag))
+		printf("Send public key through atags fail.");
 #endif
-	for (i = 0; i < sig_len; i++)
-		sig_reverse[sig_len-1-i] = sig[i];
+	key->key_len = key_len;
+	key->hw_ready = true;
+
+	return 0;
+}
+
+static int rsa_mod_exp_hw(struct rsa_key_cache *key, const uint8_t *sig,
+			  const uint32_t sig_len, const uint32_t key_len,
+			  uint8_t *output)
+{
+	struct udevice *dev;
+	uint8_t sig_reverse[sig_len];
+	uint8_t buf[sig_len];
+	int i, ret;
 
-	dev = crypto_get_device(rsa_key.algo);
+	ret = rsa_key_prepare_hw(key, key_len);
+	if (ret)
+		return ret;
+
+	dev = crypto_get_device(key->hw_key.algo);
 	if (!dev) {
-		printf("No crypto device for expected RSA\n");
+		debug("No crypto device for expected RSA\n");
 		return -ENODEV;
 	}
 
-	ret = crypto_rsa_verify(dev, &rsa_key, (u8 *)sig_reverse, buf);
+	for (i = 0; i < sig_len; i++)
+		sig_reverse[sig_len-1-i] = sig[i];
+
+	ret = crypto_rsa_verify(dev, &key->hw_key, (u8 *)sig_reverse, buf);
 	if (ret)
-		goto out;
+		return ret;
 
 	for (i = 0; i < sig_len; i++)
-		sig_reverse[sig_len-1-i] = buf[i];
+		output[sig_len-1-i] = buf[i];
 
-	memcpy(output, sig_reverse, sig_len);
-out:
-	free(rsa_key.n);
-	free(rsa_key.e);
-	free(rsa_key.c);
-
-	return ret;
+	return 0;
 }
 #endif
+
+static int rsa_mod_exp_dev(struct key_prop *prop, const uint8_t *sig,
+			   const uint32_t sig_len, uint8_t *output)
+{
+	struct udevice *mod_exp_dev;
+	int ret;
+
+	ret = uclass_get_device(UCLASS_MOD_EXP, 0, &mod_exp_dev);
+	if (ret) {
+		printf("RSA: Can't find Modular Exp implementation\n");
+		return -EINVAL;
+	}
+
+	return rsa_mod_exp(mod_exp_dev, sig, sig_len, prop, output);
+}
 #endif
 
 int padding_pkcs_15_verify(struct image_sign_info *info,
@@ -413,18 +472,19 @@ static int rsa_verify_key(struct image_sign_info *info,
 	uint8_t buf[sig_len];
 
 #if !defined(USE_HOSTCC)
-#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
-	ret = rsa_mod_exp_hw(prop, sig, sig_len, key_len, buf);
+#if CONFIG_IS_ENABLED(DM_CRYPTO)
+	/*
+	 * Prefer the crypto uclass (e.g. Rockchip PKA), only fall back to the
+	 * UCLASS_MOD_EXP device when it can't handle the key and hardware is
+	 * not enforced by FIT_HW_CRYPTO.
+	 */
+	ret = rsa_mod_exp_hw(container_of(prop, struct rsa_key_cache, prop),
+			     sig, sig_len, key_len, buf);
+	if (ret && !CONFIG_IS_ENABLED(FIT_HW_CRYPTO) &&
+	    (ret == -ENODEV || ret == -ENOENT || ret == -EINVAL))
+		ret = rsa_mod_exp_dev(prop, sig, sig_len, buf);
 #else
-	struct udevice *mod_exp_dev;
-
-	ret = uclass_get_device(UCLASS_MOD_EXP, 0, &mod_exp_dev);
-	if (ret) {
-		printf("RSA: Can't find Modular Exp implementation\n");
-		return -EINVAL;
-	}
-
-	ret = rsa_mod_exp(mod_exp_dev, sig, sig_len, prop, buf);
+	ret = rsa_mod_exp_dev(prop, sig, sig_len, buf);
 #endif
 #else
 	ret = rsa_mod_exp_sw(sig, sig_len, prop, buf);
@@ -488,17 +548,52 @@ static int rsa_get_key_prop(struct key_prop *prop, struct image_sign_info *info,
 
 #ifdef CONFIG_ROCKCHIP_CRYPTO_V1
 	prop->factor_c = fdt_getprop(blob, node, "rsa,c", NULL);
-	if (!prop.factor_c)
+	if (!prop->factor_c && RSA_FACTOR_REQUIRED)
 		return -EFAULT;
 #else
 	prop->factor_np = fdt_getprop(blob, node, "rsa,np", NULL);
-	if (!prop->factor_np)
+	if (!prop->factor_np && RSA_FACTOR_REQUIRED)
 		return -EFAULT;
 #endif
 
 	return 0;
 }
 
+#if !defined(USE_HOSTCC)
+static struct key_prop *rsa_get_cached_key_prop(struct image_sign_info *info,
+						int node)
+{
+	struct rsa_key_cache *key;
+	int i;
+
+	if (node < 0)
+		return NULL;
+
+	for (i = 0; i < RSA_KEY_CACHE_NUM; i++) {
+		key = &rsa_key_cache[i];
+		if (key->blob == info->fdt_blob && key->node == node)
+			return &key->prop;
+	}
+
+	/* replace the oldest one */
+	key = &rsa_key_cache[rsa_key_cache_next];
+	rsa_key_cache_next = (rsa_key_cache_next + 1) % RSA_KEY_CACHE_NUM;
+#if CONFIG_IS_ENABLED(DM_CRYPTO)
+	if (key->hw_ready)
+		free(key->hw_key.n);
+#endif
+	memset(key, 0, sizeof(*key));
+
+	if (rsa_get_key_prop(&key->prop, info, node))
+		return NULL;
+
+	key->blob = info->fdt_blob;
+	key->node = node;
+
+	return &key->prop;
+}
+#endif
+
 /**
  * rsa_verify_with_keynode() - Verify a signature against some data using
  * information in node with prperties of RSA Key like modulus, exponent etc.
@@ -518,6 +613,16 @@ static int rsa_verify_with_keynode(struct image_sign_info *info,
 				   const void *hash, uint8_t *sig,
 				   uint sig_len, int node)
 {
+#if !defined(USE_HOSTCC)
+	struct key_prop *prop;
+
+	prop = rsa_get_cached_key_prop(info, node);
+	if (!prop)
+		return -EFAULT;
+
+	return rsa_verify_key(info, prop, sig, sig_len, hash,
+			      info->crypto->key_len);
+#else
 	struct key_prop prop;
 
 	if (rsa_get_key_prop(&prop, info, node))
@@ -525,7 +630,33 @@ static int rsa_verify_with_keynode(struct image_sign_info *info,
 
 	return rsa_verify_key(info, &prop, sig, sig_len, hash,
 			      info->crypto->key_len);
+#endif
+}
+
+#if !defined(USE_HOSTCC)
+int rsa_key_mod_exp(const void *blob, int node, const uint8_t *sig,
+		    uint32_t sig_len, uint8_t *out, bool hw)
+{
+	struct image_sign_info info = { .fdt_blob = blob };
+	struct key_prop *prop;
+
+	prop = rsa_get_cached_key_prop(&info, node);
+	if (!prop)
+		return -EFAULT;
+
+	if (sig_len != prop->num_bits / 8)
+		return -EINVAL;
+
+	if (!hw)
+		return rsa_mod_exp_dev(prop, sig, sig_len, out);
+#if CONFIG_IS_ENABLED(DM_CRYPTO)
+	return rsa_mod_exp_hw(container_of(prop, struct rsa_key_cache, prop),
+			      sig, sig_len, sig_len, out);
+#else
+	return -ENOSYS;
+#endif
 }
+#endif
 
 int rsa_verify(struct image_sign_info *info,
 	       const struct image_region region[], int region_count,
@@ -39,6 +39,12 @@ bool sysmem_has_init(void)
 	       plat_sysmem.has_initr : plat_sysmem.has_initf;
 }
 
+/* The timer may not be set up before relocation, so only time after it */
+static ulong sysmem_time_us(void)
+{
+	return gd->flags & GD_FLG_RELOC ? timer_get_us() : 0;
+}
+
 static inline int sysmem_is_overlap(phys_addr_t base1, phys_size_t size1,
 				    phys_addr_t base2, phys_size_t size2)
 {
@@ -161,6 +167,33 @@ void sysmem_dump(void)
 	printf("    --------------------------------------------------------------------\n\n");
 }
 
+void sysmem_stats(void)
+{
+	struct sysmem *sysmem = &plat_sysmem;
+	struct lmb *lmb = &sysmem->lmb;
+
+	if (!sysmem_has_init())
+		return;
+
+	printf("\nsysmem_stats:\n");
+	printf("    alloc.calls            = %ld (%ld failed)\n",
+	       sysmem->alloc_calls, sysmem->alloc_fails);
+	printf("    alloc.time             = %ld us (avg %ld us, max %ld us)\n",
+	       sysmem->alloc_us,
+	       sysmem->alloc_calls ? sysmem->alloc_us / sysmem->alloc_calls : 0,
+	       sysmem->alloc_max_us);
+	printf("    free.calls             = %ld\n", sysmem->free_calls);
+	printf("    free.time              = %ld us (avg %ld us)\n",
+	       sysmem->free_us,
+	       sysmem->free_calls ? sysmem->free_us / sysmem->free_calls : 0);
+	printf("    allocated.cnt          = %ld, kmem-resv.cnt = %ld\n",
+	       sysmem->allocated_cnt, sysmem->kmem_resv_cnt);
+	printf("    LMB.memory.rgn         = %ld of %d\n",
+	       lmb->memory.cnt, MAX_LMB_REGIONS);
+	printf("    LMB.reserved.rgn       = %ld of %d (peak %ld)\n\n",
+	       lmb->reserved.cnt, MAX_LMB_REGIONS, sysmem->rgn_peak);
+}
+
 void sysmem_overflow_check(void)
 {
 	struct sysmem *sysmem = &plat_sysmem;
@@ -315,11 +348,11 @@ finish:
 	return name;
 }
 
-static void *sysmem_alloc_align_base(enum memblk_id id,
-				     const char *mem_name,
-				     phys_addr_t base,
-				     phys_size_t size,
-				     ulong align)
+static void *__sysmem_alloc_align_base(enum memblk_id id,
+				       const char *mem_name,
+				       phys_addr_t base,
+				       phys_size_t size,
+				       ulong align)
 {
 	struct sysmem *sysmem = &plat_sysmem;
 	struct memblk_attr attr;
@@ -552,6 +585,30 @@ out:
 			(void *)base : NULL;
 }
 
+static void *sysmem_alloc_align_base(enum memblk_id id,
+				     const char *mem_name,
+				     phys_addr_t base,
+				     phys_size_t size,
+				     ulong align)
+{
+	struct sysmem *sysmem = &plat_sysmem;
+	ulong start, us;
+	void *paddr;
+
+	start = sysmem_time_us();
+	paddr = __sysmem_alloc_align_base(id, mem_name, base, size, align);
+	us = sysmem_time_us() - start;
+
+	sysmem->alloc_calls++;
+	sysmem->alloc_us += us;
+	sysmem->alloc_max_us = max(sysmem->alloc_max_us, us);
+	sysmem->rgn_peak = max(sysmem->rgn_peak, sysmem->lmb.reserved.cnt);
+	if (!paddr)
+		sysmem->alloc_fails++;
+
+	return paddr;
+}
+
 void *sysmem_alloc(enum memblk_id id, phys_size_t size)
 {
 	void *paddr;
@@ -664,10 +721,14 @@ int sysmem_free(phys_addr_t base)
 	struct memblock *mem;
 	struct list_head *node;
 	int ret, found = 0;
+	ulong start;
 
 	if (!sysmem_has_init())
 		return -ENOSYS;
 
+	start = sysmem_time_us();
+	sysmem->free_calls++;
+
 	/* Find existence */
 	list_for_each(node, &sysmem->allocated_head) {
 		mem = list_entry(node, struct memblock, node);
@@ -695,6 +756,7 @@ int sysmem_free(phys_addr_t base)
 		SYSMEM_E("Failed to free \"%s\" at 0x%08lx\n",
 			 mem->attr.name, (ulong)base);
 	}
+	sysmem->free_us += sysmem_time_us() - start;
 
 	return (ret >= 0) ? 0 : ret;
 }
@@ -798,6 +860,13 @@ static int do_sysmem_dump(cmd_tbl_t *cmdtp, int flag,
 	return 0;
 }
 
+static int do_sysmem_stats(cmd_tbl_t *cmdtp, int flag,
+			   int argc, char *const argv[])
+{
+	sysmem_stats();
+	return 0;
+}
+
 static int do_sysmem_search(cmd_tbl_t *cmdtp, int flag,
 			    int argc, char *const argv[])
 {
@@ -827,6 +896,12 @@ U_BOOT_CMD(
 	""
 );
 
+U_BOOT_CMD(
+	sysmem_stats, 1, 1, do_sysmem_stats,
+	"Dump sysmem allocation count and cost",
+	""
+);
+
 U_BOOT_CMD(
 	sysmem_search, 2, 1, do_sysmem_search,
 	"Search a available sysmem region",
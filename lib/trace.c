@@ -5,16 +5,40 @@
  */
 
 #include <common.h>
+#include <div64.h>
 #include <mapmem.h>
 #include <trace.h>
 #include <asm/io.h>
 #include <asm/sections.h>
+#include <linux/log2.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 static char trace_enabled __attribute__((section(".data")));
 static char trace_inited __attribute__((section(".data")));
 
+/*
+ * Each function call site found has a slot in an open-addressed hash table
+ * of call counts, one slot per FUNC_HASH_BYTES of code. This is a fraction
+ * of the size of an array indexed by every possible function site.
+ */
+#define FUNC_HASH_BYTES		32
+#define FUNC_HASH_PROBES	16
+
+struct trace_func_slot {
+	u32 func;		/* Function number plus one, 0 if unused */
+	u32 count;		/* Number of times called */
+};
+
+/*
+ * A call record as kept in memory. The caller is not stored since it can
+ * be worked out from the entry and exit records when the trace is exported.
+ */
+struct trace_rec {
+	u32 func;		/* Function number */
+	u32 flags;		/* Flags and timestamp */
+};
+
 /* The header block at the start of the trace memory area */
 struct trace_hdr {
 	int func_count;		/* Total number of function call sites */
@@ -22,21 +46,31 @@ struct trace_hdr {
 	u64 untracked_count;	/* Total number of untracked function calls */
 	int funcs_used;		/* Total number of functions used */
 
-	/*
-	 * Call count for each function. This is indexed by the word offset
-	 * of the function from gd->relocaddr
-	 */
-	uintptr_t *call_accum;
+	/* Call count for each function, hashed by function number */
+	struct trace_func_slot *func_hash;
+	uint func_hash_bits;
 
 	/* Function trace list */
-	struct trace_call *ftrace;	/* The function call records */
+	enum trace_mode mode;
+	struct trace_rec *ftrace;	/* The function call records */
 	ulong ftrace_size;	/* Num. of ftrace records we have space for */
 	ulong ftrace_count;	/* Num. of ftrace records written */
+	ulong ftrace_pos;	/* Index of the next record to write */
 	ulong ftrace_too_deep_count;	/* Functions that were too deep */
 
+	/* Call stack samples, in the same space as the function trace */
+	u32 *samples;
+	ulong sample_size;	/* Num. of words we have space for */
+	ulong sample_used;	/* Num. of words written */
+	ulong sample_count;	/* Num. of samples written */
+	ulong sample_dropped;	/* Num. of samples which did not fit */
+	ulong sample_ticks;	/* Sample interval, 0 if not sampling */
+	u64 next_sample;	/* Tick count at which to take the next sample */
+
 	int depth;
 	int depth_limit;
 	int max_depth;
+	u32 stack[TRACE_STACK_MAX];	/* Function at each call depth */
 };
 
 static struct trace_hdr *hdr;	/* Pointer to start of trace buffer */
@@ -57,40 +91,106 @@ static inline uintptr_t __attribute__((no_instrument_function))
 	return offset / FUNC_SITE_SIZE;
 }
 
-static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
-				void *caller, ulong flags)
+static void __attribute__((no_instrument_function)) add_func_count(uint func)
 {
-	if (hdr->depth > hdr->depth_limit) {
-		hdr->ftrace_too_deep_count++;
+	uint mask = (1U << hdr->func_hash_bits) - 1;
+	struct trace_func_slot *slot;
+	uint i, probe;
+
+	if (func >= hdr->func_count) {
+		hdr->untracked_count++;
 		return;
 	}
-	if (hdr->ftrace_count < hdr->ftrace_size) {
-		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
+	i = (func * 0x9e3779b1U) >> (32 - hdr->func_hash_bits);
+	for (probe = 0; probe < FUNC_HASH_PROBES; probe++) {
+		slot = &hdr->func_hash[i];
+		if (slot->func == func + 1) {
+			slot->count++;
+			hdr->call_count++;
+			return;
+		}
+		if (!slot->func) {
+			slot->func = func + 1;
+			slot->count = 1;
+			hdr->funcs_used++;
+			hdr->call_count++;
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+	hdr->untracked_count++;
+}
+
+static void __attribute__((no_instrument_function)) add_rec(u32 func,
+								u32 flags)
+{
+	struct trace_rec *rec;
 
-		rec->func = func_ptr_to_num(func_ptr);
-		rec->caller = func_ptr_to_num(caller);
-		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
+	if (hdr->ftrace_pos == hdr->ftrace_size) {
+		if (hdr->mode != TRACE_MODE_RING || hdr->ftrace_size < 2) {
+			hdr->ftrace_count++;
+			return;
+		}
+		/* The first record is the text base, so keep it */
+		hdr->ftrace_pos = 1;
 	}
+	rec = &hdr->ftrace[hdr->ftrace_pos++];
+	rec->func = func;
+	rec->flags = flags;
 	hdr->ftrace_count++;
 }
 
+static void __attribute__((no_instrument_function)) add_ftrace(uint func,
+								   ulong flags)
+{
+	if (hdr->depth > hdr->depth_limit) {
+		hdr->ftrace_too_deep_count++;
+		return;
+	}
+	add_rec(func, flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK));
+}
+
 static void __attribute__((no_instrument_function)) add_textbase(void)
 {
-	if (hdr->ftrace_count < hdr->ftrace_size) {
-		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
+	add_rec(CONFIG_SYS_TEXT_BASE, FUNCF_TEXTBASE);
+}
+
+/*
+ * Record the call stack if the sample interval has passed. This is checked
+ * on function entry rather than from a timer interrupt, so a sample is
+ * weighted by the number of intervals since the last one.
+ */
+static void __attribute__((no_instrument_function)) add_sample(void)
+{
+	u64 ticks = get_ticks();
+	ulong periods;
+	u32 *sample;
+	int frames, i;
+
+	if (ticks < hdr->next_sample)
+		return;
+	periods = (ulong)(ticks - hdr->next_sample) / hdr->sample_ticks + 1;
+	hdr->next_sample = ticks + hdr->sample_ticks;
 
-		rec->func = CONFIG_SYS_TEXT_BASE;
-		rec->caller = 0;
-		rec->flags = FUNCF_TEXTBASE;
+	frames = min(hdr->depth + 1, (int)TRACE_STACK_MAX);
+	if (hdr->sample_used + 1 + frames > hdr->sample_size) {
+		hdr->sample_dropped++;
+		return;
 	}
-	hdr->ftrace_count++;
+	sample = &hdr->samples[hdr->sample_used];
+	sample[0] = TRACE_SAMPLE_HDR(frames,
+			min(periods, (ulong)TRACE_SAMPLE_WEIGHT_MAX));
+	for (i = 0; i < frames; i++)
+		sample[i + 1] = hdr->stack[i];
+	hdr->sample_used += 1 + frames;
+	hdr->sample_count++;
 }
 
 /**
  * This is called on every function entry
  *
- * We add to our tally for this function and add to the list of called
- * functions.
+ * We add to our tally for this function and either add to the list of
+ * called functions or check whether it is time to sample the call stack.
  *
  * @param func_ptr	Pointer to function being entered
  * @param caller	Pointer to function which called this function
@@ -99,18 +199,17 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_enter(
 		void *func_ptr, void *caller)
 {
 	if (trace_enabled) {
-		int func;
-
-		add_ftrace(func_ptr, caller, FUNCF_ENTRY);
-		func = func_ptr_to_num(func_ptr);
-		if (func < hdr->func_count) {
-			hdr->call_accum[func]++;
-			hdr->call_count++;
-		} else {
-			hdr->untracked_count++;
-		}
+		uint func = func_ptr_to_num(func_ptr);
+
+		add_func_count(func);
+		if (hdr->depth < TRACE_STACK_MAX)
+			hdr->stack[hdr->depth] = func;
+		if (hdr->sample_ticks)
+			add_sample();
+		else
+			add_ftrace(func, FUNCF_ENTRY);
 		hdr->depth++;
-		if (hdr->depth > hdr->depth_limit)
+		if (hdr->depth > hdr->max_depth)
 			hdr->max_depth = hdr->depth;
 	}
 }
@@ -118,7 +217,9 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_enter(
 /**
  * This is called on every function exit
  *
- * We do nothing here.
+ * We add an exit record unless we are sampling. The depth does not go
+ * below zero, so that functions which were running when tracing started
+ * do not push the rest of the trace to a negative depth.
  *
  * @param func_ptr	Pointer to function being entered
  * @param caller	Pointer to function which called this function
@@ -127,8 +228,10 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_exit(
 		void *func_ptr, void *caller)
 {
 	if (trace_enabled) {
-		add_ftrace(func_ptr, caller, FUNCF_EXIT);
-		hdr->depth--;
+		if (hdr->depth > 0)
+			hdr->depth--;
+		if (!hdr->sample_ticks)
+			add_ftrace(func_ptr_to_num(func_ptr), FUNCF_EXIT);
 	}
 }
 
@@ -147,9 +250,9 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_exit(
 int trace_list_functions(void *buff, int buff_size, unsigned int *needed)
 {
 	struct trace_output_hdr *output_hdr = NULL;
+	struct trace_func_slot *slot;
 	void *end, *ptr = buff;
-	int func;
-	int upto;
+	int i, upto;
 
 	end = buff ? buff + buff_size : NULL;
 
@@ -159,17 +262,16 @@ int trace_list_functions(void *buff, int buff_size, unsigned int *needed)
 	ptr += sizeof(struct trace_output_hdr);
 
 	/* Add information about each function */
-	for (func = upto = 0; func < hdr->func_count; func++) {
-		int calls = hdr->call_accum[func];
-
-		if (!calls)
+	for (i = upto = 0; i < 1 << hdr->func_hash_bits; i++) {
+		slot = &hdr->func_hash[i];
+		if (!slot->func)
 			continue;
 
 		if (ptr + sizeof(struct trace_output_func) < end) {
 			struct trace_output_func *stats = ptr;
 
-			stats->offset = func * FUNC_SITE_SIZE;
-			stats->call_count = calls;
+			stats->offset = (slot->func - 1) * FUNC_SITE_SIZE;
+			stats->call_count = slot->count;
 			upto++;
 		}
 		ptr += sizeof(struct trace_output_func);
@@ -188,12 +290,33 @@ int trace_list_functions(void *buff, int buff_size, unsigned int *needed)
 	return 0;
 }
 
+/* Check whether the ring has overwritten any records */
+static bool trace_wrapped(void)
+{
+	return hdr->mode == TRACE_MODE_RING &&
+		hdr->ftrace_count > hdr->ftrace_size;
+}
+
+/**
+ * Produce a list of function entry/exit records, oldest first
+ *
+ * The caller of each call is the function which the shadow stack built up
+ * from the earlier records says is running. It is 0 for records which
+ * belong to calls made before the oldest record.
+ *
+ * @param buff		Buffer to place list into
+ * @param buff_size	Size of buffer
+ * @param needed	Returns size of buffer needed, which may be
+ *			greater than buff_size if we ran out of space.
+ * @return 0 if ok, -1 if space was exhausted
+ */
 int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 {
 	struct trace_output_hdr *output_hdr = NULL;
+	u32 stack[TRACE_STACK_MAX];
 	void *end, *ptr = buff;
-	int rec, upto;
-	int count;
+	int rec, upto, sp;
+	ulong count, first;
 
 	end = buff ? buff + buff_size : NULL;
 
@@ -202,17 +325,52 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 		output_hdr = ptr;
 	ptr += sizeof(struct trace_output_hdr);
 
-	/* Add information about each call */
-	count = hdr->ftrace_count;
-	if (count > hdr->ftrace_size)
+	/* Once the ring has wrapped the oldest record is the next to go */
+	if (trace_wrapped()) {
 		count = hdr->ftrace_size;
-	for (rec = upto = 0; rec < count; rec++) {
+		first = hdr->ftrace_pos;
+	} else {
+		count = hdr->ftrace_pos;
+		first = 1;
+	}
+
+	/* Add information about each call */
+	for (rec = upto = sp = 0; rec < count; rec++) {
+		struct trace_rec *call;
+		u32 caller = 0;
+		int idx;
+
+		idx = rec ? first + rec - 1 : 0;
+		if (idx >= hdr->ftrace_size)
+			idx -= hdr->ftrace_size - 1;
+		call = &hdr->ftrace[idx];
+
+		switch (TRACE_CALL_TYPE(call)) {
+		case FUNCF_ENTRY:
+			if (sp > 0 && sp <= TRACE_STACK_MAX)
+				caller = stack[sp - 1];
+			if (sp < TRACE_STACK_MAX)
+				stack[sp] = call->func;
+			sp++;
+			break;
+		case FUNCF_EXIT:
+			if (sp > 0)
+				sp--;
+			if (sp > 0 && sp <= TRACE_STACK_MAX)
+				caller = stack[sp - 1];
+			break;
+		}
+
 		if (ptr + sizeof(struct trace_call) < end) {
-			struct trace_call *call = &hdr->ftrace[rec];
 			struct trace_call *out = ptr;
 
-			out->func = call->func * FUNC_SITE_SIZE;
-			out->caller = call->caller * FUNC_SITE_SIZE;
+			if (TRACE_CALL_TYPE(call) == FUNCF_TEXTBASE) {
+				out->func = call->func;
+				out->caller = 0;
+			} else {
+				out->func = call->func * FUNC_SITE_SIZE;
+				out->caller = caller * FUNC_SITE_SIZE;
+			}
 			out->flags = call->flags;
 			upto++;
 		}
@@ -232,6 +390,53 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 	return 0;
 }
 
+int trace_list_samples(void *buff, int buff_size, unsigned int *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	ulong pos, upto;
+	int frames, i;
+
+	*needed = 0;
+	if (!hdr->sample_count)
+		return 0;
+
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) < end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Add each sample, converting function numbers to offsets */
+	for (pos = upto = 0; pos < hdr->sample_used; pos += 1 + frames) {
+		u32 *sample = &hdr->samples[pos];
+
+		frames = TRACE_SAMPLE_FRAMES(sample[0]);
+		if (ptr + (1 + frames) * sizeof(u32) < end) {
+			u32 *out = ptr;
+
+			out[0] = sample[0];
+			for (i = 1; i <= frames; i++)
+				out[i] = sample[i] * FUNC_SITE_SIZE;
+			upto++;
+		}
+		ptr += (1 + frames) * sizeof(u32);
+	}
+
+	/* Update the header */
+	if (output_hdr) {
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+	}
+
+	/* Work out how must of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -1;
+	return 0;
+}
+
 /* Print basic information about tracing */
 void trace_print_stats(void)
 {
@@ -247,18 +452,32 @@ void trace_print_stats(void)
 	}
 	print_grouped_ull(hdr->func_count, 10);
 	puts(" function sites\n");
+	print_grouped_ull(hdr->funcs_used, 10);
+	printf(" functions called (%u hash slots)\n",
+	       1U << hdr->func_hash_bits);
 	print_grouped_ull(hdr->call_count, 10);
 	puts(" function calls\n");
 	print_grouped_ull(hdr->untracked_count, 10);
 	puts(" untracked function calls\n");
-	count = min(hdr->ftrace_count, hdr->ftrace_size);
-	print_grouped_ull(count, 10);
-	puts(" traced function calls");
-	if (hdr->ftrace_count > hdr->ftrace_size) {
-		printf(" (%lu dropped due to overflow)",
-		       hdr->ftrace_count - hdr->ftrace_size);
+	if (hdr->mode == TRACE_MODE_SAMPLE) {
+		print_grouped_ull(hdr->sample_count, 10);
+		printf(" call stack samples every %lu ticks",
+		       hdr->sample_ticks);
+		if (hdr->sample_dropped)
+			printf(" (%lu dropped due to overflow)",
+			       hdr->sample_dropped);
+		puts("\n");
+	} else {
+		count = trace_wrapped() ? hdr->ftrace_size : hdr->ftrace_pos;
+		print_grouped_ull(count, 10);
+		puts(" traced function calls");
+		if (hdr->ftrace_count > count) {
+			printf(" (%lu %s)", hdr->ftrace_count - count,
+			       hdr->mode == TRACE_MODE_RING ?
+			       "overwritten" : "dropped due to overflow");
+		}
+		puts("\n");
 	}
-	puts("\n");
 	printf("%15d maximum observed call depth\n", hdr->max_depth);
 	printf("%15d call depth limit\n", hdr->depth_limit);
 	print_grouped_ull(hdr->ftrace_too_deep_count, 10);
@@ -267,9 +486,72 @@ void trace_print_stats(void)
 
 void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
 {
+	/* Don't count the time we were paused as one long sample */
+	if (enabled && trace_inited && hdr->sample_ticks)
+		hdr->next_sample = get_ticks() + hdr->sample_ticks;
 	trace_enabled = enabled != 0;
 }
 
+int __attribute__((no_instrument_function)) trace_set_mode(
+		enum trace_mode mode, ulong sample_us)
+{
+	char was_enabled = trace_enabled;
+
+	if (!trace_inited) {
+		printf("Trace is disabled\n");
+		return -1;
+	}
+	if (mode == TRACE_MODE_SAMPLE && !sample_us)
+		return -1;
+
+	trace_enabled = 0;
+	hdr->mode = mode;
+	hdr->ftrace_count = 0;
+	hdr->ftrace_pos = 0;
+	add_textbase();
+
+	hdr->samples = (u32 *)&hdr->ftrace[1];
+	hdr->sample_size = hdr->ftrace_size > 1 ?
+		(hdr->ftrace_size - 1) * sizeof(*hdr->ftrace) / sizeof(u32) : 0;
+	hdr->sample_used = 0;
+	hdr->sample_count = 0;
+	hdr->sample_dropped = 0;
+	hdr->sample_ticks = 0;
+	if (mode == TRACE_MODE_SAMPLE) {
+		hdr->sample_ticks = max_t(u64, lldiv((u64)sample_us *
+						     get_tbclk(), 1000000), 1);
+		hdr->next_sample = get_ticks() + hdr->sample_ticks;
+	}
+	trace_enabled = was_enabled;
+
+	return 0;
+}
+
+/* Work out the size of the header and count hash for a U-Boot this size */
+static size_t __attribute__((no_instrument_function)) trace_hdr_size(void)
+{
+	ulong slots;
+
+	slots = roundup_pow_of_two(max(gd->mon_len / FUNC_HASH_BYTES, 256UL));
+
+	return sizeof(*hdr) + slots * sizeof(struct trace_func_slot);
+}
+
+static void __attribute__((no_instrument_function)) trace_hdr_setup(
+		void *buff, size_t buff_size, size_t needed)
+{
+	hdr->func_count = gd->mon_len / FUNC_SITE_SIZE;
+	hdr->func_hash = (struct trace_func_slot *)(hdr + 1);
+	hdr->func_hash_bits = ilog2((needed - sizeof(*hdr)) /
+				    sizeof(struct trace_func_slot));
+
+	/* Use any remaining space for the timed function trace */
+	hdr->ftrace = (struct trace_rec *)(buff + needed);
+	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
+	hdr->ftrace_pos = min(hdr->ftrace_pos, hdr->ftrace_size);
+	add_textbase();
+}
+
 /**
  * Init the tracing system ready for used, and enable it
  *
@@ -279,13 +561,11 @@ void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
 int __attribute__((no_instrument_function)) trace_init(void *buff,
 		size_t buff_size)
 {
-	ulong func_count = gd->mon_len / FUNC_SITE_SIZE;
-	size_t needed;
+	size_t needed = trace_hdr_size();
 	int was_disabled = !trace_enabled;
 
 	if (!was_disabled) {
 #ifdef CONFIG_TRACE_EARLY
-		char *end;
 		ulong used;
 
 		/*
@@ -295,8 +575,8 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 		trace_enabled = 0;
 		hdr = map_sysmem(CONFIG_TRACE_EARLY_ADDR,
 				 CONFIG_TRACE_EARLY_SIZE);
-		end = (char *)&hdr->ftrace[hdr->ftrace_count];
-		used = end - (char *)hdr;
+		used = needed + hdr->ftrace_pos * sizeof(*hdr->ftrace);
+		used = min(used, (ulong)buff_size);
 		printf("trace: copying %08lx bytes of early data from %x to %08lx\n",
 		       used, CONFIG_TRACE_EARLY_ADDR,
 		       (ulong)map_to_sysmem(buff));
@@ -307,7 +587,6 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 #endif
 	}
 	hdr = (struct trace_hdr *)buff;
-	needed = sizeof(*hdr) + func_count * sizeof(uintptr_t);
 	if (needed > buff_size) {
 		printf("trace: buffer size %zd bytes: at least %zd needed\n",
 		       buff_size, needed);
@@ -316,13 +595,7 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 
 	if (was_disabled)
 		memset(hdr, '\0', needed);
-	hdr->func_count = func_count;
-	hdr->call_accum = (uintptr_t *)(hdr + 1);
-
-	/* Use any remaining space for the timed function trace */
-	hdr->ftrace = (struct trace_call *)(buff + needed);
-	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
-	add_textbase();
+	trace_hdr_setup(buff, buff_size, needed);
 
 	puts("trace: enabled\n");
 	hdr->depth_limit = 15;
@@ -334,16 +607,14 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 #ifdef CONFIG_TRACE_EARLY
 int __attribute__((no_instrument_function)) trace_early_init(void)
 {
-	ulong func_count = gd->mon_len / FUNC_SITE_SIZE;
 	size_t buff_size = CONFIG_TRACE_EARLY_SIZE;
-	size_t needed;
+	size_t needed = trace_hdr_size();
 
 	/* We can ignore additional calls to this function */
 	if (trace_enabled)
 		return 0;
 
 	hdr = map_sysmem(CONFIG_TRACE_EARLY_ADDR, CONFIG_TRACE_EARLY_SIZE);
-	needed = sizeof(*hdr) + func_count * sizeof(uintptr_t);
 	if (needed > buff_size) {
 		printf("trace: buffer size is %zd bytes, at least %zd needed\n",
 		       buff_size, needed);
@@ -351,13 +622,7 @@ int __attribute__((no_instrument_function)) trace_early_init(void)
 	}
 
 	memset(hdr, '\0', needed);
-	hdr->call_accum = (uintptr_t *)(hdr + 1);
-	hdr->func_count = func_count;
-
-	/* Use any remaining space for the timed function trace */
-	hdr->ftrace = (struct trace_call *)((char *)hdr + needed);
-	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
-	add_textbase();
+	trace_hdr_setup(hdr, buff_size, needed);
 	hdr->depth_limit = 200;
 	printf("trace: early enable at %08x\n", CONFIG_TRACE_EARLY_ADDR);
 
@@ -328,6 +328,20 @@ int eth_is_active(struct udevice *dev)
 	return priv->state == ETH_STATE_ACTIVE;
 }
 
+int eth_get_stats(struct udevice *dev, struct eth_stats *stats)
+{
+	struct eth_ops *ops = eth_get_ops(dev);
+
+	if (!device_active(dev))
+		return -ENODEV;
+	if (!ops->get_stats)
+		return -ENOSYS;
+
+	memset(stats, '\0', sizeof(*stats));
+
+	return ops->get_stats(dev, stats);
+}
+
 int eth_send(void *packet, int length)
 {
 	struct udevice *current;
@@ -489,6 +503,8 @@ static int eth_post_probe(struct udevice *dev)
 			ops->write_hwaddr += gd->reloc_off;
 		if (ops->read_rom_hwaddr)
 			ops->read_rom_hwaddr += gd->reloc_off;
+		if (ops->get_stats)
+			ops->get_stats += gd->reloc_off;
 
 		reloc_done++;
 	}
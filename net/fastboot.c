@@ -29,15 +29,31 @@ struct __attribute__((packed)) fastboot_header {
 	unsigned short seq;
 };
 
+/*
+ * The host tool sends up to 8KiB per packet when we allow it. Anything
+ * bigger than an Ethernet frame needs IP reassembly (20 + 8 byte headers).
+ */
+#if defined(CONFIG_IP_DEFRAG) && CONFIG_NET_MAXDEFRAG >= 8192 + 28
+#define PACKET_SIZE 8192
+#else
 #define PACKET_SIZE 1024
+#endif
 #define FASTBOOT_HEADER_SIZE sizeof(struct fastboot_header)
 #define DATA_SIZE (PACKET_SIZE - FASTBOOT_HEADER_SIZE)
 #define FASTBOOT_VERSION "0.4"
 
+#ifndef CONFIG_FASTBOOT_UDP_WINDOW
+#define CONFIG_FASTBOOT_UDP_WINDOW 1
+#endif
+
 /* Sequence number sent for every packet */
 static unsigned short fb_sequence_number = 1;
 static const unsigned short fb_packet_size = PACKET_SIZE;
 static const unsigned short fb_udp_version = 1;
+/* Data bytes in a full packet, as agreed with the host in INIT */
+static unsigned int fb_data_size = DATA_SIZE;
+/* Bit n set: download packet fb_sequence_number + n already stored */
+static unsigned int fb_window_mask;
 
 /* Keep track of last packet for resubmission */
 static uchar last_packet[PACKET_SIZE];
@@ -58,6 +74,9 @@ static int fastboot_remote_port;
 /* The UDP port at our end */
 static int fastboot_our_port;
 
+/* NUL terminated copy of a command, download data is used in place */
+static char fb_command[DATA_SIZE + 1];
+
 static void fb_getvar(char*);
 static void fb_download(char*, unsigned int, char*);
 static void fb_flash(char*);
@@ -103,6 +122,27 @@ void fastboot_send_info(const char *msg)
 			    fastboot_remote_port, fastboot_our_port, len);
 }
 
+/**
+ * Sends a header-only acknowledgement, used for download packets received
+ * ahead of the current sequence number. Doesn't touch last_packet.
+ *
+ * @param seq    Sequence number being acknowledged
+ */
+static void fastboot_send_ack(unsigned short seq)
+{
+	struct fastboot_header fb_ack_header = {
+		.id = FASTBOOT_FASTBOOT,
+		.flags = 0,
+		.seq = htons(seq)
+	};
+	uchar *packet = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+
+	memcpy(packet, &fb_ack_header, sizeof(fb_ack_header));
+	net_send_udp_packet(net_server_ethaddr, fastboot_remote_ip,
+			    fastboot_remote_port, fastboot_our_port,
+			    sizeof(fb_ack_header));
+}
+
 /**
  * Constructs and sends a packet in response to received fastboot packet
  *
@@ -358,6 +398,62 @@ static void fb_download(char *fastboot_data, unsigned int fastboot_data_len,
 	}
 }
 
+/**
+ * Stores a download packet that arrived ahead of the one the sequence
+ * number expects, straight at its final place in the download buffer.
+ * Every packet but the last one carries fb_data_size bytes.
+ *
+ * @param ahead   Distance from the expected sequence number
+ * @param data    Pointer to received fastboot data
+ * @param len     Length of received fastboot data
+ * @return 0 if the packet was stored, -1 if it has to be ignored
+ */
+static int fb_download_ahead(unsigned short ahead, uchar *data,
+		unsigned int len)
+{
+	unsigned int offset = bytes_received + ahead * fb_data_size;
+
+	if (!cmd_string || strcmp("download", cmd_string) || !bytes_expected ||
+	    !len || offset + len > bytes_expected ||
+	    (len != fb_data_size && offset + len != bytes_expected))
+		return -1;
+
+	memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + offset, data, len);
+	fb_window_mask |= 1U << ahead;
+
+	return 0;
+}
+
+/**
+ * Moves the sequence number past the download packets stored ahead of
+ * the one just handled, which were acknowledged when they arrived.
+ */
+static void fb_download_advance(void)
+{
+	struct fastboot_header fb_ack_header = {
+		.id = FASTBOOT_FASTBOOT,
+		.flags = 0,
+	};
+
+	if (!(fb_window_mask & 2)) {
+		fb_window_mask = 0;
+		return;
+	}
+
+	while (fb_window_mask & 2) {
+		fb_window_mask >>= 1;
+		bytes_received = min(bytes_received + fb_data_size,
+				     bytes_expected);
+		fb_sequence_number++;
+	}
+	fb_window_mask = 0;
+
+	/* A retransmission of the newest one gets its ack again */
+	fb_ack_header.seq = htons(fb_sequence_number - 1);
+	last_packet_len = sizeof(fb_ack_header);
+	memcpy(last_packet, &fb_ack_header, last_packet_len);
+}
+
 /**
  * Writes the previously downloaded image to the partition indicated by
  * cmd_parameter. Writes to response.
@@ -459,6 +555,7 @@ static void cleanup_command_data(void)
 		free(cmd_string);
 	}
 	cmd_parameter = cmd_string = NULL;
+	fb_window_mask = 0;
 }
 
 /**
@@ -474,8 +571,8 @@ static void fastboot_handler(uchar *packet, unsigned dport, struct in_addr sip,
 		unsigned sport, unsigned len)
 {
 	struct fastboot_header fb_header;
-	char fastboot_data[DATA_SIZE] = {0};
-	unsigned int fastboot_data_len = 0;
+	char *fastboot_data = (char *)packet;
+	unsigned short ahead;
 
 	if (dport != fastboot_our_port) {
 		return;
@@ -499,16 +596,40 @@ static void fastboot_handler(uchar *packet, unsigned dport, struct in_addr sip,
 		break;
 	case FASTBOOT_INIT:
 	case FASTBOOT_FASTBOOT:
-		fastboot_data_len = len;
-		if (len > 0) {
-			memcpy(fastboot_data, packet, len);
+		if (fb_header.id == FASTBOOT_INIT && len >= 4) {
+			/* Host version and maximum packet size */
+			unsigned short host_size = (packet[2] << 8) | packet[3];
+
+			if (host_size > FASTBOOT_HEADER_SIZE)
+				fb_data_size = min_t(unsigned int, host_size,
+						     PACKET_SIZE) -
+					       FASTBOOT_HEADER_SIZE;
+			fb_window_mask = 0;
+		}
+		if (fb_header.id == FASTBOOT_FASTBOOT && !cmd_string) {
+			/* New command, needs to be NUL terminated for parsing */
+			memcpy(fb_command, packet, len);
+			fb_command[len] = '\0';
+			fastboot_data = fb_command;
+		} else {
+			fastboot_data = (char *)packet;
 		}
+		ahead = fb_header.seq - fb_sequence_number;
 		if (fb_header.seq == fb_sequence_number) {
-			fastboot_send(fb_header, fastboot_data, fastboot_data_len, 0);
+			fastboot_send(fb_header, fastboot_data, len, 0);
 			fb_sequence_number++;
+			fb_download_advance();
 		} else if (fb_header.seq == fb_sequence_number - 1) {
 			/* Retransmit last sent packet */
-			fastboot_send(fb_header, fastboot_data, fastboot_data_len, 1);
+			fastboot_send(fb_header, fastboot_data, len, 1);
+		} else if (ahead < CONFIG_FASTBOOT_UDP_WINDOW) {
+			if (fb_window_mask & (1U << ahead) ||
+			    !fb_download_ahead(ahead, packet, len))
+				fastboot_send_ack(fb_header.seq);
+		} else if ((unsigned short)-ahead <= CONFIG_FASTBOOT_UDP_WINDOW &&
+			   bytes_expected) {
+			/* Our ack of a windowed download packet was lost */
+			fastboot_send_ack(fb_header.seq);
 		}
 		break;
 	default:
@@ -45,12 +45,30 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+#ifndef CONFIG_NFS_READ_WINDOW
+#define CONFIG_NFS_READ_WINDOW	1
+#endif
+#define NFS_HASH_BYTES	(NFS_READ_SIZE / 2 * 10)	/* bytes per '#' */
+
+/* One outstanding READ, matched to its reply by the RPC xid */
+struct nfs_read_slot {
+	unsigned long id;	/* 0 when the slot is idle */
+	u32 offset;
+	u32 len;
+};
+
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
 
+static struct nfs_read_slot nfs_read_slots[CONFIG_NFS_READ_WINDOW];
+static u32 nfs_read_size;	/* bytes asked for by each READ */
+static u32 nfs_read_next;	/* first offset not requested yet */
+static u32 nfs_read_end;	/* file size, once a reply reported EOF */
+static ulong nfs_read_bytes;
+static ulong nfs_read_hashes;
+static ulong nfs_read_start;
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -386,11 +404,134 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+/*
+ * Without IP reassembly a READ reply must fit in one Ethernet frame. With
+ * it, use the biggest power of two the server and the reassembly buffer
+ * allow. Servers answering with less make nfs_read_done() shrink it.
+ */
+static u32 nfs_max_read_size(void)
+{
+	u32 size = NFS_READ_SIZE;
+#ifdef CONFIG_IP_DEFRAG
+	u32 max = (supported_nfs_versions & NFSV2_FLAG) ? NFS_MAXDATA :
+							   NFS3_MAXDATA;
+
+	while (size * 2 <= max &&
+	       size * 2 + NFS_READ_OVERHEAD <= CONFIG_NET_MAXDEFRAG)
+		size *= 2;
+#endif
+	return size;
+}
+
+static void nfs_read_issue(struct nfs_read_slot *slot, u32 offset, u32 len)
+{
+	slot->offset = offset;
+	slot->len = len;
+	nfs_read_req(offset, len);
+	slot->id = rpc_id;
+}
+
+/* Keep CONFIG_NFS_READ_WINDOW READs in flight until EOF is known */
+static void nfs_read_fill(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id)
+			continue;
+		if (nfs_read_next >= nfs_read_end)
+			break;
+		nfs_read_issue(&nfs_read_slots[i], nfs_read_next,
+			       nfs_read_size);
+		nfs_read_next += nfs_read_size;
+	}
+}
+
+static void nfs_read_start_file(void)
+{
+	memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
+	nfs_read_size = nfs_max_read_size();
+	nfs_read_next = 0;
+	nfs_read_end = ~0U;
+	nfs_read_bytes = 0;
+	nfs_read_hashes = 0;
+	nfs_read_start = get_timer(0);
+	debug("NFS READ size %u, window %d\n", nfs_read_size,
+	      CONFIG_NFS_READ_WINDOW);
+
+	nfs_read_fill();
+}
+
+/* Done once every byte below the EOF offset has arrived */
+static bool nfs_read_complete(void)
+{
+	int i;
+
+	if (nfs_read_end == ~0U)
+		return false;
+
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id &&
+		    nfs_read_slots[i].offset < nfs_read_end)
+			return false;
+	}
+
+	return true;
+}
+
+static void nfs_read_progress(int rlen)
+{
+	nfs_read_bytes += rlen;
+	while (nfs_read_hashes < nfs_read_bytes / NFS_HASH_BYTES) {
+		if (nfs_read_hashes && !(nfs_read_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		nfs_read_hashes++;
+	}
+}
+
+static void nfs_read_done(struct nfs_read_slot *slot, int rlen, bool eof)
+{
+	u32 end = slot->offset + rlen;
+
+	slot->id = 0;
+	nfs_read_progress(rlen);
+
+	if (eof || !rlen) {
+		if (end < nfs_read_end)
+			nfs_read_end = end;
+	} else if (rlen < slot->len) {
+		/*
+		 * Either the end of an NFSv2 file or a server with a smaller
+		 * transfer size: ask for the rest, a zero length reply tells
+		 * which one it was.
+		 */
+		if (rlen >= NFS_READ_SIZE && rlen < nfs_read_size)
+			nfs_read_size = rounddown(rlen, NFS_READ_SIZE);
+		nfs_read_issue(slot, end, slot->len - rlen);
+		return;
+	}
+
+	nfs_read_fill();
+}
+
+static void nfs_read_report(void)
+{
+	ulong time_taken = get_timer(nfs_read_start);
+
+	if (time_taken > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time_taken * 1000, "/s");
+	}
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
 static void nfs_send(void)
 {
+	int i;
+
 	debug("%s\n", __func__);
 
 	switch (nfs_state) {
@@ -416,7 +557,12 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+			struct nfs_read_slot *slot = &nfs_read_slots[i];
+
+			if (slot->id)
+				nfs_read_issue(slot, slot->offset, slot->len);
+		}
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -652,19 +798,28 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs_read_reply(uchar *pkt, unsigned len)
+static int nfs_read_reply(uchar *pkt, unsigned len,
+			  struct nfs_read_slot **slotp, bool *eof)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
-	uchar *data_ptr;
+	unsigned long id;
+	uint32_t *data;
+	int i, off, rlen;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the headers are copied, the data goes straight to memory */
+	if (len < sizeof(rpc_pkt.u.reply.id) * 7)
+		return -NFS_RPC_DROP;
+	memcpy(&rpc_pkt.u.data[0], pkt, min_t(unsigned, len, NFS_READ_OVERHEAD));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	id = ntohl(rpc_pkt.u.reply.id);
+	*slotp = NULL;
+	for (i = 0; i < CONFIG_NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].id == id)
+			*slotp = &nfs_read_slots[i];
+	}
+	if (!id || !*slotp)
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -678,31 +833,28 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		data = &rpc_pkt.u.reply.data[19];
+		*eof = false;
 	} else {  /* NFSV3_FLAG */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
-		/* Skip unused values :
-			EOF:		32 bits value,
-			data_size:	32 bits value,
-		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		*eof = !!rpc_pkt.u.reply.data[2 + nfsv3_data_offset];
+		/* Skip unused value : data_size: 32 bits value */
+		data = &rpc_pkt.u.reply.data[4 + nfsv3_data_offset];
 	}
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	/* Offset of the file data within the UDP payload */
+	off = (uchar *)data - &rpc_pkt.u.data[0];
+	if (rlen < 0 || rlen > (*slotp)->len || off + rlen > len)
+		return -NFS_RPC_DROP;
+
+	if (store_block(pkt + off, (*slotp)->offset, rlen))
+		return -9999;
 
 	return rlen;
 }
@@ -727,6 +879,8 @@ static void nfs_timeout_handler(void)
 static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len)
 {
+	struct nfs_read_slot *slot;
+	bool eof;
 	int rlen;
 	int reply;
 
@@ -796,9 +950,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start_file();
 		}
 		break;
 
@@ -821,20 +973,25 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &slot, &eof);
+		if (rlen == -NFS_RPC_DROP)
+			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			nfs_read_done(slot, rlen, eof);
+			if (!nfs_read_complete())
+				break;
+			nfs_read_report();
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
+			memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
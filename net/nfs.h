@@ -43,6 +43,10 @@
  * case, most NFS servers are optimized for a power of 2.
  */
 #define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
+#define NFS_MAXDATA	8192	/* biggest READ an NFSv2 server answers */
+#define NFS3_MAXDATA	32768	/* usual limit of NFSv3 servers over UDP */
+/* IP, UDP, RPC and NFS headers in front of the data of a READ reply */
+#define NFS_READ_OVERHEAD	256
 
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
@@ -0,0 +1,148 @@
+/*
+ * Tests for the crypto uclass
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <crypto.h>
+#include <dm.h>
+#include <malloc.h>
+#include <u-boot/sha256.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define TEST_REGIONS		4
+#define TEST_REGION_SIZE	(256 << 10)
+#define TEST_BENCH_LOOPS	16
+
+/* Lay out header/kernel/ramdisk/dtb like regions with gaps between them */
+static u8 *setup_regions(struct image_region region[], bool aligned)
+{
+	u8 *buf;
+	int i;
+
+	buf = memalign(ARCH_DMA_MINALIGN, TEST_REGIONS * TEST_REGION_SIZE * 2);
+	if (!buf)
+		return NULL;
+
+	for (i = 0; i < TEST_REGIONS * TEST_REGION_SIZE * 2; i++)
+		buf[i] = i * 7 + (i >> 9);
+
+	for (i = 0; i < TEST_REGIONS; i++) {
+		region[i].data = buf + i * TEST_REGION_SIZE * 2;
+		region[i].size = TEST_REGION_SIZE;
+		if (!aligned) {
+			region[i].data = buf + i * TEST_REGION_SIZE * 2 + i;
+			region[i].size -= 3 * i;
+		}
+	}
+
+	return buf;
+}
+
+static void soft_regions_csum(const struct image_region region[], u8 *output)
+{
+	sha256_context ctx;
+	int i;
+
+	sha256_starts(&ctx);
+	for (i = 0; i < TEST_REGIONS; i++)
+		sha256_update(&ctx, region[i].data, region[i].size);
+	sha256_finish(&ctx, output);
+}
+
+/* Aligned regions are chained over the caller buffers without copies */
+static int dm_test_crypto_sha_regions(struct unit_test_state *uts)
+{
+	struct image_region region[TEST_REGIONS];
+	struct sandbox_crypto_stats stats;
+	u8 hash[SHA256_SUM_LEN], expect[SHA256_SUM_LEN];
+	struct udevice *dev;
+	sha_context ctx;
+	u8 *buf;
+
+	dev = crypto_get_device(CRYPTO_SHA256);
+	ut_assertnonnull(dev);
+
+	buf = setup_regions(region, true);
+	ut_assertnonnull(buf);
+	soft_regions_csum(region, expect);
+
+	sandbox_crypto_get_stats(dev, &stats, true);
+	ctx.algo = CRYPTO_SHA256;
+	ut_assertok(crypto_sha_regions_csum(dev, &ctx, region, TEST_REGIONS,
+					    hash));
+	ut_assert(!memcmp(expect, hash, sizeof(hash)));
+	sandbox_crypto_get_stats(dev, &stats, true);
+	ut_asserteq(0, stats.bounce_bytes);
+	ut_asserteq(TEST_REGIONS * TEST_REGION_SIZE, stats.dma_bytes);
+	ut_asserteq(TEST_REGIONS, stats.descs);
+
+	/* Misaligned regions still hash correctly through the cache */
+	free(buf);
+	buf = setup_regions(region, false);
+	ut_assertnonnull(buf);
+	soft_regions_csum(region, expect);
+
+	ut_assertok(crypto_sha_regions_csum(dev, &ctx, region, TEST_REGIONS,
+					    hash));
+	ut_assert(!memcmp(expect, hash, sizeof(hash)));
+	sandbox_crypto_get_stats(dev, &stats, true);
+	ut_assert(stats.bounce_bytes > 0);
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_crypto_sha_regions, DM_TESTF_SCAN_FDT);
+
+/* Compare the scatter list path with one update per region */
+static int dm_test_crypto_sha_regions_bench(struct unit_test_state *uts)
+{
+	struct image_region region[TEST_REGIONS];
+	u8 hash[SHA256_SUM_LEN], expect[SHA256_SUM_LEN];
+	ulong start, sg_us, upd_us;
+	struct udevice *dev;
+	sha_context ctx;
+	int loop, i;
+	u8 *buf;
+
+	dev = crypto_get_device(CRYPTO_SHA256);
+	ut_assertnonnull(dev);
+	buf = setup_regions(region, true);
+	ut_assertnonnull(buf);
+
+	ctx.algo = CRYPTO_SHA256;
+	start = timer_get_us();
+	for (loop = 0; loop < TEST_BENCH_LOOPS; loop++)
+		ut_assertok(crypto_sha_regions_csum(dev, &ctx, region,
+						    TEST_REGIONS, hash));
+	sg_us = max(timer_get_us() - start, 1UL);
+
+	start = timer_get_us();
+	for (loop = 0; loop < TEST_BENCH_LOOPS; loop++) {
+		/* Unaligned size fields between the images, as in Android */
+		ctx.length = TEST_REGIONS * (TEST_REGION_SIZE + 4);
+		ut_assertok(crypto_sha_init(dev, &ctx));
+		for (i = 0; i < TEST_REGIONS; i++) {
+			ut_assertok(crypto_sha_update(dev,
+						      (u32 *)region[i].data,
+						      region[i].size));
+			ut_assertok(crypto_sha_update(dev,
+						      (u32 *)&region[i].size,
+						      4));
+		}
+		ut_assertok(crypto_sha_final(dev, &ctx, expect));
+	}
+	upd_us = max(timer_get_us() - start, 1UL);
+
+	printf("sha256 %d x %d KiB: regions %lu MB/s, updates %lu MB/s\n",
+	       TEST_REGIONS, TEST_REGION_SIZE >> 10,
+	       TEST_BENCH_LOOPS * TEST_REGIONS * TEST_REGION_SIZE / sg_us,
+	       TEST_BENCH_LOOPS * TEST_REGIONS * TEST_REGION_SIZE / upd_us);
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_crypto_sha_regions_bench, DM_TESTF_SCAN_FDT);
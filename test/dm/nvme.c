@@ -0,0 +1,81 @@
+/*
+ * Tests for the NVMe driver, using the sandbox NVMe emulator
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <malloc.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/* 1MiB, which the emulator's 16KiB transfer limit splits into 64 commands */
+#define TEST_BLOCKS	2048
+#define TEST_START	3
+
+static int nvme_test_rw(struct unit_test_state *uts)
+{
+	struct sandbox_nvme_stats stats;
+	struct udevice *dev, *emul;
+	struct blk_desc *desc;
+	u8 *wbuf, *rbuf;
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_NVME, 0, &dev));
+	ut_assertok(device_find_first_child(dev, &emul));
+	ut_asserteq(UCLASS_PCI_EMUL, device_get_uclass_id(emul));
+
+	desc = blk_get_devnum_by_type(IF_TYPE_NVME, 0);
+	ut_assertnonnull(desc);
+	ut_asserteq(512, desc->blksz);
+	ut_asserteq(8192, desc->lba);
+
+	wbuf = malloc(TEST_BLOCKS * 512);
+	rbuf = malloc(TEST_BLOCKS * 512);
+	ut_assertnonnull(wbuf);
+	ut_assertnonnull(rbuf);
+	for (i = 0; i < TEST_BLOCKS * 512; i++)
+		wbuf[i] = i * 7 + (i >> 9);
+
+	sandbox_nvme_get_stats(emul, &stats, true);
+	ut_asserteq(TEST_BLOCKS, blk_dwrite(desc, TEST_START, TEST_BLOCKS,
+					    wbuf));
+	sandbox_nvme_get_stats(emul, &stats, true);
+	ut_asserteq(TEST_BLOCKS / 32, stats.cmds);
+	ut_asserteq(16, stats.max_batch);
+	ut_assert(stats.doorbells < stats.cmds);
+	ut_assert(stats.reordered > 0);
+
+	/* The emulator completes each batch in reverse order */
+	memset(rbuf, '\0', TEST_BLOCKS * 512);
+	ut_asserteq(TEST_BLOCKS, blk_dread(desc, TEST_START, TEST_BLOCKS,
+					   rbuf));
+	ut_assertok(memcmp(wbuf, rbuf, TEST_BLOCKS * 512));
+
+	/* Only the blocks before the first failed command are reported */
+	ut_asserteq(64, blk_dread(desc, desc->lba - 64, 128, rbuf));
+
+	free(wbuf);
+	free(rbuf);
+
+	return 0;
+}
+
+/* Test that I/O with several commands outstanding completes correctly */
+static int dm_test_nvme_rw(struct unit_test_state *uts)
+{
+	int ret;
+
+	/* The driver needs the BAR mapped and real register access */
+	sandbox_set_enable_pci_map(true);
+	sandbox_set_enable_memio(true);
+	ret = nvme_test_rw(uts);
+	sandbox_set_enable_pci_map(false);
+	sandbox_set_enable_memio(false);
+
+	return ret;
+}
+DM_TEST(dm_test_nvme_rw, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -8,6 +8,7 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <asm/state.h>
 #include <asm/test.h>
@@ -72,6 +73,46 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_spi_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that every read mode works through the read direct mapping */
+static int dm_test_spi_flash_dirmap(struct unit_test_state *uts)
+{
+	const struct spi_nor_read_mode *mode;
+	struct spi_flash *flash;
+	struct udevice *dev;
+	int full_size = 0x200000;
+	int size = 0x10000;
+	u8 *src, *dst;
+
+	src = map_sysmem(0x20000, full_size);
+	ut_assertok(os_write_file("spi.bin", src, full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	flash = dev_get_uclass_priv(dev);
+
+	/* The sandbox bus has no mem_ops, so this is the degraded mode */
+	ut_assertnonnull(flash->rdesc);
+	ut_assert(flash->rdesc->nodirmap);
+	ut_assert(flash->num_read_modes > 0);
+
+	dst = map_sysmem(0x20000 + full_size, full_size);
+	for (mode = flash->read_modes;
+	     mode < flash->read_modes + flash->num_read_modes; mode++) {
+		ut_assertok(spi_nor_set_read_mode(flash, mode));
+		ut_asserteq(mode->opcode, flash->read_opcode);
+		memset(dst, '\0', size);
+		ut_assertok(spi_flash_read_dm(dev, 0x100, size, dst));
+		ut_assertok(memcmp(src + 0x100, dst, size));
+	}
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_dirmap, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Functional test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash_func(struct unit_test_state *uts)
 {
@@ -76,6 +76,45 @@ static int compress_frame_buffer(struct udevice *dev)
 	return destlen;
 }
 
+/* Start recording changes, with @copy holding the current frame buffer */
+static void start_damage_check(struct udevice *dev, void *copy)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+
+	memcpy(copy, priv->fb, priv->fb_size);
+	priv->damage.xend = 0;
+}
+
+/**
+ * check_damage() - Check that the damage covers every changed pixel
+ *
+ * @uts:	Test state
+ * @dev:	Video device
+ * @copy:	Frame buffer contents saved by start_damage_check()
+ * @return 0 on success
+ */
+static int check_damage(struct unit_test_state *uts, struct udevice *dev,
+			const void *copy)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	const u16 *old = copy;
+	const u16 *new = priv->fb;
+	int x, y;
+
+	for (y = 0; y < priv->ysize; y++) {
+		for (x = 0; x < priv->xsize; x++, old++, new++) {
+			if (*old == *new)
+				continue;
+			ut_assert(x >= priv->damage.xstart);
+			ut_assert(x < priv->damage.xend);
+			ut_assert(y >= priv->damage.ystart);
+			ut_assert(y < priv->damage.yend);
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Call this function at any point to halt and show the current display. Be
  * sure to run the test with the -l flag.
@@ -153,6 +192,96 @@ static int dm_test_video_chars(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_chars, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that drawing records the damaged area of the frame buffer */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+
+	/* The display is cleared on probe */
+	ut_asserteq(0, priv->damage.xstart);
+	ut_asserteq(0, priv->damage.ystart);
+	ut_asserteq(priv->xsize, priv->damage.xend);
+	ut_asserteq(priv->ysize, priv->damage.yend);
+
+	priv->damage.xend = 0;
+	vidconsole_putc_xy(con, VID_TO_POS(16), 32, 'a');
+	ut_asserteq(16, priv->damage.xstart);
+	ut_asserteq(32, priv->damage.ystart);
+	ut_asserteq(24, priv->damage.xend);
+	ut_asserteq(48, priv->damage.yend);
+
+	/* Further drawing extends the area */
+	vidconsole_set_row(con, 4, WHITE);
+	ut_asserteq(0, priv->damage.xstart);
+	ut_asserteq(32, priv->damage.ystart);
+	ut_asserteq(priv->xsize, priv->damage.xend);
+	ut_asserteq(80, priv->damage.yend);
+
+	priv->damage.xend = 0;
+	/* Anything outside the display is clipped or ignored */
+	video_damage(dev, -10, priv->ysize - 8, 20, 20);
+	ut_asserteq(0, priv->damage.xstart);
+	ut_asserteq(priv->ysize - 8, priv->damage.ystart);
+	ut_asserteq(10, priv->damage.xend);
+	ut_asserteq(priv->ysize, priv->damage.yend);
+
+	priv->damage.xend = 0;
+	video_damage(dev, priv->xsize, 0, 10, 10);
+	video_damage(dev, 0, 0, 0, 10);
+	ut_asserteq(0, priv->damage.xend);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/*
+ * Measure console output and the amount of frame buffer that would be
+ * flushed for it, compared with flushing the whole frame on every sync
+ */
+static int dm_test_video_bench(struct unit_test_state *uts)
+{
+	struct vidconsole_priv *vc_priv;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+	ulong start, us, flushed = 0;
+	int i, j;
+
+#define BENCH_LINES	40
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	vc_priv = dev_get_uclass_priv(con);
+	priv->damage.xend = 0;
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LINES; i++) {
+		for (j = 0; j < 60; j++)
+			vidconsole_put_char(con, 'A' + (i + j) % 50);
+		vidconsole_put_char(con, '\n');
+		flushed += (priv->damage.yend - priv->damage.ystart) *
+			priv->line_length;
+		priv->damage.xend = 0;
+	}
+	us = timer_get_us() - start;
+
+	printf("%d lines in %lu us, flushed %lu KiB instead of %lu KiB\n",
+	       BENCH_LINES, us, flushed >> 10,
+	       (ulong)BENCH_LINES * priv->fb_size >> 10);
+	ut_asserteq(BENCH_LINES * vc_priv->y_charsize * priv->line_length,
+		    flushed);
+
+	return 0;
+}
+DM_TEST(dm_test_video_bench, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /**
  * check_vidconsole_output() - Run a text console test
  *
@@ -167,6 +296,8 @@ static int check_vidconsole_output(struct unit_test_state *uts, int rot,
 {
 	struct udevice *dev, *con;
 	struct sandbox_sdl_plat *plat;
+	struct video_priv *priv;
+	void *copy;
 	int i;
 
 	ut_assertok(uclass_find_device(UCLASS_VIDEO, 0, &dev));
@@ -177,18 +308,26 @@ static int check_vidconsole_output(struct unit_test_state *uts, int rot,
 	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
 	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
 	ut_asserteq(46, compress_frame_buffer(dev));
+	priv = dev_get_uclass_priv(dev);
+	copy = malloc(priv->fb_size);
+	ut_assertnonnull(copy);
 
 	/* Check display wrap */
+	start_damage_check(dev, copy);
 	for (i = 0; i < 120; i++)
 		vidconsole_put_char(con, 'A' + i % 50);
 	ut_asserteq(wrap_size, compress_frame_buffer(dev));
+	ut_assertok(check_damage(uts, dev, copy));
 
 	/* Check display scrolling */
+	start_damage_check(dev, copy);
 	for (i = 0; i < SCROLL_LINES; i++) {
 		vidconsole_put_char(con, 'A' + i % 50);
 		vidconsole_put_char(con, '\n');
 	}
 	ut_asserteq(scroll_size, compress_frame_buffer(dev));
+	ut_assertok(check_damage(uts, dev, copy));
+	free(copy);
 
 	/* If we scroll enough, the screen becomes blank again */
 	for (i = 0; i < SCROLL_LINES; i++)
@@ -334,6 +473,8 @@ static int dm_test_video_truetype_bs(struct unit_test_state *uts)
 {
 	struct sandbox_sdl_plat *plat;
 	struct udevice *dev, *con;
+	struct video_priv *priv;
+	void *copy;
 	const char *test_string = "...Criticism may or may\b\b\b\b\b\bnot be agreeable, but seldom it is necessary\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\bit is necessary. It fulfils the same function as pain in the human body. It calls attention to an unhealthy state of things.";
 	const char *s;
 
@@ -344,9 +485,15 @@ static int dm_test_video_truetype_bs(struct unit_test_state *uts)
 
 	ut_assertok(uclass_get_device(UCLASS_VIDEO, 0, &dev));
 	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	copy = malloc(priv->fb_size);
+	ut_assertnonnull(copy);
+	start_damage_check(dev, copy);
 	for (s = test_string; *s; s++)
 		vidconsole_put_char(con, *s);
 	ut_asserteq(34871, compress_frame_buffer(dev));
+	ut_assertok(check_damage(uts, dev, copy));
+	free(copy);
 
 	return 0;
 }
@@ -0,0 +1,223 @@
+/*
+ * Tests for the memcpy/memmove/memset/memcmp implementations, checked
+ * byte for byte against simple reference loops over all small alignments.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <test/suites.h>
+
+#define TEST_BUF_SIZE	1024
+#define TEST_GUARD	128
+#define TEST_MAX_LEN	(TEST_BUF_SIZE - 2 * TEST_GUARD)
+#define TEST_MAX_OFF	16
+
+static u8 test_src[TEST_BUF_SIZE] __aligned(64);
+static u8 test_dst[TEST_BUF_SIZE] __aligned(64);
+static u8 test_ref[TEST_BUF_SIZE] __aligned(64);
+
+/* Every length up to two 64 byte blocks, then a few large ones */
+static int test_next_len(int len)
+{
+	return len < 160 ? len + 1 : len * 2 + 3;
+}
+
+static void test_fill(u8 *buf, int seed)
+{
+	int i;
+
+	for (i = 0; i < TEST_BUF_SIZE; i++)
+		buf[i] = i * 13 + seed + (i >> 8);
+}
+
+/* volatile so that the compiler does not turn these back into calls */
+static void ref_memcpy(volatile u8 *dst, const volatile u8 *src, int n)
+{
+	while (n--)
+		*dst++ = *src++;
+}
+
+static void ref_memmove(volatile u8 *dst, const volatile u8 *src, int n)
+{
+	if (dst <= src) {
+		ref_memcpy(dst, src, n);
+		return;
+	}
+	while (n--)
+		dst[n] = src[n];
+}
+
+static int ref_memcmp(const volatile u8 *s1, const volatile u8 *s2, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (s1[i] != s2[i])
+			return s1[i] - s2[i];
+	}
+
+	return 0;
+}
+
+static int test_check(const char *name, int doff, int soff, int len)
+{
+	if (!ref_memcmp(test_dst, test_ref, TEST_BUF_SIZE))
+		return 0;
+
+	printf("%s: %s mismatch, dst+%d src+%d len %d\n", __func__, name,
+	       doff, soff, len);
+
+	return -EINVAL;
+}
+
+static int test_memcpy(void)
+{
+	int doff, soff, len;
+	u8 *dst, *src;
+
+	for (doff = 0; doff < TEST_MAX_OFF; doff++) {
+		for (soff = 0; soff < TEST_MAX_OFF; soff++) {
+			dst = test_dst + TEST_GUARD + doff;
+			src = test_src + TEST_GUARD + soff;
+			for (len = 0; len <= TEST_MAX_LEN - TEST_MAX_OFF;
+			     len = test_next_len(len)) {
+				test_fill(test_src, 1);
+				test_fill(test_dst, 2);
+				test_fill(test_ref, 2);
+				ref_memcpy(test_ref + TEST_GUARD + doff, src,
+					   len);
+				if (memcpy(dst, src, len) != dst)
+					return -EINVAL;
+				if (test_check("memcpy", doff, soff, len))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_memmove(void)
+{
+	static const int deltas[] = { -65, -64, -9, -8, -1, 0, 1, 8, 9, 64,
+				      65 };
+	int off, i, len;
+	u8 *src;
+
+	for (off = 0; off < TEST_MAX_OFF; off++) {
+		for (i = 0; i < ARRAY_SIZE(deltas); i++) {
+			src = test_dst + TEST_GUARD + off;
+			for (len = 0; len <= TEST_MAX_LEN - TEST_MAX_OFF;
+			     len = test_next_len(len)) {
+				test_fill(test_dst, 3);
+				test_fill(test_ref, 3);
+				ref_memmove(test_ref + TEST_GUARD + off +
+					    deltas[i],
+					    test_ref + TEST_GUARD + off, len);
+				if (memmove(src + deltas[i], src, len) !=
+				    src + deltas[i])
+					return -EINVAL;
+				if (test_check("memmove", off + deltas[i], off,
+					       len))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_memset(void)
+{
+	static const int vals[] = { 0, 0xa5, 0x17f };
+	int off, i, len, j;
+	u8 *dst;
+
+	for (off = 0; off < TEST_MAX_OFF; off++) {
+		for (i = 0; i < ARRAY_SIZE(vals); i++) {
+			dst = test_dst + TEST_GUARD + off;
+			for (len = 0; len <= TEST_MAX_LEN - TEST_MAX_OFF;
+			     len = test_next_len(len)) {
+				test_fill(test_dst, 4);
+				test_fill(test_ref, 4);
+				for (j = 0; j < len; j++)
+					test_ref[TEST_GUARD + off + j] = vals[i];
+				if (memset(dst, vals[i], len) != dst)
+					return -EINVAL;
+				if (test_check("memset", off, vals[i], len))
+					return -EINVAL;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int test_memcmp_one(const u8 *s1, const u8 *s2, int len)
+{
+	int expect = ref_memcmp(s1, s2, len);
+	int ret = memcmp(s1, s2, len);
+
+	if ((expect < 0) != (ret < 0) || (expect > 0) != (ret > 0)) {
+		printf("%s: memcmp len %d returned %d, expected %d\n",
+		       __func__, len, ret, expect);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int test_memcmp(void)
+{
+	int doff, soff, len, pos;
+	u8 *s1, *s2;
+
+	test_fill(test_src, 5);
+	for (doff = 0; doff < TEST_MAX_OFF; doff++) {
+		for (soff = 0; soff < TEST_MAX_OFF; soff++) {
+			s1 = test_dst + TEST_GUARD + doff;
+			s2 = test_src + TEST_GUARD + soff;
+			for (len = 0; len <= TEST_MAX_LEN - TEST_MAX_OFF;
+			     len = test_next_len(len)) {
+				ref_memcpy(s1, s2, len);
+				if (test_memcmp_one(s1, s2, len))
+					return -EINVAL;
+				if (!len)
+					continue;
+
+				/* Differences at the start, middle and end */
+				for (pos = 0; pos < len; pos += len / 2 + 1) {
+					s1[pos] = s2[pos] ^ 0x80;
+					if (test_memcmp_one(s1, s2, len) ||
+					    test_memcmp_one(s2, s1, len))
+						return -EINVAL;
+					s1[pos] = s2[pos];
+				}
+				s1[len - 1] = s2[len - 1] + 1;
+				if (test_memcmp_one(s1, s2, len) ||
+				    test_memcmp_one(s2, s1, len))
+					return -EINVAL;
+				s1[len - 1] = s2[len - 1];
+			}
+		}
+	}
+
+	return 0;
+}
+
+int do_ut_string(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret = 0;
+
+	ret |= test_memcpy();
+	ret |= test_memmove();
+	ret |= test_memset();
+	ret |= test_memcmp();
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -452,6 +452,44 @@ err_buf:
 	return -1;
 }
 
+/* Write all of buf, pwrite() may return early for large sizes */
+static int fit_write_at(int fd, const void *buf, size_t size, off_t offset)
+{
+	ssize_t ret;
+
+	while (size) {
+		ret = pwrite(fd, buf, size, offset);
+		if (ret <= 0)
+			return -EIO;
+		buf += ret;
+		size -= ret;
+		offset += ret;
+	}
+
+	return 0;
+}
+
+static ulong fit_get_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Cached hashes are not checked against the data, so they must not end up
+ * in a FIT which is about to be signed.
+ */
+static const char *fit_hash_cache_file(struct image_tool_params *params)
+{
+	if (params->keydir || params->keydest)
+		return NULL;
+
+	return getenv("MKIMAGE_HASH_CACHE");
+}
+
 /**
  * fit_extract_data() - Move all data outside the FIT
  *
@@ -460,85 +498,123 @@ err_buf:
  * using an offset into that area. The 'data' properties turn into
  * 'data-offset' properties.
  *
+ * The FIT is edited in a private mapping of the file, last image first so
+ * that only the small tail of the FIT moves on each edit. The new file is
+ * then written straight from the shared mapping, without copying the image
+ * data in memory.
+ *
  * This function cannot cope with FITs with 'data-offset' properties. All
  * data must be in 'data' properties on entry.
  */
 static int fit_extract_data(struct image_tool_params *params, const char *fname)
 {
-	void *buf;
-	int buf_ptr;
-	int fit_size, new_size;
-	int fd;
+	struct {
+		int node;
+		int offset;	/* of the data in the file */
+		int len;
+		int pos;	/* of the data in the external area */
+	} *ext = NULL;
+	int count = 0, buf_ptr = 0;
+	int new_size;
+	int fd, outfd = -1;
 	struct stat sbuf;
-	void *fdt;
+	char *outname;
+	size_t size;
+	void *src = MAP_FAILED, *fdt = MAP_FAILED;
 	int ret;
 	int images;
 	int node;
+	int i;
 
-	fd = mmap_fdt(params->cmdname, fname, 0x400, &fdt, &sbuf, false);
-	if (fd < 0)
-		return -EIO;
-	fit_size = fdt_totalsize(fdt);
+	outname = malloc(strlen(fname) + 5);
+	if (!outname)
+		return -ENOMEM;
+	sprintf(outname, "%s.ext", fname);
 
-	/* Allocate space to hold the image data we will extract */
-	buf = malloc(fit_size);
-	if (!buf) {
-		ret = -ENOMEM;
-		goto err_munmap;
+	fd = open(fname, O_RDWR | O_BINARY);
+	if (fd < 0 || fstat(fd, &sbuf) < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			params->cmdname, fname, strerror(errno));
+		ret = -EIO;
+		goto err;
 	}
-	buf_ptr = 0;
 
+	/* Room for the data-offset and data-size properties */
+	size = sbuf.st_size + 0x400;
+	if (ftruncate(fd, size)) {
+		ret = -EIO;
+		goto err;
+	}
+	src = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	fdt = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (src == MAP_FAILED || fdt == MAP_FAILED ||
+	    fdt_check_header(fdt) || fdt_open_into(fdt, fdt, size)) {
+		fprintf(stderr, "%s: Invalid FIT blob %s\n", params->cmdname,
+			fname);
+		ret = -EIO;
+		goto err;
+	}
 	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
 	if (images < 0) {
 		debug("%s: Cannot find /images node: %d\n", __func__, images);
 		ret = -EINVAL;
-		goto err_munmap;
+		goto err;
 	}
 
 	for (node = fdt_first_subnode(fdt, images);
 	     node >= 0;
 	     node = fdt_next_subnode(fdt, node)) {
 		const char *data;
+		void *tmp;
 		int len;
 
 		data = fdt_getprop(fdt, node, "data", &len);
 		if (!data)
 			continue;
-		memcpy(buf + buf_ptr, data, len);
+		tmp = realloc(ext, (count + 1) * sizeof(*ext));
+		if (!tmp) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		ext = tmp;
+		ext[count].node = node;
+		/* fdt_open_into() may have moved the struct block */
+		ext[count].offset = data - (const char *)fdt -
+				    fdt_off_dt_struct(fdt) +
+				    fdt_off_dt_struct(src);
+		ext[count].len = len;
+		ext[count].pos = buf_ptr;
+		count++;
 		debug("Extracting data size %x\n", len);
 
+		buf_ptr += FIT_ALIGN(len);
+	}
+
+	/* Edits only move what follows them, so earlier nodes stay put */
+	for (i = count - 1; i >= 0; i--) {
+		node = ext[i].node;
 		ret = fdt_delprop(fdt, node, "data");
 		if (ret) {
 			ret = -EPERM;
-			goto err_munmap;
+			goto err;
 		}
 		if (params->external_offset > 0) {
 			/* An external offset positions the data absolutely. */
 			fdt_setprop_u32(fdt, node, "data-position",
-					params->external_offset + buf_ptr);
+					params->external_offset + ext[i].pos);
 		} else {
-			fdt_setprop_u32(fdt, node, "data-offset", buf_ptr);
+			fdt_setprop_u32(fdt, node, "data-offset", ext[i].pos);
 		}
-		fdt_setprop_u32(fdt, node, "data-size", len);
-
-		buf_ptr += FIT_ALIGN(len);
+		fdt_setprop_u32(fdt, node, "data-size", ext[i].len);
 	}
 
 	/* Pack the FDT and place the data after it */
 	fdt_pack(fdt);
 
-	debug("Size reduced from %x to %x\n", fit_size, fdt_totalsize(fdt));
+	debug("Size reduced to %x\n", fdt_totalsize(fdt));
 	debug("External data size %x\n", buf_ptr);
 	new_size = fdt_totalsize(fdt);
 	new_size = FIT_ALIGN(new_size);
-	munmap(fdt, sbuf.st_size);
-
-	if (ftruncate(fd, new_size)) {
-		debug("%s: Failed to truncate file: %s\n", __func__,
-		      strerror(errno));
-		ret = -EIO;
-		goto err;
-	}
 
 	/* Check if an offset for the external data was set. */
 	if (params->external_offset > 0) {
@@ -550,28 +626,48 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		}
 		new_size = params->external_offset;
 	}
-	if (lseek(fd, new_size, SEEK_SET) < 0) {
-		debug("%s: Failed to seek to end of file: %s\n", __func__,
-		      strerror(errno));
+
+	outfd = open(outname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (outfd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			params->cmdname, outname, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-	if (write(fd, buf, buf_ptr) != buf_ptr) {
+	ret = fit_write_at(outfd, fdt, fdt_totalsize(fdt), 0);
+	for (i = 0; !ret && i < count; i++)
+		ret = fit_write_at(outfd, src + ext[i].offset, ext[i].len,
+				   new_size + ext[i].pos);
+	if (!ret && ftruncate(outfd, new_size + buf_ptr))
+		ret = -EIO;
+	if (ret) {
 		debug("%s: Failed to write external data to file %s\n",
 		      __func__, strerror(errno));
-		ret = -EIO;
 		goto err;
 	}
-	free(buf);
-	close(fd);
-	return 0;
+	close(outfd);
+	outfd = -1;
+
+	if (rename(outname, fname)) {
+		fprintf(stderr, "%s: Can't rename %s to %s: %s\n",
+			params->cmdname, outname, fname, strerror(errno));
+		unlink(outname);
+		ret = -EIO;
+	}
 
-err_munmap:
-	munmap(fdt, sbuf.st_size);
 err:
-	if (buf)
-		free(buf);
-	close(fd);
+	if (outfd >= 0) {
+		close(outfd);
+		unlink(outname);
+	}
+	if (fdt != MAP_FAILED)
+		munmap(fdt, size);
+	if (src != MAP_FAILED)
+		munmap(src, size);
+	if (fd >= 0)
+		close(fd);
+	free(outname);
+	free(ext);
 	return ret;
 }
 
@@ -687,6 +783,10 @@ static int fit_handle_file(struct image_tool_params *params)
 	char tmpfile[MKIMAGE_MAX_TMPFILE_LEN];
 	char cmd[MKIMAGE_MAX_DTC_CMDLINE_LEN];
 	size_t size_inc;
+	ulong start, step;
+	struct stat sbuf;
+	void *ptr;
+	int tfd;
 	int ret;
 
 	/* Flattened Image Tree (FIT) format  handling */
@@ -703,6 +803,7 @@ static int fit_handle_file(struct image_tool_params *params)
 	sprintf (tmpfile, "%s%s", params->imagefile, MKIMAGE_TMPFILE_SUFFIX);
 
 	/* We either compile the source file, or use the existing FIT image */
+	start = fit_get_ms();
 	if (params->auto_its) {
 		if (fit_build(params, tmpfile)) {
 			fprintf(stderr, "%s: failed to build FIT\n",
@@ -729,6 +830,9 @@ static int fit_handle_file(struct image_tool_params *params)
 	ret = fit_import_data(params, tmpfile);
 	if (ret)
 		goto err_system;
+	step = fit_get_ms();
+	if (params->timing)
+		printf("FIT: build %lu ms\n", step - start);
 
 	/* Args "-E -p": move the data so it is external to the FIT, if requested */
 	if (params->external_data && params->external_offset) {
@@ -737,6 +841,17 @@ static int fit_handle_file(struct image_tool_params *params)
 			goto err_system;
 	}
 
+	/* Hash all images once, whatever happens to the FIT below */
+	tfd = mmap_fdt(params->cmdname, tmpfile, 0, &ptr, &sbuf, false);
+	if (tfd < 0)
+		goto err_system;
+	ret = fit_prepare_hashes(ptr, params->hash_jobs,
+				 fit_hash_cache_file(params), params->timing);
+	munmap(ptr, sbuf.st_size);
+	close(tfd);
+	if (ret)
+		goto err_system;
+
 	/*
 	 * Set hashes for images in the blob. Unfortunately we may need more
 	 * space in either FDT, so keep trying until we succeed.
@@ -752,6 +867,12 @@ static int fit_handle_file(struct image_tool_params *params)
 		if (!ret || ret != -ENOSPC)
 			break;
 	}
+	fit_release_hashes();
+	if (params->timing) {
+		printf("FIT: hash and sign %lu ms, %zu passes\n",
+		       fit_get_ms() - step, size_inc / 1024 + 1);
+		step = fit_get_ms();
+	}
 
 	if (ret) {
 		fprintf(stderr, "%s Can't add hashes to FIT blob: %d\n",
@@ -764,6 +885,9 @@ static int fit_handle_file(struct image_tool_params *params)
 		ret = fit_extract_data(params, tmpfile);
 		if (ret)
 			goto err_system;
+		if (params->timing)
+			printf("FIT: external data %lu ms\n",
+			       fit_get_ms() - step);
 	}
 
 	if (rename (tmpfile, params->imagefile) == -1) {
@@ -774,6 +898,8 @@ static int fit_handle_file(struct image_tool_params *params)
 		unlink (params->imagefile);
 		return EXIT_FAILURE;
 	}
+	if (params->timing)
+		printf("FIT: total %lu ms\n", fit_get_ms() - start);
 	return EXIT_SUCCESS;
 
 err_system:
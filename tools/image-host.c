@@ -12,7 +12,9 @@
 #include "mkimage.h"
 #include <bootm.h>
 #include <image.h>
+#include <pthread.h>
 #include <version.h>
+#include <u-boot/crc.h>
 
 /**
  * fit_set_hash_value - set hash value in requested has node
@@ -44,6 +46,317 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	return 0;
 }
 
+/*
+ * Image hash values are calculated before the FIT is updated: by several
+ * threads, since the FIT is only read, and optionally taken from a cache
+ * file kept between runs. fit_image_process_hash() then uses them, also when
+ * the FIT has to be expanded and processed again after -ENOSPC.
+ */
+struct fit_hash_entry {
+	char *image;		/* image node name */
+	char *node;		/* hash node name */
+	char algo[16];
+	const void *data;	/* only valid in fit_prepare_hashes() */
+	size_t size;
+	uint32_t crc;		/* cache key, with algo and size */
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	bool valid;
+	bool cached;
+};
+
+struct fit_hash_cache {
+	char algo[16];
+	size_t size;
+	uint32_t crc;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+};
+
+static struct {
+	struct fit_hash_entry *entry;
+	int count;
+	int next;		/* next entry to hash, under lock */
+	pthread_mutex_t lock;
+	struct fit_hash_cache *cache;
+	int cache_count;
+	bool use_cache;
+} fit_hashes = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/*
+ * The cache file has one line per hash: algo, data size, crc32 of the data
+ * and the hash value in hex. Entries are trusted as they are, so a stale or
+ * corrupt one puts a wrong hash into the FIT. That is only caught by the
+ * hash check when booting, and a signature made afterwards would cover the
+ * wrong value: callers must not use the cache when signing.
+ */
+static void fit_hash_cache_load(const char *fname)
+{
+	struct fit_hash_cache *c, *cache;
+	unsigned int byte;
+	char line[256];
+	FILE *f;
+	int pos;
+
+	f = fopen(fname, "r");
+	if (!f)
+		return;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (!(fit_hashes.cache_count & 63)) {
+			cache = realloc(fit_hashes.cache,
+					(fit_hashes.cache_count + 64) *
+					sizeof(*cache));
+			if (!cache)
+				break;
+			fit_hashes.cache = cache;
+		}
+		c = &fit_hashes.cache[fit_hashes.cache_count];
+		if (sscanf(line, "%15s %zu %x %n", c->algo, &c->size, &c->crc,
+			   &pos) != 3)
+			continue;
+		for (c->value_len = 0; c->value_len < FIT_MAX_HASH_LEN &&
+		     sscanf(line + pos, "%2x", &byte) == 1; pos += 2)
+			c->value[c->value_len++] = byte;
+		if (c->value_len)
+			fit_hashes.cache_count++;
+	}
+
+	fclose(f);
+}
+
+/* Lines are appended one write() each, so parallel builds can share it */
+static void fit_hash_cache_save(const char *fname)
+{
+	struct fit_hash_entry *e;
+	FILE *f;
+	int i, j;
+
+	f = fopen(fname, "a");
+	if (!f) {
+		fprintf(stderr, "Can't update hash cache %s: %s\n", fname,
+			strerror(errno));
+		return;
+	}
+	setvbuf(f, NULL, _IOLBF, 0);
+
+	for (i = 0; i < fit_hashes.count; i++) {
+		e = &fit_hashes.entry[i];
+		if (!e->valid || e->cached || !strcmp(e->algo, "crc32"))
+			continue;
+		fprintf(f, "%s %zu %08x ", e->algo, e->size, e->crc);
+		for (j = 0; j < e->value_len; j++)
+			fprintf(f, "%02x", e->value[j]);
+		fprintf(f, "\n");
+	}
+
+	fclose(f);
+}
+
+static void fit_hash_calc(struct fit_hash_entry *e)
+{
+	struct fit_hash_cache *c;
+	int i;
+
+	/* A crc32 is cheaper to calculate than to look up */
+	if (fit_hashes.use_cache && strcmp(e->algo, "crc32")) {
+		e->crc = crc32(0, e->data, e->size);
+		for (i = 0; i < fit_hashes.cache_count; i++) {
+			c = &fit_hashes.cache[i];
+			if (c->size != e->size || c->crc != e->crc ||
+			    strcmp(c->algo, e->algo))
+				continue;
+			memcpy(e->value, c->value, c->value_len);
+			e->value_len = c->value_len;
+			e->valid = true;
+			e->cached = true;
+			return;
+		}
+	}
+
+	e->valid = !calculate_hash(e->data, e->size, e->algo, e->value,
+				   &e->value_len);
+}
+
+static void *fit_hash_worker(void *arg)
+{
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&fit_hashes.lock);
+		i = fit_hashes.next++;
+		pthread_mutex_unlock(&fit_hashes.lock);
+		if (i >= fit_hashes.count)
+			break;
+		fit_hash_calc(&fit_hashes.entry[i]);
+	}
+
+	return NULL;
+}
+
+/* Largest first, so that the threads finish at about the same time */
+static int fit_hash_cmp(const void *a, const void *b)
+{
+	const struct fit_hash_entry *ea = a, *eb = b;
+
+	return (ea->size < eb->size) - (ea->size > eb->size);
+}
+
+static int fit_hash_add(const void *fit, int image_noffset, int noffset,
+			const void *data, size_t size)
+{
+	struct fit_hash_entry *e, *entry;
+	char *algo;
+
+	if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+	    strlen(algo) >= sizeof(e->algo))
+		return 0;	/* reported by fit_image_process_hash() */
+
+	entry = realloc(fit_hashes.entry,
+			(fit_hashes.count + 1) * sizeof(*entry));
+	if (!entry)
+		return -ENOMEM;
+	fit_hashes.entry = entry;
+	e = &entry[fit_hashes.count];
+	memset(e, '\0', sizeof(*e));
+	e->image = strdup(fit_get_name(fit, image_noffset, NULL));
+	e->node = strdup(fit_get_name(fit, noffset, NULL));
+	if (!e->image || !e->node) {
+		free(e->image);
+		free(e->node);
+		return -ENOMEM;
+	}
+	strcpy(e->algo, algo);
+	e->data = data;
+	e->size = size;
+	fit_hashes.count++;
+
+	return 0;
+}
+
+int fit_prepare_hashes(const void *fit, int jobs, const char *cache_file,
+		       bool verbose)
+{
+	pthread_t *threads = NULL;
+	struct timespec start, end;
+	int images_noffset, image_noffset, noffset;
+	int i, started = 0, cached = 0;
+	const void *data;
+	size_t size, total = 0;
+	ulong ms;
+	int ret;
+
+	fit_release_hashes();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return 0;	/* reported by fit_add_verification_data() */
+
+	fdt_for_each_subnode(image_noffset, fit, images_noffset) {
+		if (fit_image_get_data(fit, image_noffset, &data, &size))
+			continue;
+		fdt_for_each_subnode(noffset, fit, image_noffset) {
+			if (strncmp(fit_get_name(fit, noffset, NULL),
+				    FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)))
+				continue;
+			ret = fit_hash_add(fit, image_noffset, noffset, data,
+					   size);
+			if (ret) {
+				fit_release_hashes();
+				return ret;
+			}
+			total += size;
+		}
+	}
+	if (!fit_hashes.count)
+		return 0;
+	qsort(fit_hashes.entry, fit_hashes.count, sizeof(*fit_hashes.entry),
+	      fit_hash_cmp);
+
+	if (cache_file) {
+		fit_hash_cache_load(cache_file);
+		fit_hashes.use_cache = true;
+	}
+
+	if (jobs <= 0)
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (jobs > fit_hashes.count)
+		jobs = fit_hashes.count;
+	if (jobs > 1)
+		threads = calloc(jobs - 1, sizeof(*threads));
+
+	/* This thread is a worker too; fall back to it alone on any error */
+	for (i = 0; threads && i < jobs - 1; i++, started++) {
+		if (pthread_create(&threads[i], NULL, fit_hash_worker, NULL))
+			break;
+	}
+	fit_hash_worker(NULL);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	for (i = 0; i < fit_hashes.count; i++) {
+		fit_hashes.entry[i].data = NULL;
+		if (fit_hashes.entry[i].cached)
+			cached++;
+	}
+	if (cache_file)
+		fit_hash_cache_save(cache_file);
+
+	if (verbose) {
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ms = (end.tv_sec - start.tv_sec) * 1000 +
+		     (end.tv_nsec - start.tv_nsec) / 1000000;
+		printf("Calculated %d hashes over %zu KiB in %lu ms, %d threads, %d from cache\n",
+		       fit_hashes.count, total >> 10, ms, started + 1, cached);
+	}
+
+	return 0;
+}
+
+void fit_release_hashes(void)
+{
+	int i;
+
+	for (i = 0; i < fit_hashes.count; i++) {
+		free(fit_hashes.entry[i].image);
+		free(fit_hashes.entry[i].node);
+	}
+	free(fit_hashes.entry);
+	free(fit_hashes.cache);
+	fit_hashes.entry = NULL;
+	fit_hashes.count = 0;
+	fit_hashes.next = 0;
+	fit_hashes.cache = NULL;
+	fit_hashes.cache_count = 0;
+	fit_hashes.use_cache = false;
+}
+
+/* Returns 0 if the hash was calculated by fit_prepare_hashes() */
+static int fit_hash_lookup(const char *image_name, const char *node_name,
+			   const char *algo, size_t size, uint8_t *value,
+			   int *value_len)
+{
+	struct fit_hash_entry *e;
+	int i;
+
+	for (i = 0; i < fit_hashes.count; i++) {
+		e = &fit_hashes.entry[i];
+		if (!e->valid || e->size != size || strcmp(e->algo, algo) ||
+		    strcmp(e->image, image_name) || strcmp(e->node, node_name))
+			continue;
+		memcpy(value, e->value, e->value_len);
+		*value_len = e->value_len;
+		return 0;
+	}
+
+	return -ENOENT;
+}
+
 /**
  * fit_image_process_hash - Process a single subnode of the images/ node
  *
@@ -74,7 +387,9 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (fit_hash_lookup(image_name, node_name, algo, size, value,
+			    &value_len) &&
+	    calculate_hash(data, size, algo, value, &value_len)) {
 		printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 		       algo, node_name, image_name);
 		return -EPROTONOSUPPORT;
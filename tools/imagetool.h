@@ -78,6 +78,8 @@ struct image_tool_params {
 	bool quiet;		/* Don't output text in normal operation */
 	unsigned int external_offset;	/* Add padding to external data */
 	const char *engine_id;	/* Engine to use for signing */
+	int hash_jobs;		/* Threads hashing FIT images, 0 for auto */
+	bool timing;		/* Print the time taken by each FIT step */
 	char *extraparams;	/* Extra parameters for img creation (-X) */
 };
 
@@ -96,7 +96,11 @@ static void usage(const char *msg)
 		"          -D => set all options for device tree compiler\n"
 		"          -f => input filename for FIT source\n"
 		"          -i => input filename for ramdisk file\n"
-		"          -v => set FIT image version in decimal\n");
+		"          -v => set FIT image version in decimal\n"
+		"          -j => number of threads hashing images (default: one per CPU)\n"
+		"          -t => print the time taken by each step\n"
+		"Image hashes are reused from the file named by $MKIMAGE_HASH_CACHE, if set,\n"
+		"unless signing with -k or -K\n");
 
 #ifdef CONFIG_FIT_SIGNATURE
 	fprintf(stderr,
@@ -146,7 +150,7 @@ static void process_args(int argc, char **argv)
 	int opt;
 
 	while ((opt = getopt(argc, argv,
-			     "a:A:b:c:C:d:D:e:Ef:Fk:i:K:ln:N:p:O:rR:qsT:v:VxX:")) != -1) {
+			     "a:A:b:c:C:d:D:e:Ef:Fk:i:j:K:ln:N:p:O:rR:qstT:v:VxX:")) != -1) {
 		switch (opt) {
 		case 'a':
 			params.addr = strtoull(optarg, &ptr, 16);
@@ -215,6 +219,14 @@ static void process_args(int argc, char **argv)
 		case 'i':
 			params.fit_ramdisk = optarg;
 			break;
+		case 'j':
+			params.hash_jobs = strtoul(optarg, &ptr, 10);
+			if (*ptr) {
+				fprintf(stderr, "%s: invalid number of jobs %s\n",
+					params.cmdname, optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		case 'k':
 			params.keydir = optarg;
 			break;
@@ -261,6 +273,9 @@ static void process_args(int argc, char **argv)
 		case 's':
 			params.skipcpy = 1;
 			break;
+		case 't':
+			params.timing = true;
+			break;
 		case 'T':
 			if (strcmp(optarg, "list") == 0) {
 				show_valid_options(IH_TYPE);
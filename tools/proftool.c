@@ -56,6 +56,9 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+uint32_t *sample_list;		/* Sample header words and function offsets */
+int sample_words;
+int sample_count;
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -86,6 +89,10 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-flamegraph\tDump out call stacks in folded format for\n"
+		"\t\t\tflamegraph.pl, from samples if present, else\n"
+		"\t\t\tweighted by the time spent in each function (us)\n"
+		"   dump-funcs\t\tDump out function call counts, highest first\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -227,6 +234,56 @@ static int read_calls(FILE *fin, int count)
 	return 0;
 }
 
+static int read_funcs(FILE *fin, int count, int *not_found)
+{
+	struct trace_output_func rec;
+	struct func_info *func;
+	int i;
+
+	notice("function count: %d\n", count);
+	for (i = 0; i < count; i++) {
+		if (read_data(fin, &rec, sizeof(rec)))
+			return 1;
+		func = find_func_by_offset(rec.offset);
+		if (!func) {
+			(*not_found)++;
+			continue;
+		}
+		func->call_count = rec.call_count;
+	}
+	return 0;
+}
+
+static int read_samples(FILE *fin, int count)
+{
+	uint32_t word;
+	int alloced = 0;
+	int i, frames;
+
+	notice("sample count: %d\n", count);
+	for (i = 0; i < count; i++) {
+		if (read_data(fin, &word, sizeof(word)))
+			return 1;
+		frames = TRACE_SAMPLE_FRAMES(word);
+		if (sample_words + 1 + frames > alloced) {
+			alloced = (alloced + 1 + frames) * 2;
+			sample_list = realloc(sample_list,
+					      alloced * sizeof(*sample_list));
+			if (!sample_list) {
+				error("Cannot allocate sample_list\n");
+				return -1;
+			}
+		}
+		sample_list[sample_words] = word;
+		if (frames && read_data(fin, &sample_list[sample_words + 1],
+					frames * sizeof(*sample_list)))
+			return 1;
+		sample_words += 1 + frames;
+		sample_count++;
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -243,13 +300,23 @@ static int read_profile(FILE *fin, int *not_found)
 
 		switch (hdr.type) {
 		case TRACE_CHUNK_FUNCS:
-			/* Ignored at present */
+			if (read_funcs(fin, hdr.rec_count, not_found))
+				return 1;
 			break;
 
 		case TRACE_CHUNK_CALLS:
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
+
+		default:
+			error("Unknown chunk type %d\n", hdr.type);
+			return 1;
 		}
 	}
 	return 0;
@@ -533,6 +600,134 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/* Print a call stack as a folded line, leaving out excluded functions */
+static void out_stack(uint32_t *offsets, int count, unsigned long weight)
+{
+	struct func_info *func;
+	int i, first = 1;
+
+	if (!weight)
+		return;
+	for (i = 0; i < count; i++) {
+		func = find_func_by_offset(offsets[i]);
+		if (func && !(func->flags & FUNCF_TRACE))
+			continue;
+		printf("%s", first ? "" : ";");
+		out_func(offsets[i], 0, "");
+		first = 0;
+	}
+	if (!first)
+		printf(" %lu\n", weight);
+}
+
+/*
+ * Folded stacks, one per line, as read by flamegraph.pl:
+ *
+ * board_init_r;initr_dm;dm_init_and_scan;dm_scan_fdt 1234
+ */
+static int make_flamegraph(void)
+{
+	struct {
+		uint32_t start;		/* Entry timestamp */
+		uint32_t child;		/* Time spent in called functions */
+	} *frames;
+	uint32_t *stack, *word;
+	struct trace_call *call;
+	int depth = 0, alloced = 0;
+	int i;
+
+	/* Samples are weighted by the number of periods they stand for */
+	if (sample_count) {
+		for (i = 0, word = sample_list; i < sample_count; i++) {
+			int count = TRACE_SAMPLE_FRAMES(*word);
+
+			out_stack(word + 1, count, TRACE_SAMPLE_WEIGHT(*word));
+			word += 1 + count;
+		}
+		return 0;
+	}
+
+	/* Otherwise use the self time of each call, between entry and exit */
+	stack = NULL;
+	frames = NULL;
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		uint32_t time = call->flags & FUNCF_TIMESTAMP_MASK;
+		uint32_t total;
+
+		switch (TRACE_CALL_TYPE(call)) {
+		case FUNCF_ENTRY:
+			if (depth == alloced) {
+				alloced = alloced * 2 + 64;
+				stack = realloc(stack,
+						alloced * sizeof(*stack));
+				frames = realloc(frames,
+						 alloced * sizeof(*frames));
+				if (!stack || !frames) {
+					error("Cannot allocate call stack\n");
+					return -1;
+				}
+			}
+			stack[depth] = call->func;
+			frames[depth].start = time;
+			frames[depth].child = 0;
+			depth++;
+			break;
+
+		case FUNCF_EXIT:
+			/* Ignore exits from calls made before the trace */
+			if (!depth)
+				break;
+			depth--;
+			total = (time - frames[depth].start) &
+				FUNCF_TIMESTAMP_MASK;
+			out_stack(stack, depth + 1,
+				  total - MIN(total, frames[depth].child));
+			if (depth)
+				frames[depth - 1].child += total;
+			break;
+		}
+	}
+	free(stack);
+	free(frames);
+
+	return 0;
+}
+
+static int h_cmp_call_count(const void *v1, const void *v2)
+{
+	const struct func_info *f1 = *(struct func_info **)v1;
+	const struct func_info *f2 = *(struct func_info **)v2;
+
+	if (f1->call_count != f2->call_count)
+		return f1->call_count < f2->call_count ? 1 : -1;
+	return strcmp(f1->name, f2->name);
+}
+
+static int make_funcs(void)
+{
+	struct func_info **sorted;
+	int i, count;
+
+	sorted = calloc(func_count, sizeof(*sorted));
+	if (!sorted) {
+		error("Cannot allocate function list\n");
+		return -1;
+	}
+	for (i = count = 0; i < func_count; i++) {
+		if (func_list[i].call_count &&
+		    (func_list[i].flags & FUNCF_TRACE))
+			sorted[count++] = &func_list[i];
+	}
+	qsort(sorted, count, sizeof(*sorted), h_cmp_call_count);
+
+	printf("%10s  %s\n", "calls", "function");
+	for (i = 0; i < count; i++)
+		printf("%10lu  %s\n", sorted[i]->call_count, sorted[i]->name);
+	free(sorted);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char * const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -553,6 +748,10 @@ static int prof_tool(int argc, char * const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-flamegraph"))
+			err = make_flamegraph();
+		else if (0 == strcmp(cmd, "dump-funcs"))
+			err = make_funcs();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}
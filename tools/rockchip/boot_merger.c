@@ -4,7 +4,11 @@
  * SPDX-License-Identifier:	GPL-2.0+
  */
 #include "boot_merger.h"
+#include <fcntl.h>
+#include <pthread.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <version.h>
 
@@ -27,65 +31,10 @@ char gEat[MAX_LINE_LEN];
 char *gConfigPath;
 uint8_t *gBuf;
 bool enableRC4 = false;
+static bool gStats = false;
 
 static uint32_t g_merge_max_size = MAX_MERGE_SIZE;
 
-uint32_t gTable_Crc32[256] = {
-	0x00000000, 0x04c10db7, 0x09821b6e, 0x0d4316d9, 0x130436dc, 0x17c53b6b,
-	0x1a862db2, 0x1e472005, 0x26086db8, 0x22c9600f, 0x2f8a76d6, 0x2b4b7b61,
-	0x350c5b64, 0x31cd56d3, 0x3c8e400a, 0x384f4dbd, 0x4c10db70, 0x48d1d6c7,
-	0x4592c01e, 0x4153cda9, 0x5f14edac, 0x5bd5e01b, 0x5696f6c2, 0x5257fb75,
-	0x6a18b6c8, 0x6ed9bb7f, 0x639aada6, 0x675ba011, 0x791c8014, 0x7ddd8da3,
-	0x709e9b7a, 0x745f96cd, 0x9821b6e0, 0x9ce0bb57, 0x91a3ad8e, 0x9562a039,
-	0x8b25803c, 0x8fe48d8b, 0x82a79b52, 0x866696e5, 0xbe29db58, 0xbae8d6ef,
-	0xb7abc036, 0xb36acd81, 0xad2ded84, 0xa9ece033, 0xa4aff6ea, 0xa06efb5d,
-	0xd4316d90, 0xd0f06027, 0xddb376fe, 0xd9727b49, 0xc7355b4c, 0xc3f456fb,
-	0xceb74022, 0xca764d95, 0xf2390028, 0xf6f80d9f, 0xfbbb1b46, 0xff7a16f1,
-	0xe13d36f4, 0xe5fc3b43, 0xe8bf2d9a, 0xec7e202d, 0x34826077, 0x30436dc0,
-	0x3d007b19, 0x39c176ae, 0x278656ab, 0x23475b1c, 0x2e044dc5, 0x2ac54072,
-	0x128a0dcf, 0x164b0078, 0x1b0816a1, 0x1fc91b16, 0x018e3b13, 0x054f36a4,
-	0x080c207d, 0x0ccd2dca, 0x7892bb07, 0x7c53b6b0, 0x7110a069, 0x75d1adde,
-	0x6b968ddb, 0x6f57806c, 0x621496b5, 0x66d59b02, 0x5e9ad6bf, 0x5a5bdb08,
-	0x5718cdd1, 0x53d9c066, 0x4d9ee063, 0x495fedd4, 0x441cfb0d, 0x40ddf6ba,
-	0xaca3d697, 0xa862db20, 0xa521cdf9, 0xa1e0c04e, 0xbfa7e04b, 0xbb66edfc,
-	0xb625fb25, 0xb2e4f692, 0x8aabbb2f, 0x8e6ab698, 0x8329a041, 0x87e8adf6,
-	0x99af8df3, 0x9d6e8044, 0x902d969d, 0x94ec9b2a, 0xe0b30de7, 0xe4720050,
-	0xe9311689, 0xedf01b3e, 0xf3b73b3b, 0xf776368c, 0xfa352055, 0xfef42de2,
-	0xc6bb605f, 0xc27a6de8, 0xcf397b31, 0xcbf87686, 0xd5bf5683, 0xd17e5b34,
-	0xdc3d4ded, 0xd8fc405a, 0x6904c0ee, 0x6dc5cd59, 0x6086db80, 0x6447d637,
-	0x7a00f632, 0x7ec1fb85, 0x7382ed5c, 0x7743e0eb, 0x4f0cad56, 0x4bcda0e1,
-	0x468eb638, 0x424fbb8f, 0x5c089b8a, 0x58c9963d, 0x558a80e4, 0x514b8d53,
-	0x25141b9e, 0x21d51629, 0x2c9600f0, 0x28570d47, 0x36102d42, 0x32d120f5,
-	0x3f92362c, 0x3b533b9b, 0x031c7626, 0x07dd7b91, 0x0a9e6d48, 0x0e5f60ff,
-	0x101840fa, 0x14d94d4d, 0x199a5b94, 0x1d5b5623, 0xf125760e, 0xf5e47bb9,
-	0xf8a76d60, 0xfc6660d7, 0xe22140d2, 0xe6e04d65, 0xeba35bbc, 0xef62560b,
-	0xd72d1bb6, 0xd3ec1601, 0xdeaf00d8, 0xda6e0d6f, 0xc4292d6a, 0xc0e820dd,
-	0xcdab3604, 0xc96a3bb3, 0xbd35ad7e, 0xb9f4a0c9, 0xb4b7b610, 0xb076bba7,
-	0xae319ba2, 0xaaf09615, 0xa7b380cc, 0xa3728d7b, 0x9b3dc0c6, 0x9ffccd71,
-	0x92bfdba8, 0x967ed61f, 0x8839f61a, 0x8cf8fbad, 0x81bbed74, 0x857ae0c3,
-	0x5d86a099, 0x5947ad2e, 0x5404bbf7, 0x50c5b640, 0x4e829645, 0x4a439bf2,
-	0x47008d2b, 0x43c1809c, 0x7b8ecd21, 0x7f4fc096, 0x720cd64f, 0x76cddbf8,
-	0x688afbfd, 0x6c4bf64a, 0x6108e093, 0x65c9ed24, 0x11967be9, 0x1557765e,
-	0x18146087, 0x1cd56d30, 0x02924d35, 0x06534082, 0x0b10565b, 0x0fd15bec,
-	0x379e1651, 0x335f1be6, 0x3e1c0d3f, 0x3add0088, 0x249a208d, 0x205b2d3a,
-	0x2d183be3, 0x29d93654, 0xc5a71679, 0xc1661bce, 0xcc250d17, 0xc8e400a0,
-	0xd6a320a5, 0xd2622d12, 0xdf213bcb, 0xdbe0367c, 0xe3af7bc1, 0xe76e7676,
-	0xea2d60af, 0xeeec6d18, 0xf0ab4d1d, 0xf46a40aa, 0xf9295673, 0xfde85bc4,
-	0x89b7cd09, 0x8d76c0be, 0x8035d667, 0x84f4dbd0, 0x9ab3fbd5, 0x9e72f662,
-	0x9331e0bb, 0x97f0ed0c, 0xafbfa0b1, 0xab7ead06, 0xa63dbbdf, 0xa2fcb668,
-	0xbcbb966d, 0xb87a9bda, 0xb5398d03, 0xb1f880b4,
-};
-
-uint32_t CRC_32(uint8_t *pData, uint32_t ulSize)
-{
-	uint32_t i;
-	uint32_t nAccum = 0;
-	for (i = 0; i < ulSize; i++) {
-		nAccum = (nAccum << 8) ^ gTable_Crc32[(nAccum >> 24) ^ (*pData++)];
-	}
-	return nAccum;
-}
-
 void P_RC4(uint8_t *buf, uint32_t len)
 {
 	uint8_t S[256], K[256], temp;
@@ -609,56 +558,152 @@ static inline rk_time getTime(void)
 	return rkTime;
 }
 
-static bool writeFile(FILE *outFile, const char *path, bool fix)
+static inline uint64_t getMicros(void)
 {
-	bool ret = false;
-	uint32_t size = 0, fixSize = 0;
-	uint8_t *buf;
+	struct timespec ts;
 
-	FILE *inFile = fopen(path, "rb");
-	if (!inFile)
-		goto end;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* Size of an entry in the loader, loader entries are padded to SMALL_PACKET */
+static inline uint32_t getEntrySize(uint32_t size, bool fix)
+{
+	uint32_t tmp;
+
+	if (fix)
+		size = ((size - 1) / SMALL_PACKET + 1) * SMALL_PACKET;
+	tmp = size % ENTRY_ALIGN;
+	return size + (tmp ? (ENTRY_ALIGN - tmp) : 0);
+}
+
+static void *mapFile(const char *path, uint32_t *size)
+{
+	struct stat st;
+	void *data;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || !st.st_size) {
+		close(fd);
+		return NULL;
+	}
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+	*size = st.st_size;
+	return data;
+}
 
-	if (!getFileSize(path, &size))
+/*
+ * P_RC4() starts over from the same key on every call, so all data is XORed
+ * with the same keystream: generate it once for all entries.
+ */
+static uint8_t *gRc4Stream;
+
+typedef struct {
+	const char *path;
+	bool fix;
+	uint32_t fileSize;
+	uint32_t size;		/* aligned size in the loader */
+	uint8_t *buf;		/* encrypted data */
+	uint64_t time;		/* us, for --stats */
+	bool ok;
+	bool threaded;
+	pthread_t thread;
+} merge_job;
+
+/* Entries are independent, so each one is read and encrypted by a thread */
+static void *prepareEntry(void *arg)
+{
+	merge_job *job = arg;
+	uint64_t start = getMicros();
+	uint32_t packet, off, i, size;
+	uint8_t *data;
+
+	data = mapFile(job->path, &size);
+	if (!data)
+		goto end;
+	if (size != job->fileSize) {
+		munmap(data, size);
 		goto end;
-	if (fix) {
-		fixSize = ((size - 1) / SMALL_PACKET + 1) * SMALL_PACKET;
-		uint32_t tmp = fixSize % ENTRY_ALIGN;
-		tmp = tmp ? (ENTRY_ALIGN - tmp) : 0;
-		fixSize += tmp;
-		memset(gBuf, 0, fixSize);
-	} else {
-		memset(gBuf, 0, size + ENTRY_ALIGN);
 	}
-	if (!fread(gBuf, size, 1, inFile))
+	job->buf = calloc(job->size, 1);
+	if (!job->buf) {
+		munmap(data, size);
 		goto end;
+	}
+	memcpy(job->buf, data, size);
+	munmap(data, size);
 
-	if (fix) {
+	packet = job->fix ? SMALL_PACKET : job->size;
+	for (off = 0; off < job->size; off += packet) {
+		for (i = 0; i < packet; i++)
+			job->buf[off + i] ^= gRc4Stream[i];
+	}
+	job->ok = true;
+end:
+	job->time = getMicros() - start;
+	return NULL;
+}
 
-		buf = gBuf;
-		size = fixSize;
-		while (1) {
-			P_RC4(buf, fixSize < SMALL_PACKET ? fixSize : SMALL_PACKET);
-			buf += SMALL_PACKET;
-			if (fixSize <= SMALL_PACKET)
-				break;
-			fixSize -= SMALL_PACKET;
+static bool writeFiles(FILE *outFile, merge_job *jobs, int num)
+{
+	uint32_t maxLen = 0;
+	uint64_t start;
+	bool ret = false;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if (!getFileSize(jobs[i].path, &jobs[i].fileSize)) {
+			LOGE("write entry(%s) failed\n", jobs[i].path);
+			return false;
 		}
-	} else {
-		uint32_t tmp = size % ENTRY_ALIGN;
-		tmp = tmp ? (ENTRY_ALIGN - tmp) : 0;
-		size += tmp;
-		P_RC4(gBuf, size);
+		jobs[i].size = getEntrySize(jobs[i].fileSize, jobs[i].fix);
+		if (jobs[i].fix && maxLen < SMALL_PACKET)
+			maxLen = SMALL_PACKET;
+		else if (!jobs[i].fix && maxLen < jobs[i].size)
+			maxLen = jobs[i].size;
 	}
 
-	if (!fwrite(gBuf, size, 1, outFile))
-		goto end;
+	gRc4Stream = calloc(maxLen, 1);
+	if (!gRc4Stream)
+		return false;
+	P_RC4(gRc4Stream, maxLen);
+
+	for (i = 0; i < num; i++) {
+		jobs[i].threaded = !pthread_create(&jobs[i].thread, NULL,
+						   prepareEntry, &jobs[i]);
+		if (!jobs[i].threaded)
+			prepareEntry(&jobs[i]);
+	}
+	for (i = 0; i < num; i++) {
+		if (jobs[i].threaded)
+			pthread_join(jobs[i].thread, NULL);
+	}
+
+	for (i = 0; i < num; i++) {
+		start = getMicros();
+		if (!jobs[i].ok ||
+		    !fwrite(jobs[i].buf, jobs[i].size, 1, outFile)) {
+			LOGE("write entry(%s) failed\n", jobs[i].path);
+			goto end;
+		}
+		if (gStats)
+			printf("stats: %-40s %8u bytes, read+rc4 %6llu us, write %6llu us\n",
+			       jobs[i].path, jobs[i].size,
+			       (unsigned long long)jobs[i].time,
+			       (unsigned long long)(getMicros() - start));
+	}
 	ret = true;
 end:
-	if (inFile)
-		fclose(inFile);
-	if (!ret)
-		LOGE("write entry(%s) failed\n", path);
+	for (i = 0; i < num; i++)
+		free(jobs[i].buf);
+	free(gRc4Stream);
+	gRc4Stream = NULL;
 	return ret;
 }
 
@@ -681,10 +726,7 @@ static bool saveEntry(FILE *outFile, char *path, rk_entry_type type,
 		LOGE("save entry(%s) failed:\n\tcannot get file size.\n", path);
 		return false;
 	}
-	if (fix)
-		size = ((size - 1) / SMALL_PACKET + 1) * SMALL_PACKET;
-	uint32_t tmp = size % ENTRY_ALIGN;
-	size += tmp ? (ENTRY_ALIGN - tmp) : 0;
+	size = getEntrySize(size, fix);
 	LOGD("align size:%d\n", size);
 	entry.dataSize = size;
 	entry.dataDelay = delay;
@@ -779,17 +821,14 @@ static inline uint32_t getCrc(const char *path)
 {
 	uint32_t size = 0;
 	uint32_t crc = 0;
-	FILE *file = fopen(path, "rb");
-	getFileSize(path, &size);
-	if (!file)
-		goto end;
-	if (!fread(gBuf, size, 1, file))
-		goto end;
-	crc = CRC_32(gBuf, size);
+	uint8_t *data;
+
+	data = mapFile(path, &size);
+	if (!data)
+		return 0;
+	crc = crc32_rk(0, data, size);
+	munmap(data, size);
 	LOGD("crc:0x%08x\n", crc);
-end:
-	if (file)
-		fclose(file);
 	return crc;
 }
 
@@ -797,10 +836,12 @@ static bool mergeBoot(int argc, char **argv)
 {
 	uint32_t dataOffset;
 	bool ret = false;
-	int i;
+	int i, num = 0;
 	FILE *outFile;
 	uint32_t crc;
 	rk_boot_header hdr;
+	merge_job *jobs = NULL;
+	uint64_t start = getMicros();
 
 	if (!initOpts(argc, argv))
 		return false;
@@ -854,21 +895,21 @@ static bool mergeBoot(int argc, char **argv)
 			goto end;
 	}
 
-	LOGD("write code 471\n");
-	for (i = 0; i < gOpts.code471Num; i++) {
-		if (!writeFile(outFile, (char *)gOpts.code471Path[i], false))
-			goto end;
-	}
-	LOGD("write code 472\n");
-	for (i = 0; i < gOpts.code472Num; i++) {
-		if (!writeFile(outFile, (char *)gOpts.code472Path[i], false))
-			goto end;
-	}
-	LOGD("write loader\n");
+	LOGD("write code 471, 472 and loader\n");
+	jobs = calloc(gOpts.code471Num + gOpts.code472Num + gOpts.loaderNum,
+		      sizeof(*jobs));
+	if (!jobs)
+		goto end;
+	for (i = 0; i < gOpts.code471Num; i++)
+		jobs[num++].path = (char *)gOpts.code471Path[i];
+	for (i = 0; i < gOpts.code472Num; i++)
+		jobs[num++].path = (char *)gOpts.code472Path[i];
 	for (i = 0; i < gOpts.loaderNum; i++) {
-		if (!writeFile(outFile, gOpts.loader[i].path, true))
-			goto end;
+		jobs[num].path = gOpts.loader[i].path;
+		jobs[num++].fix = true;
 	}
+	if (!writeFiles(outFile, jobs, num))
+		goto end;
 	fflush(outFile);
 
 	LOGD("write crc\n");
@@ -876,8 +917,12 @@ static bool mergeBoot(int argc, char **argv)
 	if (!fwrite(&crc, sizeof(crc), 1, outFile))
 		goto end;
 
+	if (gStats)
+		printf("stats: total %llu us\n",
+		       (unsigned long long)(getMicros() - start));
 	ret = true;
 end:
+	free(jobs);
 	if (outFile)
 		fclose(outFile);
 	return ret;
@@ -979,6 +1024,7 @@ static void printHelp(void)
 	printf("\t" OPT_MERGE "\t\t\tMerge loader with specified config.\n");
 	printf("\t" OPT_UNPACK "\t\tUnpack specified loader to current dir.\n");
 	printf("\t" OPT_VERBOSE "\t\tDisplay more runtime informations.\n");
+	printf("\t" OPT_STATS "\t\tDisplay the time taken per component.\n");
 	printf("\t" OPT_HELP "\t\t\tDisplay this information.\n");
 	printf("\t" OPT_VERSION "\t\tDisplay version information.\n");
 	printf("\t" OPT_SUBFIX "\t\tSpec subfix.\n");
@@ -1011,6 +1057,8 @@ int main(int argc, char **argv)
 		if (!strcmp(OPT_VERBOSE, argv[i])) {
 			gDebug = true;
 			printf("enable debug\n");
+		} else if (!strcmp(OPT_STATS, argv[i])) {
+			gStats = true;
 		} else if (!strcmp(OPT_HELP, argv[i])) {
 			printHelp();
 			return 0;
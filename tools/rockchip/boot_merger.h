@@ -180,6 +180,7 @@ typedef struct {
 #pragma pack()
 
 #define OPT_VERBOSE         "--verbose"
+#define OPT_STATS           "--stats"
 #define OPT_HELP            "--help"
 #define OPT_VERSION         "--version"
 #define OPT_MERGE           "--pack"
@@ -200,4 +201,6 @@ typedef struct {
 
 #define VERSION             "2013-8-12 14:27:23"
 
+uint32_t crc32_rk(uint32_t crc, const unsigned char *s, uint32_t len);
+
 #endif/* BOOT_MERGER_H */
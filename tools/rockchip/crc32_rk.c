@@ -7,6 +7,7 @@
 
 #ifdef USE_HOSTCC
 #include <arpa/inet.h>
+#include <pthread.h>
 #else
 #include <common.h>
 #endif
@@ -86,16 +87,58 @@ static const uint32_t crc_table[256] = {
 	tole(0xbcbb966dL), tole(0xb87a9bdaL), tole(0xb5398d03L), tole(0xb1f880b4L)
 };
 
-/* ========================================================================= */
-#define DO_CRC(x) crc = tab[((crc >> 24) ^ (x)) & 255] ^ (crc << 8)
+/*
+ * Slice-by-8: crc_slice[k][b] is the CRC of byte b followed by k zero bytes,
+ * so eight input bytes are folded in with eight independent table lookups.
+ */
+static uint32_t crc_slice[8][256];
+
+static void crc32_rk_init(void)
+{
+	uint32_t c;
+	int i, k;
+
+	for (i = 0; i < 256; i++)
+		crc_slice[0][i] = le32_to_cpu(crc_table[i]);
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++) {
+			c = crc_slice[k - 1][i];
+			crc_slice[k][i] = (c << 8) ^ crc_slice[0][c >> 24];
+		}
+	}
+}
+
+static inline uint32_t get_be32(const unsigned char *s)
+{
+	return s[0] << 24 | s[1] << 16 | s[2] << 8 | s[3];
+}
+
 uint32_t crc32_rk(uint32_t crc, const unsigned char *s, uint32_t len)
 {
-	const uint32_t *tab;
-	tab = crc_table;
-	crc = cpu_to_le32(crc);
-	do {
-		DO_CRC(*s++);
-	} while (--len);
-	return le32_to_cpu(crc);
+	uint32_t x, y;
+#ifdef USE_HOSTCC
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+	pthread_once(&once, crc32_rk_init);
+#else
+	static bool init;
+
+	if (!init) {
+		crc32_rk_init();
+		init = true;
+	}
+#endif
+
+	for (; len >= 8; len -= 8, s += 8) {
+		x = crc ^ get_be32(s);
+		y = get_be32(s + 4);
+		crc = crc_slice[7][x >> 24] ^ crc_slice[6][(x >> 16) & 255] ^
+		      crc_slice[5][(x >> 8) & 255] ^ crc_slice[4][x & 255] ^
+		      crc_slice[3][y >> 24] ^ crc_slice[2][(y >> 16) & 255] ^
+		      crc_slice[1][(y >> 8) & 255] ^ crc_slice[0][y & 255];
+	}
+	while (len--)
+		crc = crc_slice[0][(crc >> 24) ^ *s++] ^ (crc << 8);
+
+	return crc;
 }
-#undef DO_CRC
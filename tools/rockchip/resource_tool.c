@@ -4,560 +4,19 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <memory.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
-
-/**
- * \brief	   SHA-1 context structure
- */
-typedef struct
-{
-    unsigned long total[2];	/*!< number of bytes processed	*/
-    unsigned long state[5];	/*!< intermediate digest state	*/
-    unsigned char buffer[64];	/*!< data block being processed */
-}
-sha1_context;
-
-/*
- * 32-bit integer manipulation macros (big endian)
- */
-#ifndef GET_UINT32_BE
-#define GET_UINT32_BE(n,b,i) {				\
-	(n) = ( (unsigned long) (b)[(i)    ] << 24 )	\
-	    | ( (unsigned long) (b)[(i) + 1] << 16 )	\
-	    | ( (unsigned long) (b)[(i) + 2] <<  8 )	\
-	    | ( (unsigned long) (b)[(i) + 3]       );	\
-}
-#endif
-#ifndef PUT_UINT32_BE
-#define PUT_UINT32_BE(n,b,i) {				\
-	(b)[(i)    ] = (unsigned char) ( (n) >> 24 );	\
-	(b)[(i) + 1] = (unsigned char) ( (n) >> 16 );	\
-	(b)[(i) + 2] = (unsigned char) ( (n) >>  8 );	\
-	(b)[(i) + 3] = (unsigned char) ( (n)       );	\
-}
-#endif
-
-/*
- * SHA-1 context setup
- */
-static
-void sha1_starts (sha1_context * ctx)
-{
-	ctx->total[0] = 0;
-	ctx->total[1] = 0;
-
-	ctx->state[0] = 0x67452301;
-	ctx->state[1] = 0xEFCDAB89;
-	ctx->state[2] = 0x98BADCFE;
-	ctx->state[3] = 0x10325476;
-	ctx->state[4] = 0xC3D2E1F0;
-}
-
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
-{
-	unsigned long temp, W[16], A, B, C, D, E;
-
-	GET_UINT32_BE (W[0], data, 0);
-	GET_UINT32_BE (W[1], data, 4);
-	GET_UINT32_BE (W[2], data, 8);
-	GET_UINT32_BE (W[3], data, 12);
-	GET_UINT32_BE (W[4], data, 16);
-	GET_UINT32_BE (W[5], data, 20);
-	GET_UINT32_BE (W[6], data, 24);
-	GET_UINT32_BE (W[7], data, 28);
-	GET_UINT32_BE (W[8], data, 32);
-	GET_UINT32_BE (W[9], data, 36);
-	GET_UINT32_BE (W[10], data, 40);
-	GET_UINT32_BE (W[11], data, 44);
-	GET_UINT32_BE (W[12], data, 48);
-	GET_UINT32_BE (W[13], data, 52);
-	GET_UINT32_BE (W[14], data, 56);
-	GET_UINT32_BE (W[15], data, 60);
-
-#define S(x,n)	((x << n) | ((x & 0xFFFFFFFF) >> (32 - n)))
-
-#define R(t) (						\
-	temp = W[(t -  3) & 0x0F] ^ W[(t - 8) & 0x0F] ^	\
-	       W[(t - 14) & 0x0F] ^ W[ t      & 0x0F],	\
-	( W[t & 0x0F] = S(temp,1) )			\
-)
-
-#define P(a,b,c,d,e,x)	{				\
-	e += S(a,5) + F(b,c,d) + K + x; b = S(b,30);	\
-}
-
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
-
-#define F(x,y,z) (z ^ (x & (y ^ z)))
-#define K 0x5A827999
-
-	P (A, B, C, D, E, W[0]);
-	P (E, A, B, C, D, W[1]);
-	P (D, E, A, B, C, W[2]);
-	P (C, D, E, A, B, W[3]);
-	P (B, C, D, E, A, W[4]);
-	P (A, B, C, D, E, W[5]);
-	P (E, A, B, C, D, W[6]);
-	P (D, E, A, B, C, W[7]);
-	P (C, D, E, A, B, W[8]);
-	P (B, C, D, E, A, W[9]);
-	P (A, B, C, D, E, W[10]);
-	P (E, A, B, C, D, W[11]);
-	P (D, E, A, B, C, W[12]);
-	P (C, D, E, A, B, W[13]);
-	P (B, C, D, E, A, W[14]);
-	P (A, B, C, D, E, W[15]);
-	P (E, A, B, C, D, R (16));
-	P (D, E, A, B, C, R (17));
-	P (C, D, E, A, B, R (18));
-	P (B, C, D, E, A, R (19));
-
-#undef K
-#undef F
-
-#define F(x,y,z) (x ^ y ^ z)
-#define K 0x6ED9EBA1
-
-	P (A, B, C, D, E, R (20));
-	P (E, A, B, C, D, R (21));
-	P (D, E, A, B, C, R (22));
-	P (C, D, E, A, B, R (23));
-	P (B, C, D, E, A, R (24));
-	P (A, B, C, D, E, R (25));
-	P (E, A, B, C, D, R (26));
-	P (D, E, A, B, C, R (27));
-	P (C, D, E, A, B, R (28));
-	P (B, C, D, E, A, R (29));
-	P (A, B, C, D, E, R (30));
-	P (E, A, B, C, D, R (31));
-	P (D, E, A, B, C, R (32));
-	P (C, D, E, A, B, R (33));
-	P (B, C, D, E, A, R (34));
-	P (A, B, C, D, E, R (35));
-	P (E, A, B, C, D, R (36));
-	P (D, E, A, B, C, R (37));
-	P (C, D, E, A, B, R (38));
-	P (B, C, D, E, A, R (39));
-
-#undef K
-#undef F
-
-#define F(x,y,z) ((x & y) | (z & (x | y)))
-#define K 0x8F1BBCDC
-
-	P (A, B, C, D, E, R (40));
-	P (E, A, B, C, D, R (41));
-	P (D, E, A, B, C, R (42));
-	P (C, D, E, A, B, R (43));
-	P (B, C, D, E, A, R (44));
-	P (A, B, C, D, E, R (45));
-	P (E, A, B, C, D, R (46));
-	P (D, E, A, B, C, R (47));
-	P (C, D, E, A, B, R (48));
-	P (B, C, D, E, A, R (49));
-	P (A, B, C, D, E, R (50));
-	P (E, A, B, C, D, R (51));
-	P (D, E, A, B, C, R (52));
-	P (C, D, E, A, B, R (53));
-	P (B, C, D, E, A, R (54));
-	P (A, B, C, D, E, R (55));
-	P (E, A, B, C, D, R (56));
-	P (D, E, A, B, C, R (57));
-	P (C, D, E, A, B, R (58));
-	P (B, C, D, E, A, R (59));
-
-#undef K
-#undef F
-
-#define F(x,y,z) (x ^ y ^ z)
-#define K 0xCA62C1D6
-
-	P (A, B, C, D, E, R (60));
-	P (E, A, B, C, D, R (61));
-	P (D, E, A, B, C, R (62));
-	P (C, D, E, A, B, R (63));
-	P (B, C, D, E, A, R (64));
-	P (A, B, C, D, E, R (65));
-	P (E, A, B, C, D, R (66));
-	P (D, E, A, B, C, R (67));
-	P (C, D, E, A, B, R (68));
-	P (B, C, D, E, A, R (69));
-	P (A, B, C, D, E, R (70));
-	P (E, A, B, C, D, R (71));
-	P (D, E, A, B, C, R (72));
-	P (C, D, E, A, B, R (73));
-	P (B, C, D, E, A, R (74));
-	P (A, B, C, D, E, R (75));
-	P (E, A, B, C, D, R (76));
-	P (D, E, A, B, C, R (77));
-	P (C, D, E, A, B, R (78));
-	P (B, C, D, E, A, R (79));
-
-#undef K
-#undef F
-
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
-}
-
-#undef P
-#undef R
-#undef S
-
-/*
- * SHA-1 process buffer
- */
-static
-void sha1_update(sha1_context *ctx, const unsigned char *input,
-		 unsigned int ilen)
-{
-	int fill;
-	unsigned long left;
-
-	if (ilen <= 0)
-		return;
-
-	left = ctx->total[0] & 0x3F;
-	fill = 64 - left;
-
-	ctx->total[0] += ilen;
-	ctx->total[0] &= 0xFFFFFFFF;
-
-	if (ctx->total[0] < (unsigned long) ilen)
-		ctx->total[1]++;
-
-	if (left && ilen >= fill) {
-		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
-		input += fill;
-		ilen -= fill;
-		left = 0;
-	}
-
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
-	}
-
-	if (ilen > 0) {
-		memcpy ((void *) (ctx->buffer + left), (void *) input, ilen);
-	}
-}
-
-static const unsigned char sha1_padding[64] = {
-	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
-
-/*
- * SHA-1 final digest
- */
-static
-void sha1_finish (sha1_context * ctx, unsigned char output[20])
-{
-	unsigned long last, padn;
-	unsigned long high, low;
-	unsigned char msglen[8];
-
-	high = (ctx->total[0] >> 29)
-		| (ctx->total[1] << 3);
-	low = (ctx->total[0] << 3);
-
-	PUT_UINT32_BE (high, msglen, 0);
-	PUT_UINT32_BE (low, msglen, 4);
-
-	last = ctx->total[0] & 0x3F;
-	padn = (last < 56) ? (56 - last) : (120 - last);
-
-	sha1_update (ctx, (unsigned char *) sha1_padding, padn);
-	sha1_update (ctx, msglen, 8);
-
-	PUT_UINT32_BE (ctx->state[0], output, 0);
-	PUT_UINT32_BE (ctx->state[1], output, 4);
-	PUT_UINT32_BE (ctx->state[2], output, 8);
-	PUT_UINT32_BE (ctx->state[3], output, 12);
-	PUT_UINT32_BE (ctx->state[4], output, 16);
-}
-
-/*
- * Output = SHA-1( input buffer )
- */
-static
-void sha1_csum(const unsigned char *input, unsigned int ilen,
-	       unsigned char *output)
-{
-	sha1_context ctx;
-
-	sha1_starts (&ctx);
-	sha1_update (&ctx, input, ilen);
-	sha1_finish (&ctx, output);
-}
-
-typedef struct {
-	uint32_t total[2];
-	uint32_t state[8];
-	uint8_t buffer[64];
-} sha256_context;
-
-static
-void sha256_starts(sha256_context * ctx)
-{
-	ctx->total[0] = 0;
-	ctx->total[1] = 0;
-
-	ctx->state[0] = 0x6A09E667;
-	ctx->state[1] = 0xBB67AE85;
-	ctx->state[2] = 0x3C6EF372;
-	ctx->state[3] = 0xA54FF53A;
-	ctx->state[4] = 0x510E527F;
-	ctx->state[5] = 0x9B05688C;
-	ctx->state[6] = 0x1F83D9AB;
-	ctx->state[7] = 0x5BE0CD19;
-}
-
-static void sha256_process(sha256_context *ctx, const uint8_t data[64])
-{
-	uint32_t temp1, temp2;
-	uint32_t W[64];
-	uint32_t A, B, C, D, E, F, G, H;
-
-	GET_UINT32_BE(W[0], data, 0);
-	GET_UINT32_BE(W[1], data, 4);
-	GET_UINT32_BE(W[2], data, 8);
-	GET_UINT32_BE(W[3], data, 12);
-	GET_UINT32_BE(W[4], data, 16);
-	GET_UINT32_BE(W[5], data, 20);
-	GET_UINT32_BE(W[6], data, 24);
-	GET_UINT32_BE(W[7], data, 28);
-	GET_UINT32_BE(W[8], data, 32);
-	GET_UINT32_BE(W[9], data, 36);
-	GET_UINT32_BE(W[10], data, 40);
-	GET_UINT32_BE(W[11], data, 44);
-	GET_UINT32_BE(W[12], data, 48);
-	GET_UINT32_BE(W[13], data, 52);
-	GET_UINT32_BE(W[14], data, 56);
-	GET_UINT32_BE(W[15], data, 60);
-
-#define SHR(x,n) ((x & 0xFFFFFFFF) >> n)
-#define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
-
-#define S0(x) (ROTR(x, 7) ^ ROTR(x,18) ^ SHR(x, 3))
-#define S1(x) (ROTR(x,17) ^ ROTR(x,19) ^ SHR(x,10))
-
-#define S2(x) (ROTR(x, 2) ^ ROTR(x,13) ^ ROTR(x,22))
-#define S3(x) (ROTR(x, 6) ^ ROTR(x,11) ^ ROTR(x,25))
-
-#define F0(x,y,z) ((x & y) | (z & (x | y)))
-#define F1(x,y,z) (z ^ (x & (y ^ z)))
-
-#define R(t)					\
-(						\
-	W[t] = S1(W[t - 2]) + W[t - 7] +	\
-		S0(W[t - 15]) + W[t - 16]	\
-)
-
-#define P(a,b,c,d,e,f,g,h,x,K) {		\
-	temp1 = h + S3(e) + F1(e,f,g) + K + x;	\
-	temp2 = S2(a) + F0(a,b,c);		\
-	d += temp1; h = temp1 + temp2;		\
-}
-
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
-	F = ctx->state[5];
-	G = ctx->state[6];
-	H = ctx->state[7];
-
-	P(A, B, C, D, E, F, G, H, W[0], 0x428A2F98);
-	P(H, A, B, C, D, E, F, G, W[1], 0x71374491);
-	P(G, H, A, B, C, D, E, F, W[2], 0xB5C0FBCF);
-	P(F, G, H, A, B, C, D, E, W[3], 0xE9B5DBA5);
-	P(E, F, G, H, A, B, C, D, W[4], 0x3956C25B);
-	P(D, E, F, G, H, A, B, C, W[5], 0x59F111F1);
-	P(C, D, E, F, G, H, A, B, W[6], 0x923F82A4);
-	P(B, C, D, E, F, G, H, A, W[7], 0xAB1C5ED5);
-	P(A, B, C, D, E, F, G, H, W[8], 0xD807AA98);
-	P(H, A, B, C, D, E, F, G, W[9], 0x12835B01);
-	P(G, H, A, B, C, D, E, F, W[10], 0x243185BE);
-	P(F, G, H, A, B, C, D, E, W[11], 0x550C7DC3);
-	P(E, F, G, H, A, B, C, D, W[12], 0x72BE5D74);
-	P(D, E, F, G, H, A, B, C, W[13], 0x80DEB1FE);
-	P(C, D, E, F, G, H, A, B, W[14], 0x9BDC06A7);
-	P(B, C, D, E, F, G, H, A, W[15], 0xC19BF174);
-	P(A, B, C, D, E, F, G, H, R(16), 0xE49B69C1);
-	P(H, A, B, C, D, E, F, G, R(17), 0xEFBE4786);
-	P(G, H, A, B, C, D, E, F, R(18), 0x0FC19DC6);
-	P(F, G, H, A, B, C, D, E, R(19), 0x240CA1CC);
-	P(E, F, G, H, A, B, C, D, R(20), 0x2DE92C6F);
-	P(D, E, F, G, H, A, B, C, R(21), 0x4A7484AA);
-	P(C, D, E, F, G, H, A, B, R(22), 0x5CB0A9DC);
-	P(B, C, D, E, F, G, H, A, R(23), 0x76F988DA);
-	P(A, B, C, D, E, F, G, H, R(24), 0x983E5152);
-	P(H, A, B, C, D, E, F, G, R(25), 0xA831C66D);
-	P(G, H, A, B, C, D, E, F, R(26), 0xB00327C8);
-	P(F, G, H, A, B, C, D, E, R(27), 0xBF597FC7);
-	P(E, F, G, H, A, B, C, D, R(28), 0xC6E00BF3);
-	P(D, E, F, G, H, A, B, C, R(29), 0xD5A79147);
-	P(C, D, E, F, G, H, A, B, R(30), 0x06CA6351);
-	P(B, C, D, E, F, G, H, A, R(31), 0x14292967);
-	P(A, B, C, D, E, F, G, H, R(32), 0x27B70A85);
-	P(H, A, B, C, D, E, F, G, R(33), 0x2E1B2138);
-	P(G, H, A, B, C, D, E, F, R(34), 0x4D2C6DFC);
-	P(F, G, H, A, B, C, D, E, R(35), 0x53380D13);
-	P(E, F, G, H, A, B, C, D, R(36), 0x650A7354);
-	P(D, E, F, G, H, A, B, C, R(37), 0x766A0ABB);
-	P(C, D, E, F, G, H, A, B, R(38), 0x81C2C92E);
-	P(B, C, D, E, F, G, H, A, R(39), 0x92722C85);
-	P(A, B, C, D, E, F, G, H, R(40), 0xA2BFE8A1);
-	P(H, A, B, C, D, E, F, G, R(41), 0xA81A664B);
-	P(G, H, A, B, C, D, E, F, R(42), 0xC24B8B70);
-	P(F, G, H, A, B, C, D, E, R(43), 0xC76C51A3);
-	P(E, F, G, H, A, B, C, D, R(44), 0xD192E819);
-	P(D, E, F, G, H, A, B, C, R(45), 0xD6990624);
-	P(C, D, E, F, G, H, A, B, R(46), 0xF40E3585);
-	P(B, C, D, E, F, G, H, A, R(47), 0x106AA070);
-	P(A, B, C, D, E, F, G, H, R(48), 0x19A4C116);
-	P(H, A, B, C, D, E, F, G, R(49), 0x1E376C08);
-	P(G, H, A, B, C, D, E, F, R(50), 0x2748774C);
-	P(F, G, H, A, B, C, D, E, R(51), 0x34B0BCB5);
-	P(E, F, G, H, A, B, C, D, R(52), 0x391C0CB3);
-	P(D, E, F, G, H, A, B, C, R(53), 0x4ED8AA4A);
-	P(C, D, E, F, G, H, A, B, R(54), 0x5B9CCA4F);
-	P(B, C, D, E, F, G, H, A, R(55), 0x682E6FF3);
-	P(A, B, C, D, E, F, G, H, R(56), 0x748F82EE);
-	P(H, A, B, C, D, E, F, G, R(57), 0x78A5636F);
-	P(G, H, A, B, C, D, E, F, R(58), 0x84C87814);
-	P(F, G, H, A, B, C, D, E, R(59), 0x8CC70208);
-	P(E, F, G, H, A, B, C, D, R(60), 0x90BEFFFA);
-	P(D, E, F, G, H, A, B, C, R(61), 0xA4506CEB);
-	P(C, D, E, F, G, H, A, B, R(62), 0xBEF9A3F7);
-	P(B, C, D, E, F, G, H, A, R(63), 0xC67178F2);
-
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
-	ctx->state[5] += F;
-	ctx->state[6] += G;
-	ctx->state[7] += H;
-}
-
-#undef P
-#undef R
-#undef F1
-#undef F0
-#undef S3
-#undef S2
-#undef S1
-#undef S0
-#undef ROTR
-#undef SHR
-
-static
-void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
-{
-	uint32_t left, fill;
-
-	if (!length)
-		return;
-
-	left = ctx->total[0] & 0x3F;
-	fill = 64 - left;
-
-	ctx->total[0] += length;
-	ctx->total[0] &= 0xFFFFFFFF;
-
-	if (ctx->total[0] < length)
-		ctx->total[1]++;
-
-	if (left && length >= fill) {
-		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
-		length -= fill;
-		input += fill;
-		left = 0;
-	}
-
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
-	}
-
-	if (length)
-		memcpy((void *) (ctx->buffer + left), (void *) input, length);
-}
-
-static uint8_t sha256_padding[64] = {
-	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
-
-static
-void sha256_finish(sha256_context * ctx, uint8_t digest[32])
-{
-	uint32_t last, padn;
-	uint32_t high, low;
-	uint8_t msglen[8];
-
-	high = ((ctx->total[0] >> 29)
-		| (ctx->total[1] << 3));
-	low = (ctx->total[0] << 3);
-
-	PUT_UINT32_BE(high, msglen, 0);
-	PUT_UINT32_BE(low, msglen, 4);
-
-	last = ctx->total[0] & 0x3F;
-	padn = (last < 56) ? (56 - last) : (120 - last);
-
-	sha256_update(ctx, sha256_padding, padn);
-	sha256_update(ctx, msglen, 8);
-
-	PUT_UINT32_BE(ctx->state[0], digest, 0);
-	PUT_UINT32_BE(ctx->state[1], digest, 4);
-	PUT_UINT32_BE(ctx->state[2], digest, 8);
-	PUT_UINT32_BE(ctx->state[3], digest, 12);
-	PUT_UINT32_BE(ctx->state[4], digest, 16);
-	PUT_UINT32_BE(ctx->state[5], digest, 20);
-	PUT_UINT32_BE(ctx->state[6], digest, 24);
-	PUT_UINT32_BE(ctx->state[7], digest, 28);
-}
-
-/*
- * Output = SHA-256( input buffer ).
- */
-static
-void sha256_csum(const unsigned char *input, unsigned int ilen,
-		 unsigned char *output)
-{
-	sha256_context ctx;
-
-	sha256_starts(&ctx);
-	sha256_update(&ctx, input, ilen);
-	sha256_finish(&ctx, output);
-}
+#include <unistd.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
 
 /* #define DEBUG */
 
@@ -615,6 +74,7 @@ typedef struct {
 } index_tbl_entry;
 
 #define OPT_VERBOSE "--verbose"
+#define OPT_STATS "--stats"
 #define OPT_HELP "--help"
 #define OPT_VERSION "--version"
 #define OPT_PRINT "--print"
@@ -651,6 +111,8 @@ typedef struct {
 #define OPT_CHARGE_ANIM_LEVEL_PFX "prefix="
 
 static char image_path[MAX_INDEX_ENTRY_PATH_LEN] = "\0";
+static int image_fd = -1;	/* image being packed */
+static bool g_stats = false;
 
 static int fix_blocks(size_t size)
 {
@@ -709,27 +171,28 @@ static int inline get_ptn_offset(void)
 	return 0;
 }
 
-static bool StorageWriteLba(int offset_block, void *data, int blocks)
+/* pwrite() to the image, so that several files can be written at once */
+static bool write_image(off_t offset, const void *data, size_t len)
 {
-	bool ret = false;
-	FILE *file = fopen(image_path, "rb+");
-	if (!file)
-		goto end;
-	int offset = offset_block * BLOCK_SIZE;
-	fseek(file, offset, SEEK_SET);
-	if (offset != ftell(file)) {
-		LOGE("Failed to seek %s to %d!", image_path, offset);
-		goto end;
-	}
-	if (!fwrite(data, blocks * BLOCK_SIZE, 1, file)) {
-		LOGE("Failed to write %s!", image_path);
-		goto end;
+	ssize_t n;
+
+	while (len) {
+		n = pwrite(image_fd, data, len, offset);
+		if (n <= 0) {
+			LOGE("Failed to write %s!", image_path);
+			return false;
+		}
+		data += n;
+		len -= n;
+		offset += n;
 	}
-	ret = true;
-end:
-	if (file)
-		fclose(file);
-	return ret;
+	return true;
+}
+
+static bool StorageWriteLba(int offset_block, void *data, int blocks)
+{
+	return write_image((off_t)offset_block * BLOCK_SIZE, data,
+			   blocks * BLOCK_SIZE);
 }
 
 static bool StorageReadLba(int offset_block, void *data, int blocks)
@@ -1151,6 +614,7 @@ static void usage(void)
 	       "\t\tSpecify input/output image path.\n");
 	printf("\t" OPT_PRINT "\t\t\tJust print informations.\n");
 	printf("\t" OPT_VERBOSE "\t\tDisplay more runtime informations.\n");
+	printf("\t" OPT_STATS "\t\t\tDisplay the time taken per file.\n");
 	printf("\t" OPT_HELP "\t\t\tDisplay this information.\n");
 	printf("\t" OPT_VERSION "\t\tDisplay version information.\n");
 	printf("\t" OPT_ROOT "path"
@@ -1180,6 +644,8 @@ int main(int argc, char **argv)
 		argc--, argv++;
 		if (!strcmp(OPT_VERBOSE, arg)) {
 			g_debug = true;
+		} else if (!strcmp(OPT_STATS, arg)) {
+			g_stats = true;
 		} else if (!strcmp(OPT_HELP, arg)) {
 			usage();
 			return 0;
@@ -1406,51 +872,126 @@ static inline size_t get_file_size(const char *path)
 	return st.st_size;
 }
 
-static int write_file(int offset_block, const char *src_path,
-		      char hash[], int hash_size)
+static inline uint64_t get_micros(void)
 {
-	LOGD("try to write file(%s) to offset:%d...", src_path, offset_block);
-	char *buf = NULL;
-	int ret = -1;
-	size_t file_size;
-	FILE *src_file = fopen(src_path, "rb");
-	if (!src_file) {
-		LOGE("Failed to open:%s", src_path);
-		goto end;
-	}
+	struct timespec ts;
 
-	file_size = get_file_size(src_path);
-	if (file_size < 0) {
-		goto end;
-	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
 
-	buf = calloc(file_size, 1);
-	if (!buf)
-		goto end;
+typedef struct {
+	const char *path;
+	int offset_block;
+	size_t size;
+	char hash[MAX_HASH_LEN];
+	int hash_size;
+	uint64_t time;		/* us, for --stats */
+	bool ok;
+} pack_job;
+
+static struct {
+	pack_job *jobs;
+	int num;
+	int next;
+	pthread_mutex_t lock;
+} pack_queue = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
 
-	if (!fread(buf, file_size, 1, src_file))
+/* Map a file, write it to the image and hash it, without copying it */
+static void write_file(pack_job *job)
+{
+	uint64_t start = get_micros();
+	void *buf = NULL;
+	struct stat st;
+	int fd;
+
+	LOGD("try to write file(%s) to offset:%d...", job->path,
+	     job->offset_block);
+	fd = open(job->path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0 || st.st_size != job->size) {
+		LOGE("Failed to open:%s", job->path);
 		goto end;
+	}
+	if (job->size) {
+		buf = mmap(NULL, job->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (buf == MAP_FAILED) {
+			buf = NULL;
+			LOGE("Failed to map:%s", job->path);
+			goto end;
+		}
+	}
 
-	if (!write_data(offset_block, buf, file_size))
+	if (!write_image((off_t)job->offset_block * BLOCK_SIZE, buf,
+			 job->size))
 		goto end;
 
-	if (hash_size == 20)
-		sha1_csum((const unsigned char *)buf, file_size,
-			  (unsigned char *)hash);
-	else if (hash_size == 32)
-		sha256_csum((const unsigned char *)buf, file_size,
-			    (unsigned char *)hash);
+	if (job->hash_size == 20)
+		sha1_csum(buf, job->size, (unsigned char *)job->hash);
+	else if (job->hash_size == 32)
+		sha256_csum_wd(buf, job->size, (unsigned char *)job->hash,
+			       CHUNKSZ_SHA256);
 	else
 		goto end;
 
-	ret = file_size;
+	job->ok = true;
 end:
-	if (src_file)
-		fclose(src_file);
 	if (buf)
-		free(buf);
+		munmap(buf, job->size);
+	if (fd >= 0)
+		close(fd);
+	job->time = get_micros() - start;
+}
 
-	return ret;
+static void *pack_worker(void *arg)
+{
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&pack_queue.lock);
+		i = pack_queue.next++;
+		pthread_mutex_unlock(&pack_queue.lock);
+		if (i >= pack_queue.num)
+			break;
+		write_file(&pack_queue.jobs[i]);
+	}
+	return NULL;
+}
+
+/* Files are independent, so they are written and hashed by all CPUs */
+static bool write_files(pack_job *jobs, int num)
+{
+	pthread_t *threads;
+	int i, started = 0;
+	long cpus;
+
+	pack_queue.jobs = jobs;
+	pack_queue.num = num;
+	pack_queue.next = 0;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > num)
+		cpus = num;
+	threads = cpus > 1 ? calloc(cpus - 1, sizeof(*threads)) : NULL;
+	for (i = 0; threads && i < cpus - 1; i++, started++) {
+		if (pthread_create(&threads[i], NULL, pack_worker, NULL))
+			break;
+	}
+	pack_worker(NULL);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	for (i = 0; i < num; i++) {
+		if (!jobs[i].ok)
+			return false;
+		if (g_stats)
+			printf("stats: %-40s %9zu bytes %6llu us\n",
+			       jobs[i].path, jobs[i].size,
+			       (unsigned long long)jobs[i].time);
+	}
+	return true;
 }
 
 static bool write_header(const int file_num)
@@ -1478,22 +1019,34 @@ static bool write_index_tbl(const int file_num, const char **files)
 	int offset =
 	        header.header_size + header.tbl_entry_size * header.tbl_entry_num;
 	index_tbl_entry entry;
-	char hash[20];	/* sha1 */
+	pack_job *jobs;
 	int i;
 
-	memcpy(entry.tag, INDEX_TBL_ENTR_TAG, sizeof(entry.tag));
+	jobs = calloc(file_num, sizeof(*jobs));
+	if (!jobs)
+		goto end;
 	for (i = 0; i < file_num; i++) {
-		size_t file_size = get_file_size(files[i]);
-		if (file_size < 0)
-			goto end;
-		entry.content_size = file_size;
-		entry.content_offset = offset;
-
-		if (write_file(offset, files[i], hash, sizeof(hash)) < 0)
+		jobs[i].path = files[i];
+		jobs[i].size = get_file_size(files[i]);
+		if (jobs[i].size == (size_t)-1)
 			goto end;
+		jobs[i].offset_block = offset;
+		jobs[i].hash_size = 20;	/* sha1 */
+		offset += fix_blocks(jobs[i].size);
+	}
+	if (!write_files(jobs, file_num))
+		goto end;
+	/* The last file is padded to a whole block */
+	if (ftruncate(image_fd, (off_t)offset * BLOCK_SIZE))
+		goto end;
 
-		memcpy(entry.hash, hash, sizeof(hash));
-		entry.hash_size = sizeof(hash);
+	memset(&entry, 0, sizeof(entry));
+	memcpy(entry.tag, INDEX_TBL_ENTR_TAG, sizeof(entry.tag));
+	for (i = 0; i < file_num; i++) {
+		entry.content_size = jobs[i].size;
+		entry.content_offset = jobs[i].offset_block;
+		memcpy(entry.hash, jobs[i].hash, jobs[i].hash_size);
+		entry.hash_size = jobs[i].hash_size;
 
 		LOGD("try to write index entry(%s)...", files[i]);
 
@@ -1518,25 +1071,26 @@ static bool write_index_tbl(const int file_num, const char **files)
 			}
 		}
 		snprintf(entry.path, sizeof(entry.path), "%s", path);
-		offset += fix_blocks(file_size);
 		if (!write_data(header.header_size + i * header.tbl_entry_size, &entry,
 		                sizeof(entry)))
 			goto end;
 	}
 	ret = true;
 end:
+	free(jobs);
 	return ret;
 }
 
 static int pack_image(int file_num, const char **files)
 {
+	uint64_t start = get_micros();
 	bool ret = false;
-	FILE *image_file = fopen(image_path, "wb");
-	if (!image_file) {
+
+	image_fd = open(image_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (image_fd < 0) {
 		LOGE("Failed to create:%s", image_path);
 		goto end;
 	}
-	fclose(image_file);
 
 	/* prepare files */
 	int i = 0;
@@ -1567,8 +1121,13 @@ static int pack_image(int file_num, const char **files)
 		goto end;
 	}
 	printf("Pack to %s successed!\n", image_path);
+	if (g_stats)
+		printf("stats: total %llu us\n",
+		       (unsigned long long)(get_micros() - start));
 	ret = true;
 end:
+	if (image_fd >= 0)
+		close(image_fd);
 	return ret ? 0 : -1;
 }
 